@@ -5,15 +5,25 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <atomic>
 #include "sgx_urts.h"
 #include "enclave_u.h"
+#include "enclave_shared.h"
+#include "worker_pool.h"
+#include "shared_ring.h"
+
+class AuditReader;
+class ConfigWatcher;
+class ContractRepository;
 
 // 常量定义
 #define ENCLAVE_FILENAME "enclave.signed.so"
+#define CONFIG_FILENAME "config/config.json"
 #define MAX_PATH 260
 #define MAX_CONTRACT_SIZE 1024 * 1024  // 1MB
 #define MAX_INPUT_SIZE 4096
 #define MAX_OUTPUT_SIZE 4096
+#define ENCLAVE_TCS_NUM 32  // 与enclave.config.xml中的TCSNum一致
 
 // 错误码定义
 typedef enum {
@@ -22,7 +32,9 @@ typedef enum {
     APP_ERROR_ENCLAVE_CALL = -2,
     APP_ERROR_FILE_IO = -3,
     APP_ERROR_INVALID_PARAM = -4,
-    APP_ERROR_MEMORY = -5
+    APP_ERROR_MEMORY = -5,
+    APP_ERROR_BUSY = -6,            // 队列已满（非阻塞提交）
+    APP_ERROR_NETWORK = -7          // 远程节点连接或协议错误
 } app_status_t;
 
 // 智能合约结构
@@ -43,19 +55,37 @@ struct ExecutionResult {
     std::vector<uint8_t> output;
     uint64_t gas_used;
     std::vector<uint8_t> execution_hash;
+    std::vector<uint8_t> code_hash;
     std::string error_message;
     
     ExecutionResult() : success(false), gas_used(0) {}
 };
 
+// 批量执行任务
+struct ContractJob {
+    const SmartContract* contract;      // 合约（为空时必须提供code_hash）
+    std::vector<uint8_t> code_hash;     // 已缓存合约的字节码哈希（32字节，可选）
+    std::vector<uint8_t> input_data;
+    uint64_t gas_limit;
+    
+    ContractJob() : contract(nullptr), gas_limit(1000000) {}
+    ContractJob(const SmartContract* job_contract, const std::vector<uint8_t>& input)
+        : contract(job_contract), input_data(input),
+          gas_limit(job_contract ? job_contract->gas_limit : 1000000) {}
+};
+
 // 证明结构
 struct ExecutionProof {
-    std::vector<uint8_t> proof_data;
+    std::vector<uint8_t> proof_data;        // execution_proof_t（批量证明时签名对象为Merkle根摘要）
     std::vector<uint8_t> measurement;
     std::vector<uint8_t> signature;
+    std::vector<uint8_t> execution_hash;    // 被证明的执行哈希
+    std::vector<uint8_t> merkle_path;       // 批量证明的包含路径（单条证明为空）
+    uint32_t leaf_index;                    // 批量证明中的叶子序号
+    uint32_t leaf_count;                    // 批量证明的叶子数量（0表示单条证明）
     bool is_valid;
     
-    ExecutionProof() : is_valid(false) {}
+    ExecutionProof() : leaf_index(0), leaf_count(0), is_valid(false) {}
 };
 
 // 应用程序类
@@ -63,6 +93,29 @@ class SGXSmartContractApp {
 private:
     sgx_enclave_id_t enclave_id;
     bool enclave_initialized;
+    std::atomic<bool> profiling_enabled;     // 配置热更新时由监视线程修改
+    bool switchless_enabled;
+    std::unique_ptr<WorkerPool> worker_pool;
+    std::unique_ptr<SharedRing> shared_ring;
+    std::unique_ptr<AuditReader> audit_reader;
+    std::unique_ptr<ContractRepository> repository;
+    std::unique_ptr<ConfigWatcher> config_watcher;
+    std::vector<int> cpu_affinity;           // 工作线程绑定的CPU（为空时不绑定）
+    
+    app_status_t run_jobs(const std::vector<ContractJob>& jobs,
+                          const std::vector<size_t>& indices,
+                          std::vector<ExecutionResult>& results);
+    WorkerPool& pool_for(size_t thread_count);
+    app_status_t submit_batch(const std::vector<ContractJob>& jobs,
+                              const std::vector<size_t>& indices,
+                              bool allow_by_hash,
+                              std::vector<ExecutionResult>& results,
+                              std::vector<size_t>& not_cached);
+    bool execute_shared(const uint8_t* code, size_t code_size,
+                        const uint8_t* input, size_t input_size, uint64_t gas_limit,
+                        uint8_t* result, size_t result_capacity, size_t* result_size,
+                        uint8_t* execution_hash, uint64_t* gas_used,
+                        sgx_status_t* enclave_ret, sgx_status_t* ret);
     
 public:
     SGXSmartContractApp();
@@ -73,23 +126,102 @@ public:
     void destroy_enclave();
     bool is_enclave_ready() const { return enclave_initialized; }
     
+    // 免切换调用模式，需在initialize_enclave之前设置
+    void set_switchless(bool enable) { switchless_enabled = enable; }
+    bool is_switchless() const { return switchless_enabled; }
+    // 工作线程绑定到给定CPU（如一个NUMA节点），未指定线程数且未配置performance.worker_threads时线程数取CPU数；
+    // 需在首次并行执行之前设置
+    void set_cpu_affinity(const std::vector<int>& cpus) { cpu_affinity = cpus; }
+    const std::vector<int>& get_cpu_affinity() const { return cpu_affinity; }
+    
+    // 执行后端选择，取值见enclave_shared.h中的execution_backend_t
+    app_status_t set_execution_backend(uint32_t backend);
+    // EXECUTION_BACKEND_JIT下合约被调用多少次后编译为本地代码（0表示不编译）
+    app_status_t set_jit_threshold(uint32_t call_threshold);
+    // 单次执行改为经由共享环形缓冲区传递字节码、输入和结果（避免EDL复制），放不下的调用仍走普通ECALL
+    app_status_t enable_shared_ring(size_t size);
+    bool is_shared_ring_enabled() const { return shared_ring != nullptr; }
+    // 合约内存（OP_LOAD/OP_STORE）按字节码哈希持久化到主机状态日志，cache_budget为0时使用默认EPC预算
+    app_status_t configure_state(bool persistent, uint64_t cache_budget = 0);
+    // Enclave内存占用（执行上下文、内存页、状态缓存），字段见enclave_shared.h
+    app_status_t get_memory_stats(enclave_memory_stats_t& stats);
+    // 执行剖析：开启后执行改走解码解释器，按字节码哈希统计操作码、基本块Gas，cycles另以rdtsc统计周期数
+    app_status_t set_profiling(bool enable, bool cycles = false);
+    // 取出Enclave中的审计记录写入AuditLog（通常由AuditReader线程调用）
+    app_status_t drain_audit_log(size_t& record_count);
+    // 按当前配置一次调整缓存预算、剖析开关（ecall_configure_runtime）和审计读取间隔；
+    // 初始化时调用，performance.config_hot_reload开启时配置文件每次变化后由监视线程再次调用
+    app_status_t apply_runtime_config();
+    // 导出剖析快照（格式见enclave_shared.h，可用ProfileSnapshot::parse解析），reset为true时导出后清空统计
+    app_status_t get_profile(std::vector<uint8_t>& snapshot, bool reset = false);
+    
     // 智能合约操作
     app_status_t load_contract_from_file(const std::string& filename, SmartContract& contract);
+    // 合约仓库（storage.contract_repository）：验证并密封合约的元数据后与已有条目合并写入，重新映射
+    app_status_t add_to_repository(const std::vector<SmartContract>& contracts);
+    // 一次ECALL把仓库中的合约解码进字节码缓存（跳过验证），之后可按哈希执行；初始化时按storage.warm_code_cache自动调用
+    app_status_t warm_code_cache(size_t& loaded);
+    // 按字节码哈希从仓库加载合约
+    app_status_t load_contract_by_hash(const std::vector<uint8_t>& code_hash, SmartContract& contract);
     app_status_t execute_contract(const SmartContract& contract, 
                                  const std::vector<uint8_t>& input_data,
                                  ExecutionResult& result);
+    app_status_t verify_contract_execution(const SmartContract& contract,
+                                          const std::vector<uint8_t>& input_data,
+                                          ExecutionResult& result);
+    app_status_t execute_batch(const std::vector<ContractJob>& jobs,
+                               std::vector<ExecutionResult>& results);
+    app_status_t execute_parallel(const std::vector<ContractJob>& jobs,
+                                  std::vector<ExecutionResult>& results,
+                                  size_t thread_count = 0);
+    // 区块执行：多个线程乐观并行执行，按任务顺序提交，结果与execute_batch相同；stats累加各区块的调度统计
+    app_status_t execute_block(const std::vector<ContractJob>& jobs,
+                               std::vector<ExecutionResult>& results,
+                               size_t thread_count = 0,
+                               block_exec_stats_t* stats = nullptr);
+    // 执行一个分片（最多消耗slice_gas）：snapshot为空时从头开始，suspended为true时snapshot保存继续执行所需的密封快照
+    app_status_t execute_slice(const SmartContract& contract,
+                               const std::vector<uint8_t>& input_data,
+                               uint64_t slice_gas,
+                               std::vector<uint8_t>& snapshot,
+                               bool& suspended,
+                               ExecutionResult& result);
+    // 流式输入执行：输入按chunk_size（0或超过INPUT_STREAM_MAX_CHUNK时取INPUT_STREAM_MAX_CHUNK）分块送入，
+    // 合约以OP_INPUT读取；读取下一块与Enclave处理当前块重叠，输入大小不受MAX_INPUT_SIZE限制
+    app_status_t execute_streaming(const SmartContract& contract,
+                                   std::istream& input,
+                                   ExecutionResult& result,
+                                   size_t chunk_size = 0);
+    // 分片并行执行：任务每次只执行slice_gas，未完成的任务回到队尾，长任务不会一直占用工作线程和TCS
+    app_status_t execute_time_sliced(const std::vector<ContractJob>& jobs,
+                                     std::vector<ExecutionResult>& results,
+                                     uint64_t slice_gas,
+                                     size_t thread_count = 0);
     
     // 证明和验证
     app_status_t generate_execution_proof(const SmartContract& contract,
                                          const std::vector<uint8_t>& input_data,
                                          ExecutionProof& proof);
+    // 对一组执行结果只签名一次Merkle根，每条成功的结果得到根证明和各自的包含路径
+    app_status_t generate_batch_proof(const std::vector<ExecutionResult>& results,
+                                      std::vector<ExecutionProof>& proofs);
     app_status_t verify_execution_proof(const ExecutionProof& proof, bool& is_valid);
+    // 在一次ECALL中验证多条证明（超过PROOF_VERIFY_MAX_BATCH时分批），不需要Enclave时使用ProofVerifier
+    app_status_t verify_execution_proofs(const std::vector<ExecutionProof>& proofs,
+                                         std::vector<bool>& valid);
+    // 证明签名公钥，供ProofVerifier作为受信任公钥
+    app_status_t get_signing_public_key(std::vector<uint8_t>& public_key);
     
     // Enclave信息
     app_status_t get_enclave_measurement(std::vector<uint8_t>& measurement);
     app_status_t create_attestation_report(const std::vector<uint8_t>& user_data,
                                           std::vector<uint8_t>& report);
     
+    // 工作线程数：requested为0时取performance.worker_threads或CPU核数，不超过ENCLAVE_TCS_NUM
+    static size_t worker_thread_count(size_t requested);
+    // 每次批量ECALL的任务数上限：performance.batch_size，不超过BATCH_MAX_JOBS
+    static size_t batch_job_limit();
+    
     // 工具函数
     static SmartContract create_sample_contract();
     static std::vector<uint8_t> create_sample_input();
@@ -98,9 +230,18 @@ public:
 };
 
 // 全局函数声明
+std::string sealed_signing_key_path();
+// Gas表：smart_contract.gas_costs中按助记符覆盖标准值，传给ecall_init_contract_verifier
+void build_gas_schedule(gas_schedule_t& schedule);
+// 证明签名密钥的密封存储：加载须在ecall_init_contract_verifier之前，保存在其之后
+bool load_sealed_signing_key(sgx_enclave_id_t eid, const std::string& filename);
+bool store_sealed_signing_key(sgx_enclave_id_t eid, const std::string& filename);
+// 在批量请求末尾追加一条任务记录（格式见enclave_shared.h中的batch_job_header_t），by_hash为true时不携带字节码
+void append_job_record(std::vector<uint8_t>& request, const ContractJob& job, bool by_hash);
 void show_main_menu();
 void run_interactive_mode();
-void run_benchmark_test(int iterations = 100);
+// json_file非空时另以JSON格式写入全部统计结果
+void run_benchmark_test(int iterations = 100, const std::string& json_file = "");
 app_status_t run_contract_from_file(const std::string& filename);
 void print_app_info();
 void print_error(const std::string& message);
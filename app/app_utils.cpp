@@ -6,6 +6,12 @@
 #include <random>
 #include <filesystem>
 #include <cstring>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 #include <openssl/sha.h>
 #include <openssl/evp.h>
 #include <openssl/bio.h>
@@ -344,6 +350,331 @@ std::string Config::data_directory = "./data";
 std::string Config::log_directory = "./logs";
 size_t Config::max_log_size = 10 * 1024 * 1024; // 10MB
 
+// 解析后的配置项：字符串保存解码后的内容，数字和布尔值保存原文
+struct ConfigValue {
+    enum Type { STRING, NUMBER, BOOLEAN, NUL } type;
+    std::string text;
+};
+
+typedef std::unordered_map<std::string, ConfigValue> ConfigValues;
+
+// reload整体替换g_config_values，读取方持有共享锁
+static std::shared_mutex g_config_mutex;
+static ConfigValues g_config_values;
+
+#define CONFIG_MAX_DEPTH 32
+
+/**
+ * 单遍JSON解析器，把标量值按点号连接的路径写入ConfigValues
+ */
+class ConfigParser {
+private:
+    const char* pos;
+    const char* end;
+    const char* begin;
+    ConfigValues& values;
+    std::string error;
+    
+    void skip_space() {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) {
+            pos++;
+        }
+    }
+    
+    bool fail(const std::string& message) {
+        if (error.empty()) {
+            size_t line = 1 + std::count(begin, pos, '\n');
+            error = message + " (第" + std::to_string(line) + "行)";
+        }
+        return false;
+    }
+    
+    bool expect(char c) {
+        skip_space();
+        if (pos >= end || *pos != c) {
+            return fail(std::string("缺少'") + c + "'");
+        }
+        pos++;
+        return true;
+    }
+    
+    static void append_utf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+    
+    bool parse_hex4(uint32_t& code) {
+        if (end - pos < 4) {
+            return fail("无效的\\u转义");
+        }
+        code = 0;
+        for (int i = 0; i < 4; i++, pos++) {
+            char c = *pos;
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                code |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                code |= c - 'A' + 10;
+            } else {
+                return fail("无效的\\u转义");
+            }
+        }
+        return true;
+    }
+    
+    bool parse_string(std::string& out) {
+        if (!expect('"')) {
+            return false;
+        }
+        out.clear();
+        while (pos < end) {
+            // 不含转义的部分整段复制
+            const char* run = pos;
+            while (pos < end && *pos != '"' && *pos != '\\' && static_cast<unsigned char>(*pos) >= 0x20) {
+                pos++;
+            }
+            out.append(run, pos);
+            if (pos >= end) {
+                break;
+            }
+            
+            char c = *pos++;
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                return fail("字符串中有控制字符");
+            }
+            if (pos >= end) {
+                break;
+            }
+            
+            switch (*pos++) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t code = 0;
+                    if (!parse_hex4(code)) {
+                        return false;
+                    }
+                    // 代理对组成一个补充平面字符
+                    if (code >= 0xD800 && code < 0xDC00 && end - pos >= 2 && pos[0] == '\\' && pos[1] == 'u') {
+                        pos += 2;
+                        uint32_t low = 0;
+                        if (!parse_hex4(low)) {
+                            return false;
+                        }
+                        if (low < 0xDC00 || low >= 0xE000) {
+                            return fail("无效的代理对");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (code >= 0xD800 && code < 0xE000) {
+                        return fail("无效的代理对");
+                    }
+                    append_utf8(out, code);
+                    break;
+                }
+                default:
+                    return fail("无效的转义字符");
+            }
+        }
+        return fail("字符串未结束");
+    }
+    
+    bool parse_number(std::string& out) {
+        const char* start = pos;
+        if (pos < end && *pos == '-') {
+            pos++;
+        }
+        if (pos < end && *pos == '0') {
+            pos++;
+        } else if (pos < end && *pos >= '1' && *pos <= '9') {
+            while (pos < end && *pos >= '0' && *pos <= '9') pos++;
+        } else {
+            return fail("无效的数字");
+        }
+        if (pos < end && *pos == '.') {
+            pos++;
+            if (pos >= end || *pos < '0' || *pos > '9') {
+                return fail("无效的数字");
+            }
+            while (pos < end && *pos >= '0' && *pos <= '9') pos++;
+        }
+        if (pos < end && (*pos == 'e' || *pos == 'E')) {
+            pos++;
+            if (pos < end && (*pos == '+' || *pos == '-')) {
+                pos++;
+            }
+            if (pos >= end || *pos < '0' || *pos > '9') {
+                return fail("无效的数字");
+            }
+            while (pos < end && *pos >= '0' && *pos <= '9') pos++;
+        }
+        out.assign(start, pos);
+        return true;
+    }
+    
+    bool parse_literal(const char* literal) {
+        size_t length = strlen(literal);
+        if (static_cast<size_t>(end - pos) < length || memcmp(pos, literal, length) != 0) {
+            return fail("无效的值");
+        }
+        pos += length;
+        return true;
+    }
+    
+    bool parse_value(const std::string& path, int depth) {
+        if (depth > CONFIG_MAX_DEPTH) {
+            return fail("嵌套过深");
+        }
+        skip_space();
+        if (pos >= end) {
+            return fail("缺少值");
+        }
+        
+        ConfigValue value;
+        switch (*pos) {
+            case '{': {
+                pos++;
+                skip_space();
+                if (pos < end && *pos == '}') {
+                    pos++;
+                    return true;
+                }
+                std::string key;
+                while (true) {
+                    if (!parse_string(key) || !expect(':') ||
+                        !parse_value(path.empty() ? key : path + "." + key, depth + 1)) {
+                        return false;
+                    }
+                    skip_space();
+                    if (pos >= end || *pos != ',') {
+                        return expect('}');
+                    }
+                    pos++;
+                }
+            }
+            case '[': {
+                pos++;
+                skip_space();
+                if (pos < end && *pos == ']') {
+                    pos++;
+                    return true;
+                }
+                size_t index = 0;
+                while (true) {
+                    if (!parse_value(path + "." + std::to_string(index++), depth + 1)) {
+                        return false;
+                    }
+                    skip_space();
+                    if (pos >= end || *pos != ',') {
+                        return expect(']');
+                    }
+                    pos++;
+                }
+            }
+            case '"':
+                value.type = ConfigValue::STRING;
+                if (!parse_string(value.text)) {
+                    return false;
+                }
+                break;
+            case 't':
+            case 'f': {
+                const char* literal = *pos == 't' ? "true" : "false";
+                if (!parse_literal(literal)) {
+                    return false;
+                }
+                value.type = ConfigValue::BOOLEAN;
+                value.text = literal;
+                break;
+            }
+            case 'n':
+                value.type = ConfigValue::NUL;
+                if (!parse_literal("null")) {
+                    return false;
+                }
+                break;
+            default:
+                value.type = ConfigValue::NUMBER;
+                if (!parse_number(value.text)) {
+                    return false;
+                }
+                break;
+        }
+        
+        // 重复的键以后出现的为准
+        values[path] = std::move(value);
+        return true;
+    }
+    
+public:
+    ConfigParser(const std::string& text, ConfigValues& output)
+        : pos(text.data()), end(text.data() + text.size()), begin(text.data()), values(output) {}
+    
+    bool parse() {
+        skip_space();
+        if (pos >= end || *pos != '{') {
+            return fail("顶层必须是对象");
+        }
+        if (!parse_value("", 0)) {
+            return false;
+        }
+        skip_space();
+        return pos == end || fail("多余的内容");
+    }
+    
+    const std::string& error_message() const { return error; }
+};
+
+/**
+ * 读取并解析配置文件
+ */
+static bool parse_config_file(const std::string& filename, ConfigValues& values) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        Logger::error("Failed to open config file: " + filename);
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    ConfigParser parser(text, values);
+    if (!parser.parse()) {
+        Logger::error("Invalid config file " + filename + ": " + parser.error_message());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 查找配置项（调用方持有g_config_mutex）
+ */
+static const ConfigValue* find_config_value(const std::string& key) {
+    auto it = g_config_values.find(key);
+    return it == g_config_values.end() ? nullptr : &it->second;
+}
+
 bool Config::load(const std::string& filename) {
     config_file = filename;
     
@@ -352,14 +683,52 @@ bool Config::load(const std::string& filename) {
         return save(filename); // 创建默认配置文件
     }
     
-    // 简化实现：这里应该解析JSON文件
-    // 由于这是演示代码，我们只是标记为已加载
+    ConfigValues values;
+    if (!parse_config_file(filename, values)) {
+        return false;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(g_config_mutex);
+        g_config_values.swap(values);
+    }
     loaded = true;
+    
+    enclave_file = get_string("sgx.enclave_file", enclave_file);
+    debug_mode = get_bool("sgx.debug", debug_mode);
+    int gas_limit = get_int("smart_contract.default_gas_limit", static_cast<int>(default_gas_limit));
+    if (gas_limit > 0) {
+        default_gas_limit = static_cast<uint64_t>(gas_limit);
+    }
+    server_host = get_string("network.server_host", server_host);
+    server_port = get_int("network.server_port", server_port);
+    max_connections = get_int("network.max_connections", max_connections);
+    data_directory = get_string("storage.data_directory", data_directory);
+    log_directory = get_string("storage.log_directory", log_directory);
+    int log_size = get_int("storage.max_log_size", static_cast<int>(max_log_size));
+    if (log_size > 0) {
+        max_log_size = static_cast<size_t>(log_size);
+    }
+    
     Logger::info("Configuration loaded from " + filename);
     
     return true;
 }
 
+bool Config::reload() {
+    ConfigValues values;
+    if (!loaded || !parse_config_file(config_file, values)) {
+        return false;
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(g_config_mutex);
+    g_config_values.swap(values);
+    return true;
+}
+
+std::string Config::file_path() {
+    return config_file;
+}
+
 bool Config::save(const std::string& filename) {
     // 简化实现：创建一个基本的JSON配置文件
     std::ofstream file(filename);
@@ -392,30 +761,50 @@ bool Config::save(const std::string& filename) {
 }
 
 std::string Config::get_string(const std::string& key, const std::string& default_value) {
-    // 简化实现：返回默认值
-    return default_value;
+    std::shared_lock<std::shared_mutex> lock(g_config_mutex);
+    const ConfigValue* value = find_config_value(key);
+    return value && value->type != ConfigValue::NUL ? value->text : default_value;
 }
 
 int Config::get_int(const std::string& key, int default_value) {
-    // 简化实现：返回默认值
-    return default_value;
+    std::shared_lock<std::shared_mutex> lock(g_config_mutex);
+    const ConfigValue* value = find_config_value(key);
+    if (!value || value->type != ConfigValue::NUMBER) {
+        return default_value;
+    }
+    
+    // 只接受int范围内的整数
+    errno = 0;
+    char* parsed_end = nullptr;
+    long long result = strtoll(value->text.c_str(), &parsed_end, 10);
+    if (errno != 0 || *parsed_end != '\0' || result < INT_MIN || result > INT_MAX) {
+        return default_value;
+    }
+    return static_cast<int>(result);
 }
 
 bool Config::get_bool(const std::string& key, bool default_value) {
-    // 简化实现：返回默认值
-    return default_value;
+    std::shared_lock<std::shared_mutex> lock(g_config_mutex);
+    const ConfigValue* value = find_config_value(key);
+    if (!value || value->type != ConfigValue::BOOLEAN) {
+        return default_value;
+    }
+    return value->text == "true";
 }
 
 void Config::set_string(const std::string& key, const std::string& value) {
-    // 简化实现：暂不支持运行时修改
+    std::unique_lock<std::shared_mutex> lock(g_config_mutex);
+    g_config_values[key] = ConfigValue{ ConfigValue::STRING, value };
 }
 
 void Config::set_int(const std::string& key, int value) {
-    // 简化实现：暂不支持运行时修改
+    std::unique_lock<std::shared_mutex> lock(g_config_mutex);
+    g_config_values[key] = ConfigValue{ ConfigValue::NUMBER, std::to_string(value) };
 }
 
 void Config::set_bool(const std::string& key, bool value) {
-    // 简化实现：暂不支持运行时修改
+    std::unique_lock<std::shared_mutex> lock(g_config_mutex);
+    g_config_values[key] = ConfigValue{ ConfigValue::BOOLEAN, value ? "true" : "false" };
 }
 
 // OCall实现
@@ -428,39 +817,6 @@ extern "C" {
         std::cerr << str << std::flush;
     }
     
-    int ocall_read_storage(const char* key, uint8_t* data, size_t* data_size) {
-        std::string filename = Config::data_directory + "/" + std::string(key) + ".dat";
-        
-        if (!AppUtils::file_exists(filename)) {
-            return -1; // 文件不存在
-        }
-        
-        auto file_data = AppUtils::read_file(filename);
-        if (file_data.empty()) {
-            return -2; // 读取失败
-        }
-        
-        if (*data_size < file_data.size()) {
-            *data_size = file_data.size();
-            return -3; // 缓冲区太小
-        }
-        
-        memcpy(data, file_data.data(), file_data.size());
-        *data_size = file_data.size();
-        
-        return 0; // 成功
-    }
-    
-    int ocall_write_storage(const char* key, const uint8_t* data, size_t data_size) {
-        // 确保数据目录存在
-        AppUtils::create_directory(Config::data_directory);
-        
-        std::string filename = Config::data_directory + "/" + std::string(key) + ".dat";
-        std::vector<uint8_t> file_data(data, data + data_size);
-        
-        return AppUtils::write_file(filename, file_data) ? 0 : -1;
-    }
-    
     int ocall_network_request(const char* url, const uint8_t* request_data, size_t request_size,
                              uint8_t* response_data, size_t* response_size) {
         // 简化实现：模拟网络请求
@@ -481,8 +837,7 @@ extern "C" {
         return 0; // 成功
     }
     
-    void ocall_audit_log(int level, const char* message) {
-        LogLevel log_level = static_cast<LogLevel>(level);
-        Logger::log(log_level, "[ENCLAVE] " + std::string(message));
+    uint64_t ocall_get_timestamp() {
+        return AppUtils::get_timestamp_ms();
     }
 }
\ No newline at end of file
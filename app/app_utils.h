@@ -252,7 +252,8 @@ private:
 };
 
 /**
- * 配置管理类
+ * 配置管理类：load解析JSON文件，嵌套的键以点号连接（数组元素以下标为键），
+ * 如"performance.jit.call_threshold"。get_*和set_*为线程安全，reload不影响并发的读取
  */
 class Config {
 private:
@@ -276,12 +277,24 @@ public:
     static size_t max_log_size;
     
     /**
-     * 加载配置文件
+     * 加载配置文件，并据此设置上面的静态配置项（解析失败时保留原有配置）
      * @param filename 配置文件名
      * @return 是否成功
      */
     static bool load(const std::string& filename = "config.json");
     
+    /**
+     * 重新解析上次加载的配置文件，只替换get_*返回的值，静态配置项保持启动时的值
+     * @return 是否成功
+     */
+    static bool reload();
+    
+    /**
+     * 获取上次加载的配置文件路径
+     * @return 文件路径
+     */
+    static std::string file_path();
+    
     /**
      * 保存配置文件
      * @param filename 配置文件名
@@ -339,11 +352,15 @@ public:
 extern "C" {
     void ocall_print_string(const char* str);
     void ocall_print_error(const char* str);
-    int ocall_read_storage(const char* key, uint8_t* data, size_t* data_size);
-    int ocall_write_storage(const char* key, const uint8_t* data, size_t data_size);
+    // 状态OCALL在state_store.cpp中实现
+    int ocall_state_read(const uint8_t* key, size_t key_size, uint8_t* value, size_t value_capacity,
+                         size_t* value_size, uint64_t* version);
+    int ocall_state_write_batch(const uint8_t* records, size_t records_size, uint32_t record_count);
     int ocall_network_request(const char* url, const uint8_t* request_data, size_t request_size, 
                              uint8_t* response_data, size_t* response_size);
-    void ocall_audit_log(int level, const char* message);
+    // 审计OCALL在audit_log.cpp中实现
+    int ocall_audit_write_batch(const uint8_t* records, size_t records_size, uint32_t record_count);
+    uint64_t ocall_get_timestamp();
 }
 
 #endif // APP_UTILS_H
\ No newline at end of file
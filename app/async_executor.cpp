@@ -0,0 +1,194 @@
+#include "async_executor.h"
+#include "enclave_shared.h"
+
+#include <algorithm>
+#include <chrono>
+
+AsyncExecutor::AsyncExecutor(SGXSmartContractApp& owner, size_t queue_capacity, size_t thread_count)
+    : app(owner), submissions(queue_capacity), next_ticket(1), queued(0), in_flight(0),
+      stopping(false), idle_dispatchers(0), blocked_submitters(0) {
+    dispatcher_count = SGXSmartContractApp::worker_thread_count(thread_count);
+
+    dispatchers.reserve(dispatcher_count);
+    for (size_t i = 0; i < dispatcher_count; i++) {
+        dispatchers.emplace_back(&AsyncExecutor::dispatcher_loop, this);
+    }
+}
+
+AsyncExecutor::~AsyncExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        stopping.store(true);
+    }
+    work_available.notify_all();
+    space_available.notify_all();
+
+    for (std::thread& dispatcher : dispatchers) {
+        dispatcher.join();
+    }
+}
+
+app_status_t AsyncExecutor::submit(ContractJob job, uint64_t& ticket) {
+    Request request;
+    request.job = std::move(job);
+    app_status_t status = enqueue(request, true);
+    ticket = request.ticket;
+    return status;
+}
+
+app_status_t AsyncExecutor::try_submit(ContractJob job, uint64_t& ticket) {
+    Request request;
+    request.job = std::move(job);
+    app_status_t status = enqueue(request, false);
+    ticket = request.ticket;
+    return status;
+}
+
+std::future<ExecutionResult> AsyncExecutor::submit_future(ContractJob job) {
+    Request request;
+    request.job = std::move(job);
+    request.promise = std::make_shared<std::promise<ExecutionResult>>();
+    std::future<ExecutionResult> future = request.promise->get_future();
+
+    std::shared_ptr<std::promise<ExecutionResult>> promise = request.promise;
+    if (enqueue(request, true) != APP_SUCCESS) {
+        ExecutionResult result;
+        result.error_message = "执行器已停止";
+        promise->set_value(std::move(result));
+    }
+    return future;
+}
+
+size_t AsyncExecutor::poll(std::vector<Completion>& completed, size_t max_count, uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(completion_mutex);
+    if (completions.empty() && timeout_ms > 0) {
+        completion_available.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                                      [this]() { return !completions.empty(); });
+    }
+
+    size_t count = completions.size();
+    if (max_count > 0) {
+        count = std::min(count, max_count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        completed.push_back(std::move(completions.front()));
+        completions.pop_front();
+    }
+    return count;
+}
+
+app_status_t AsyncExecutor::enqueue(Request& request, bool wait) {
+    if (stopping.load()) {
+        return APP_ERROR_INVALID_PARAM;
+    }
+
+    request.ticket = next_ticket.fetch_add(1);
+    in_flight.fetch_add(1);
+
+    while (!submissions.try_push(request)) {
+        if (!wait || stopping.load()) {
+            in_flight.fetch_sub(1);
+            return stopping.load() ? APP_ERROR_INVALID_PARAM : APP_ERROR_BUSY;
+        }
+
+        // 背压：等待调度线程取走任务；先登记再检查计数，与dispatcher_loop的先出队再检查登记配对，不会丢失唤醒
+        std::unique_lock<std::mutex> lock(wait_mutex);
+        blocked_submitters.fetch_add(1);
+        space_available.wait(lock, [this]() {
+            return stopping.load() || queued.load() < submissions.capacity();
+        });
+        blocked_submitters.fetch_sub(1);
+    }
+
+    queued.fetch_add(1);
+    if (idle_dispatchers.load() > 0) {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        work_available.notify_one();
+    }
+    return APP_SUCCESS;
+}
+
+bool AsyncExecutor::wait_for_work() {
+    // 短暂让出CPU，连续提交时调度线程不必进入条件变量
+    for (int i = 0; i < 64; i++) {
+        if (queued.load() > 0) {
+            return true;
+        }
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(wait_mutex);
+    idle_dispatchers.fetch_add(1);
+    work_available.wait(lock, [this]() { return stopping.load() || queued.load() > 0; });
+    idle_dispatchers.fetch_sub(1);
+
+    // 停止时仍先执行完已提交的任务
+    return queued.load() > 0 || !stopping.load();
+}
+
+void AsyncExecutor::dispatcher_loop() {
+    std::vector<Request> batch;
+    std::vector<ContractJob> jobs;
+    std::vector<ExecutionResult> results;
+
+    while (true) {
+        Request request;
+        if (!submissions.try_pop(request)) {
+            if (!wait_for_work()) {
+                return;
+            }
+            continue;
+        }
+        batch.push_back(std::move(request));
+
+        // 每次最多取走积压任务的1/线程数，其余调度线程同时各取一批，所有TCS都保持忙碌
+        size_t backlog = queued.load();
+        size_t limit = std::min<size_t>((backlog + dispatcher_count - 1) / dispatcher_count,
+                                        SGXSmartContractApp::batch_job_limit());
+        while (batch.size() < limit && submissions.try_pop(request)) {
+            batch.push_back(std::move(request));
+        }
+
+        queued.fetch_sub(batch.size());
+        if (blocked_submitters.load() > 0) {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            space_available.notify_all();
+        }
+
+        jobs.clear();
+        for (Request& item : batch) {
+            jobs.push_back(std::move(item.job));
+        }
+
+        app_status_t status = app.execute_batch(jobs, results);
+
+        std::vector<Completion> done;
+        done.reserve(batch.size());
+        for (size_t i = 0; i < batch.size(); i++) {
+            ExecutionResult& result = results[i];
+            if (status != APP_SUCCESS && !result.success && result.error_message.empty()) {
+                result.error_message = "批量执行失败";
+            }
+
+            if (batch[i].promise) {
+                batch[i].promise->set_value(std::move(result));
+            } else {
+                Completion completion;
+                completion.ticket = batch[i].ticket;
+                completion.result = std::move(result);
+                done.push_back(std::move(completion));
+            }
+        }
+
+        if (!done.empty()) {
+            std::lock_guard<std::mutex> lock(completion_mutex);
+            for (Completion& completion : done) {
+                completions.push_back(std::move(completion));
+            }
+        }
+        completion_available.notify_all();
+
+        in_flight.fetch_sub(batch.size());
+        batch.clear();
+    }
+}
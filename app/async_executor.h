@@ -0,0 +1,127 @@
+#ifndef ASYNC_EXECUTOR_H
+#define ASYNC_EXECUTOR_H
+
+#include "app.h"
+#include "mpmc_queue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 异步合约执行器
+ * 任务经有界无锁队列提交，调度线程每次取出一批通过execute_batch在一次ECALL中执行，
+ * 结果放入完成队列由poll取回（或通过submit_future返回的future取回）。
+ * 每个调度线程占用一个Enclave TCS，与execute_parallel的工作线程合计不应超过TCSNum。
+ * 任务引用的合约在完成前必须保持有效
+ */
+class AsyncExecutor {
+public:
+    // 已完成的任务
+    struct Completion {
+        uint64_t ticket;                    // submit返回的票据
+        ExecutionResult result;
+
+        Completion() : ticket(0) {}
+    };
+
+private:
+    struct Request {
+        uint64_t ticket;
+        ContractJob job;
+        std::shared_ptr<std::promise<ExecutionResult>> promise;    // 为空时结果进入完成队列
+
+        Request() : ticket(0) {}
+    };
+
+    SGXSmartContractApp& app;
+    MpmcQueue<Request> submissions;
+    std::vector<std::thread> dispatchers;
+    size_t dispatcher_count;
+    std::atomic<uint64_t> next_ticket;
+    std::atomic<size_t> queued;             // 已入队未取出的任务数
+    std::atomic<size_t> in_flight;          // 已提交未完成的任务数
+    std::atomic<bool> stopping;
+
+    // 队列空或满时的等待（只在慢路径上加锁）
+    std::mutex wait_mutex;
+    std::condition_variable work_available;
+    std::condition_variable space_available;
+    std::atomic<size_t> idle_dispatchers;
+    std::atomic<size_t> blocked_submitters;
+
+    std::mutex completion_mutex;
+    std::condition_variable completion_available;
+    std::deque<Completion> completions;
+
+    app_status_t enqueue(Request& request, bool wait);
+    bool wait_for_work();
+    void dispatcher_loop();
+
+public:
+    /**
+     * 创建执行器并启动调度线程
+     * @param owner 已初始化Enclave的应用（生命周期须长于执行器）
+     * @param queue_capacity 提交队列容量（向上取整到2的幂），队列满时submit阻塞
+     * @param thread_count 调度线程数（0表示与execute_parallel相同的默认值）
+     */
+    AsyncExecutor(SGXSmartContractApp& owner, size_t queue_capacity, size_t thread_count = 0);
+
+    /**
+     * 执行完已提交的任务后停止调度线程（未取回的完成结果随之丢弃）
+     */
+    ~AsyncExecutor();
+
+    AsyncExecutor(const AsyncExecutor&) = delete;
+    AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+
+    /**
+     * 提交任务，队列满时等待调度线程取走任务
+     * @param job 任务
+     * @param ticket 输出的票据（对应Completion::ticket）
+     * @return 状态码
+     */
+    app_status_t submit(ContractJob job, uint64_t& ticket);
+
+    /**
+     * 提交任务，队列满时立即返回
+     * @param job 任务
+     * @param ticket 输出的票据
+     * @return 状态码（队列满时为APP_ERROR_BUSY）
+     */
+    app_status_t try_submit(ContractJob job, uint64_t& ticket);
+
+    /**
+     * 提交任务并通过future取回结果（结果不进入完成队列），队列满时等待
+     * @param job 任务
+     * @return 执行结果的future
+     */
+    std::future<ExecutionResult> submit_future(ContractJob job);
+
+    /**
+     * 取回已完成的任务（追加到completed末尾，完成顺序不一定与提交顺序相同）
+     * @param completed 输出的完成结果
+     * @param max_count 最多取回的数量（0表示不限）
+     * @param timeout_ms 没有已完成任务时最多等待的毫秒数（0表示不等待）
+     * @return 取回的数量
+     */
+    size_t poll(std::vector<Completion>& completed, size_t max_count = 0, uint32_t timeout_ms = 0);
+
+    /**
+     * 获取已提交未完成的任务数
+     * @return 任务数
+     */
+    size_t pending() const { return in_flight.load(); }
+
+    /**
+     * 获取调度线程数
+     * @return 线程数
+     */
+    size_t thread_count() const { return dispatcher_count; }
+};
+
+#endif // ASYNC_EXECUTOR_H
@@ -0,0 +1,199 @@
+#include "audit_log.h"
+#include "app.h"
+#include "app_utils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+const unsigned AUDIT_LOG_BACKUPS = 3;
+const uint32_t AUDIT_READ_INTERVAL_MS = 100;
+
+const char* event_name(uint32_t event) {
+    switch (event) {
+        case AUDIT_EVENT_EXECUTION_STARTED: return "execution_started";
+        case AUDIT_EVENT_EXECUTION_COMPLETED: return "execution_completed";
+        case AUDIT_EVENT_EXECUTION_FAILED: return "execution_failed";
+        default: return "unknown";
+    }
+}
+
+const char* level_name(uint32_t level) {
+    switch (level) {
+        case 0: return "DEBUG";
+        case 1: return "INFO";
+        case 2: return "WARNING";
+        default: return "ERROR";
+    }
+}
+
+/**
+ * 格式化当前时间（毫秒精度）
+ */
+std::string timestamp_now() {
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+
+    std::tm local;
+    localtime_r(&seconds, &local);
+    std::ostringstream ss;
+    ss << std::put_time(&local, "%Y-%m-%d %H:%M:%S") << '.' << std::setw(3) << std::setfill('0') << ms;
+    return ss.str();
+}
+
+} // namespace
+
+AuditLog::AuditLog(const std::string& log_path, size_t max_bytes, unsigned backup_count, bool enable)
+    : path(log_path), max_size(max_bytes), backups(backup_count), file_size(0), next_sequence(0),
+      enabled(enable) {
+    if (enabled) {
+        std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        if (!parent.empty()) {
+            std::error_code ec;
+            std::filesystem::create_directories(parent, ec);
+        }
+        open_file();
+    }
+}
+
+void AuditLog::open_file() {
+    file.open(path, std::ios::out | std::ios::app);
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    file_size = ec ? 0 : static_cast<size_t>(size);
+}
+
+void AuditLog::rotate() {
+    file.close();
+
+    std::error_code ec;
+    for (unsigned i = backups; i > 1; i--) {
+        std::filesystem::rename(path + "." + std::to_string(i - 1), path + "." + std::to_string(i), ec);
+    }
+    if (backups > 0) {
+        std::filesystem::rename(path, path + ".1", ec);
+    } else {
+        std::filesystem::remove(path, ec);
+    }
+
+    open_file();
+}
+
+bool AuditLog::write(const audit_record_t* records, size_t count) {
+    if (!enabled || count == 0) {
+        return true;
+    }
+    if (!records) {
+        return false;
+    }
+
+    // 整批格式化后一次写入，文件I/O不在执行路径上
+    std::string stamp = timestamp_now();
+    std::ostringstream lines;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (size_t i = 0; i < count; i++) {
+        const audit_record_t& record = records[i];
+        if (record.sequence > next_sequence) {
+            lines << stamp << " WARNING " << (record.sequence - next_sequence) << " audit records lost\n";
+        }
+        next_sequence = record.sequence + 1;
+
+        std::vector<uint8_t> code_hash(record.code_hash, record.code_hash + sizeof(record.code_hash));
+        lines << stamp << " #" << record.sequence << " " << level_name(record.level)
+              << " " << event_name(record.event) << " code=" << AppUtils::to_hex_string(code_hash);
+        if (record.event == AUDIT_EVENT_EXECUTION_COMPLETED || record.event == AUDIT_EVENT_EXECUTION_FAILED) {
+            lines << " gas=" << record.gas_used;
+        }
+        if (record.event == AUDIT_EVENT_EXECUTION_FAILED) {
+            lines << " status=0x" << std::hex << record.status << std::dec;
+        }
+        if (record.data_size > 0) {
+            size_t kept = record.data_size < AUDIT_RECORD_DATA_SIZE ? record.data_size : AUDIT_RECORD_DATA_SIZE;
+            lines << " data[" << record.data_size << "]="
+                  << AppUtils::to_hex_string(std::vector<uint8_t>(record.data, record.data + kept));
+        }
+        lines << "\n";
+    }
+
+    std::string text = lines.str();
+    if (max_size > 0 && file_size > 0 && file_size + text.size() > max_size) {
+        rotate();
+    }
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    file.flush();
+    file_size += text.size();
+    return file.good();
+}
+
+AuditLog& AuditLog::instance() {
+    size_t max_bytes = static_cast<size_t>(
+        Config::get_int("security.max_audit_log_size_mb", static_cast<int>(Config::max_log_size / (1024 * 1024)))) *
+        1024 * 1024;
+    static AuditLog log(Config::get_string("security.audit_log_file", Config::log_directory + "/audit.log"),
+                        max_bytes, AUDIT_LOG_BACKUPS,
+                        Config::get_bool("security.enable_audit_logging", true));
+    return log;
+}
+
+AuditReader::AuditReader(SGXSmartContractApp& owner, uint32_t interval)
+    : app(owner), interval_ms(interval ? interval : AUDIT_READ_INTERVAL_MS), stopping(false) {
+    reader = std::thread(&AuditReader::reader_loop, this);
+}
+
+AuditReader::~AuditReader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    reader.join();
+}
+
+void AuditReader::set_interval(uint32_t interval) {
+    std::lock_guard<std::mutex> lock(mutex);
+    interval_ms = interval ? interval : AUDIT_READ_INTERVAL_MS;
+}
+
+void AuditReader::reader_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // 停止时最后再取一次，不遗漏已写入的记录
+        bool stop = wakeup.wait_for(lock, std::chrono::milliseconds(interval_ms), [this]() { return stopping; });
+        lock.unlock();
+
+        size_t count;
+        do {
+            count = 0;
+            if (app.drain_audit_log(count) != APP_SUCCESS) {
+                break;
+            }
+        } while (count == AUDIT_DRAIN_MAX_RECORDS);
+
+        lock.lock();
+        if (stop) {
+            return;
+        }
+    }
+}
+
+// 审计OCALL实现
+extern "C" {
+    int ocall_audit_write_batch(const uint8_t* records, size_t records_size, uint32_t record_count) {
+        if (records_size != static_cast<size_t>(record_count) * sizeof(audit_record_t)) {
+            return -1;
+        }
+        return AuditLog::instance().write(reinterpret_cast<const audit_record_t*>(records), record_count) ? 0 : -1;
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef AUDIT_LOG_H
+#define AUDIT_LOG_H
+
+#include "enclave_shared.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class SGXSmartContractApp;
+
+/**
+ * 审计日志文件：Enclave导出的audit_record_t批量格式化后一次写入，
+ * 文件超过大小上限时轮转为path.1 ... path.N（编号越大越旧）。
+ * 时间为主机取出记录的时间。所有接口均为线程安全
+ */
+class AuditLog {
+private:
+    std::string path;
+    size_t max_size;
+    unsigned backups;
+    std::ofstream file;
+    size_t file_size;
+    uint64_t next_sequence;                 // 下一条记录的序号（用于发现被丢弃的记录）
+    bool enabled;
+    std::mutex mutex;
+
+    void open_file();
+    void rotate();
+
+public:
+    /**
+     * 创建审计日志（目录不存在时创建）
+     * @param log_path 日志文件路径
+     * @param max_bytes 单个文件的大小上限（0表示不轮转）
+     * @param backup_count 保留的已轮转文件数
+     * @param enable 为false时丢弃所有记录
+     */
+    AuditLog(const std::string& log_path, size_t max_bytes, unsigned backup_count, bool enable = true);
+
+    AuditLog(const AuditLog&) = delete;
+    AuditLog& operator=(const AuditLog&) = delete;
+
+    /**
+     * 写入一批记录
+     * @param records 记录
+     * @param count 记录数量
+     * @return 是否写入成功
+     */
+    bool write(const audit_record_t* records, size_t count);
+
+    /**
+     * 获取全局审计日志（security.audit_log_file，大小上限为security.max_audit_log_size_mb或Config::max_log_size）
+     * @return 审计日志
+     */
+    static AuditLog& instance();
+};
+
+/**
+ * 审计记录读取线程：定期通过ecall_drain_audit_log取出Enclave中的记录写入AuditLog，
+ * 执行路径上不再有审计日志的OCALL。读取时占用一个TCS
+ */
+class AuditReader {
+private:
+    SGXSmartContractApp& app;
+    uint32_t interval_ms;
+    std::thread reader;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping;
+
+    void reader_loop();
+
+public:
+    /**
+     * 启动读取线程
+     * @param owner 已初始化Enclave的应用（生命周期须长于读取线程）
+     * @param interval 两次读取之间的毫秒数
+     */
+    AuditReader(SGXSmartContractApp& owner, uint32_t interval);
+
+    /**
+     * 停止读取线程并取出剩余的记录
+     */
+    ~AuditReader();
+
+    AuditReader(const AuditReader&) = delete;
+    AuditReader& operator=(const AuditReader&) = delete;
+
+    /**
+     * 修改读取间隔，从下一次等待开始生效
+     * @param interval 两次读取之间的毫秒数（0表示默认值）
+     */
+    void set_interval(uint32_t interval);
+};
+
+#endif // AUDIT_LOG_H
@@ -0,0 +1,839 @@
+#include "benchmark.h"
+#include "enclave_shared.h"
+#include "proof_verifier.h"
+#include "async_executor.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+/**
+ * 取样本的分位数（最近秩法，会重排样本）
+ */
+static double percentile(std::vector<double>& samples, double fraction) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(samples.size())));
+    size_t index = std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0);
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+BenchmarkStats run_benchmark(const std::string& name, int iterations,
+                             const std::function<bool()>& operation) {
+    BenchmarkStats stats;
+    stats.name = name;
+
+    // 预热，使Enclave内的字节码缓存和免切换工作线程进入稳定状态
+    int warmup = std::min(iterations / 10 + 1, 100);
+    for (int i = 0; i < warmup; i++) {
+        operation();
+    }
+
+    // 逐次计时用于分位数，总耗时另行计时以免计入采样开销
+    std::vector<double> samples(static_cast<size_t>(std::max(iterations, 0)));
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        auto op_start = std::chrono::high_resolution_clock::now();
+        if (!operation()) {
+            stats.failures++;
+        }
+        auto op_end = std::chrono::high_resolution_clock::now();
+        samples[i] = std::chrono::duration<double, std::micro>(op_end - op_start).count();
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    stats.iterations = static_cast<uint64_t>(iterations);
+    stats.total_us = std::chrono::duration<double, std::micro>(end_time - start_time).count();
+    if (iterations > 0) {
+        stats.avg_us = stats.total_us / iterations;
+        stats.p50_us = percentile(samples, 0.50);
+        stats.p99_us = percentile(samples, 0.99);
+    }
+    if (stats.total_us > 0) {
+        stats.ops_per_sec = iterations * 1e6 / stats.total_us;
+    }
+
+    return stats;
+}
+
+BenchmarkStats per_item_stats(const BenchmarkStats& stats, uint64_t items) {
+    BenchmarkStats result = stats;
+    if (items > 1) {
+        double scale = static_cast<double>(items);
+        result.iterations = stats.iterations * items;
+        result.failures = stats.failures * items;
+        result.avg_us = stats.avg_us / scale;
+        result.p50_us = stats.p50_us / scale;
+        result.p99_us = stats.p99_us / scale;
+        result.ops_per_sec = stats.ops_per_sec * scale;
+    }
+    return result;
+}
+
+std::vector<BenchmarkStats> run_switchless_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+    SmartContract contract = SGXSmartContractApp::create_sample_contract();
+    std::vector<uint8_t> input = SGXSmartContractApp::create_sample_input();
+
+    const bool modes[] = { false, true };
+    for (bool switchless : modes) {
+        SGXSmartContractApp app;
+        app.set_switchless(switchless);
+        if (app.initialize_enclave() != APP_SUCCESS) {
+            print_error(std::string("无法创建Enclave: ") + (switchless ? "switchless" : "regular"));
+            continue;
+        }
+
+        std::string mode = switchless ? "switchless" : "regular";
+
+        // 只有ECALL的执行路径
+        all_stats.push_back(run_benchmark(mode + "/execute_contract", iterations, [&]() {
+            ExecutionResult result;
+            return app.execute_contract(contract, input, result) == APP_SUCCESS;
+        }));
+
+        // ECALL加两次审计日志OCALL的验证路径
+        all_stats.push_back(run_benchmark(mode + "/verify_contract_execution", iterations, [&]() {
+            ExecutionResult result;
+            return app.verify_contract_execution(contract, input, result) == APP_SUCCESS;
+        }));
+
+        app.destroy_enclave();
+    }
+
+    return all_stats;
+}
+
+/**
+ * 追加PUSH指令
+ */
+static void emit_push(std::vector<uint8_t>& code, uint64_t value) {
+    code.push_back(0x01); // OP_PUSH
+    for (int i = 0; i < 8; i++) {
+        code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+SmartContract create_loop_contract(uint64_t count, const std::vector<uint8_t>& body) {
+    // mem[0] = count; do { body; mem[0] = mem[0] - 1; } while (mem[0] != 0);
+    // 操作数字节同样需要通过验证器，count和跳转地址的每个字节都不能超过0x16
+    std::vector<uint8_t> code;
+    emit_push(code, 0);
+    emit_push(code, count);
+    code.push_back(0x14); // OP_STORE
+
+    uint32_t loop_start = static_cast<uint32_t>(code.size());
+    code.insert(code.end(), body.begin(), body.end());
+    emit_push(code, 0);
+    emit_push(code, 0);
+    code.push_back(0x13); // OP_LOAD
+    emit_push(code, 1);
+    code.push_back(0x04); // OP_SUB
+    code.push_back(0x14); // OP_STORE
+    emit_push(code, 0);
+    code.push_back(0x13); // OP_LOAD
+    code.push_back(0x10); // OP_JMPIF
+    for (int i = 0; i < 4; i++) {
+        code.push_back(static_cast<uint8_t>(loop_start >> (i * 8)));
+    }
+    code.push_back(0xFF); // OP_HALT
+
+    return SmartContract(code, "loop");
+}
+
+std::vector<BenchmarkStats> run_backend_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+    SmartContract contract = create_loop_contract(0x1010);
+    std::vector<uint8_t> input = SGXSmartContractApp::create_sample_input();
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return all_stats;
+    }
+
+    const struct {
+        uint32_t backend;
+        const char* name;
+    } backends[] = {
+        { EXECUTION_BACKEND_INTERPRETER, "backend/interpreter" },
+        { EXECUTION_BACKEND_DECODED, "backend/decoded" },
+        { EXECUTION_BACKEND_THREADED, "backend/threaded" },
+        { EXECUTION_BACKEND_JIT, "backend/jit" },
+    };
+
+    // 首次执行即编译，使交叉验证覆盖本地代码
+    app.set_jit_threshold(1);
+
+    // 以字节码解释器的结果为基准交叉验证各后端
+    std::vector<uint8_t> reference_hash;
+    for (const auto& entry : backends) {
+        if (app.set_execution_backend(entry.backend) != APP_SUCCESS) {
+            print_error(std::string("无法选择执行后端: ") + entry.name);
+            continue;
+        }
+
+        ExecutionResult result;
+        if (app.execute_contract(contract, input, result) == APP_SUCCESS) {
+            if (reference_hash.empty()) {
+                reference_hash = result.execution_hash;
+            } else if (result.execution_hash != reference_hash) {
+                print_warning(std::string("执行哈希与字节码解释器不一致: ") + entry.name);
+            }
+        }
+
+        all_stats.push_back(run_benchmark(entry.name, iterations, [&]() {
+            ExecutionResult iteration_result;
+            return app.execute_contract(contract, input, iteration_result) == APP_SUCCESS;
+        }));
+    }
+
+    app.destroy_enclave();
+
+    return all_stats;
+}
+
+// 批量证明基准中每批的执行结果数量
+#define PROOF_BENCHMARK_BATCH_SIZE 256
+
+std::vector<BenchmarkStats> run_proof_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+    SmartContract contract = SGXSmartContractApp::create_sample_contract();
+    std::vector<uint8_t> input = SGXSmartContractApp::create_sample_input();
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return all_stats;
+    }
+
+    // 输入不同的一批执行，执行哈希各不相同
+    std::vector<ContractJob> jobs;
+    for (int i = 0; i < PROOF_BENCHMARK_BATCH_SIZE; i++) {
+        std::vector<uint8_t> job_input = input;
+        job_input.push_back(static_cast<uint8_t>(i));
+        job_input.push_back(static_cast<uint8_t>(i >> 8));
+        jobs.push_back(ContractJob(&contract, job_input));
+    }
+
+    std::vector<ExecutionResult> results;
+    if (app.execute_batch(jobs, results) != APP_SUCCESS) {
+        print_error("批量执行失败");
+        return all_stats;
+    }
+
+    all_stats.push_back(run_benchmark("proof/single", iterations, [&]() {
+        ExecutionProof proof;
+        return app.generate_execution_proof(contract, input, proof) == APP_SUCCESS;
+    }));
+
+    int batches = std::max(iterations / PROOF_BENCHMARK_BATCH_SIZE, 1);
+    std::vector<ExecutionProof> proofs;
+    all_stats.push_back(run_benchmark("proof/batch_" + std::to_string(PROOF_BENCHMARK_BATCH_SIZE), batches, [&]() {
+        std::vector<ExecutionResult> batch_results;
+        return app.execute_batch(jobs, batch_results) == APP_SUCCESS &&
+               app.generate_batch_proof(batch_results, proofs) == APP_SUCCESS;
+    }));
+
+    size_t next = 0;
+    all_stats.push_back(run_benchmark("proof/verify_batch_item", iterations, [&]() {
+        bool is_valid = false;
+        if (proofs.empty()) {
+            return false;
+        }
+        const ExecutionProof& proof = proofs[next++ % proofs.size()];
+        return app.verify_execution_proof(proof, is_valid) == APP_SUCCESS && is_valid;
+    }));
+
+    // 逐条签名的证明各自有不同的签名，用于对比三种验证方式
+    std::vector<ExecutionProof> singles(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        app.generate_execution_proof(contract, jobs[i].input_data, singles[i]);
+    }
+
+    all_stats.push_back(run_benchmark("proof/verify_single", iterations, [&]() {
+        bool is_valid = false;
+        const ExecutionProof& proof = singles[next++ % singles.size()];
+        return app.verify_execution_proof(proof, is_valid) == APP_SUCCESS && is_valid;
+    }));
+
+    auto all_valid = [](const std::vector<bool>& valid) {
+        return std::find(valid.begin(), valid.end(), false) == valid.end();
+    };
+
+    all_stats.push_back(run_benchmark("proof/verify_ecall_" + std::to_string(PROOF_BENCHMARK_BATCH_SIZE), batches, [&]() {
+        std::vector<bool> valid;
+        return app.verify_execution_proofs(singles, valid) == APP_SUCCESS && all_valid(valid);
+    }));
+
+    std::vector<uint8_t> public_key;
+    ProofVerifier verifier;
+    if (app.get_signing_public_key(public_key) == APP_SUCCESS) {
+        verifier.add_trusted_key(public_key);
+    }
+    all_stats.push_back(run_benchmark("proof/verify_host_" + std::to_string(PROOF_BENCHMARK_BATCH_SIZE), batches, [&]() {
+        return all_valid(verifier.verify_batch(singles));
+    }));
+
+    app.destroy_enclave();
+
+    return all_stats;
+}
+
+// 异步提交基准中每轮提交的任务数量
+#define ASYNC_BENCHMARK_BATCH_SIZE 256
+
+std::vector<BenchmarkStats> run_async_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+    SmartContract contract = SGXSmartContractApp::create_sample_contract();
+    std::vector<uint8_t> input = SGXSmartContractApp::create_sample_input();
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return all_stats;
+    }
+
+    all_stats.push_back(run_benchmark("async/sync_execute_contract", iterations, [&]() {
+        ExecutionResult result;
+        return app.execute_contract(contract, input, result) == APP_SUCCESS && result.success;
+    }));
+
+    // 单个提交线程连续提交一批任务，边提交边取回完成结果
+    AsyncExecutor executor(app, ASYNC_BENCHMARK_BATCH_SIZE);
+    int batches = std::max(iterations / ASYNC_BENCHMARK_BATCH_SIZE, 1);
+    std::vector<AsyncExecutor::Completion> completed;
+    all_stats.push_back(run_benchmark("async/submit_poll_" + std::to_string(ASYNC_BENCHMARK_BATCH_SIZE), batches, [&]() {
+        completed.clear();
+        for (int i = 0; i < ASYNC_BENCHMARK_BATCH_SIZE; i++) {
+            uint64_t ticket = 0;
+            if (executor.submit(ContractJob(&contract, input), ticket) != APP_SUCCESS) {
+                return false;
+            }
+            executor.poll(completed);
+        }
+        while (completed.size() < static_cast<size_t>(ASYNC_BENCHMARK_BATCH_SIZE)) {
+            executor.poll(completed, 0, 100);
+        }
+        for (const AsyncExecutor::Completion& completion : completed) {
+            if (!completion.result.success) {
+                return false;
+            }
+        }
+        return true;
+    }));
+
+    return all_stats;
+}
+
+std::vector<BenchmarkStats> run_ecall_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return all_stats;
+    }
+
+    // 只有一条OP_HALT的合约：一次ECALL往返加上字节码哈希和缓存查找
+    SmartContract halt(std::vector<uint8_t>{ 0xFF }, "halt");
+    all_stats.push_back(run_benchmark("ecall/execute_halt", iterations, [&]() {
+        ExecutionResult result;
+        return app.execute_contract(halt, {}, result) == APP_SUCCESS;
+    }));
+
+    // 不执行合约的ECALL，作为往返开销的下限
+    all_stats.push_back(run_benchmark("ecall/get_measurement", iterations, [&]() {
+        std::vector<uint8_t> measurement;
+        return app.get_enclave_measurement(measurement) == APP_SUCCESS;
+    }));
+
+    app.destroy_enclave();
+
+    return all_stats;
+}
+
+// 操作码基准的循环次数和每次循环中各指令块的重复次数
+#define OPCODE_BENCHMARK_LOOPS      0x0404
+#define OPCODE_BENCHMARK_REPEAT     8
+
+std::vector<BenchmarkStats> run_opcode_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+
+    // 每个指令块以PUSH开始、以POP或STORE结束，栈深度不变
+    const struct {
+        const char* name;
+        std::vector<uint8_t> block;     // 除PUSH外的指令，PUSH操作数另行插入
+        size_t instructions;
+    } families[] = {
+        // PUSH 1, POP
+        { "opcode/stack", { 0x01, 0x02 }, 2 },
+        // PUSH 9, PUSH 3, ADD, PUSH 2, MUL, PUSH 7, MOD, PUSH 1, SUB, PUSH 3, DIV, POP
+        { "opcode/arith", { 0x01, 0x01, 0x03, 0x01, 0x05, 0x01, 0x07, 0x01, 0x04, 0x01, 0x06, 0x02 }, 12 },
+        // PUSH 9, PUSH 3, XOR, PUSH 5, AND, PUSH 6, OR, NOT, PUSH 2, LT, PUSH 1, EQ, POP
+        { "opcode/logic", { 0x01, 0x01, 0x0A, 0x01, 0x08, 0x01, 0x09, 0x0B, 0x01, 0x0D, 0x01, 0x0C, 0x02 }, 13 },
+        // PUSH 8, PUSH 8, LOAD, STORE
+        { "opcode/memory", { 0x01, 0x01, 0x13, 0x14 }, 4 },
+        // PUSH 0, PUSH 16, HASH, POP
+        { "opcode/hash", { 0x01, 0x01, 0x15, 0x02 }, 4 },
+    };
+    const uint64_t push_values[][6] = {
+        { 1 },
+        { 9, 3, 2, 7, 1, 3 },
+        { 9, 3, 5, 6, 2, 1 },
+        { 8, 8 },
+        { 0, 16 },
+    };
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return all_stats;
+    }
+
+    // 用空循环体的耗时扣除循环本身和ECALL的开销
+    SmartContract baseline = create_loop_contract(OPCODE_BENCHMARK_LOOPS);
+    baseline.gas_limit = 100000000;
+    BenchmarkStats baseline_stats = run_benchmark("opcode/loop_baseline", iterations, [&]() {
+        ExecutionResult result;
+        return app.execute_contract(baseline, {}, result) == APP_SUCCESS;
+    });
+    all_stats.push_back(baseline_stats);
+
+    for (size_t f = 0; f < sizeof(families) / sizeof(families[0]); f++) {
+        std::vector<uint8_t> body;
+        for (int r = 0; r < OPCODE_BENCHMARK_REPEAT; r++) {
+            size_t next_push = 0;
+            for (uint8_t opcode : families[f].block) {
+                if (opcode == 0x01) {
+                    emit_push(body, push_values[f][next_push++]);
+                } else {
+                    body.push_back(opcode);
+                }
+            }
+        }
+
+        SmartContract contract = create_loop_contract(OPCODE_BENCHMARK_LOOPS, body);
+        contract.gas_limit = 100000000;
+        BenchmarkStats stats = run_benchmark(families[f].name, iterations, [&]() {
+            ExecutionResult result;
+            return app.execute_contract(contract, {}, result) == APP_SUCCESS;
+        });
+
+        double instructions = static_cast<double>(OPCODE_BENCHMARK_LOOPS) * OPCODE_BENCHMARK_REPEAT *
+                              static_cast<double>(families[f].instructions);
+        stats.ns_per_op = std::max(0.0, (stats.avg_us - baseline_stats.avg_us) * 1000.0 / instructions);
+        all_stats.push_back(stats);
+    }
+
+    app.destroy_enclave();
+
+    return all_stats;
+}
+
+/**
+ * 写入PUSH的8字节操作数（每个字节不超过0x16，不同的value得到不同的字节码）
+ */
+static void encode_unique_operand(uint8_t* operand, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        operand[i] = static_cast<uint8_t>(value % 0x17);
+        value /= 0x17;
+    }
+}
+
+std::vector<BenchmarkStats> run_code_size_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return all_stats;
+    }
+
+    const size_t sizes[] = { 256, 4096, 65536 };
+    uint64_t unique = 0;
+    for (size_t size : sizes) {
+        // PUSH x, POP, JMP size, OP_NOP填充, HALT：只执行四条指令，验证、解码和哈希覆盖全部字节。
+        // 字节码须以HALT结束，跳转地址的每个字节不超过0x16，因此总长为size + 1
+        std::vector<uint8_t> code;
+        emit_push(code, 0);
+        code.push_back(0x02); // OP_POP
+        code.push_back(0x0F); // OP_JMP
+        for (int i = 0; i < 4; i++) {
+            code.push_back(static_cast<uint8_t>(size >> (i * 8)));
+        }
+        code.resize(size, 0x00);
+        code.push_back(0xFF); // OP_HALT
+        SmartContract contract(code, "padded");
+
+        // 大合约按字节数折算迭代次数
+        int scaled = std::max(10, static_cast<int>(iterations * 256 / size));
+        std::string suffix = "_" + std::to_string(size);
+
+        // 每次修改PUSH操作数，Enclave每次都要验证并解码新的字节码
+        all_stats.push_back(run_benchmark("code/validate_miss" + suffix, scaled, [&]() {
+            encode_unique_operand(contract.bytecode.data() + 1, ++unique);
+            ExecutionResult result;
+            return app.execute_contract(contract, {}, result) == APP_SUCCESS;
+        }));
+
+        // 同一字节码命中缓存，只剩复制和哈希
+        all_stats.push_back(run_benchmark("code/hash_hit" + suffix, scaled, [&]() {
+            ExecutionResult result;
+            return app.execute_contract(contract, {}, result) == APP_SUCCESS;
+        }));
+    }
+
+    app.destroy_enclave();
+
+    return all_stats;
+}
+
+std::vector<BenchmarkStats> run_state_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS || app.configure_state(true) != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return all_stats;
+    }
+
+    // PUSH 0, LOAD, POP, HALT：读取持久化内存，内容不变时不写回
+    std::vector<uint8_t> read_code;
+    emit_push(read_code, 0);
+    read_code.push_back(0x13); // OP_LOAD
+    read_code.push_back(0x02); // OP_POP
+    read_code.push_back(0xFF); // OP_HALT
+    SmartContract reader(read_code, "state_read");
+
+    // mem[0] = mem[0] + 1：每次执行都提交新的内存映像并追加到主机状态日志
+    std::vector<uint8_t> write_code;
+    emit_push(write_code, 0);
+    emit_push(write_code, 0);
+    write_code.push_back(0x13); // OP_LOAD
+    emit_push(write_code, 1);
+    write_code.push_back(0x03); // OP_ADD
+    write_code.push_back(0x14); // OP_STORE
+    write_code.push_back(0xFF); // OP_HALT
+    SmartContract writer(write_code, "state_write");
+
+    // 先执行一次，读合约的状态项进入缓存
+    ExecutionResult seed;
+    app.execute_contract(reader, {}, seed);
+
+    all_stats.push_back(run_benchmark("state/read", iterations, [&]() {
+        ExecutionResult result;
+        return app.execute_contract(reader, {}, result) == APP_SUCCESS;
+    }));
+
+    all_stats.push_back(run_benchmark("state/write", iterations, [&]() {
+        ExecutionResult result;
+        return app.execute_contract(writer, {}, result) == APP_SUCCESS;
+    }));
+
+    app.destroy_enclave();
+
+    return all_stats;
+}
+
+std::vector<BenchmarkStats> run_streaming_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return all_stats;
+    }
+
+    // do { n = INPUT(0, 4096); } while (n != 0)：逐段读完全部输入
+    std::vector<uint8_t> code;
+    uint32_t loop_start = static_cast<uint32_t>(code.size());
+    emit_push(code, 0);
+    emit_push(code, 4096);
+    code.push_back(0x1C); // OP_INPUT
+    code.push_back(0x10); // OP_JMPIF
+    for (int i = 0; i < 4; i++) {
+        code.push_back(static_cast<uint8_t>(loop_start >> (i * 8)));
+    }
+    code.push_back(0xFF); // OP_HALT
+    SmartContract reader(code, "stream_read");
+
+    std::string payload(STREAMING_BENCHMARK_INPUT_SIZE, '\0');
+    for (size_t i = 0; i < payload.size(); i++) {
+        payload[i] = static_cast<char>(i * 31);
+    }
+    std::istringstream input(payload);
+
+    all_stats.push_back(run_benchmark("stream/input_" + std::to_string(STREAMING_BENCHMARK_INPUT_SIZE >> 20) + "MB",
+                                      iterations, [&]() {
+        input.clear();
+        input.seekg(0);
+        ExecutionResult result;
+        return app.execute_streaming(reader, input, result) == APP_SUCCESS;
+    }));
+
+    app.destroy_enclave();
+
+    return all_stats;
+}
+
+// 线程扩展基准中每轮执行的任务数量
+#define SCALING_BENCHMARK_JOBS 256
+
+std::vector<BenchmarkStats> run_scaling_benchmark(int iterations) {
+    std::vector<BenchmarkStats> all_stats;
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return all_stats;
+    }
+
+    // 计算密集的循环合约，每个任务的输入不同
+    SmartContract contract = create_loop_contract(0x0101);
+    std::vector<ContractJob> jobs;
+    for (int i = 0; i < SCALING_BENCHMARK_JOBS; i++) {
+        jobs.push_back(ContractJob(&contract, std::vector<uint8_t>{ static_cast<uint8_t>(i) }));
+    }
+
+    size_t max_threads = SGXSmartContractApp::worker_thread_count(0);
+    int rounds = std::max(iterations / SCALING_BENCHMARK_JOBS, 1);
+    // 线程数按2的幂递增，最后一档为默认的工作线程数
+    std::vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    for (size_t threads : thread_counts) {
+        BenchmarkStats stats = run_benchmark("scaling/threads_" + std::to_string(threads), rounds, [&]() {
+            std::vector<ExecutionResult> results;
+            return app.execute_parallel(jobs, results, threads) == APP_SUCCESS;
+        });
+        all_stats.push_back(per_item_stats(stats, SCALING_BENCHMARK_JOBS));
+    }
+
+    app.destroy_enclave();
+
+    return all_stats;
+}
+
+void print_benchmark_stats(const BenchmarkStats& stats) {
+    std::cout << std::left << std::setw(38) << stats.name << std::right
+              << " 迭代: " << stats.iterations
+              << " 失败: " << stats.failures
+              << std::fixed << std::setprecision(2)
+              << " 平均: " << stats.avg_us << " us"
+              << " p50: " << stats.p50_us << " us"
+              << " p99: " << stats.p99_us << " us"
+              << " 吞吐: " << stats.ops_per_sec << " ops/s";
+    if (stats.ns_per_op > 0) {
+        std::cout << " 单条指令: " << stats.ns_per_op << " ns";
+    }
+    std::cout << std::defaultfloat << std::endl;
+}
+
+bool measure_memory_footprint(int contract_count, enclave_memory_stats_t& stats) {
+    // 地址的每个字节不超过0x16，同时不超过合约内存上限
+    const int max_contracts = 0x17 * 0x10;
+    contract_count = std::min(contract_count, max_contracts);
+
+    std::vector<SmartContract> contracts;
+    for (int i = 0; i < contract_count; i++) {
+        // mem[address] = mem[address] + 1
+        uint64_t address = static_cast<uint64_t>(i % 0x17) | (static_cast<uint64_t>(i / 0x17) << 8);
+        std::vector<uint8_t> code;
+        emit_push(code, address);
+        emit_push(code, address);
+        code.push_back(0x13); // OP_LOAD
+        emit_push(code, 1);
+        code.push_back(0x03); // OP_ADD
+        code.push_back(0x14); // OP_STORE
+        code.push_back(0xFF); // OP_HALT
+        contracts.push_back(SmartContract(code, "counter"));
+    }
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS || app.configure_state(true) != APP_SUCCESS) {
+        print_error("无法创建Enclave");
+        return false;
+    }
+
+    for (const SmartContract& contract : contracts) {
+        ExecutionResult result;
+        if (app.execute_contract(contract, {}, result) != APP_SUCCESS) {
+            return false;
+        }
+    }
+
+    return app.get_memory_stats(stats) == APP_SUCCESS;
+}
+
+/**
+ * 打印一组统计结果并追加到汇总列表
+ */
+static void print_section(const std::string& title, const std::vector<BenchmarkStats>& stats,
+                          std::vector<BenchmarkStats>& all_stats) {
+    std::cout << "\n=== " << title << " ===" << std::endl;
+    for (const BenchmarkStats& entry : stats) {
+        print_benchmark_stats(entry);
+        all_stats.push_back(entry);
+    }
+}
+
+/**
+ * 转义JSON字符串
+ */
+static std::string json_escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+
+bool write_benchmark_json(const std::string& filename, int iterations,
+                          const std::vector<BenchmarkStats>& stats,
+                          const enclave_memory_stats_t* memory) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        print_error("无法写入基准测试结果: " + filename);
+        return false;
+    }
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    file << std::fixed << std::setprecision(3);
+    file << "{\n";
+    file << "  \"version\": 1,\n";
+    file << "  \"timestamp\": " << std::chrono::duration_cast<std::chrono::seconds>(now).count() << ",\n";
+    file << "  \"iterations\": " << iterations << ",\n";
+    file << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    file << "  \"results\": [\n";
+    for (size_t i = 0; i < stats.size(); i++) {
+        const BenchmarkStats& entry = stats[i];
+        file << "    {\"name\": \"" << json_escape(entry.name) << "\""
+             << ", \"iterations\": " << entry.iterations
+             << ", \"failures\": " << entry.failures
+             << ", \"total_us\": " << entry.total_us
+             << ", \"avg_us\": " << entry.avg_us
+             << ", \"p50_us\": " << entry.p50_us
+             << ", \"p99_us\": " << entry.p99_us
+             << ", \"ops_per_sec\": " << entry.ops_per_sec;
+        if (entry.ns_per_op > 0) {
+            file << ", \"ns_per_op\": " << entry.ns_per_op;
+        }
+        file << "}" << (i + 1 < stats.size() ? "," : "") << "\n";
+    }
+    file << "  ]";
+    if (memory) {
+        file << ",\n  \"memory\": {"
+             << "\"context_bytes\": " << memory->context_bytes
+             << ", \"slot_bytes\": " << memory->slot_bytes
+             << ", \"slot_count\": " << memory->slot_count
+             << ", \"memory_pages\": " << memory->memory_pages
+             << ", \"state_entries\": " << memory->state_entries
+             << ", \"state_bytes\": " << memory->state_bytes
+             << ", \"slab_bytes_reserved\": " << memory->slab_bytes_reserved
+             << ", \"slab_bytes_in_use\": " << memory->slab_bytes_in_use << "}";
+    }
+    file << "\n}\n";
+
+    return file.good();
+}
+
+void run_benchmark_test(int iterations, const std::string& json_file) {
+    std::vector<BenchmarkStats> all_stats;
+
+    std::vector<BenchmarkStats> switchless_stats = run_switchless_benchmark(iterations);
+    print_section("普通模式与免切换模式对比", switchless_stats, all_stats);
+
+    // 按测试项比较两种模式
+    size_t half = switchless_stats.size() / 2;
+    if (switchless_stats.size() == half * 2) {
+        for (size_t i = 0; i < half; i++) {
+            const BenchmarkStats& regular = switchless_stats[i];
+            const BenchmarkStats& switchless = switchless_stats[i + half];
+            if (switchless.avg_us > 0) {
+                std::cout << "加速比 " << regular.name.substr(regular.name.find('/') + 1) << ": "
+                          << std::fixed << std::setprecision(2)
+                          << regular.avg_us / switchless.avg_us << "x"
+                          << std::defaultfloat << std::endl;
+            }
+        }
+    }
+
+    print_section("ECALL往返", run_ecall_benchmark(iterations), all_stats);
+
+    // 每次执行数千条指令，迭代次数相应减少
+    print_section("操作码耗时", run_opcode_benchmark(std::max(iterations / 100, 10)), all_stats);
+
+    print_section("执行后端对比", run_backend_benchmark(iterations), all_stats);
+
+    print_section("字节码验证与哈希", run_code_size_benchmark(iterations), all_stats);
+
+    std::vector<BenchmarkStats> proof_stats = run_proof_benchmark(iterations);
+    print_section("执行证明", proof_stats, all_stats);
+    if (proof_stats.size() >= 2) {
+        std::cout << "批量证明平均每条: " << std::fixed << std::setprecision(2)
+                  << proof_stats[1].avg_us / PROOF_BENCHMARK_BATCH_SIZE << " us（含执行）"
+                  << std::defaultfloat << std::endl;
+    }
+    if (proof_stats.size() >= 6) {
+        std::cout << "批量验证平均每条: ECALL " << std::fixed << std::setprecision(2)
+                  << proof_stats[4].avg_us / PROOF_BENCHMARK_BATCH_SIZE << " us, 主机并行 "
+                  << proof_stats[5].avg_us / PROOF_BENCHMARK_BATCH_SIZE << " us"
+                  << std::defaultfloat << std::endl;
+    }
+
+    print_section("状态读写", run_state_benchmark(iterations), all_stats);
+
+    // 每次执行读取整个流式输入，迭代次数相应减少
+    std::vector<BenchmarkStats> streaming_stats = run_streaming_benchmark(std::max(iterations / 10, 5));
+    print_section("流式输入", streaming_stats, all_stats);
+    if (!streaming_stats.empty() && streaming_stats[0].avg_us > 0) {
+        std::cout << "流式输入吞吐: " << std::fixed << std::setprecision(2)
+                  << STREAMING_BENCHMARK_INPUT_SIZE / streaming_stats[0].avg_us << " MB/s"
+                  << std::defaultfloat << std::endl;
+    }
+
+    std::vector<BenchmarkStats> async_stats = run_async_benchmark(iterations);
+    print_section("异步提交", async_stats, all_stats);
+    if (async_stats.size() >= 2) {
+        std::cout << "异步提交平均每条: " << std::fixed << std::setprecision(2)
+                  << async_stats[1].avg_us / ASYNC_BENCHMARK_BATCH_SIZE << " us（"
+                  << SGXSmartContractApp::worker_thread_count(0) << " 个调度线程）"
+                  << std::defaultfloat << std::endl;
+    }
+
+    print_section("多线程扩展（每个任务）", run_scaling_benchmark(iterations), all_stats);
+
+    std::cout << "\n=== Enclave内存占用 ===" << std::endl;
+    enclave_memory_stats_t memory;
+    bool memory_ok = measure_memory_footprint(256, memory);
+    if (memory_ok) {
+        std::cout << "执行上下文: " << memory.context_bytes << " 字节/个（另持有 "
+                  << memory.memory_pages << " 个 " << memory.memory_page_size << " 字节内存页）" << std::endl;
+        std::cout << "执行槽: " << memory.slot_count << " 个 x " << memory.slot_bytes << " 字节" << std::endl;
+        std::cout << "状态缓存: " << memory.state_entries << " 项, " << memory.state_bytes << " 字节";
+        if (memory.state_entries > 0) {
+            std::cout << "（平均 " << memory.state_bytes / memory.state_entries << " 字节/项）";
+        }
+        std::cout << ", 预算 " << memory.state_budget << " 字节" << std::endl;
+        std::cout << "小对象分配器: 已分配 " << memory.slab_bytes_in_use << " / 保留 "
+                  << memory.slab_bytes_reserved << " 字节" << std::endl;
+    }
+
+    if (!json_file.empty() && write_benchmark_json(json_file, iterations, all_stats, memory_ok ? &memory : nullptr)) {
+        print_success("基准测试结果已写入 " + json_file);
+    }
+}
@@ -0,0 +1,154 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "app.h"
+
+#include <string>
+#include <vector>
+#include <functional>
+
+/**
+ * 基准测试统计
+ */
+struct BenchmarkStats {
+    std::string name;
+    uint64_t iterations;
+    uint64_t failures;
+    double total_us;
+    double avg_us;
+    double p50_us;
+    double p99_us;
+    double ops_per_sec;
+    double ns_per_op;           // 单条指令耗时（仅操作码基准，其余为0）
+
+    BenchmarkStats()
+        : iterations(0), failures(0), total_us(0), avg_us(0), p50_us(0), p99_us(0),
+          ops_per_sec(0), ns_per_op(0) {}
+};
+
+/**
+ * 重复执行操作并统计耗时
+ * @param name 测试名称
+ * @param iterations 迭代次数
+ * @param operation 单次操作，返回是否成功
+ * @return 统计结果
+ */
+BenchmarkStats run_benchmark(const std::string& name, int iterations,
+                             const std::function<bool()>& operation);
+
+/**
+ * 把每次迭代处理一批的统计折算为单项统计
+ * @param stats 按批次统计的结果
+ * @param items 每批的项数
+ * @return 折算后的统计（迭代次数、耗时、分位数和吞吐均按单项计）
+ */
+BenchmarkStats per_item_stats(const BenchmarkStats& stats, uint64_t items);
+
+/**
+ * 测量ECALL往返开销：只有OP_HALT的合约执行和不执行合约的度量值查询
+ * @param iterations 迭代次数
+ * @return 统计结果（依次为空合约执行和度量值查询）
+ */
+std::vector<BenchmarkStats> run_ecall_benchmark(int iterations);
+
+/**
+ * 按操作码类别（栈、算术、逻辑、内存、哈希）测量当前执行后端的单条指令耗时
+ * @param iterations 每个类别的执行次数
+ * @return 统计结果（首项为空循环基准，其余各项的ns_per_op已扣除循环开销）
+ */
+std::vector<BenchmarkStats> run_opcode_benchmark(int iterations);
+
+/**
+ * 按字节码大小测量验证解码（缓存未命中）和复制哈希（缓存命中）的开销
+ * @param iterations 256字节合约的迭代次数（更大的合约按字节数折算）
+ * @return 统计结果（每种大小依次为未命中和命中）
+ */
+std::vector<BenchmarkStats> run_code_size_benchmark(int iterations);
+
+/**
+ * 启用状态持久化后测量只读和写回合约内存的执行延迟
+ * @param iterations 迭代次数
+ * @return 统计结果（依次为读取和写入）
+ */
+std::vector<BenchmarkStats> run_state_benchmark(int iterations);
+
+// 流式输入基准每次执行的输入大小
+#define STREAMING_BENCHMARK_INPUT_SIZE (4 * 1024 * 1024)
+
+/**
+ * 经execute_streaming把STREAMING_BENCHMARK_INPUT_SIZE字节的输入分块送入只做OP_INPUT的合约
+ * @param iterations 迭代次数
+ * @return 统计结果
+ */
+std::vector<BenchmarkStats> run_streaming_benchmark(int iterations);
+
+/**
+ * 以不同线程数经execute_parallel执行同一组任务，衡量多TCS扩展
+ * @param iterations 任务总数（按每轮的任务数折算为轮数）
+ * @return 按单个任务折算的统计结果（线程数从1按2的幂递增到默认工作线程数）
+ */
+std::vector<BenchmarkStats> run_scaling_benchmark(int iterations);
+
+/**
+ * 对比普通模式与免切换模式下的合约执行和审计日志路径
+ * @param iterations 每项测试的迭代次数
+ * @return 统计结果（依次为普通模式和免切换模式）
+ */
+std::vector<BenchmarkStats> run_switchless_benchmark(int iterations);
+
+/**
+ * 创建以内存计数器循环的合约，用于衡量解释器分派开销
+ * @param count 循环次数（每个字节不超过0x16）
+ * @param body 每次循环先执行的指令（不得改变栈深度、不得写入mem[0..7]）
+ * @return 合约
+ */
+SmartContract create_loop_contract(uint64_t count, const std::vector<uint8_t>& body = std::vector<uint8_t>());
+
+/**
+ * 对比各执行后端的合约执行耗时，并校验执行哈希一致
+ * @param iterations 每个后端的迭代次数
+ * @return 统计结果（依次为字节码解释器、解码执行、线程化分派和JIT）
+ */
+std::vector<BenchmarkStats> run_backend_benchmark(int iterations);
+
+/**
+ * 对比逐条签名和Merkle批量签名的证明生成耗时，以及逐条、批量ECALL和主机并行的证明验证耗时
+ * @param iterations 单条操作的迭代次数（批量操作按批次数折算）
+ * @return 统计结果（依次为单条证明、批量证明、批量证明单项验证、单条验证、批量ECALL验证和主机并行验证）
+ */
+std::vector<BenchmarkStats> run_proof_benchmark(int iterations);
+
+/**
+ * 对比同步execute_contract与单个线程经AsyncExecutor连续提交、轮询取回的吞吐
+ * @param iterations 同步执行的迭代次数（异步按每轮ASYNC_BENCHMARK_BATCH_SIZE个任务折算）
+ * @return 统计结果（依次为同步执行和异步提交）
+ */
+std::vector<BenchmarkStats> run_async_benchmark(int iterations);
+
+/**
+ * 启用状态持久化后执行一组各自写入不同地址的计数器合约，读取Enclave内存占用统计
+ * @param contract_count 合约数量（每个合约占用一个状态项，最多368个）
+ * @param stats 输出统计
+ * @return 是否成功
+ */
+bool measure_memory_footprint(int contract_count, enclave_memory_stats_t& stats);
+
+/**
+ * 打印统计结果
+ * @param stats 统计结果
+ */
+void print_benchmark_stats(const BenchmarkStats& stats);
+
+/**
+ * 以JSON格式写入基准测试结果，用于跨版本的回归比较
+ * @param filename 输出文件
+ * @param iterations 基准测试的迭代次数
+ * @param stats 统计结果
+ * @param memory Enclave内存占用（可为nullptr）
+ * @return 是否成功
+ */
+bool write_benchmark_json(const std::string& filename, int iterations,
+                          const std::vector<BenchmarkStats>& stats,
+                          const enclave_memory_stats_t* memory);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,104 @@
+#include "config_watcher.h"
+#include "app_utils.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+ConfigWatcher::ConfigWatcher(const std::string& path, std::function<void()> callback)
+    : on_change(std::move(callback)), inotify_fd(-1), stop_fd(-1) {
+    size_t slash = path.find_last_of('/');
+    directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    file_name = slash == std::string::npos ? path : path.substr(slash + 1);
+    
+    // 监视目录而不是文件本身：文件被重命名替换后原来的监视会失效
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd < 0 || stop_fd < 0 ||
+        inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        Logger::warning("无法监视配置文件: " + path + " (" + strerror(errno) + ")");
+        return;
+    }
+    
+    watcher = std::thread(&ConfigWatcher::watch_loop, this);
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    if (watcher.joinable()) {
+        uint64_t one = 1;
+        ssize_t written = write(stop_fd, &one, sizeof(one));
+        (void)written;
+        watcher.join();
+    }
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+    }
+    if (stop_fd >= 0) {
+        close(stop_fd);
+    }
+}
+
+/**
+ * 读出所有待处理的inotify事件
+ * @return 是否有关于配置文件的事件
+ */
+static bool drain_events(int fd, const std::string& file_name) {
+    alignas(struct inotify_event) char buffer[4096];
+    bool matched = false;
+    
+    while (true) {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return matched;
+        }
+        for (char* p = buffer; p < buffer + length;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            if (event->len > 0 && file_name == event->name) {
+                matched = true;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+/**
+ * 等待配置文件变化并在写入平息后返回
+ * @return false表示监视线程应当退出
+ */
+bool ConfigWatcher::wait_for_change() {
+    struct pollfd fds[2] = { { inotify_fd, POLLIN, 0 }, { stop_fd, POLLIN, 0 } };
+    bool changed = false;
+    
+    while (true) {
+        // 收到事件后只再等待一个平息周期，期间的新事件重新计时
+        int ready = poll(fds, 2, changed ? CONFIG_WATCH_SETTLE_MS : -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (fds[1].revents) {
+            return false;
+        }
+        if (ready == 0) {
+            return true;
+        }
+        if (drain_events(inotify_fd, file_name)) {
+            changed = true;
+        }
+    }
+}
+
+void ConfigWatcher::watch_loop() {
+    while (wait_for_change()) {
+        // 解析失败时保留原有配置，等待下一次修改
+        if (Config::reload()) {
+            Logger::info("Configuration reloaded from " + Config::file_path());
+            on_change();
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef CONFIG_WATCHER_H
+#define CONFIG_WATCHER_H
+
+#include <functional>
+#include <string>
+#include <thread>
+
+// 文件变化后等待写入平息的毫秒数，编辑器保存时常产生多个事件
+#define CONFIG_WATCH_SETTLE_MS 100
+
+/**
+ * 配置文件监视线程：通过inotify监视配置文件所在目录，文件被写入或替换
+ * （编辑器通常先写临时文件再重命名）后调用Config::reload，成功时回调on_change。
+ * 回调在监视线程中执行
+ */
+class ConfigWatcher {
+private:
+    std::string directory;
+    std::string file_name;
+    std::function<void()> on_change;
+    int inotify_fd;
+    int stop_fd;                            // eventfd，析构时唤醒监视线程
+    std::thread watcher;
+
+    void watch_loop();
+    bool wait_for_change();
+
+public:
+    /**
+     * 开始监视
+     * @param path 配置文件路径
+     * @param callback 重新加载成功后的回调
+     */
+    ConfigWatcher(const std::string& path, std::function<void()> callback);
+
+    /**
+     * 停止监视线程
+     */
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    /**
+     * 监视是否已启动（inotify不可用时为false）
+     * @return 是否已启动
+     */
+    bool is_active() const { return watcher.joinable(); }
+};
+
+#endif // CONFIG_WATCHER_H
@@ -0,0 +1,252 @@
+#include "contract_repository.h"
+#include "app_utils.h"
+#include "enclave_shared.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+size_t align_up(size_t size) {
+    return (size + CONTRACT_REPO_ALIGN - 1) & ~static_cast<size_t>(CONTRACT_REPO_ALIGN - 1);
+}
+
+bool range_in_file(uint64_t offset, uint64_t size, size_t file_size) {
+    return offset <= file_size && size <= file_size - offset;
+}
+
+bool write_fully(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * 检查文件头和索引（索引须按哈希严格升序，条目位于文件内）
+ */
+bool validate_layout(const uint8_t* data, size_t size) {
+    if (size < sizeof(contract_repo_header_t)) {
+        return false;
+    }
+
+    contract_repo_header_t header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, CONTRACT_REPO_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CONTRACT_REPO_VERSION || header.file_size != size ||
+        header.entry_count > CONTRACT_REPO_MAX_ENTRIES || header.index_offset < sizeof(header) ||
+        header.index_offset % CONTRACT_REPO_ALIGN != 0 ||
+        !range_in_file(header.index_offset,
+                       static_cast<uint64_t>(header.entry_count) * sizeof(contract_repo_index_t), size)) {
+        return false;
+    }
+
+    const contract_repo_index_t* index = reinterpret_cast<const contract_repo_index_t*>(data + header.index_offset);
+    for (uint32_t i = 0; i < header.entry_count; i++) {
+        const contract_repo_index_t& entry = index[i];
+        if (!range_in_file(entry.meta_offset, entry.meta_size, size) ||
+            !range_in_file(entry.code_offset, entry.code_size, size)) {
+            return false;
+        }
+        if (i > 0 && memcmp(index[i - 1].code_hash, entry.code_hash, sizeof(entry.code_hash)) >= 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+ContractRepository::ContractRepository(const std::string& repository_path)
+    : path(repository_path), data(nullptr), size(0), index(nullptr), count(0) {
+    if (AppUtils::file_exists(path) && !map_file()) {
+        Logger::warning("合约仓库无效，已忽略: " + path);
+    }
+}
+
+ContractRepository::~ContractRepository() {
+    unmap();
+}
+
+bool ContractRepository::map_file() {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(contract_repo_header_t))) {
+        close(fd);
+        return false;
+    }
+
+    // 映射建立后即可关闭文件；仓库被替换时旧文件在解除映射前仍然有效
+    size_t file_size = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapped);
+    if (!validate_layout(bytes, file_size)) {
+        munmap(mapped, file_size);
+        return false;
+    }
+
+    contract_repo_header_t header;
+    memcpy(&header, bytes, sizeof(header));
+    data = bytes;
+    size = file_size;
+    index = reinterpret_cast<const contract_repo_index_t*>(bytes + header.index_offset);
+    count = header.entry_count;
+    return true;
+}
+
+void ContractRepository::unmap() {
+    if (data) {
+        munmap(const_cast<uint8_t*>(data), size);
+        data = nullptr;
+        size = 0;
+        index = nullptr;
+        count = 0;
+    }
+}
+
+bool ContractRepository::find(const uint8_t* code_hash, const uint8_t** code, size_t* code_size) const {
+    if (!data || !code_hash) {
+        return false;
+    }
+
+    const contract_repo_index_t* end = index + count;
+    const contract_repo_index_t* found = std::lower_bound(index, end, code_hash,
+        [](const contract_repo_index_t& entry, const uint8_t* hash) {
+            return memcmp(entry.code_hash, hash, sizeof(entry.code_hash)) < 0;
+        });
+    if (found == end || memcmp(found->code_hash, code_hash, sizeof(found->code_hash)) != 0) {
+        return false;
+    }
+
+    if (code) {
+        *code = data + found->code_offset;
+    }
+    if (code_size) {
+        *code_size = found->code_size;
+    }
+    return true;
+}
+
+bool ContractRepository::load(const std::vector<uint8_t>& code_hash, SmartContract& contract) const {
+    const uint8_t* code = nullptr;
+    size_t code_size = 0;
+    if (code_hash.size() != sizeof(index->code_hash) || !find(code_hash.data(), &code, &code_size)) {
+        return false;
+    }
+
+    contract.bytecode.assign(code, code + code_size);
+    contract.name = AppUtils::to_hex_string(code_hash);
+    return true;
+}
+
+void ContractRepository::read_entries(std::vector<Entry>& entries) const {
+    entries.clear();
+    entries.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const contract_repo_index_t& item = index[i];
+        Entry entry;
+        entry.code_hash.assign(item.code_hash, item.code_hash + sizeof(item.code_hash));
+        entry.sealed_meta.assign(data + item.meta_offset, data + item.meta_offset + item.meta_size);
+        entry.bytecode.assign(data + item.code_offset, data + item.code_offset + item.code_size);
+        entries.push_back(std::move(entry));
+    }
+}
+
+app_status_t ContractRepository::write(const std::string& repository_path, std::vector<Entry> entries) {
+    for (const Entry& entry : entries) {
+        if (entry.code_hash.size() != sizeof(contract_repo_index_t::code_hash) ||
+            entry.sealed_meta.size() > CONTRACT_REPO_MAX_META_SIZE || entry.bytecode.empty()) {
+            return APP_ERROR_INVALID_PARAM;
+        }
+    }
+
+    // 稳定排序后去重，哈希相同时保留后出现的条目
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.code_hash < b.code_hash;
+    });
+    std::vector<Entry> unique;
+    unique.reserve(entries.size());
+    for (Entry& entry : entries) {
+        if (!unique.empty() && unique.back().code_hash == entry.code_hash) {
+            unique.back() = std::move(entry);
+        } else {
+            unique.push_back(std::move(entry));
+        }
+    }
+    if (unique.size() > CONTRACT_REPO_MAX_ENTRIES) {
+        return APP_ERROR_INVALID_PARAM;
+    }
+
+    std::vector<uint8_t> file(sizeof(contract_repo_header_t), 0);
+    std::vector<contract_repo_index_t> file_index(unique.size());
+    for (size_t i = 0; i < unique.size(); i++) {
+        const Entry& entry = unique[i];
+        contract_repo_index_t& item = file_index[i];
+        memset(&item, 0, sizeof(item));
+        memcpy(item.code_hash, entry.code_hash.data(), sizeof(item.code_hash));
+
+        item.meta_offset = file.size();
+        item.meta_size = static_cast<uint32_t>(entry.sealed_meta.size());
+        file.insert(file.end(), entry.sealed_meta.begin(), entry.sealed_meta.end());
+        file.resize(align_up(file.size()), 0);
+
+        item.code_offset = file.size();
+        item.code_size = static_cast<uint32_t>(entry.bytecode.size());
+        file.insert(file.end(), entry.bytecode.begin(), entry.bytecode.end());
+        file.resize(align_up(file.size()), 0);
+    }
+
+    contract_repo_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CONTRACT_REPO_MAGIC, sizeof(header.magic));
+    header.version = CONTRACT_REPO_VERSION;
+    header.entry_count = static_cast<uint32_t>(file_index.size());
+    header.index_offset = file.size();
+    header.file_size = file.size() + file_index.size() * sizeof(contract_repo_index_t);
+
+    const uint8_t* index_bytes = reinterpret_cast<const uint8_t*>(file_index.data());
+    file.insert(file.end(), index_bytes, index_bytes + file_index.size() * sizeof(contract_repo_index_t));
+    memcpy(file.data(), &header, sizeof(header));
+
+    std::filesystem::path parent = std::filesystem::path(repository_path).parent_path();
+    if (!parent.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(parent, ec);
+    }
+
+    const std::string temp_path = repository_path + ".tmp";
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return APP_ERROR_FILE_IO;
+    }
+
+    bool ok = write_fully(fd, file.data(), file.size()) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok && rename(temp_path.c_str(), repository_path.c_str()) == 0;
+    if (!ok) {
+        unlink(temp_path.c_str());
+        return APP_ERROR_FILE_IO;
+    }
+
+    return APP_SUCCESS;
+}
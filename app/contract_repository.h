@@ -0,0 +1,85 @@
+#ifndef CONTRACT_REPOSITORY_H
+#define CONTRACT_REPOSITORY_H
+
+#include "app.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * 合约仓库：所有合约的字节码和密封元数据打包在一个只读文件中（格式见enclave_shared.h），
+ * 打开时整体映射，按字节码哈希二分查找，读取不复制也不经过流。
+ * 映射后的输出可直接交给ecall_warm_code_cache一次预热字节码缓存。
+ * 写入总是生成新文件后原子替换，已打开的映射不受影响。打开后只读，所有接口均为线程安全
+ */
+class ContractRepository {
+public:
+    // 写入仓库的条目
+    struct Entry {
+        std::vector<uint8_t> code_hash;     // 字节码哈希（32字节）
+        std::vector<uint8_t> sealed_meta;   // ecall_seal_contract_metadata输出的密封元数据
+        std::vector<uint8_t> bytecode;      // 字节码
+    };
+
+private:
+    std::string path;
+    const uint8_t* data;
+    size_t size;
+    const contract_repo_index_t* index;
+    uint32_t count;
+
+    bool map_file();
+    void unmap();
+
+public:
+    /**
+     * 打开并映射仓库文件，文件不存在或格式无效时is_open()为false
+     * @param repository_path 仓库文件路径
+     */
+    explicit ContractRepository(const std::string& repository_path);
+    ~ContractRepository();
+
+    ContractRepository(const ContractRepository&) = delete;
+    ContractRepository& operator=(const ContractRepository&) = delete;
+
+    bool is_open() const { return data != nullptr; }
+    const std::string& file_path() const { return path; }
+    const uint8_t* mapped_data() const { return data; }
+    size_t mapped_size() const { return size; }
+    size_t entry_count() const { return count; }
+
+    /**
+     * 按字节码哈希查找合约
+     * @param code_hash 字节码哈希（32字节）
+     * @param code 输出指向映射内字节码的指针（仓库对象销毁前有效）
+     * @param code_size 输出字节码大小
+     * @return 是否找到
+     */
+    bool find(const uint8_t* code_hash, const uint8_t** code, size_t* code_size) const;
+
+    /**
+     * 按字节码哈希加载合约（复制字节码）
+     * @param code_hash 字节码哈希
+     * @param contract 输出合约
+     * @return 是否找到
+     */
+    bool load(const std::vector<uint8_t>& code_hash, SmartContract& contract) const;
+
+    /**
+     * 复制出所有条目（用于与新合约合并后重写仓库）
+     * @param entries 输出条目
+     */
+    void read_entries(std::vector<Entry>& entries) const;
+
+    /**
+     * 写入仓库文件：按哈希排序，哈希相同的条目保留后出现的一个，先写临时文件再原子替换
+     * @param repository_path 仓库文件路径
+     * @param entries 条目
+     * @return 应用状态码
+     */
+    static app_status_t write(const std::string& repository_path, std::vector<Entry> entries);
+};
+
+#endif // CONTRACT_REPOSITORY_H
@@ -0,0 +1,1086 @@
+#include "enclave_dispatcher.h"
+#include "app_utils.h"
+#include "enclave_shared.h"
+
+#include <openssl/sha.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <map>
+#include <set>
+
+// ---------------------------------------------------------------------------
+// NUMA拓扑
+// ---------------------------------------------------------------------------
+
+/**
+ * 解析内核的CPU列表格式（如"0-3,8-11"）
+ */
+static std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t comma = text.find(',', pos);
+        std::string range = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        if (!range.empty() && range[0] >= '0' && range[0] <= '9') {
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    return cpus;
+}
+
+static bool read_line(const std::string& path, std::string& line) {
+    std::ifstream file(path);
+    return file.is_open() && std::getline(file, line);
+}
+
+/**
+ * 当前进程亲和性掩码内的CPU（容器和taskset限制的CPU不会出现在结果中）
+ */
+static std::set<int> allowed_cpus() {
+    std::set<int> cpus;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &cpu_set)) {
+                cpus.insert(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+std::vector<NumaNode> detect_numa_nodes() {
+    std::set<int> allowed = allowed_cpus();
+    std::map<int, std::vector<int>> grouped;
+
+    // 优先使用NUMA节点
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (dir) {
+        while (struct dirent* entry = readdir(dir)) {
+            int id = -1;
+            char tail = 0;
+            if (sscanf(entry->d_name, "node%d%c", &id, &tail) != 1) {
+                continue;
+            }
+            std::string line;
+            if (!read_line("/sys/devices/system/node/" + std::string(entry->d_name) + "/cpulist", line)) {
+                continue;
+            }
+            for (int cpu : parse_cpu_list(line)) {
+                if (allowed.count(cpu)) {
+                    grouped[id].push_back(cpu);
+                }
+            }
+        }
+        closedir(dir);
+    }
+
+    // 内核未启用NUMA时按CPU插槽分组
+    if (grouped.empty()) {
+        for (int cpu : allowed) {
+            std::string line;
+            if (read_line("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/physical_package_id", line)) {
+                grouped[std::atoi(line.c_str())].push_back(cpu);
+            }
+        }
+    }
+
+    std::vector<NumaNode> nodes;
+    for (auto& item : grouped) {
+        if (!item.second.empty()) {
+            std::sort(item.second.begin(), item.second.end());
+            nodes.push_back({ item.first, item.second });
+        }
+    }
+    if (nodes.empty()) {
+        nodes.push_back({ 0, std::vector<int>(allowed.begin(), allowed.end()) });
+    }
+    return nodes;
+}
+
+/**
+ * 把调用线程绑定到给定CPU
+ */
+static bool bind_current_thread(const std::vector<int>& cpus) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    return CPU_COUNT(&cpu_set) > 0 &&
+           pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// 协议辅助函数
+// ---------------------------------------------------------------------------
+
+static size_t align_record(size_t size) {
+    return (size + BATCH_RECORD_ALIGN - 1) & ~(size_t)(BATCH_RECORD_ALIGN - 1);
+}
+
+static bool send_all(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+static bool recv_all(int fd, uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+/**
+ * 设置收发超时（performance.timeout_seconds），对端停止响应时连接线程不会一直阻塞
+ */
+static void configure_socket(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct timeval timeout;
+    timeout.tv_sec = std::max(Config::get_int("performance.timeout_seconds", 30), 1);
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+static bool valid_frame(const DispatchFrameHeader& header) {
+    return header.magic == DISPATCH_PROTOCOL_MAGIC && header.version == DISPATCH_PROTOCOL_VERSION &&
+           header.job_count <= BATCH_MAX_JOBS && header.payload_size <= DISPATCH_MAX_FRAME_SIZE;
+}
+
+/**
+ * 在响应末尾追加一条结果记录（proof为空时不附带证明）
+ */
+static void append_result_record(std::vector<uint8_t>& response, const ExecutionResult& result,
+                                 const ExecutionProof& proof) {
+    DispatchResultRecord record;
+    memset(&record, 0, sizeof(record));
+    record.success = result.success ? 1 : 0;
+    record.output_size = static_cast<uint32_t>(result.output.size());
+    record.error_size = static_cast<uint32_t>(result.error_message.size());
+    if (proof.proof_data.size() == EXECUTION_PROOF_SIZE) {
+        record.proof_size = EXECUTION_PROOF_SIZE;
+        record.path_size = static_cast<uint32_t>(proof.merkle_path.size());
+        record.leaf_index = proof.leaf_index;
+        record.leaf_count = proof.leaf_count;
+    }
+    record.gas_used = result.gas_used;
+    if (result.code_hash.size() == sizeof(record.code_hash)) {
+        memcpy(record.code_hash, result.code_hash.data(), sizeof(record.code_hash));
+    }
+    if (result.execution_hash.size() == sizeof(record.execution_hash)) {
+        memcpy(record.execution_hash, result.execution_hash.data(), sizeof(record.execution_hash));
+    }
+
+    size_t data_size = result.output.size() + result.error_message.size() + record.proof_size + record.path_size;
+    size_t offset = response.size();
+    response.resize(offset + align_record(sizeof(record) + data_size), 0);
+    uint8_t* out = response.data() + offset;
+    memcpy(out, &record, sizeof(record));
+    out += sizeof(record);
+    if (!result.output.empty()) {
+        memcpy(out, result.output.data(), result.output.size());
+        out += result.output.size();
+    }
+    if (!result.error_message.empty()) {
+        memcpy(out, result.error_message.data(), result.error_message.size());
+        out += result.error_message.size();
+    }
+    if (record.proof_size > 0) {
+        memcpy(out, proof.proof_data.data(), record.proof_size);
+        out += record.proof_size;
+        if (record.path_size > 0) {
+            memcpy(out, proof.merkle_path.data(), record.path_size);
+        }
+    }
+}
+
+/**
+ * 读取一条结果记录及其证明
+ * @return false表示记录越界或证明字段格式错误
+ */
+static bool read_result_record(const std::vector<uint8_t>& response, size_t& offset, ExecutionResult& result,
+                               ExecutionProof& proof) {
+    DispatchResultRecord record;
+    if (response.size() - offset < sizeof(record)) {
+        return false;
+    }
+    memcpy(&record, response.data() + offset, sizeof(record));
+    if ((record.proof_size != 0 && record.proof_size != EXECUTION_PROOF_SIZE) ||
+        record.path_size % 32 != 0 || record.path_size > 32 * MERKLE_MAX_DEPTH) {
+        return false;
+    }
+
+    size_t data_size = static_cast<size_t>(record.output_size) + record.error_size +
+                       record.proof_size + record.path_size;
+    size_t record_size = align_record(sizeof(record) + data_size);
+    if (record_size > response.size() - offset) {
+        return false;
+    }
+
+    const uint8_t* data = response.data() + offset + sizeof(record);
+    result.success = record.success != 0;
+    result.gas_used = record.gas_used;
+    result.output.assign(data, data + record.output_size);
+    data += record.output_size;
+    result.error_message.assign(reinterpret_cast<const char*>(data), record.error_size);
+    data += record.error_size;
+    result.code_hash.assign(record.code_hash, record.code_hash + sizeof(record.code_hash));
+    if (result.success) {
+        result.execution_hash.assign(record.execution_hash, record.execution_hash + sizeof(record.execution_hash));
+    } else {
+        result.execution_hash.clear();
+    }
+
+    proof = ExecutionProof();
+    if (record.proof_size > 0) {
+        proof.proof_data.assign(data, data + record.proof_size);
+        proof.signature.assign(data + record.proof_size - 64, data + record.proof_size);
+        proof.merkle_path.assign(data + record.proof_size, data + record.proof_size + record.path_size);
+        proof.leaf_index = record.leaf_index;
+        proof.leaf_count = record.leaf_count;
+    }
+
+    offset += record_size;
+    return true;
+}
+
+/**
+ * 由任务重新计算执行哈希（与Enclave的compute_execution_hash相同）：
+ * SHA256(字节码哈希 | 输入哈希（输入为空时省略） | 输出 | Gas使用量)
+ */
+static std::vector<uint8_t> expected_execution_hash(const ContractJob& job, const ExecutionResult& result) {
+    std::vector<uint8_t> message(SHA256_DIGEST_LENGTH);
+    SHA256(job.contract->bytecode.data(), job.contract->bytecode.size(), message.data());
+    if (!job.input_data.empty()) {
+        size_t offset = message.size();
+        message.resize(offset + SHA256_DIGEST_LENGTH);
+        SHA256(job.input_data.data(), job.input_data.size(), message.data() + offset);
+    }
+    message.insert(message.end(), result.output.begin(), result.output.end());
+    const uint8_t* gas = reinterpret_cast<const uint8_t*>(&result.gas_used);
+    message.insert(message.end(), gas, gas + sizeof(result.gas_used));
+
+    std::vector<uint8_t> hash(SHA256_DIGEST_LENGTH);
+    SHA256(message.data(), message.size(), hash.data());
+    return hash;
+}
+
+static void reject_result(ExecutionResult& result, const std::string& message) {
+    result.success = false;
+    result.output.clear();
+    result.execution_hash.clear();
+    result.error_message = message;
+}
+
+static void fail_jobs(const std::vector<size_t>& indices, size_t begin, size_t end,
+                      std::vector<ExecutionResult>& results, const std::string& message) {
+    for (size_t i = begin; i < end; i++) {
+        results[indices[i]].success = false;
+        results[indices[i]].error_message = message;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// RemoteNode
+// ---------------------------------------------------------------------------
+
+RemoteNode::RemoteNode(const std::string& remote_host, uint16_t remote_port, size_t connection_limit)
+    : host(remote_host), port(remote_port), max_connections(std::max<size_t>(connection_limit, 1)), open_count(0) {
+}
+
+RemoteNode::~RemoteNode() {
+    // 析构时所有请求都已返回，只剩空闲连接
+    for (int fd : idle) {
+        close(fd);
+    }
+}
+
+/**
+ * 取出空闲连接，没有时在上限内新建，已达上限时等待其他请求归还
+ * @return 连接（-1表示无法连接）
+ */
+int RemoteNode::acquire() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        connection_available.wait(lock, [this]() { return !idle.empty() || open_count < max_connections; });
+        if (!idle.empty()) {
+            int fd = idle.back();
+            idle.pop_back();
+            return fd;
+        }
+        open_count++;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addresses = nullptr;
+    int fd = -1;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) == 0) {
+        for (struct addrinfo* address = addresses; address && fd < 0; address = address->ai_next) {
+            fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+            if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(addresses);
+    }
+
+    if (fd < 0) {
+        release(-1, false);
+        return -1;
+    }
+    configure_socket(fd);
+    return fd;
+}
+
+/**
+ * 归还连接，出错的连接直接关闭
+ */
+void RemoteNode::release(int fd, bool reusable) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (reusable) {
+            idle.push_back(fd);
+        } else {
+            if (fd >= 0) {
+                close(fd);
+            }
+            open_count--;
+        }
+    }
+    connection_available.notify_one();
+}
+
+/**
+ * 发送indices[begin, end)对应的任务并读取结果
+ */
+app_status_t RemoteNode::send_request(const std::vector<ContractJob>& jobs,
+                                      const std::vector<size_t>& indices,
+                                      size_t begin, size_t end,
+                                      std::vector<ExecutionResult>& results) {
+    std::vector<uint8_t> request(sizeof(DispatchFrameHeader));
+    for (size_t i = begin; i < end; i++) {
+        append_job_record(request, jobs[indices[i]], false);
+    }
+
+    DispatchFrameHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = DISPATCH_PROTOCOL_MAGIC;
+    header.version = DISPATCH_PROTOCOL_VERSION;
+    header.job_count = static_cast<uint32_t>(end - begin);
+    header.payload_size = request.size() - sizeof(header);
+    memcpy(request.data(), &header, sizeof(header));
+
+    int fd = acquire();
+    if (fd < 0) {
+        fail_jobs(indices, begin, end, results, "无法连接远程节点: " + address());
+        return APP_ERROR_NETWORK;
+    }
+
+    DispatchFrameHeader reply;
+    std::vector<uint8_t> response;
+    bool ok = send_all(fd, request.data(), request.size()) &&
+              recv_all(fd, reinterpret_cast<uint8_t*>(&reply), sizeof(reply)) &&
+              valid_frame(reply) && reply.job_count == header.job_count;
+    if (ok) {
+        response.resize(static_cast<size_t>(reply.payload_size));
+        ok = recv_all(fd, response.data(), response.size());
+    }
+
+    // 逐条读取前先归还连接：此后的解析错误与连接状态无关
+    release(fd, ok);
+    if (!ok) {
+        fail_jobs(indices, begin, end, results, "远程节点通信失败: " + address());
+        return APP_ERROR_NETWORK;
+    }
+
+    size_t offset = 0;
+    std::vector<ExecutionProof> proofs(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        if (!read_result_record(response, offset, results[indices[i]], proofs[i - begin])) {
+            fail_jobs(indices, i, end, results, "远程节点响应格式错误: " + address());
+            return APP_ERROR_NETWORK;
+        }
+    }
+
+    app_status_t status = verify_results(jobs, indices, begin, end, results, proofs);
+    return status != APP_SUCCESS ? status : static_cast<app_status_t>(reply.status);
+}
+
+/**
+ * 检查indices[begin, end)的远程结果：执行哈希须与由任务重新计算的一致，
+ * 证明须由受信任公钥签名且覆盖该执行哈希，不符的成功结果改为失败
+ */
+app_status_t RemoteNode::verify_results(const std::vector<ContractJob>& jobs,
+                                        const std::vector<size_t>& indices,
+                                        size_t begin, size_t end,
+                                        std::vector<ExecutionResult>& results,
+                                        std::vector<ExecutionProof>& proofs) {
+    app_status_t status = APP_SUCCESS;
+    std::vector<size_t> checked;
+    std::vector<ExecutionProof> pending;
+
+    for (size_t i = begin; i < end; i++) {
+        ExecutionResult& result = results[indices[i]];
+        if (!result.success) {
+            continue;
+        }
+
+        ExecutionProof& proof = proofs[i - begin];
+        if (proof.proof_data.size() != EXECUTION_PROOF_SIZE ||
+            result.execution_hash != expected_execution_hash(jobs[indices[i]], result)) {
+            reject_result(result, "远程结果与任务不符: " + address());
+            status = APP_ERROR_ENCLAVE_CALL;
+            continue;
+        }
+        proof.execution_hash = result.execution_hash;
+        checked.push_back(i);
+        pending.push_back(std::move(proof));
+    }
+
+    std::vector<bool> valid = verifier.verify_batch(pending);
+    for (size_t k = 0; k < checked.size(); k++) {
+        if (!valid[k]) {
+            reject_result(results[indices[checked[k]]], "远程结果的执行证明无效: " + address());
+            status = APP_ERROR_ENCLAVE_CALL;
+        }
+    }
+    return status;
+}
+
+app_status_t RemoteNode::execute(const std::vector<ContractJob>& jobs,
+                                 const std::vector<size_t>& indices,
+                                 std::vector<ExecutionResult>& results) {
+    app_status_t status = APP_SUCCESS;
+    size_t begin = 0;
+
+    while (begin < indices.size()) {
+        // 每个请求不超过BATCH_MAX_JOBS条记录和DISPATCH_MAX_FRAME_SIZE字节
+        size_t end = begin;
+        size_t payload = 0;
+        while (end < indices.size() && end - begin < BATCH_MAX_JOBS) {
+            const ContractJob& job = jobs[indices[end]];
+            size_t record_size = batch_job_record_size(job.contract->bytecode.size(), job.input_data.size());
+            if (payload + record_size > DISPATCH_MAX_FRAME_SIZE) {
+                break;
+            }
+            payload += record_size;
+            end++;
+        }
+
+        // 单条记录就超出上限的任务不能转发
+        if (end == begin) {
+            fail_jobs(indices, begin, begin + 1, results, "任务过大，无法转发");
+            status = APP_ERROR_INVALID_PARAM;
+            begin++;
+            continue;
+        }
+
+        app_status_t chunk_status = send_request(jobs, indices, begin, end, results);
+        if (chunk_status == APP_ERROR_NETWORK) {
+            fail_jobs(indices, end, indices.size(), results, "远程节点不可用: " + address());
+            return APP_ERROR_NETWORK;
+        }
+        if (chunk_status != APP_SUCCESS) {
+            status = chunk_status;
+        }
+        begin = end;
+    }
+
+    return status;
+}
+
+// ---------------------------------------------------------------------------
+// EnclaveDispatcher
+// ---------------------------------------------------------------------------
+
+/**
+ * 64位整数的混合函数（splitmix64的最终化步骤）
+ */
+static uint64_t mix64(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+static std::vector<uint8_t> job_code_hash(const ContractJob& job) {
+    if (!job.contract) {
+        return job.code_hash;
+    }
+    std::vector<uint8_t> hash(SHA256_DIGEST_LENGTH);
+    SHA256(job.contract->bytecode.data(), job.contract->bytecode.size(), hash.data());
+    return hash;
+}
+
+EnclaveDispatcher::EnclaveDispatcher() : persistent(false), spill_threshold(0) {
+}
+
+EnclaveDispatcher::~EnclaveDispatcher() {
+    shutdown();
+}
+
+app_status_t EnclaveDispatcher::initialize(size_t enclave_count) {
+    if (!shards.empty()) {
+        return APP_SUCCESS;
+    }
+
+    persistent = Config::get_bool("state.persistent", false);
+    spill_threshold = static_cast<size_t>(std::max(Config::get_int("dispatcher.spill_threshold", 0), 0));
+    bool forward_remote = Config::get_bool("dispatcher.forward_remote", false);
+
+    // 远程节点有自己的状态日志，路由到远程的合约会从另一份状态开始执行
+    if (forward_remote && persistent) {
+        print_error("dispatcher.forward_remote不能与state.persistent同时启用");
+        return APP_ERROR_INVALID_PARAM;
+    }
+
+    // 通道不认证对端，远程结果只凭远程Enclave的签名可信
+    if (forward_remote) {
+        remote.reset(new RemoteNode(Config::server_host, static_cast<uint16_t>(Config::server_port),
+                                    static_cast<size_t>(std::max(Config::max_connections, 1))));
+        std::string trusted_key = Config::get_string("dispatcher.remote_public_key", "");
+        if (!remote->add_trusted_key(AppUtils::from_hex_string(trusted_key))) {
+            print_error("dispatcher.remote_public_key无效，无法验证远程节点的执行证明");
+            remote.reset();
+            return APP_ERROR_INVALID_PARAM;
+        }
+    }
+
+    std::vector<NumaNode> nodes = detect_numa_nodes();
+    if (enclave_count == 0) {
+        enclave_count = static_cast<size_t>(std::max(Config::get_int("dispatcher.enclaves", 0), 0));
+    }
+    if (enclave_count == 0) {
+        enclave_count = nodes.size();
+    }
+    enclave_count = std::min<size_t>(enclave_count, DISPATCHER_MAX_ENCLAVES);
+    bool pin = Config::get_bool("dispatcher.pin_threads", true);
+
+    // 创建期间调用线程绑定到目标节点：Enclave的初始化在本地内存上完成，
+    // 审计读取和配置监视线程也继承该节点的亲和性
+    cpu_set_t saved;
+    CPU_ZERO(&saved);
+    bool restore = pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) == 0;
+
+    for (size_t i = 0; i < enclave_count; i++) {
+        std::unique_ptr<Shard> shard(new Shard());
+        shard->node = nodes[i % nodes.size()];
+        shard->app.reset(new SGXSmartContractApp());
+        if (pin) {
+            bind_current_thread(shard->node.cpus);
+            shard->app->set_cpu_affinity(shard->node.cpus);
+        }
+
+        // 依次创建：第一个Enclave密封的签名密钥由之后的Enclave恢复，所有证明使用同一公钥
+        app_status_t status = shard->app->initialize_enclave();
+        if (restore) {
+            pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+        }
+        if (status != APP_SUCCESS) {
+            print_error("无法在NUMA节点" + std::to_string(shard->node.id) + "上创建Enclave");
+            shutdown();
+            return status;
+        }
+        shards.push_back(std::move(shard));
+    }
+
+    print_success("调度器已就绪: " + std::to_string(shards.size()) + " 个Enclave, " +
+                  std::to_string(nodes.size()) + " 个NUMA节点" +
+                  (remote ? "，远程节点 " + remote->address() : ""));
+    return APP_SUCCESS;
+}
+
+void EnclaveDispatcher::shutdown() {
+    remote.reset();
+    shards.clear();
+}
+
+/**
+ * 最高随机权重哈希：每个目标以(字节码哈希, 目标序号)计算权重，取权重最大者。
+ * 增减远程节点只移动归属于它的合约，本地Enclave之间的归属不变
+ * @return 目标下标（等于shards.size()时表示远程节点）
+ */
+size_t EnclaveDispatcher::route(const std::vector<uint8_t>& code_hash, bool allow_remote) const {
+    uint64_t prefix = 0;
+    memcpy(&prefix, code_hash.data(), std::min(code_hash.size(), sizeof(prefix)));
+
+    size_t targets = shards.size() + (allow_remote && remote ? 1 : 0);
+    size_t best = 0;
+    uint64_t best_weight = 0;
+    for (size_t i = 0; i < targets; i++) {
+        uint64_t weight = mix64(prefix ^ mix64(i + 1));
+        if (i == 0 || weight > best_weight) {
+            best = i;
+            best_weight = weight;
+        }
+    }
+    return best;
+}
+
+/**
+ * 目标Enclave的并发调用达到阈值时改用最空闲的Enclave（启用状态持久化时不溢出）
+ */
+size_t EnclaveDispatcher::spill(size_t target) const {
+    if (persistent || spill_threshold == 0 || shards[target]->in_flight.load() < spill_threshold) {
+        return target;
+    }
+
+    size_t idlest = target;
+    for (size_t i = 0; i < shards.size(); i++) {
+        if (shards[i]->in_flight.load() < shards[idlest]->in_flight.load()) {
+            idlest = i;
+        }
+    }
+    return idlest;
+}
+
+app_status_t EnclaveDispatcher::execute_contract(const SmartContract& contract,
+                                                 const std::vector<uint8_t>& input_data,
+                                                 ExecutionResult& result) {
+    if (shards.empty()) {
+        print_error("调度器未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+
+    ContractJob job(&contract, input_data);
+    std::vector<uint8_t> code_hash = job_code_hash(job);
+    size_t target = route(code_hash, true);
+
+    if (target == shards.size()) {
+        std::vector<ContractJob> jobs(1, job);
+        std::vector<size_t> indices(1, 0);
+        std::vector<ExecutionResult> results(1);
+        app_status_t status = remote->execute(jobs, indices, results);
+        if (status != APP_ERROR_NETWORK) {
+            result = results[0];
+            if (status == APP_SUCCESS && !result.success) {
+                status = APP_ERROR_ENCLAVE_CALL;
+            }
+            return status;
+        }
+        // 转发时不持久化状态，执行结果与位置无关，远程不可用时在本地执行
+        print_warning(results[0].error_message + "，改在本地执行");
+        target = route(code_hash, false);
+    }
+
+    Shard& shard = *shards[spill(target)];
+    shard.in_flight++;
+    app_status_t status = shard.app->execute_contract(contract, input_data, result);
+    shard.in_flight--;
+    return status;
+}
+
+app_status_t EnclaveDispatcher::execute_batch(const std::vector<ContractJob>& jobs,
+                                              std::vector<ExecutionResult>& results,
+                                              bool allow_remote) {
+    if (shards.empty()) {
+        print_error("调度器未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+
+    results.assign(jobs.size(), ExecutionResult());
+
+    // 按路由分组，最后一组为远程节点；按哈希引用的任务没有字节码，不能转发
+    std::vector<std::vector<size_t>> groups(shards.size() + 1);
+    std::vector<std::vector<uint8_t>> hashes(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        hashes[i] = job_code_hash(jobs[i]);
+        groups[route(hashes[i], allow_remote && jobs[i].contract != nullptr)].push_back(i);
+    }
+
+    // 各组在本节点的工作线程池中执行，组内的结果按任务下标写回
+    // 等待和执行中的任务计入in_flight，单次调用溢出时能看到批量执行的负载
+    auto run_local = [this, &jobs, &results](size_t target, const std::vector<size_t>& indices) {
+        std::vector<ContractJob> subset;
+        subset.reserve(indices.size());
+        for (size_t index : indices) {
+            subset.push_back(jobs[index]);
+        }
+        std::vector<ExecutionResult> subset_results;
+        Shard& shard = *shards[target];
+        shard.in_flight += indices.size();
+        app_status_t status;
+        {
+            std::lock_guard<std::mutex> lock(shard.batch_mutex);
+            status = shard.app->execute_parallel(subset, subset_results);
+        }
+        shard.in_flight -= indices.size();
+        for (size_t i = 0; i < indices.size() && i < subset_results.size(); i++) {
+            results[indices[i]] = std::move(subset_results[i]);
+        }
+        return status;
+    };
+
+    std::vector<std::future<app_status_t>> pending;
+    for (size_t target = 0; target < shards.size(); target++) {
+        if (!groups[target].empty()) {
+            pending.push_back(std::async(std::launch::async, run_local, target, std::cref(groups[target])));
+        }
+    }
+
+    if (!groups[shards.size()].empty()) {
+        pending.push_back(std::async(std::launch::async, [this, &jobs, &results, &groups, &hashes, &run_local]() {
+            const std::vector<size_t>& indices = groups[shards.size()];
+            app_status_t status = remote->execute(jobs, indices, results);
+            if (status != APP_ERROR_NETWORK) {
+                return status;
+            }
+
+            // 远程不可用时整组改在本地执行（结果与位置无关，已完成的任务重新执行也得到相同结果）
+            print_warning("远程节点不可用: " + remote->address() + "，" +
+                          std::to_string(indices.size()) + " 个任务改在本地执行");
+            std::vector<std::vector<size_t>> local(shards.size());
+            for (size_t index : indices) {
+                local[route(hashes[index], false)].push_back(index);
+            }
+            status = APP_SUCCESS;
+            for (size_t target = 0; target < shards.size(); target++) {
+                if (!local[target].empty()) {
+                    app_status_t local_status = run_local(target, local[target]);
+                    if (local_status != APP_SUCCESS) {
+                        status = local_status;
+                    }
+                }
+            }
+            return status;
+        }));
+    }
+
+    app_status_t status = APP_SUCCESS;
+    for (std::future<app_status_t>& future : pending) {
+        app_status_t group_status = future.get();
+        if (group_status != APP_SUCCESS && status == APP_SUCCESS) {
+            status = group_status;
+        }
+    }
+    return status;
+}
+
+app_status_t EnclaveDispatcher::generate_batch_proof(const std::vector<ExecutionResult>& results,
+                                                     std::vector<ExecutionProof>& proofs) {
+    if (shards.empty()) {
+        print_error("调度器未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    return shards[0]->app->generate_batch_proof(results, proofs);
+}
+
+// ---------------------------------------------------------------------------
+// DispatchServer
+// ---------------------------------------------------------------------------
+
+DispatchServer::DispatchServer(EnclaveDispatcher& target, const std::string& address, uint16_t port,
+                               size_t connection_limit)
+    : dispatcher(target), max_connections(std::max<size_t>(connection_limit, 1)), listen_fd(-1), stop_fd(-1) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    struct addrinfo* addresses = nullptr;
+    if (getaddrinfo(address.empty() ? nullptr : address.c_str(), std::to_string(port).c_str(),
+                    &hints, &addresses) != 0) {
+        print_error("无法解析监听地址: " + address);
+        return;
+    }
+
+    for (struct addrinfo* candidate = addresses; candidate && listen_fd < 0; candidate = candidate->ai_next) {
+        listen_fd = socket(candidate->ai_family, candidate->ai_socktype | SOCK_CLOEXEC, candidate->ai_protocol);
+        if (listen_fd < 0) {
+            continue;
+        }
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(listen_fd, candidate->ai_addr, candidate->ai_addrlen) != 0 ||
+            listen(listen_fd, static_cast<int>(max_connections)) != 0) {
+            close(listen_fd);
+            listen_fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (listen_fd < 0 || stop_fd < 0) {
+        print_error("无法监听 " + address + ":" + std::to_string(port) + " (" + strerror(errno) + ")");
+        return;
+    }
+
+    acceptor = std::thread(&DispatchServer::accept_loop, this);
+}
+
+DispatchServer::~DispatchServer() {
+    if (acceptor.joinable()) {
+        uint64_t one = 1;
+        ssize_t written = write(stop_fd, &one, sizeof(one));
+        (void)written;
+        acceptor.join();
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+    }
+    if (stop_fd >= 0) {
+        close(stop_fd);
+    }
+}
+
+/**
+ * 回收已结束的连接线程（all为true时先断开所有连接）
+ */
+void DispatchServer::reap_connections(bool all) {
+    for (auto it = connections.begin(); it != connections.end();) {
+        Connection* connection = it->get();
+        if (all) {
+            shutdown(connection->fd, SHUT_RDWR);
+        }
+        if (all || connection->done.load()) {
+            connection->worker.join();
+            close(connection->fd);
+            it = connections.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DispatchServer::accept_loop() {
+    struct pollfd fds[2] = { { listen_fd, POLLIN, 0 }, { stop_fd, POLLIN, 0 } };
+
+    while (true) {
+        int ready = poll(fds, 2, -1);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0 || fds[1].revents) {
+            break;
+        }
+
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        reap_connections(false);
+        if (connections.size() >= max_connections) {
+            Logger::warning("调度服务连接数已达上限(" + std::to_string(max_connections) + ")，拒绝新连接");
+            close(fd);
+            continue;
+        }
+
+        configure_socket(fd);
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->fd = fd;
+        connection->worker = std::thread(&DispatchServer::serve_connection, this, connection.get());
+        connections.push_back(std::move(connection));
+    }
+
+    reap_connections(true);
+}
+
+/**
+ * 依次处理一个连接上的请求，对端关闭、协议错误或服务停止时返回
+ */
+void DispatchServer::serve_connection(Connection* connection) {
+    int fd = connection->fd;
+    struct pollfd fds[2] = { { fd, POLLIN, 0 }, { stop_fd, POLLIN, 0 } };
+
+    while (true) {
+        // 请求之间的空闲等待不受收发超时限制
+        int ready = poll(fds, 2, -1);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0 || fds[1].revents) {
+            break;
+        }
+
+        DispatchFrameHeader header;
+        if (!recv_all(fd, reinterpret_cast<uint8_t*>(&header), sizeof(header)) || !valid_frame(header)) {
+            break;
+        }
+        std::vector<uint8_t> payload(static_cast<size_t>(header.payload_size));
+        if (!recv_all(fd, payload.data(), payload.size())) {
+            break;
+        }
+
+        // 解析任务记录，字节码复制到本请求的合约对象中（预留容量使指针保持有效）
+        std::vector<SmartContract> contracts;
+        std::vector<ContractJob> jobs;
+        contracts.reserve(header.job_count);
+        jobs.reserve(header.job_count);
+        size_t offset = 0;
+        bool valid = true;
+        for (uint32_t i = 0; i < header.job_count && valid; i++) {
+            batch_job_header_t record;
+            if (payload.size() - offset < sizeof(record)) {
+                valid = false;
+                break;
+            }
+            memcpy(&record, payload.data() + offset, sizeof(record));
+            size_t record_size = batch_job_record_size(record.code_size, record.input_size);
+            bool by_hash = (record.flags & BATCH_JOB_FLAG_BY_HASH) != 0;
+            if (record_size > payload.size() - offset || record.code_size > MAX_CONTRACT_SIZE ||
+                (by_hash ? record.code_size != 0 : record.code_size == 0)) {
+                valid = false;
+                break;
+            }
+
+            const uint8_t* code = payload.data() + offset + sizeof(record);
+            const uint8_t* input = code + record.code_size;
+            ContractJob job;
+            if (by_hash) {
+                job.code_hash.assign(record.code_hash, record.code_hash + sizeof(record.code_hash));
+            } else {
+                contracts.emplace_back(std::vector<uint8_t>(code, code + record.code_size), "remote");
+                job.contract = &contracts.back();
+            }
+            job.input_data.assign(input, input + record.input_size);
+            job.gas_limit = record.gas_limit;
+            jobs.push_back(std::move(job));
+            offset += record_size;
+        }
+        if (!valid) {
+            Logger::warning("调度服务收到格式错误的请求，关闭连接");
+            break;
+        }
+
+        std::vector<ExecutionResult> results;
+        app_status_t status = dispatcher.execute_batch(jobs, results, false);
+
+        // 调用方按请求的任务数读取结果记录，调度器提前失败时以失败记录补齐
+        if (results.size() < jobs.size()) {
+            ExecutionResult failed;
+            failed.error_message = "调度服务执行失败";
+            results.resize(jobs.size(), failed);
+        }
+
+        // 无法签名时成功的结果不带证明，调用方会拒绝它们
+        std::vector<ExecutionProof> proofs;
+        app_status_t proof_status = dispatcher.generate_batch_proof(results, proofs);
+        if (proof_status != APP_SUCCESS) {
+            Logger::error("调度服务无法为结果生成执行证明");
+            proofs.assign(results.size(), ExecutionProof());
+            status = proof_status;
+        }
+
+        std::vector<uint8_t> response(sizeof(DispatchFrameHeader));
+        for (size_t i = 0; i < results.size(); i++) {
+            append_result_record(response, results[i], proofs[i]);
+        }
+        DispatchFrameHeader reply;
+        memset(&reply, 0, sizeof(reply));
+        reply.magic = DISPATCH_PROTOCOL_MAGIC;
+        reply.version = DISPATCH_PROTOCOL_VERSION;
+        reply.job_count = static_cast<uint32_t>(results.size());
+        reply.status = status;
+        reply.payload_size = response.size() - sizeof(reply);
+        memcpy(response.data(), &reply, sizeof(reply));
+
+        if (reply.payload_size > DISPATCH_MAX_FRAME_SIZE || !send_all(fd, response.data(), response.size())) {
+            break;
+        }
+    }
+
+    connection->done.store(true);
+}
+
+// ---------------------------------------------------------------------------
+// 服务模式
+// ---------------------------------------------------------------------------
+
+int run_dispatch_server() {
+    // 在创建任何线程之前屏蔽信号，由主线程以sigwait等待
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    // 远程请求来自其他主机，它们的执行不能写入本机的持久化状态
+    if (Config::get_bool("state.persistent", false)) {
+        print_error("服务模式只执行无状态任务，请关闭state.persistent");
+        return 1;
+    }
+
+    EnclaveDispatcher dispatcher;
+    if (dispatcher.initialize() != APP_SUCCESS) {
+        print_error("无法初始化调度器");
+        return 1;
+    }
+
+    // 调用方以该公钥作为dispatcher.remote_public_key验证本节点返回的结果
+    std::vector<uint8_t> public_key;
+    if (dispatcher.shard(0).get_signing_public_key(public_key) != APP_SUCCESS) {
+        print_error("无法获取签名公钥");
+        return 1;
+    }
+    print_success("签名公钥: " + AppUtils::to_hex_string(public_key));
+
+    std::string address = Config::get_string("dispatcher.listen_address", "127.0.0.1");
+    DispatchServer server(dispatcher, address, static_cast<uint16_t>(Config::server_port),
+                          static_cast<size_t>(std::max(Config::max_connections, 1)));
+    if (!server.is_listening()) {
+        return 1;
+    }
+    print_success("调度服务已启动: " + address + ":" + std::to_string(Config::server_port));
+
+    int received = 0;
+    sigwait(&signals, &received);
+    print_success("收到信号，停止调度服务");
+    return 0;
+}
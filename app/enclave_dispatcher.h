@@ -0,0 +1,267 @@
+#ifndef ENCLAVE_DISPATCHER_H
+#define ENCLAVE_DISPATCHER_H
+
+#include "app.h"
+#include "proof_verifier.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 单个主机上的Enclave数量上限
+#define DISPATCHER_MAX_ENCLAVES     16
+
+/*
+ * 远程转发协议（TCP，字段为主机字节序，节点间须为相同架构）：
+ *   请求 = DispatchFrameHeader | job_count条批量任务记录（格式同ecall_execute_batch，总是携带字节码）
+ *   响应 = DispatchFrameHeader | job_count条结果记录
+ * 每条结果记录为 DispatchResultRecord | 输出 | 错误信息 | 执行证明 | 包含路径 | 填充至8字节对齐。
+ * 通道本身不加密也不认证对端：成功的结果附带远程Enclave签名的批量证明，
+ * 调用方由任务重新计算执行哈希，并用dispatcher.remote_public_key验证证明，不符的结果按失败处理。
+ * 连接上的请求依次处理，一个连接同时只有一个请求
+ */
+#define DISPATCH_PROTOCOL_MAGIC     0x50534944  // "DISP"
+#define DISPATCH_PROTOCOL_VERSION   2
+#define DISPATCH_MAX_FRAME_SIZE     (16 * 1024 * 1024)
+
+struct DispatchFrameHeader {
+    uint32_t magic;                         // DISPATCH_PROTOCOL_MAGIC
+    uint32_t version;                       // DISPATCH_PROTOCOL_VERSION
+    uint32_t job_count;                     // 记录数量（不超过BATCH_MAX_JOBS）
+    int32_t status;                         // 响应中整个请求的app_status_t（请求中为0）
+    uint64_t payload_size;                  // 其后的数据大小（不超过DISPATCH_MAX_FRAME_SIZE）
+};
+
+struct DispatchResultRecord {
+    uint32_t success;                       // 是否执行成功
+    uint32_t output_size;                   // 输出大小
+    uint32_t error_size;                    // 错误信息大小
+    uint32_t proof_size;                    // 执行证明大小（成功时为EXECUTION_PROOF_SIZE，否则为0）
+    uint32_t path_size;                     // 包含路径大小（32字节的倍数，不超过MERKLE_MAX_DEPTH层）
+    uint32_t leaf_index;                    // 批量证明中的叶子序号
+    uint32_t leaf_count;                    // 批量证明的叶子数量
+    uint32_t reserved;                      // 保留
+    uint64_t gas_used;                      // 已使用Gas
+    uint8_t code_hash[32];                  // 字节码哈希
+    uint8_t execution_hash[32];             // 执行哈希（失败时为0）
+};
+
+// NUMA节点（或CPU插槽）及其中当前进程可用的CPU
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+/**
+ * 检测NUMA节点：依次读取/sys/devices/system/node与各CPU的physical_package_id，
+ * 只保留进程亲和性掩码内的CPU；都不可用时返回包含全部可用CPU的单个节点
+ * @return 节点列表（至少一个）
+ */
+std::vector<NumaNode> detect_numa_nodes();
+
+/**
+ * 远程节点：按max_connections上限复用到同一地址的TCP连接，连接出错后关闭并在下次请求时重连；
+ * 只接受执行证明由受信任公钥签名的成功结果
+ */
+class RemoteNode {
+private:
+    std::string host;
+    uint16_t port;
+    size_t max_connections;
+    ProofVerifier verifier;
+    std::mutex mutex;
+    std::condition_variable connection_available;
+    std::vector<int> idle;                  // 空闲连接
+    size_t open_count;                      // 已打开的连接数（含使用中的）
+
+    int acquire();
+    void release(int fd, bool reusable);
+    app_status_t send_request(const std::vector<ContractJob>& jobs,
+                              const std::vector<size_t>& indices,
+                              size_t begin, size_t end,
+                              std::vector<ExecutionResult>& results);
+    app_status_t verify_results(const std::vector<ContractJob>& jobs,
+                                const std::vector<size_t>& indices,
+                                size_t begin, size_t end,
+                                std::vector<ExecutionResult>& results,
+                                std::vector<ExecutionProof>& proofs);
+
+public:
+    RemoteNode(const std::string& remote_host, uint16_t remote_port, size_t connection_limit);
+    ~RemoteNode();
+
+    RemoteNode(const RemoteNode&) = delete;
+    RemoteNode& operator=(const RemoteNode&) = delete;
+
+    /**
+     * 添加远程Enclave的签名公钥（远程节点以--serve启动时输出）
+     * @param public_key SGX格式的公钥（64字节）
+     * @return 公钥是否有效
+     */
+    bool add_trusted_key(const std::vector<uint8_t>& public_key) { return verifier.add_trusted_key(public_key); }
+
+    /**
+     * 在远程节点执行任务（按BATCH_MAX_JOBS和DISPATCH_MAX_FRAME_SIZE拆成多个请求）
+     * @param jobs 任务（必须携带合约字节码）
+     * @param indices 要执行的任务下标
+     * @param results 按任务下标写入的结果
+     * @return 应用状态码（连接或协议错误时为APP_ERROR_NETWORK，已写入的结果仍有效；
+     *         有结果未通过证明验证时为APP_ERROR_ENCLAVE_CALL）
+     */
+    app_status_t execute(const std::vector<ContractJob>& jobs,
+                         const std::vector<size_t>& indices,
+                         std::vector<ExecutionResult>& results);
+
+    std::string address() const { return host + ":" + std::to_string(port); }
+};
+
+/**
+ * 多Enclave调度器：每个NUMA节点一个Enclave，工作线程绑定在节点内，
+ * 任务按字节码哈希的最高随机权重（rendezvous）哈希路由到固定的Enclave，使各自的字节码缓存保持命中；
+ * 开启dispatcher.forward_remote时network.server_host:server_port上的远程节点作为额外的路由目标。
+ * 所有Enclave共用同一签名密钥和状态日志，启用状态持久化时同一合约总在本机的同一Enclave执行；
+ * 远程节点有独立的状态日志，因此远程转发不能与状态持久化同时启用
+ */
+class EnclaveDispatcher {
+private:
+    struct Shard {
+        std::unique_ptr<SGXSmartContractApp> app;
+        NumaNode node;
+        std::atomic<size_t> in_flight;      // 正在执行的任务数（单次调用和批量执行中等待或执行的任务）
+        std::mutex batch_mutex;             // 串行化同一Enclave上的批量执行（工作线程池不是可重入的）
+
+        Shard() : in_flight(0) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::unique_ptr<RemoteNode> remote;
+    bool persistent;                        // 是否启用了状态持久化（此时不溢出到其他Enclave）
+    size_t spill_threshold;                 // 单次调用溢出到最空闲Enclave的并发阈值（0表示不溢出）
+
+    size_t route(const std::vector<uint8_t>& code_hash, bool allow_remote) const;
+    size_t spill(size_t target) const;
+
+public:
+    EnclaveDispatcher();
+    ~EnclaveDispatcher();
+
+    EnclaveDispatcher(const EnclaveDispatcher&) = delete;
+    EnclaveDispatcher& operator=(const EnclaveDispatcher&) = delete;
+
+    /**
+     * 创建Enclave：依次在各节点的CPU上创建，期间调用线程临时绑定到该节点
+     * @param enclave_count Enclave数量（0时取dispatcher.enclaves，仍为0时每个NUMA节点一个）
+     * @return 应用状态码（同时启用远程转发和状态持久化、或远程转发缺少有效的dispatcher.remote_public_key时
+     *         为APP_ERROR_INVALID_PARAM；任一Enclave创建失败时销毁已创建的Enclave）
+     */
+    app_status_t initialize(size_t enclave_count = 0);
+
+    /**
+     * 销毁所有Enclave并断开远程连接
+     */
+    void shutdown();
+
+    size_t shard_count() const { return shards.size(); }
+    SGXSmartContractApp& shard(size_t index) { return *shards[index]->app; }
+    const NumaNode& shard_node(size_t index) const { return shards[index]->node; }
+    bool has_remote() const { return remote != nullptr; }
+
+    /**
+     * 字节码哈希路由到的本地Enclave（不考虑远程节点）
+     * @param code_hash 字节码哈希（32字节）
+     * @return Enclave下标
+     */
+    size_t shard_for(const std::vector<uint8_t>& code_hash) const { return route(code_hash, false); }
+
+    /**
+     * 执行单个合约
+     * @param contract 合约
+     * @param input_data 输入数据
+     * @param result 执行结果
+     * @return 应用状态码
+     */
+    app_status_t execute_contract(const SmartContract& contract,
+                                  const std::vector<uint8_t>& input_data,
+                                  ExecutionResult& result);
+
+    /**
+     * 执行一批任务：按路由分组，各Enclave以绑定在本节点的工作线程并行执行，远程分组同时转发
+     * @param jobs 任务（按哈希引用的任务只路由到本地Enclave）
+     * @param results 与任务一一对应的结果
+     * @param allow_remote 是否允许转发（处理远程请求时为false，避免再次转发）
+     * @return 应用状态码
+     */
+    app_status_t execute_batch(const std::vector<ContractJob>& jobs,
+                               std::vector<ExecutionResult>& results,
+                               bool allow_remote = true);
+
+    /**
+     * 为执行成功的结果生成批量证明（所有Enclave共用签名密钥，由第一个Enclave签名）
+     * @param results 执行结果
+     * @param proofs 与结果一一对应的证明（失败的结果为空证明）
+     * @return 应用状态码
+     */
+    app_status_t generate_batch_proof(const std::vector<ExecutionResult>& results,
+                                      std::vector<ExecutionProof>& proofs);
+};
+
+/**
+ * 远程转发服务：在network.server_port上接受其他节点的调度请求，用本地Enclave执行（不再转发），
+ * 成功的结果附带批量执行证明；同时处理的连接数不超过network.max_connections，超出的连接被直接关闭。
+ * 服务不认证请求方，任何能连接的对端都可以提交任务
+ */
+class DispatchServer {
+private:
+    struct Connection {
+        int fd;
+        std::thread worker;
+        std::atomic<bool> done;
+
+        Connection() : fd(-1), done(false) {}
+    };
+
+    EnclaveDispatcher& dispatcher;
+    size_t max_connections;
+    int listen_fd;
+    int stop_fd;                            // eventfd，析构时唤醒接受线程和连接线程
+    std::thread acceptor;
+    std::vector<std::unique_ptr<Connection>> connections;   // 只由接受线程修改
+
+    void accept_loop();
+    void serve_connection(Connection* connection);
+    void reap_connections(bool all);
+
+public:
+    /**
+     * 开始监听
+     * @param target 执行请求的调度器
+     * @param address 监听地址（如"127.0.0.1"）
+     * @param port 监听端口
+     * @param connection_limit 同时处理的连接数上限
+     */
+    DispatchServer(EnclaveDispatcher& target, const std::string& address, uint16_t port, size_t connection_limit);
+
+    /**
+     * 停止监听并等待所有连接线程退出
+     */
+    ~DispatchServer();
+
+    DispatchServer(const DispatchServer&) = delete;
+    DispatchServer& operator=(const DispatchServer&) = delete;
+
+    bool is_listening() const { return acceptor.joinable(); }
+};
+
+/**
+ * 以服务模式运行（--serve）：创建调度器和DispatchServer，直到收到SIGINT或SIGTERM；
+ * 启动时输出签名公钥，供调用方配置为dispatcher.remote_public_key；启用状态持久化时拒绝启动
+ * @return 进程退出码
+ */
+int run_dispatch_server();
+
+#endif // ENCLAVE_DISPATCHER_H
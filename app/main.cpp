@@ -5,10 +5,14 @@
 #include <iomanip>
 #include <chrono>
 #include <memory>
+#include <cstdlib>
 
 #include "sgx_urts.h"
 #include "enclave_u.h"
+#include "enclave_shared.h"
 #include "app_utils.h"
+#include "benchmark.h"
+#include "enclave_dispatcher.h"
 
 // Enclave相关
 #define ENCLAVE_FILENAME "enclave.signed.so"
@@ -32,14 +36,34 @@ sgx_status_t initialize_enclave() {
     
     std::cout << "Enclave created successfully. EID: " << global_eid << std::endl;
     
+    // 恢复上次密封的证明签名密钥
+    const std::string key_file = sealed_signing_key_path();
+    bool key_loaded = load_sealed_signing_key(global_eid, key_file);
+    
     // 初始化验证器
+    gas_schedule_t schedule;
+    build_gas_schedule(schedule);
     sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
-    ret = ecall_init_verifier(global_eid, &enclave_ret);
+    ret = ecall_init_contract_verifier(global_eid, &enclave_ret,
+                                       reinterpret_cast<const uint8_t*>(&schedule), sizeof(schedule));
     if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
         std::cerr << "Failed to initialize verifier: 0x" << std::hex << ret << ", 0x" << enclave_ret << std::endl;
         return (ret != SGX_SUCCESS) ? ret : enclave_ret;
     }
     
+    if (!key_loaded && !store_sealed_signing_key(global_eid, key_file)) {
+        std::cerr << "Warning: failed to store sealed signing key" << std::endl;
+    }
+    
+    // 合约状态持久化
+    if (Config::get_bool("state.persistent", false)) {
+        uint64_t budget = static_cast<uint64_t>(Config::get_int("state.cache_budget_kb", 0)) * 1024;
+        ret = ecall_configure_state(global_eid, &enclave_ret, 1, budget);
+        if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+            std::cerr << "Warning: failed to enable persistent contract state" << std::endl;
+        }
+    }
+    
     std::cout << "Contract verifier initialized successfully." << std::endl;
     
     return SGX_SUCCESS;
@@ -101,7 +125,7 @@ std::vector<uint8_t> create_sample_contract() {
     bytecode.push_back(0x03); // OP_ADD
     
     // HALT
-    bytecode.push_back(0x18); // OP_HALT
+    bytecode.push_back(0xFF); // OP_HALT
     
     std::cout << "Created sample contract: " << bytecode.size() << " bytes" << std::endl;
     
@@ -132,6 +156,7 @@ bool execute_smart_contract(const std::vector<uint8_t>& bytecode, const std::vec
     uint8_t result_buffer[4096];
     size_t result_size = sizeof(result_buffer);
     uint8_t execution_hash[32];
+    uint64_t gas_used = 0;
     
     // 记录开始时间
     auto start_time = std::chrono::high_resolution_clock::now();
@@ -149,8 +174,10 @@ bool execute_smart_contract(const std::vector<uint8_t>& bytecode, const std::vec
         input_size,
         gas_limit,
         result_buffer,
+        sizeof(result_buffer),
         &result_size,
-        execution_hash
+        execution_hash,
+        &gas_used
     );
     
     // 记录结束时间
@@ -170,6 +197,7 @@ bool execute_smart_contract(const std::vector<uint8_t>& bytecode, const std::vec
     // 显示执行结果
     std::cout << "\n=== Execution Results ===" << std::endl;
     std::cout << "Execution time: " << duration.count() << " microseconds" << std::endl;
+    std::cout << "Gas used: " << gas_used << std::endl;
     std::cout << "Result size: " << result_size << " bytes" << std::endl;
     
     if (result_size > 0) {
@@ -203,19 +231,45 @@ bool generate_execution_proof(const std::vector<uint8_t>& bytecode, const std::v
     
     std::cout << "\n=== Generating Execution Proof ===" << std::endl;
     
-    uint8_t proof_data[1024];
-    size_t proof_size = sizeof(proof_data);
+    // 先执行合约得到执行哈希，证明对其签名
+    uint8_t result_buffer[4096];
+    size_t result_size = 0;
+    uint8_t execution_hash[32];
+    uint64_t gas_used = 0;
     
     sgx_status_t ret = SGX_ERROR_UNEXPECTED;
     sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
     
-    ret = ecall_generate_proof(
+    ret = ecall_execute_contract(
         global_eid,
         &enclave_ret,
-        const_cast<uint8_t*>(bytecode.data()),
+        bytecode.data(),
         bytecode.size(),
+        input_data.empty() ? nullptr : input_data.data(),
+        input_data.size(),
+        1000000,
+        result_buffer,
+        sizeof(result_buffer),
+        &result_size,
+        execution_hash,
+        &gas_used
+    );
+    
+    if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+        std::cerr << "Contract execution failed: 0x" << std::hex << ret << ", 0x" << enclave_ret << std::endl;
+        return false;
+    }
+    
+    uint8_t proof_data[EXECUTION_PROOF_SIZE];
+    size_t proof_size = 0;
+    
+    ret = ecall_generate_execution_proof(
+        global_eid,
+        &enclave_ret,
+        execution_hash,
         proof_data,
-        proof_size
+        sizeof(proof_data),
+        &proof_size
     );
     
     if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
@@ -334,7 +388,8 @@ void show_menu() {
     std::cout << "Choose an option: ";
 }
 
-// 性能基准测试功能已移除，保持演示版本简洁
+// 性能基准测试见benchmark.cpp，通过 --benchmark [iterations] [--json file] 运行
+// 多Enclave调度服务见enclave_dispatcher.cpp，通过 --serve 运行
 
 /**
  * 主函数
@@ -343,6 +398,32 @@ int main(int argc, char* argv[]) {
     std::cout << "SGX Smart Contract Verification Demo" << std::endl;
     std::cout << "====================================" << std::endl;
     
+    // 配置文件解析失败时使用默认配置
+    if (!Config::load(CONFIG_FILENAME)) {
+        std::cerr << "Warning: failed to load " << CONFIG_FILENAME << ", using defaults" << std::endl;
+    }
+    
+    // 基准测试模式：自行创建普通和免切换两个Enclave
+    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+        int iterations = 10000;
+        std::string json_file;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--json" && i + 1 < argc) {
+                json_file = argv[++i];
+            } else if (std::atoi(arg.c_str()) > 0) {
+                iterations = std::atoi(arg.c_str());
+            }
+        }
+        run_benchmark_test(iterations, json_file);
+        return 0;
+    }
+    
+    // 服务模式：每个NUMA节点一个Enclave，接受其他节点转发的任务
+    if (argc > 1 && std::string(argv[1]) == "--serve") {
+        return run_dispatch_server();
+    }
+    
     // 初始化Enclave
     if (initialize_enclave() != SGX_SUCCESS) {
         std::cerr << "Failed to initialize enclave" << std::endl;
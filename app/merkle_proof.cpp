@@ -0,0 +1,132 @@
+#include "merkle_proof.h"
+#include "enclave_shared.h"
+
+#include <openssl/sha.h>
+#include <cstring>
+#include <algorithm>
+
+static const size_t NODE_SIZE = SHA256_DIGEST_LENGTH;
+
+/**
+ * 计算带前缀的哈希：SHA256(prefix | left | right)
+ */
+static void hash_node(uint8_t prefix, const uint8_t* left, const uint8_t* right, uint8_t* out) {
+    uint8_t buffer[1 + 2 * NODE_SIZE];
+    size_t size = 1 + NODE_SIZE;
+
+    buffer[0] = prefix;
+    memcpy(buffer + 1, left, NODE_SIZE);
+    if (right) {
+        memcpy(buffer + 1 + NODE_SIZE, right, NODE_SIZE);
+        size += NODE_SIZE;
+    }
+
+    SHA256(buffer, size, out);
+}
+
+MerkleTree::MerkleTree(const std::vector<std::vector<uint8_t>>& execution_hashes)
+    : leaves(execution_hashes.size()) {
+    if (leaves == 0) {
+        return;
+    }
+
+    std::vector<uint8_t> level(leaves * NODE_SIZE);
+    for (size_t i = 0; i < leaves; i++) {
+        uint8_t hash[NODE_SIZE] = {0};
+        memcpy(hash, execution_hashes[i].data(), std::min(execution_hashes[i].size(), NODE_SIZE));
+        hash_node(MERKLE_LEAF_PREFIX, hash, nullptr, &level[i * NODE_SIZE]);
+    }
+    levels.push_back(std::move(level));
+
+    // 节点数为奇数时最后一个节点直接上移
+    while (levels.back().size() > NODE_SIZE) {
+        const std::vector<uint8_t>& child = levels.back();
+        size_t count = child.size() / NODE_SIZE;
+        std::vector<uint8_t> parent((count + 1) / 2 * NODE_SIZE);
+        for (size_t i = 0; i + 1 < count; i += 2) {
+            hash_node(MERKLE_NODE_PREFIX, &child[i * NODE_SIZE], &child[(i + 1) * NODE_SIZE],
+                      &parent[i / 2 * NODE_SIZE]);
+        }
+        if (count & 1) {
+            memcpy(&parent[count / 2 * NODE_SIZE], &child[(count - 1) * NODE_SIZE], NODE_SIZE);
+        }
+        levels.push_back(std::move(parent));
+    }
+}
+
+std::vector<uint8_t> MerkleTree::root() const {
+    if (levels.empty()) {
+        return {};
+    }
+    return levels.back();
+}
+
+std::vector<uint8_t> MerkleTree::path(size_t index) const {
+    std::vector<uint8_t> result;
+    if (index >= leaves) {
+        return result;
+    }
+
+    for (size_t depth = 0; depth + 1 < levels.size(); depth++) {
+        size_t count = levels[depth].size() / NODE_SIZE;
+        size_t sibling = index ^ 1;
+        if (sibling < count) {
+            const uint8_t* node = &levels[depth][sibling * NODE_SIZE];
+            result.insert(result.end(), node, node + NODE_SIZE);
+        }
+        index /= 2;
+    }
+
+    return result;
+}
+
+std::vector<uint8_t> MerkleTree::root_from_path(const std::vector<uint8_t>& execution_hash,
+                                                uint32_t index, uint32_t count,
+                                                const std::vector<uint8_t>& path) {
+    if (execution_hash.size() != NODE_SIZE || count == 0 || count > MERKLE_MAX_LEAVES ||
+        index >= count || path.size() % NODE_SIZE != 0) {
+        return {};
+    }
+
+    uint8_t node[NODE_SIZE];
+    hash_node(MERKLE_LEAF_PREFIX, execution_hash.data(), nullptr, node);
+
+    size_t consumed = 0;
+    while (count > 1) {
+        if (index & 1) {
+            if (consumed + NODE_SIZE > path.size()) return {};
+            hash_node(MERKLE_NODE_PREFIX, &path[consumed], node, node);
+            consumed += NODE_SIZE;
+        } else if (index + 1 < count) {
+            if (consumed + NODE_SIZE > path.size()) return {};
+            hash_node(MERKLE_NODE_PREFIX, node, &path[consumed], node);
+            consumed += NODE_SIZE;
+        }
+        index /= 2;
+        count = (count + 1) / 2;
+    }
+
+    // 多余的路径节点说明序号或数量与路径不匹配
+    if (consumed != path.size()) {
+        return {};
+    }
+
+    return std::vector<uint8_t>(node, node + NODE_SIZE);
+}
+
+std::vector<uint8_t> MerkleTree::batch_digest(const std::vector<uint8_t>& root, uint32_t count) {
+    if (root.size() != NODE_SIZE) {
+        return {};
+    }
+
+    uint8_t buffer[1 + NODE_SIZE + 4];
+    buffer[0] = MERKLE_ROOT_PREFIX;
+    memcpy(buffer + 1, root.data(), NODE_SIZE);
+    for (int i = 0; i < 4; i++) {
+        buffer[1 + NODE_SIZE + i] = static_cast<uint8_t>(count >> (i * 8));
+    }
+
+    uint8_t digest[NODE_SIZE];
+    SHA256(buffer, sizeof(buffer), digest);
+    return std::vector<uint8_t>(digest, digest + NODE_SIZE);
+}
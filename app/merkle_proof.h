@@ -0,0 +1,65 @@
+#ifndef MERKLE_PROOF_H
+#define MERKLE_PROOF_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * 批量执行证明的Merkle树（主机侧）
+ * 构造规则与Enclave内的merkle_tree.cpp一致，见enclave_shared.h中的MERKLE_*定义
+ */
+class MerkleTree {
+private:
+    // levels[0]为叶子层，每层为连续存放的32字节节点
+    std::vector<std::vector<uint8_t>> levels;
+    size_t leaves;
+
+public:
+    /**
+     * 由执行哈希构造Merkle树
+     * @param execution_hashes 执行哈希（每个32字节）
+     */
+    explicit MerkleTree(const std::vector<std::vector<uint8_t>>& execution_hashes);
+
+    /**
+     * 获取叶子数量
+     * @return 叶子数量
+     */
+    size_t leaf_count() const { return leaves; }
+
+    /**
+     * 获取Merkle根
+     * @return 根哈希（树为空时为空）
+     */
+    std::vector<uint8_t> root() const;
+
+    /**
+     * 获取叶子的包含路径
+     * @param index 叶子序号
+     * @return 自底向上的兄弟节点（每个32字节，无兄弟节点的层不占位置）
+     */
+    std::vector<uint8_t> path(size_t index) const;
+
+    /**
+     * 由执行哈希和包含路径计算Merkle根
+     * @param execution_hash 执行哈希
+     * @param index 叶子序号
+     * @param count 叶子数量
+     * @param path 包含路径
+     * @return 根哈希（路径与序号、数量不匹配时为空）
+     */
+    static std::vector<uint8_t> root_from_path(const std::vector<uint8_t>& execution_hash,
+                                               uint32_t index, uint32_t count,
+                                               const std::vector<uint8_t>& path);
+
+    /**
+     * 计算批量证明的签名对象
+     * @param root Merkle根
+     * @param count 叶子数量
+     * @return 摘要
+     */
+    static std::vector<uint8_t> batch_digest(const std::vector<uint8_t>& root, uint32_t count);
+};
+
+#endif // MERKLE_PROOF_H
@@ -0,0 +1,162 @@
+#include "profile_report.h"
+#include "app_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// 热点操作码和热点基本块各输出的数量
+static const size_t REPORT_TOP_OPCODES = 5;
+static const size_t REPORT_TOP_BLOCKS = 5;
+
+static const char* const OPCODE_NAMES[PROFILE_OPCODE_SLOTS - 1] = {
+    "NOP", "PUSH", "POP", "ADD", "SUB", "MUL", "DIV", "MOD",
+    "AND", "OR", "XOR", "NOT", "EQ", "LT", "GT", "JMP",
+    "JMPIF", "CALL", "RET", "LOAD", "STORE", "HASH", "VERIFY", "COPY",
+    "VADD", "VXOR", "VCMP", "VSUM", "INPUT"
+};
+
+/**
+ * 获取统计槽对应的操作码名称
+ */
+static std::string slot_name(uint32_t slot) {
+    if (slot == PROFILE_OPCODE_SLOTS - 1) {
+        return "HALT/其他";
+    }
+    if (OPCODE_NAMES[slot]) {
+        return OPCODE_NAMES[slot];
+    }
+    std::ostringstream ss;
+    ss << "0x" << std::hex << std::setw(2) << std::setfill('0') << slot;
+    return ss.str();
+}
+
+/**
+ * 格式化命中率
+ */
+static std::string hit_rate(uint64_t hits, uint64_t misses) {
+    std::ostringstream ss;
+    ss << hits << " 命中 / " << misses << " 未命中";
+    if (hits + misses > 0) {
+        ss << " (" << std::fixed << std::setprecision(1)
+           << 100.0 * static_cast<double>(hits) / static_cast<double>(hits + misses) << "%)";
+    }
+    return ss.str();
+}
+
+bool ProfileSnapshot::parse(const std::vector<uint8_t>& data, ProfileSnapshot& snapshot) {
+    snapshot.contracts.clear();
+    if (data.size() < sizeof(snapshot.header)) {
+        return false;
+    }
+
+    memcpy(&snapshot.header, data.data(), sizeof(snapshot.header));
+    if (snapshot.header.version != PROFILE_VERSION || snapshot.header.contract_count > PROFILE_MAX_CONTRACTS) {
+        return false;
+    }
+
+    size_t offset = sizeof(snapshot.header);
+    for (uint32_t i = 0; i < snapshot.header.contract_count; i++) {
+        Contract contract;
+        if (data.size() - offset < sizeof(contract.summary)) {
+            return false;
+        }
+        memcpy(&contract.summary, data.data() + offset, sizeof(contract.summary));
+        offset += sizeof(contract.summary);
+
+        uint32_t block_count = contract.summary.block_count;
+        if (block_count > PROFILE_MAX_BLOCKS || data.size() - offset < block_count * sizeof(profile_block_t)) {
+            return false;
+        }
+        contract.blocks.resize(block_count);
+        if (block_count > 0) {
+            memcpy(contract.blocks.data(), data.data() + offset, block_count * sizeof(profile_block_t));
+        }
+        offset += block_count * sizeof(profile_block_t);
+
+        snapshot.contracts.push_back(std::move(contract));
+    }
+
+    return offset == data.size();
+}
+
+void log_profile_report(const ProfileSnapshot& snapshot, size_t max_contracts) {
+    const profile_snapshot_header_t& header = snapshot.header;
+
+    Logger::info("执行剖析: " + std::to_string(header.profiled_executions) + " 次执行, " +
+                 std::to_string(snapshot.contracts.size()) + " 个合约" +
+                 (header.executions_dropped > 0
+                      ? "（合约表已满，" + std::to_string(header.executions_dropped) + " 次执行未统计）"
+                      : ""));
+    Logger::info("字节码缓存: " + hit_rate(header.code_cache_hits, header.code_cache_misses) +
+                 ", 淘汰 " + std::to_string(header.code_cache_evictions));
+    Logger::info("状态缓存: " + hit_rate(header.state_cache_hits, header.state_cache_misses) +
+                 ", 淘汰 " + std::to_string(header.state_cache_evictions));
+    Logger::info("结果缓存: " + hit_rate(header.result_cache_hits, header.result_cache_misses) +
+                 ", 淘汰 " + std::to_string(header.result_cache_evictions) +
+                 ", 复用证明 " + std::to_string(header.result_cache_proof_hits));
+
+    std::vector<const ProfileSnapshot::Contract*> order;
+    for (const ProfileSnapshot::Contract& contract : snapshot.contracts) {
+        order.push_back(&contract);
+    }
+    std::sort(order.begin(), order.end(), [](const ProfileSnapshot::Contract* a, const ProfileSnapshot::Contract* b) {
+        return a->summary.gas_used > b->summary.gas_used;
+    });
+    if (order.size() > max_contracts) {
+        order.resize(max_contracts);
+    }
+
+    bool cycles = (header.flags & PROFILE_FLAG_CYCLES) != 0;
+    for (const ProfileSnapshot::Contract* contract : order) {
+        const profile_contract_t& summary = contract->summary;
+        std::vector<uint8_t> prefix(summary.code_hash, summary.code_hash + 8);
+
+        std::ostringstream line;
+        line << "合约 " << AppUtils::to_hex_string(prefix) << "...: " << summary.executions
+             << " 次执行, Gas " << summary.gas_used;
+        if (cycles && summary.executions > 0) {
+            line << ", 平均 " << summary.cycles / summary.executions << " 周期/次";
+        }
+        Logger::info(line.str());
+
+        // 热点操作码
+        std::vector<uint32_t> slots;
+        for (uint32_t slot = 0; slot < PROFILE_OPCODE_SLOTS; slot++) {
+            if (summary.opcode_counts[slot] > 0) {
+                slots.push_back(slot);
+            }
+        }
+        std::sort(slots.begin(), slots.end(), [&summary](uint32_t a, uint32_t b) {
+            return summary.opcode_counts[a] > summary.opcode_counts[b];
+        });
+        std::ostringstream opcodes;
+        opcodes << "  操作码:";
+        for (size_t i = 0; i < slots.size() && i < REPORT_TOP_OPCODES; i++) {
+            uint32_t slot = slots[i];
+            opcodes << " " << slot_name(slot) << "=" << summary.opcode_counts[slot];
+            if (cycles) {
+                opcodes << "(" << summary.opcode_cycles[slot] / summary.opcode_counts[slot] << "周期)";
+            }
+        }
+        Logger::info(opcodes.str());
+
+        // 热点基本块
+        std::vector<profile_block_t> blocks = contract->blocks;
+        std::sort(blocks.begin(), blocks.end(), [](const profile_block_t& a, const profile_block_t& b) {
+            return a.gas_used > b.gas_used;
+        });
+        std::ostringstream hot_blocks;
+        hot_blocks << "  基本块:";
+        for (size_t i = 0; i < blocks.size() && i < REPORT_TOP_BLOCKS; i++) {
+            hot_blocks << " @" << blocks[i].start_pc << " 进入" << blocks[i].entries
+                       << "次/Gas " << blocks[i].gas_used;
+        }
+        if (summary.blocks_dropped > 0) {
+            hot_blocks << "（另有 " << summary.blocks_dropped << " 次块入口未统计）";
+        }
+        Logger::info(hot_blocks.str());
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef PROFILE_REPORT_H
+#define PROFILE_REPORT_H
+
+#include "enclave_shared.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * 执行剖析快照（主机侧解析结果），快照格式见enclave_shared.h中的PROFILE_*定义
+ */
+struct ProfileSnapshot {
+    // 单个合约的统计
+    struct Contract {
+        profile_contract_t summary;
+        std::vector<profile_block_t> blocks;
+    };
+
+    profile_snapshot_header_t header;
+    std::vector<Contract> contracts;
+
+    /**
+     * 解析ecall_get_profile导出的快照
+     * @param data 快照数据
+     * @param snapshot 输出的解析结果
+     * @return 是否成功（版本不符或数据截断时为false）
+     */
+    static bool parse(const std::vector<uint8_t>& data, ProfileSnapshot& snapshot);
+};
+
+/**
+ * 通过Logger输出剖析报告：缓存命中率，以及按累计Gas排序的前若干个合约的
+ * 热点操作码和热点基本块
+ * @param snapshot 剖析快照
+ * @param max_contracts 最多输出的合约数
+ */
+void log_profile_report(const ProfileSnapshot& snapshot, size_t max_contracts = 8);
+
+#endif // PROFILE_REPORT_H
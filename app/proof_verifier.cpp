@@ -0,0 +1,284 @@
+#include "proof_verifier.h"
+#include "merkle_proof.h"
+#include "enclave_shared.h"
+
+#include <openssl/sha.h>
+#include <openssl/evp.h>
+#include <openssl/ec.h>
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/param_build.h>
+
+#include <thread>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/**
+ * 读取SGX小端格式的32字节整数
+ */
+BIGNUM* le_to_bn(const uint8_t* data) {
+    uint8_t be[32];
+    for (int i = 0; i < 32; i++) {
+        be[i] = data[31 - i];
+    }
+    return BN_bin2bn(be, sizeof(be), nullptr);
+}
+
+/**
+ * 由SGX格式的公钥（小端X|Y）构造P-256公钥，导入时检查点是否在曲线上
+ * @param public_key SGX格式的公钥（64字节）
+ * @return 公钥（无效时为nullptr）
+ */
+EVP_PKEY* decode_public_key(const uint8_t* public_key) {
+    // 未压缩点编码：0x04 | X（大端）| Y（大端）
+    uint8_t point[65];
+    point[0] = 0x04;
+    for (int i = 0; i < 32; i++) {
+        point[1 + i] = public_key[31 - i];
+        point[33 + i] = public_key[63 - i];
+    }
+
+    OSSL_PARAM_BLD* builder = OSSL_PARAM_BLD_new();
+    OSSL_PARAM* params = nullptr;
+    if (builder &&
+        OSSL_PARAM_BLD_push_utf8_string(builder, OSSL_PKEY_PARAM_GROUP_NAME, SN_X9_62_prime256v1, 0) == 1 &&
+        OSSL_PARAM_BLD_push_octet_string(builder, OSSL_PKEY_PARAM_PUB_KEY, point, sizeof(point)) == 1) {
+        params = OSSL_PARAM_BLD_to_param(builder);
+    }
+    OSSL_PARAM_BLD_free(builder);
+    if (!params) {
+        return nullptr;
+    }
+
+    EVP_PKEY* key = nullptr;
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_from_name(nullptr, "EC", nullptr);
+    if (!ctx || EVP_PKEY_fromdata_init(ctx) != 1 ||
+        EVP_PKEY_fromdata(ctx, &key, EVP_PKEY_PUBLIC_KEY, params) != 1) {
+        key = nullptr;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    OSSL_PARAM_free(params);
+    return key;
+}
+
+/**
+ * 已解码公钥缓存，每个验证线程独占一个
+ * 同时缓存已初始化的验证上下文，避免每次验证重新查找算法实现
+ */
+class KeyCache {
+private:
+    struct Entry {
+        EVP_PKEY* key;
+        EVP_PKEY_CTX* verify_ctx;
+    };
+
+    std::unordered_map<std::string, Entry> keys;
+
+public:
+    KeyCache() = default;
+    KeyCache(const KeyCache&) = delete;
+    KeyCache& operator=(const KeyCache&) = delete;
+
+    ~KeyCache() {
+        for (auto& entry : keys) {
+            EVP_PKEY_CTX_free(entry.second.verify_ctx);
+            EVP_PKEY_free(entry.second.key);
+        }
+    }
+
+    /**
+     * 获取公钥的验证上下文，首次使用时解码公钥
+     * @param public_key SGX格式的公钥（64字节）
+     * @return 验证上下文（公钥无效时为nullptr）
+     */
+    EVP_PKEY_CTX* get(const uint8_t* public_key) {
+        std::string id(reinterpret_cast<const char*>(public_key), 64);
+        auto it = keys.find(id);
+        if (it != keys.end()) {
+            return it->second.verify_ctx;
+        }
+
+        Entry entry = { decode_public_key(public_key), nullptr };
+        if (entry.key) {
+            entry.verify_ctx = EVP_PKEY_CTX_new_from_pkey(nullptr, entry.key, nullptr);
+            if (entry.verify_ctx && EVP_PKEY_verify_init(entry.verify_ctx) != 1) {
+                EVP_PKEY_CTX_free(entry.verify_ctx);
+                entry.verify_ctx = nullptr;
+            }
+        }
+
+        keys.emplace(id, entry);
+        return entry.verify_ctx;
+    }
+};
+
+/**
+ * 验证证明的签名
+ * @param cache 公钥缓存
+ * @param proof_data execution_proof_t
+ * @param signed_hash 签名覆盖的哈希
+ * @return 是否有效
+ */
+bool verify_signature(KeyCache& cache, const std::set<std::vector<uint8_t>>& trusted_keys,
+                      const uint8_t* proof_data, const uint8_t* signed_hash) {
+    if (memcmp(proof_data, signed_hash, 32) != 0) {
+        return false;
+    }
+
+    const uint8_t* public_key = proof_data + EXECUTION_PROOF_PUBLIC_KEY_OFFSET;
+    if (trusted_keys.count(std::vector<uint8_t>(public_key, public_key + 64)) == 0) {
+        return false;
+    }
+
+    EVP_PKEY_CTX* verify_ctx = cache.get(public_key);
+    if (!verify_ctx) {
+        return false;
+    }
+
+    // sgx_ecdsa_sign对签名字段之前的所有字节做SHA-256后签名
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256(proof_data, EXECUTION_PROOF_SIGNATURE_OFFSET, digest);
+
+    // EVP_PKEY_verify接受DER编码的签名
+    const uint8_t* signature = proof_data + EXECUTION_PROOF_SIGNATURE_OFFSET;
+    ECDSA_SIG* sig = ECDSA_SIG_new();
+    BIGNUM* r = le_to_bn(signature);
+    BIGNUM* s = le_to_bn(signature + 32);
+    if (!sig || !r || !s || ECDSA_SIG_set0(sig, r, s) != 1) {
+        BN_free(r);
+        BN_free(s);
+        ECDSA_SIG_free(sig);
+        return false;
+    }
+
+    uint8_t* der = nullptr;
+    int der_size = i2d_ECDSA_SIG(sig, &der);
+    ECDSA_SIG_free(sig);
+    if (der_size <= 0) {
+        return false;
+    }
+
+    bool valid = EVP_PKEY_verify(verify_ctx, der, static_cast<size_t>(der_size), digest, sizeof(digest)) == 1;
+    OPENSSL_free(der);
+    return valid;
+}
+
+} // namespace
+
+ProofVerifier::ProofVerifier(size_t threads) : thread_count(threads) {
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+}
+
+bool ProofVerifier::add_trusted_key(const std::vector<uint8_t>& public_key) {
+    if (public_key.size() != 64) {
+        return false;
+    }
+
+    KeyCache cache;
+    if (!cache.get(public_key.data())) {
+        return false;
+    }
+
+    trusted_keys.insert(public_key);
+    return true;
+}
+
+std::vector<uint8_t> ProofVerifier::signed_hash(const ExecutionProof& proof) {
+    if (proof.proof_data.size() != EXECUTION_PROOF_SIZE) {
+        return {};
+    }
+
+    if (proof.leaf_count == 0) {
+        // 未单独给出执行哈希时取证明开头的哈希
+        if (proof.execution_hash.empty()) {
+            return std::vector<uint8_t>(proof.proof_data.begin(), proof.proof_data.begin() + 32);
+        }
+        return proof.execution_hash.size() == 32 ? proof.execution_hash : std::vector<uint8_t>();
+    }
+
+    std::vector<uint8_t> root = MerkleTree::root_from_path(proof.execution_hash, proof.leaf_index,
+                                                           proof.leaf_count, proof.merkle_path);
+    if (root.empty()) {
+        return {};
+    }
+    return MerkleTree::batch_digest(root, proof.leaf_count);
+}
+
+bool ProofVerifier::verify(const ExecutionProof& proof) const {
+    std::vector<uint8_t> hash = signed_hash(proof);
+    if (hash.empty()) {
+        return false;
+    }
+
+    KeyCache cache;
+    return verify_signature(cache, trusted_keys, proof.proof_data.data(), hash.data());
+}
+
+std::vector<bool> ProofVerifier::verify_batch(const std::vector<ExecutionProof>& proofs) const {
+    std::vector<bool> valid(proofs.size(), false);
+
+    // 同一批量证明的各项共享根证明和签名对象，只需验证一次签名
+    std::vector<std::vector<uint8_t>> hashes(proofs.size());
+    std::vector<size_t> unique_of(proofs.size(), SIZE_MAX);
+    std::vector<size_t> uniques;
+    std::unordered_map<std::string, size_t> seen;
+    for (size_t i = 0; i < proofs.size(); i++) {
+        hashes[i] = signed_hash(proofs[i]);
+        if (hashes[i].empty()) {
+            continue;
+        }
+
+        std::string id(proofs[i].proof_data.begin(), proofs[i].proof_data.end());
+        id.append(hashes[i].begin(), hashes[i].end());
+        auto inserted = seen.emplace(std::move(id), uniques.size());
+        if (inserted.second) {
+            uniques.push_back(i);
+        }
+        unique_of[i] = inserted.first->second;
+    }
+
+    // 各线程按块领取待验证的签名
+    std::vector<uint8_t> unique_valid(uniques.size(), 0);
+    std::atomic<size_t> next(0);
+    const size_t chunk = 64;
+    auto worker = [&]() {
+        KeyCache cache;
+        for (;;) {
+            size_t begin = next.fetch_add(chunk);
+            if (begin >= uniques.size()) {
+                break;
+            }
+            size_t end = std::min(begin + chunk, uniques.size());
+            for (size_t k = begin; k < end; k++) {
+                size_t i = uniques[k];
+                unique_valid[k] = verify_signature(cache, trusted_keys, proofs[i].proof_data.data(),
+                                                   hashes[i].data()) ? 1 : 0;
+            }
+        }
+    };
+
+    size_t threads = std::min(thread_count, (uniques.size() + chunk - 1) / chunk);
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < proofs.size(); i++) {
+        if (unique_of[i] != SIZE_MAX) {
+            valid[i] = unique_valid[unique_of[i]] != 0;
+        }
+    }
+
+    return valid;
+}
@@ -0,0 +1,57 @@
+#ifndef PROOF_VERIFIER_H
+#define PROOF_VERIFIER_H
+
+#include "app.h"
+
+#include <vector>
+#include <set>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * 主机侧执行证明验证器，不需要Enclave
+ * 使用OpenSSL验证ECDSA签名，只接受受信任公钥（ecall_get_signing_public_key导出）签名的证明
+ */
+class ProofVerifier {
+private:
+    std::set<std::vector<uint8_t>> trusted_keys;
+    size_t thread_count;
+
+public:
+    /**
+     * 创建验证器
+     * @param threads 批量验证的线程数（0表示使用全部CPU核）
+     */
+    explicit ProofVerifier(size_t threads = 0);
+
+    /**
+     * 添加受信任的签名公钥
+     * @param public_key SGX格式的公钥（64字节）
+     * @return 公钥格式是否正确
+     */
+    bool add_trusted_key(const std::vector<uint8_t>& public_key);
+
+    /**
+     * 计算证明签名所覆盖的哈希
+     * 单条证明为执行哈希，批量证明为由包含路径还原的Merkle根摘要
+     * @param proof 执行证明
+     * @return 哈希（包含路径不匹配时为空）
+     */
+    static std::vector<uint8_t> signed_hash(const ExecutionProof& proof);
+
+    /**
+     * 验证单条证明
+     * @param proof 执行证明
+     * @return 是否有效
+     */
+    bool verify(const ExecutionProof& proof) const;
+
+    /**
+     * 并行验证多条证明，共享同一根证明的批量证明项只验证一次签名
+     * @param proofs 执行证明
+     * @return 每条证明是否有效
+     */
+    std::vector<bool> verify_batch(const std::vector<ExecutionProof>& proofs) const;
+};
+
+#endif // PROOF_VERIFIER_H
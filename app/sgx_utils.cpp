@@ -1,12 +1,27 @@
 #include "app.h"
 #include "app_utils.h"
+#include "enclave_shared.h"
+#include "merkle_proof.h"
+#include "proof_verifier.h"
+#include "profile_report.h"
+#include "audit_log.h"
+#include "contract_repository.h"
+#include "config_watcher.h"
+#include "sgx_uswitchless.h"
+#include <openssl/sha.h>
 #include <fstream>
 #include <iomanip>
-#include <chrono>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <unordered_map>
+#include <sys/mman.h>
 
 // SGXSmartContractApp类实现
-SGXSmartContractApp::SGXSmartContractApp() : enclave_id(0), enclave_initialized(false) {
+SGXSmartContractApp::SGXSmartContractApp()
+    : enclave_id(0), enclave_initialized(false), profiling_enabled(false),
+      switchless_enabled(Config::get_bool("performance.switchless.enabled", false)) {
 }
 
 SGXSmartContractApp::~SGXSmartContractApp() {
@@ -18,158 +33,1486 @@ app_status_t SGXSmartContractApp::initialize_enclave() {
         return APP_SUCCESS;
     }
     
-    sgx_status_t ret = sgx_create_enclave(ENCLAVE_FILENAME, SGX_DEBUG_FLAG, NULL, NULL, &enclave_id, NULL);
+    sgx_status_t ret = SGX_ERROR_UNEXPECTED;
+    if (switchless_enabled) {
+        // 可信工作线程各占用一个TCS，会减少可用于并行执行的TCS数量
+        sgx_uswitchless_config_t us_config = SGX_USWITCHLESS_CONFIG_INITIALIZER;
+        us_config.num_uworkers = static_cast<uint32_t>(Config::get_int("performance.switchless.untrusted_workers", 2));
+        us_config.num_tworkers = static_cast<uint32_t>(Config::get_int("performance.switchless.trusted_workers", 2));
+        
+        const void* enclave_ex_p[32] = { 0 };
+        enclave_ex_p[SGX_CREATE_ENCLAVE_EX_SWITCHLESS_BIT_IDX] = &us_config;
+        
+        ret = sgx_create_enclave_ex(ENCLAVE_FILENAME, SGX_DEBUG_FLAG, NULL, NULL, &enclave_id, NULL,
+                                    SGX_CREATE_ENCLAVE_EX_SWITCHLESS, enclave_ex_p);
+    } else {
+        ret = sgx_create_enclave(ENCLAVE_FILENAME, SGX_DEBUG_FLAG, NULL, NULL, &enclave_id, NULL);
+    }
+    
     if (ret != SGX_SUCCESS) {
         print_error("创建Enclave失败: 0x" + std::to_string(ret));
         return APP_ERROR_ENCLAVE_INIT;
     }
     
-    // 初始化验证器
+    // 恢复上次密封的证明签名密钥，没有时由验证器初始化生成
+    const std::string key_file = sealed_signing_key_path();
+    bool key_loaded = load_sealed_signing_key(enclave_id, key_file);
+    
+    // 初始化验证器
+    gas_schedule_t schedule;
+    build_gas_schedule(schedule);
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    ret = ecall_init_contract_verifier(enclave_id, &enclave_ret,
+                                       reinterpret_cast<const uint8_t*>(&schedule), sizeof(schedule));
+    if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+        print_error("初始化验证器失败");
+        sgx_destroy_enclave(enclave_id);
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    if (!key_loaded && !store_sealed_signing_key(enclave_id, key_file)) {
+        print_warning("无法保存证明签名密钥，重启后将使用新密钥");
+    }
+    
+    enclave_initialized = true;
+    
+    // 热点合约编译为本地代码（需要Enclave配置可执行的保留内存）
+    if (Config::get_bool("performance.jit.enabled", false)) {
+        set_jit_threshold(static_cast<uint32_t>(Config::get_int("performance.jit.call_threshold", 64)));
+        set_execution_backend(EXECUTION_BACKEND_JIT);
+    }
+    
+    // 单次执行使用共享环形缓冲区
+    if (Config::get_bool("performance.shared_ring.enabled", false)) {
+        size_t ring_size = static_cast<size_t>(Config::get_int("performance.shared_ring.size_kb", 4096)) * 1024;
+        if (enable_shared_ring(ring_size) != APP_SUCCESS) {
+            print_warning("无法注册共享环形缓冲区，继续使用普通ECALL");
+        }
+    }
+    
+    // 合约状态持久化（状态日志见state.log_file）
+    if (Config::get_bool("state.persistent", false)) {
+        uint64_t budget = static_cast<uint64_t>(Config::get_int("state.cache_budget_kb", 0)) * 1024;
+        if (configure_state(true, budget) != APP_SUCCESS) {
+            print_warning("无法启用合约状态持久化");
+        }
+    }
+    
+    // 合约仓库只读映射，启动时一次预热字节码缓存
+    repository.reset(new ContractRepository(
+        Config::get_string("storage.contract_repository", Config::data_directory + "/contracts.repo")));
+    if (repository->is_open() && Config::get_bool("storage.warm_code_cache", true)) {
+        size_t loaded = 0;
+        if (warm_code_cache(loaded) == APP_SUCCESS) {
+            print_success("字节码缓存已预热: " + std::to_string(loaded) + "/" +
+                       std::to_string(repository->entry_count()) + " 个合约");
+        } else {
+            print_warning("无法预热字节码缓存");
+        }
+    }
+    
+    // 审计记录由读取线程批量取出
+    if (Config::get_bool("security.enable_audit_logging", true)) {
+        audit_reader.reset(new AuditReader(*this,
+            static_cast<uint32_t>(Config::get_int("security.audit_read_interval_ms", 100))));
+    }
+    
+    // 缓存预算和执行剖析，配置文件变化后由监视线程重新应用
+    if (apply_runtime_config() != APP_SUCCESS) {
+        print_warning("无法应用运行时配置");
+    }
+    if (Config::get_bool("performance.config_hot_reload", false)) {
+        config_watcher.reset(new ConfigWatcher(Config::file_path(), [this]() {
+            if (apply_runtime_config() != APP_SUCCESS) {
+                print_warning("无法应用更新后的运行时配置");
+            }
+        }));
+    }
+    
+    print_success("Enclave初始化成功，EID: " + std::to_string(enclave_id) +
+                  (switchless_enabled ? "（免切换模式）" : ""));
+    return APP_SUCCESS;
+}
+
+void SGXSmartContractApp::destroy_enclave() {
+    // 先停止配置监视和工作线程，确保没有线程仍在Enclave内；读取线程停止前取出剩余的审计记录
+    config_watcher.reset();
+    worker_pool.reset();
+    audit_reader.reset();
+    
+    if (enclave_initialized && enclave_id != 0) {
+        // 销毁前输出剖析报告
+        std::vector<uint8_t> snapshot;
+        ProfileSnapshot profile;
+        if (profiling_enabled && get_profile(snapshot) == APP_SUCCESS &&
+            ProfileSnapshot::parse(snapshot, profile)) {
+            log_profile_report(profile);
+        }
+        
+        sgx_destroy_enclave(enclave_id);
+        enclave_id = 0;
+        enclave_initialized = false;
+        print_success("Enclave已销毁");
+    }
+    
+    // Enclave销毁后才能释放已注册的共享内存
+    shared_ring.reset();
+}
+
+app_status_t SGXSmartContractApp::load_contract_from_file(const std::string& filename, SmartContract& contract) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        print_error("无法打开合约文件: " + filename);
+        return APP_ERROR_FILE_IO;
+    }
+    
+    file.seekg(0, std::ios::end);
+    size_t size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    
+    if (size > MAX_CONTRACT_SIZE) {
+        print_error("合约文件过大: " + std::to_string(size) + " bytes");
+        return APP_ERROR_INVALID_PARAM;
+    }
+    
+    contract.bytecode.resize(size);
+    file.read(reinterpret_cast<char*>(contract.bytecode.data()), size);
+    contract.name = filename;
+    
+    print_success("加载合约成功: " + std::to_string(size) + " bytes");
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::add_to_repository(const std::vector<SmartContract>& contracts) {
+    if (!enclave_initialized) {
+        print_error("Enclave未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    std::vector<ContractRepository::Entry> entries;
+    if (repository && repository->is_open()) {
+        repository->read_entries(entries);
+    }
+    
+    for (const SmartContract& contract : contracts) {
+        ContractRepository::Entry entry;
+        entry.bytecode = contract.bytecode;
+        entry.code_hash.resize(SHA256_DIGEST_LENGTH);
+        SHA256(contract.bytecode.data(), contract.bytecode.size(), entry.code_hash.data());
+        entry.sealed_meta.resize(CONTRACT_REPO_MAX_META_SIZE);
+        
+        size_t sealed_size = 0;
+        sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+        sgx_status_t ret = ecall_seal_contract_metadata(enclave_id, &enclave_ret,
+                                                        contract.bytecode.data(), contract.bytecode.size(),
+                                                        entry.sealed_meta.data(), entry.sealed_meta.size(),
+                                                        &sealed_size);
+        if (ret != SGX_SUCCESS) {
+            AppUtils::print_sgx_status(ret, "ecall_seal_contract_metadata");
+            return APP_ERROR_ENCLAVE_CALL;
+        }
+        if (enclave_ret != SGX_SUCCESS) {
+            print_error("合约验证失败，未加入仓库: " + contract.name);
+            return APP_ERROR_INVALID_PARAM;
+        }
+        
+        entry.sealed_meta.resize(sealed_size);
+        entries.push_back(std::move(entry));
+    }
+    
+    std::string path = repository ? repository->file_path()
+                                  : Config::get_string("storage.contract_repository",
+                                                       Config::data_directory + "/contracts.repo");
+    app_status_t status = ContractRepository::write(path, std::move(entries));
+    if (status != APP_SUCCESS) {
+        print_error("无法写入合约仓库: " + path);
+        return status;
+    }
+    
+    repository.reset(new ContractRepository(path));
+    print_success("合约仓库已更新: " + std::to_string(repository->entry_count()) + " 个合约");
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::warm_code_cache(size_t& loaded) {
+    loaded = 0;
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    if (!repository || !repository->is_open()) {
+        return APP_ERROR_FILE_IO;
+    }
+    
+    // Enclave会顺序读取整个映射，预先读入页缓存
+    madvise(const_cast<uint8_t*>(repository->mapped_data()), repository->mapped_size(), MADV_WILLNEED);
+    
+    uint32_t cached = 0;
+    uint32_t rejected = 0;
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_warm_code_cache(enclave_id, &enclave_ret, repository->mapped_data(),
+                                             repository->mapped_size(), &cached, &rejected);
+    if (ret != SGX_SUCCESS) {
+        AppUtils::print_sgx_status(ret, "ecall_warm_code_cache");
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    if (enclave_ret != SGX_SUCCESS) {
+        AppUtils::print_sgx_status(enclave_ret, "预热字节码缓存");
+        return APP_ERROR_INVALID_PARAM;
+    }
+    
+    // 元数据由其他签名者密封或条目被篡改时被拒绝，这些合约在首次执行时照常验证
+    if (rejected > 0) {
+        print_warning("合约仓库中有 " + std::to_string(rejected) + " 个条目未通过校验");
+    }
+    
+    loaded = cached;
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::load_contract_by_hash(const std::vector<uint8_t>& code_hash,
+                                                        SmartContract& contract) {
+    if (!repository || !repository->load(code_hash, contract)) {
+        return APP_ERROR_FILE_IO;
+    }
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::execute_contract(const SmartContract& contract,
+                                                  const std::vector<uint8_t>& input_data,
+                                                  ExecutionResult& result) {
+    if (!enclave_initialized) {
+        print_error("Enclave未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    if (contract.bytecode.empty()) {
+        print_error("合约字节码为空");
+        return APP_ERROR_INVALID_PARAM;
+    }
+    
+    // 准备执行参数
+    const uint8_t* contract_code = contract.bytecode.data();
+    size_t code_size = contract.bytecode.size();
+    const uint8_t* input = input_data.empty() ? nullptr : input_data.data();
+    size_t input_size = input_data.size();
+    
+    // 结果缓冲区
+    uint8_t result_buffer[MAX_OUTPUT_SIZE];
+    size_t result_size = sizeof(result_buffer);
+    uint8_t execution_hash[32];
+    uint64_t gas_used = 0;
+    
+    // 调用Enclave执行合约
+    sgx_status_t ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    
+    if (!shared_ring || !execute_shared(contract_code, code_size, input, input_size, contract.gas_limit,
+                                        result_buffer, sizeof(result_buffer), &result_size,
+                                        execution_hash, &gas_used, &enclave_ret, &ret)) {
+        ret = ecall_execute_contract(
+            enclave_id,
+            &enclave_ret,
+            contract_code,
+            code_size,
+            input,
+            input_size,
+            contract.gas_limit,
+            result_buffer,
+            sizeof(result_buffer),
+            &result_size,
+            execution_hash,
+            &gas_used
+        );
+    }
+    
+    if (ret != SGX_SUCCESS) {
+        result.success = false;
+        result.error_message = "SGX调用失败: 0x" + std::to_string(ret);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    result.gas_used = gas_used;
+    if (enclave_ret != SGX_SUCCESS) {
+        result.success = false;
+        result.error_message = "合约执行失败: 0x" + std::to_string(enclave_ret);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    // 填充执行结果
+    result.success = true;
+    result.output.assign(result_buffer, result_buffer + result_size);
+    result.execution_hash.assign(execution_hash, execution_hash + 32);
+    
+    return APP_SUCCESS;
+}
+
+bool SGXSmartContractApp::execute_shared(const uint8_t* code, size_t code_size,
+                                         const uint8_t* input, size_t input_size, uint64_t gas_limit,
+                                         uint8_t* result, size_t result_capacity, size_t* result_size,
+                                         uint8_t* execution_hash, uint64_t* gas_used,
+                                         sgx_status_t* enclave_ret, sgx_status_t* ret) {
+    // 区域布局：字节码 | 输入 | 结果，各自按SHARED_RING_ALIGN对齐
+    auto aligned = [](size_t size) {
+        return (size + SHARED_RING_ALIGN - 1) / SHARED_RING_ALIGN * SHARED_RING_ALIGN;
+    };
+    size_t input_offset = aligned(code_size);
+    size_t result_offset = input_offset + aligned(input_size);
+    
+    SharedRing::Span span;
+    if (code_size > SHARED_RING_MAX_CODE_SIZE || !shared_ring->acquire(result_offset + result_capacity, span)) {
+        return false;
+    }
+    
+    uint8_t* base = shared_ring->data() + span.offset;
+    memcpy(base, code, code_size);
+    if (input_size > 0) {
+        memcpy(base + input_offset, input, input_size);
+    }
+    
+    *ret = ecall_execute_shared(
+        enclave_id,
+        enclave_ret,
+        span.offset,
+        code_size,
+        span.offset + input_offset,
+        input_size,
+        gas_limit,
+        span.offset + result_offset,
+        result_capacity,
+        result_size,
+        execution_hash,
+        gas_used
+    );
+    
+    if (*ret == SGX_SUCCESS && *enclave_ret == SGX_SUCCESS && *result_size <= result_capacity) {
+        memcpy(result, base + result_offset, *result_size);
+    }
+    
+    shared_ring->release(span);
+    return true;
+}
+
+app_status_t SGXSmartContractApp::verify_contract_execution(const SmartContract& contract,
+                                                            const std::vector<uint8_t>& input_data,
+                                                            ExecutionResult& result) {
+    if (!enclave_initialized) {
+        print_error("Enclave未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    if (contract.bytecode.empty() || input_data.empty()) {
+        print_error("合约字节码或输入数据为空");
+        return APP_ERROR_INVALID_PARAM;
+    }
+    
+    uint8_t result_buffer[MAX_OUTPUT_SIZE];
+    size_t result_size = 0;
+    uint64_t gas_used = 0;
+    
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_verify_contract_execution(
+        enclave_id,
+        &enclave_ret,
+        contract.bytecode.data(),
+        contract.bytecode.size(),
+        input_data.data(),
+        input_data.size(),
+        result_buffer,
+        sizeof(result_buffer),
+        &result_size,
+        &gas_used
+    );
+    
+    if (ret != SGX_SUCCESS) {
+        result.success = false;
+        result.error_message = "SGX调用失败: 0x" + std::to_string(ret);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    if (enclave_ret != SGX_SUCCESS) {
+        result.success = false;
+        result.error_message = "合约验证失败: 0x" + std::to_string(enclave_ret);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    result.success = true;
+    result.output.assign(result_buffer, result_buffer + result_size);
+    result.gas_used = gas_used;
+    
+    return APP_SUCCESS;
+}
+
+/**
+ * 在批量请求末尾追加一条任务记录（记录按8字节对齐，填充部分为0）
+ */
+void append_job_record(std::vector<uint8_t>& request, const ContractJob& job, bool by_hash) {
+    size_t code_size = by_hash ? 0 : job.contract->bytecode.size();
+    
+    batch_job_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.flags = by_hash ? BATCH_JOB_FLAG_BY_HASH : 0;
+    header.code_size = static_cast<uint32_t>(code_size);
+    header.input_size = static_cast<uint32_t>(job.input_data.size());
+    header.gas_limit = job.gas_limit;
+    if (by_hash) {
+        memcpy(header.code_hash, job.code_hash.data(), sizeof(header.code_hash));
+    }
+    
+    size_t record_offset = request.size();
+    request.resize(record_offset + batch_job_record_size(code_size, job.input_data.size()), 0);
+    uint8_t* record = request.data() + record_offset;
+    memcpy(record, &header, sizeof(header));
+    if (code_size > 0) {
+        memcpy(record + sizeof(header), job.contract->bytecode.data(), code_size);
+    }
+    if (!job.input_data.empty()) {
+        memcpy(record + sizeof(header) + code_size, job.input_data.data(), job.input_data.size());
+    }
+}
+
+/**
+ * 把一条批量结果转换为ExecutionResult
+ * @param response 批量结果缓冲区
+ * @param record_count 结果记录数量（数据区紧随其后）
+ * @param index 记录下标
+ * @param result 输出结果
+ * @return 任务的执行状态
+ */
+static sgx_status_t read_batch_result(const std::vector<uint8_t>& response, size_t record_count,
+                                      size_t index, ExecutionResult& result) {
+    batch_result_t record;
+    memcpy(&record, response.data() + index * sizeof(batch_result_t), sizeof(record));
+    const uint8_t* result_data = response.data() + record_count * sizeof(batch_result_t);
+    
+    sgx_status_t job_status = static_cast<sgx_status_t>(record.status);
+    result.gas_used = record.gas_used;
+    result.code_hash.assign(record.code_hash, record.code_hash + sizeof(record.code_hash));
+    
+    if (job_status != SGX_SUCCESS) {
+        result.success = false;
+        result.error_message = "合约执行失败: 0x" + std::to_string(job_status);
+        return job_status;
+    }
+    
+    if (static_cast<size_t>(record.result_offset) + record.result_size > BATCH_RESULT_DATA_SIZE) {
+        result.success = false;
+        result.error_message = "批量结果越界";
+        return job_status;
+    }
+    
+    result.success = true;
+    result.output.assign(result_data + record.result_offset,
+                         result_data + record.result_offset + record.result_size);
+    result.execution_hash.assign(record.execution_hash,
+                                 record.execution_hash + sizeof(record.execution_hash));
+    return job_status;
+}
+
+app_status_t SGXSmartContractApp::execute_batch(const std::vector<ContractJob>& jobs,
+                                                std::vector<ExecutionResult>& results) {
+    if (!enclave_initialized) {
+        print_error("Enclave未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    results.assign(jobs.size(), ExecutionResult());
+    if (jobs.empty()) {
+        return APP_SUCCESS;
+    }
+    
+    std::vector<size_t> indices(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        indices[i] = i;
+    }
+    
+    return run_jobs(jobs, indices, results);
+}
+
+app_status_t SGXSmartContractApp::execute_parallel(const std::vector<ContractJob>& jobs,
+                                                   std::vector<ExecutionResult>& results,
+                                                   size_t thread_count) {
+    if (!enclave_initialized) {
+        print_error("Enclave未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    results.assign(jobs.size(), ExecutionResult());
+    if (jobs.empty()) {
+        return APP_SUCCESS;
+    }
+    
+    WorkerPool& pool = pool_for(thread_count);
+    thread_count = pool.size();
+    
+    // 按线程数切分任务，每个分片是单个工作线程的一批ECALL
+    size_t chunk_size = (jobs.size() + thread_count - 1) / thread_count;
+    chunk_size = std::min<size_t>(chunk_size, batch_job_limit());
+    
+    std::atomic<int> failed(APP_SUCCESS);
+    for (size_t begin = 0; begin < jobs.size(); begin += chunk_size) {
+        size_t end = std::min(begin + chunk_size, jobs.size());
+        pool.submit([this, &jobs, &results, &failed, begin, end]() {
+            std::vector<size_t> indices;
+            indices.reserve(end - begin);
+            for (size_t i = begin; i < end; i++) {
+                indices.push_back(i);
+            }
+            
+            // 各分片只写入自己的结果下标，无需加锁
+            app_status_t status = run_jobs(jobs, indices, results);
+            if (status != APP_SUCCESS) {
+                failed.store(status);
+            }
+        });
+    }
+    
+    pool.wait_all();
+    
+    return static_cast<app_status_t>(failed.load());
+}
+
+app_status_t SGXSmartContractApp::execute_block(const std::vector<ContractJob>& jobs,
+                                                std::vector<ExecutionResult>& results,
+                                                size_t thread_count,
+                                                block_exec_stats_t* stats) {
+    if (!enclave_initialized) {
+        print_error("Enclave未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    results.assign(jobs.size(), ExecutionResult());
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+    if (jobs.empty()) {
+        return APP_SUCCESS;
+    }
+    
+    WorkerPool& pool = pool_for(thread_count);
+    
+    std::vector<uint8_t> request;
+    std::vector<uint8_t> response;
+    std::vector<size_t> chunk;
+    request.reserve(BATCH_MAX_REQUEST_SIZE);
+    const size_t job_limit = batch_job_limit();
+    
+    // 执行并提交当前区块
+    auto run_block = [&]() -> app_status_t {
+        if (chunk.empty()) {
+            return APP_SUCCESS;
+        }
+        
+        uint32_t block_id = 0;
+        sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+        sgx_status_t ret = ecall_block_begin(enclave_id, &enclave_ret, request.data(), request.size(),
+                                             static_cast<uint32_t>(chunk.size()), &block_id);
+        if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+            print_error("打开区块失败: 0x" + std::to_string(ret != SGX_SUCCESS ? ret : enclave_ret));
+            return APP_ERROR_ENCLAVE_CALL;
+        }
+        
+        // 每个工作线程只进入Enclave一次，在Enclave内领取事务直到领完；
+        // 没有被执行的事务由提交时补上，因此不检查返回值
+        size_t workers = std::min(pool.size(), chunk.size());
+        for (size_t i = 0; i < workers; i++) {
+            pool.submit([this, block_id]() {
+                sgx_status_t execute_ret = SGX_ERROR_UNEXPECTED;
+                ecall_block_execute(enclave_id, &execute_ret, block_id);
+            });
+        }
+        pool.wait_all();
+        
+        size_t records_size = chunk.size() * sizeof(batch_result_t);
+        response.assign(records_size + BATCH_RESULT_DATA_SIZE, 0);
+        block_exec_stats_t block_stats;
+        memset(&block_stats, 0, sizeof(block_stats));
+        
+        enclave_ret = SGX_ERROR_UNEXPECTED;
+        ret = ecall_block_commit(enclave_id, &enclave_ret, block_id, response.data(), response.size(),
+                                 reinterpret_cast<uint8_t*>(&block_stats), sizeof(block_stats));
+        if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+            print_error("提交区块失败: 0x" + std::to_string(ret != SGX_SUCCESS ? ret : enclave_ret));
+            return APP_ERROR_ENCLAVE_CALL;
+        }
+        
+        for (size_t i = 0; i < chunk.size(); i++) {
+            read_batch_result(response, chunk.size(), i, results[chunk[i]]);
+        }
+        if (stats) {
+            stats->tx_count += block_stats.tx_count;
+            stats->contract_count += block_stats.contract_count;
+            stats->executions += block_stats.executions;
+            stats->reexecutions += block_stats.reexecutions;
+            stats->state_updates += block_stats.state_updates;
+        }
+        
+        request.clear();
+        chunk.clear();
+        return APP_SUCCESS;
+    };
+    
+    // 超过一个区块上限的任务按顺序拆成多个区块，前一个区块提交后才执行下一个
+    for (size_t index = 0; index < jobs.size(); index++) {
+        const ContractJob& job = jobs[index];
+        
+        // 区块中的任务不能再携带字节码重新提交，只有没有字节码的任务按哈希引用
+        bool by_hash = !job.contract && job.code_hash.size() == 32;
+        if (!by_hash && (!job.contract || job.contract->bytecode.empty())) {
+            results[index].success = false;
+            results[index].error_message = "合约字节码为空";
+            continue;
+        }
+        
+        size_t code_size = by_hash ? 0 : job.contract->bytecode.size();
+        size_t record_size = batch_job_record_size(code_size, job.input_data.size());
+        if (chunk.size() == job_limit || request.size() + record_size > BATCH_MAX_REQUEST_SIZE) {
+            app_status_t status = run_block();
+            if (status != APP_SUCCESS) {
+                return status;
+            }
+        }
+        
+        // 单个任务超过区块上限时在前面的区块提交后单独执行，顺序不变
+        if (record_size > BATCH_MAX_REQUEST_SIZE) {
+            if (!job.contract) {
+                results[index].success = false;
+                results[index].error_message = "任务超过区块大小上限";
+                continue;
+            }
+            SmartContract contract = *job.contract;
+            contract.gas_limit = job.gas_limit;
+            execute_contract(contract, job.input_data, results[index]);
+            continue;
+        }
+        
+        append_job_record(request, job, by_hash);
+        chunk.push_back(index);
+    }
+    
+    return run_block();
+}
+
+size_t SGXSmartContractApp::worker_thread_count(size_t requested) {
+    // 线程数受TCS数量限制，超过时ECALL会返回SGX_ERROR_OUT_OF_TCS
+    if (requested == 0) {
+        int configured = Config::get_int("performance.worker_threads", 0);
+        requested = configured > 0 ? static_cast<size_t>(configured) : 0;
+    }
+    if (requested == 0) {
+        requested = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return std::min<size_t>(requested, ENCLAVE_TCS_NUM);
+}
+
+size_t SGXSmartContractApp::batch_job_limit() {
+    int configured = Config::get_int("performance.batch_size", BATCH_MAX_JOBS);
+    return configured > 0 ? std::min<size_t>(static_cast<size_t>(configured), BATCH_MAX_JOBS) : BATCH_MAX_JOBS;
+}
+
+WorkerPool& SGXSmartContractApp::pool_for(size_t thread_count) {
+    if (thread_count == 0 && !cpu_affinity.empty() && Config::get_int("performance.worker_threads", 0) <= 0) {
+        thread_count = cpu_affinity.size();
+    }
+    thread_count = worker_thread_count(thread_count);
+    
+    if (!worker_pool || worker_pool->size() != thread_count) {
+        worker_pool.reset(new WorkerPool(thread_count, cpu_affinity));
+    }
+    return *worker_pool;
+}
+
+app_status_t SGXSmartContractApp::execute_slice(const SmartContract& contract,
+                                                const std::vector<uint8_t>& input_data,
+                                                uint64_t slice_gas,
+                                                std::vector<uint8_t>& snapshot,
+                                                bool& suspended,
+                                                ExecutionResult& result) {
+    suspended = false;
+    if (!enclave_initialized) {
+        print_error("Enclave未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    if (contract.bytecode.empty()) {
+        print_error("合约字节码为空");
+        return APP_ERROR_INVALID_PARAM;
+    }
+    
+    std::vector<uint8_t> next_snapshot(EXEC_SNAPSHOT_MAX_SEALED_SIZE);
+    size_t next_size = 0;
+    uint32_t slice_suspended = 0;
+    uint64_t gas_used = 0;
+    uint8_t result_buffer[MAX_OUTPUT_SIZE];
+    size_t result_size = 0;
+    uint8_t execution_hash[32];
+    
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_execute_slice(
+        enclave_id,
+        &enclave_ret,
+        contract.bytecode.data(),
+        contract.bytecode.size(),
+        input_data.empty() ? nullptr : input_data.data(),
+        input_data.size(),
+        contract.gas_limit,
+        slice_gas,
+        snapshot.empty() ? nullptr : snapshot.data(),
+        snapshot.size(),
+        next_snapshot.data(),
+        next_snapshot.size(),
+        &next_size,
+        &slice_suspended,
+        &gas_used,
+        result_buffer,
+        sizeof(result_buffer),
+        &result_size,
+        execution_hash
+    );
+    
+    if (ret != SGX_SUCCESS) {
+        result.success = false;
+        result.error_message = "SGX调用失败: 0x" + std::to_string(ret);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    result.gas_used = gas_used;
+    if (enclave_ret != SGX_SUCCESS) {
+        result.success = false;
+        result.error_message = "合约执行失败: 0x" + std::to_string(enclave_ret);
+        snapshot.clear();
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    if (slice_suspended) {
+        next_snapshot.resize(next_size);
+        snapshot.swap(next_snapshot);
+        suspended = true;
+        return APP_SUCCESS;
+    }
+    
+    snapshot.clear();
+    result.success = true;
+    result.output.assign(result_buffer, result_buffer + result_size);
+    result.execution_hash.assign(execution_hash, execution_hash + 32);
+    
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::execute_streaming(const SmartContract& contract,
+                                                    std::istream& input,
+                                                    ExecutionResult& result,
+                                                    size_t chunk_size) {
+    result.success = false;
+    if (!enclave_initialized) {
+        print_error("Enclave未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    if (contract.bytecode.empty()) {
+        print_error("合约字节码为空");
+        return APP_ERROR_INVALID_PARAM;
+    }
+    
+    if (chunk_size == 0 || chunk_size > INPUT_STREAM_MAX_CHUNK) {
+        chunk_size = INPUT_STREAM_MAX_CHUNK;
+    }
+    
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    uint32_t session_id = 0;
+    sgx_status_t ret = ecall_input_stream_open(
+        enclave_id,
+        &enclave_ret,
+        contract.bytecode.data(),
+        contract.bytecode.size(),
+        contract.gas_limit,
+        &session_id
+    );
+    if (ret != SGX_SUCCESS) {
+        result.error_message = "SGX调用失败: 0x" + std::to_string(ret);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    if (enclave_ret != SGX_SUCCESS) {
+        result.error_message = "打开流式输入失败: 0x" + std::to_string(enclave_ret);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    // 读取一块，返回是否已读到输入末尾
+    auto read_chunk = [&input, chunk_size](std::vector<uint8_t>& buffer) {
+        buffer.resize(chunk_size);
+        input.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(chunk_size));
+        buffer.resize(static_cast<size_t>(input.gcount()));
+        return !input || input.peek() == std::char_traits<char>::eof();
+    };
+    
+    // 双缓冲：Enclave处理当前块时在另一个缓冲区读取下一块
+    std::vector<uint8_t> buffers[2];
+    size_t current = 0;
+    bool final = read_chunk(buffers[current]);
+    app_status_t status = APP_SUCCESS;
+    
+    while (status == APP_SUCCESS) {
+        std::future<bool> next;
+        if (!final) {
+            next = std::async(std::launch::async, read_chunk, std::ref(buffers[current ^ 1]));
+        }
+        
+        const std::vector<uint8_t>& chunk = buffers[current];
+        uint32_t completed = 0;
+        ret = ecall_input_stream_feed(
+            enclave_id,
+            &enclave_ret,
+            session_id,
+            chunk.empty() ? nullptr : chunk.data(),
+            chunk.size(),
+            final ? 1 : 0,
+            &completed
+        );
+        bool next_final = next.valid() ? next.get() : true;
+        
+        if (ret != SGX_SUCCESS) {
+            result.error_message = "SGX调用失败: 0x" + std::to_string(ret);
+            status = APP_ERROR_ENCLAVE_CALL;
+        } else if (enclave_ret != SGX_SUCCESS) {
+            result.error_message = "合约执行失败: 0x" + std::to_string(enclave_ret);
+            status = APP_ERROR_ENCLAVE_CALL;
+        } else if (input.bad()) {
+            result.error_message = "读取输入失败";
+            status = APP_ERROR_FILE_IO;
+        }
+        if (final) {
+            break;
+        }
+        final = next_final;
+        current ^= 1;
+    }
+    
+    // 出错时同样关闭会话，Enclave放弃执行并释放会话占用的内存
+    uint8_t result_buffer[MAX_OUTPUT_SIZE];
+    size_t result_size = 0;
+    uint8_t execution_hash[32];
+    uint64_t gas_used = 0;
+    ret = ecall_input_stream_close(
+        enclave_id,
+        &enclave_ret,
+        session_id,
+        result_buffer,
+        sizeof(result_buffer),
+        &result_size,
+        execution_hash,
+        &gas_used
+    );
+    
+    if (ret != SGX_SUCCESS) {
+        result.error_message = "SGX调用失败: 0x" + std::to_string(ret);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    result.gas_used = gas_used;
+    if (status != APP_SUCCESS) {
+        return status;
+    }
+    if (enclave_ret != SGX_SUCCESS) {
+        result.error_message = "合约执行失败: 0x" + std::to_string(enclave_ret);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    result.success = true;
+    result.output.assign(result_buffer, result_buffer + result_size);
+    result.execution_hash.assign(execution_hash, execution_hash + 32);
+    
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::execute_time_sliced(const std::vector<ContractJob>& jobs,
+                                                      std::vector<ExecutionResult>& results,
+                                                      uint64_t slice_gas,
+                                                      size_t thread_count) {
+    if (!enclave_initialized) {
+        print_error("Enclave未初始化");
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    results.assign(jobs.size(), ExecutionResult());
+    for (const ContractJob& job : jobs) {
+        if (!job.contract) {
+            print_error("分片执行需要合约字节码");
+            return APP_ERROR_INVALID_PARAM;
+        }
+    }
+    if (jobs.empty()) {
+        return APP_SUCCESS;
+    }
+    
+    WorkerPool& pool = pool_for(thread_count);
+    
+    // 每个任务一次只执行一个分片，挂起后带着快照重新排到队尾；快照只由当前持有任务的线程访问
+    std::vector<std::vector<uint8_t>> snapshots(jobs.size());
+    std::atomic<int> failed(APP_SUCCESS);
+    std::function<void(size_t)> run_slice = [&](size_t index) {
+        const ContractJob& job = jobs[index];
+        SmartContract contract = *job.contract;
+        contract.gas_limit = job.gas_limit;
+        
+        bool suspended = false;
+        app_status_t status = execute_slice(contract, job.input_data, slice_gas,
+                                            snapshots[index], suspended, results[index]);
+        if (status == APP_SUCCESS && suspended) {
+            pool.submit([&run_slice, index]() { run_slice(index); });
+        } else if (status != APP_SUCCESS && status != APP_ERROR_ENCLAVE_CALL) {
+            failed.store(status);
+        }
+    };
+    
+    for (size_t i = 0; i < jobs.size(); i++) {
+        pool.submit([&run_slice, i]() { run_slice(i); });
+    }
+    
+    pool.wait_all();
+    
+    return static_cast<app_status_t>(failed.load());
+}
+
+app_status_t SGXSmartContractApp::run_jobs(const std::vector<ContractJob>& jobs,
+                                           const std::vector<size_t>& indices,
+                                           std::vector<ExecutionResult>& results) {
+    // 第一轮优先按哈希引用，未命中Enclave缓存的任务在第二轮携带字节码重新提交
+    std::vector<size_t> not_cached;
+    app_status_t status = submit_batch(jobs, indices, true, results, not_cached);
+    if (status != APP_SUCCESS || not_cached.empty()) {
+        return status;
+    }
+    
+    std::vector<size_t> unused;
+    return submit_batch(jobs, not_cached, false, results, unused);
+}
+
+app_status_t SGXSmartContractApp::submit_batch(const std::vector<ContractJob>& jobs,
+                                               const std::vector<size_t>& indices,
+                                               bool allow_by_hash,
+                                               std::vector<ExecutionResult>& results,
+                                               std::vector<size_t>& not_cached) {
+    std::vector<uint8_t> request;
+    std::vector<uint8_t> response;
+    std::vector<size_t> chunk;
+    request.reserve(BATCH_MAX_REQUEST_SIZE);
+    const size_t job_limit = batch_job_limit();
+    
+    // 提交当前批次并解析结果
+    auto flush = [&]() -> app_status_t {
+        if (chunk.empty()) {
+            return APP_SUCCESS;
+        }
+        
+        size_t records_size = chunk.size() * sizeof(batch_result_t);
+        response.assign(records_size + BATCH_RESULT_DATA_SIZE, 0);
+        
+        sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+        sgx_status_t ret = ecall_execute_batch(
+            enclave_id,
+            &enclave_ret,
+            request.data(),
+            request.size(),
+            static_cast<uint32_t>(chunk.size()),
+            response.data(),
+            response.size()
+        );
+        
+        if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+            print_error("批量执行失败: 0x" + std::to_string(ret != SGX_SUCCESS ? ret : enclave_ret));
+            return APP_ERROR_ENCLAVE_CALL;
+        }
+        
+        for (size_t i = 0; i < chunk.size(); i++) {
+            size_t index = chunk[i];
+            sgx_status_t job_status = read_batch_result(response, chunk.size(), i, results[index]);
+            if (job_status == SGX_ERROR_CONTRACT_NOT_CACHED && jobs[index].contract) {
+                results[index] = ExecutionResult();
+                not_cached.push_back(index);
+            }
+        }
+        
+        request.clear();
+        chunk.clear();
+        return APP_SUCCESS;
+    };
+    
+    for (size_t index : indices) {
+        const ContractJob& job = jobs[index];
+        bool by_hash = allow_by_hash && job.code_hash.size() == 32;
+        
+        if (!by_hash && (!job.contract || job.contract->bytecode.empty())) {
+            results[index].success = false;
+            results[index].error_message = "合约字节码为空";
+            continue;
+        }
+        
+        size_t code_size = by_hash ? 0 : job.contract->bytecode.size();
+        size_t record_size = batch_job_record_size(code_size, job.input_data.size());
+        
+        // 单个任务超过批次上限时单独执行
+        if (record_size > BATCH_MAX_REQUEST_SIZE) {
+            if (!job.contract) {
+                results[index].success = false;
+                results[index].error_message = "任务超过批次大小上限";
+                continue;
+            }
+            SmartContract contract = *job.contract;
+            contract.gas_limit = job.gas_limit;
+            execute_contract(contract, job.input_data, results[index]);
+            continue;
+        }
+        
+        if (chunk.size() == job_limit || request.size() + record_size > BATCH_MAX_REQUEST_SIZE) {
+            app_status_t status = flush();
+            if (status != APP_SUCCESS) {
+                return status;
+            }
+        }
+        
+        append_job_record(request, job, by_hash);
+        chunk.push_back(index);
+    }
+    
+    return flush();
+}
+
+app_status_t SGXSmartContractApp::generate_execution_proof(const SmartContract& contract,
+                                                          const std::vector<uint8_t>& input_data,
+                                                          ExecutionProof& proof) {
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    proof.is_valid = false;
+    
+    // 证明绑定执行哈希，先在Enclave内执行合约
+    ExecutionResult result;
+    app_status_t status = execute_contract(contract, input_data, result);
+    if (status != APP_SUCCESS) {
+        return status;
+    }
+    
+    uint8_t proof_data[EXECUTION_PROOF_SIZE];
+    size_t proof_size = 0;
+    
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_generate_execution_proof(
+        enclave_id,
+        &enclave_ret,
+        result.execution_hash.data(),
+        proof_data,
+        sizeof(proof_data),
+        &proof_size
+    );
+    
+    if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS || proof_size != sizeof(proof_data)) {
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    // 签名位于证明末尾
+    proof.proof_data.assign(proof_data, proof_data + proof_size);
+    proof.signature.assign(proof_data + proof_size - 64, proof_data + proof_size);
+    proof.execution_hash = result.execution_hash;
+    proof.merkle_path.clear();
+    proof.leaf_index = 0;
+    proof.leaf_count = 0;
+    proof.is_valid = true;
+    
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::generate_batch_proof(const std::vector<ExecutionResult>& results,
+                                                      std::vector<ExecutionProof>& proofs) {
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    proofs.assign(results.size(), ExecutionProof());
+    
+    // 只为执行成功的结果生成证明
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < results.size(); i++) {
+        if (results[i].success && results[i].execution_hash.size() == 32) {
+            indices.push_back(i);
+        }
+    }
+    
+    // 超过单棵树上限时分为多棵树，每棵树签名一次
+    for (size_t begin = 0; begin < indices.size(); begin += MERKLE_MAX_LEAVES) {
+        size_t end = std::min(indices.size(), begin + static_cast<size_t>(MERKLE_MAX_LEAVES));
+        
+        std::vector<std::vector<uint8_t>> leaves;
+        std::vector<uint8_t> packed;
+        leaves.reserve(end - begin);
+        packed.reserve((end - begin) * 32);
+        for (size_t k = begin; k < end; k++) {
+            const std::vector<uint8_t>& hash = results[indices[k]].execution_hash;
+            leaves.push_back(hash);
+            packed.insert(packed.end(), hash.begin(), hash.end());
+        }
+        
+        uint8_t proof_data[EXECUTION_PROOF_SIZE];
+        size_t proof_size = 0;
+        
+        sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+        sgx_status_t ret = ecall_generate_batch_proof(
+            enclave_id,
+            &enclave_ret,
+            packed.data(),
+            packed.size(),
+            proof_data,
+            sizeof(proof_data),
+            &proof_size
+        );
+        
+        if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS || proof_size != sizeof(proof_data)) {
+            return APP_ERROR_ENCLAVE_CALL;
+        }
+        
+        // 包含路径由同一组哈希在主机侧计算，可信性来自根签名
+        MerkleTree tree(leaves);
+        for (size_t k = begin; k < end; k++) {
+            ExecutionProof& proof = proofs[indices[k]];
+            proof.proof_data.assign(proof_data, proof_data + proof_size);
+            proof.signature.assign(proof_data + proof_size - 64, proof_data + proof_size);
+            proof.execution_hash = leaves[k - begin];
+            proof.merkle_path = tree.path(k - begin);
+            proof.leaf_index = static_cast<uint32_t>(k - begin);
+            proof.leaf_count = static_cast<uint32_t>(end - begin);
+            proof.is_valid = true;
+        }
+    }
+    
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::verify_execution_proof(const ExecutionProof& proof, bool& is_valid) {
+    is_valid = false;
+    
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    if (proof.proof_data.size() != EXECUTION_PROOF_SIZE) {
+        return APP_ERROR_INVALID_PARAM;
+    }
+    
+    // 批量证明由包含路径还原Merkle根，签名对象为根摘要
+    std::vector<uint8_t> signed_hash = ProofVerifier::signed_hash(proof);
+    if (signed_hash.empty()) {
+        return APP_SUCCESS;
+    }
+    
+    int valid = 0;
     sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
-    ret = ecall_init_verifier(enclave_id, &enclave_ret);
+    sgx_status_t ret = ecall_verify_execution_proof(
+        enclave_id,
+        &enclave_ret,
+        proof.proof_data.data(),
+        proof.proof_data.size(),
+        signed_hash.data(),
+        &valid
+    );
+    
     if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
-        print_error("初始化验证器失败");
-        sgx_destroy_enclave(enclave_id);
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    
+    is_valid = (valid != 0);
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::verify_execution_proofs(const std::vector<ExecutionProof>& proofs,
+                                                         std::vector<bool>& valid) {
+    valid.assign(proofs.size(), false);
+    
+    if (!enclave_initialized) {
         return APP_ERROR_ENCLAVE_INIT;
     }
     
-    enclave_initialized = true;
-    print_success("Enclave初始化成功，EID: " + std::to_string(enclave_id));
+    // 同一批量证明的各项共享根证明和签名对象，只提交一次
+    std::vector<size_t> unique_of(proofs.size(), SIZE_MAX);
+    std::vector<size_t> uniques;
+    std::vector<std::vector<uint8_t>> hashes;
+    std::unordered_map<std::string, size_t> seen;
+    for (size_t i = 0; i < proofs.size(); i++) {
+        std::vector<uint8_t> hash = ProofVerifier::signed_hash(proofs[i]);
+        if (hash.empty()) {
+            continue;
+        }
+        
+        std::string id(proofs[i].proof_data.begin(), proofs[i].proof_data.end());
+        id.append(hash.begin(), hash.end());
+        auto inserted = seen.emplace(std::move(id), uniques.size());
+        if (inserted.second) {
+            uniques.push_back(i);
+            hashes.push_back(std::move(hash));
+        }
+        unique_of[i] = inserted.first->second;
+    }
+    
+    std::vector<uint8_t> unique_valid(uniques.size(), 0);
+    for (size_t begin = 0; begin < uniques.size(); begin += PROOF_VERIFY_MAX_BATCH) {
+        size_t count = std::min(uniques.size() - begin, static_cast<size_t>(PROOF_VERIFY_MAX_BATCH));
+        
+        std::vector<uint8_t> packed_proofs;
+        std::vector<uint8_t> packed_hashes;
+        packed_proofs.reserve(count * EXECUTION_PROOF_SIZE);
+        packed_hashes.reserve(count * 32);
+        for (size_t k = begin; k < begin + count; k++) {
+            const std::vector<uint8_t>& data = proofs[uniques[k]].proof_data;
+            packed_proofs.insert(packed_proofs.end(), data.begin(), data.end());
+            packed_hashes.insert(packed_hashes.end(), hashes[k].begin(), hashes[k].end());
+        }
+        
+        std::vector<uint8_t> bitmap((count + 7) / 8, 0);
+        sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+        sgx_status_t ret = ecall_verify_execution_proofs(
+            enclave_id,
+            &enclave_ret,
+            packed_proofs.data(),
+            packed_proofs.size(),
+            packed_hashes.data(),
+            packed_hashes.size(),
+            static_cast<uint32_t>(count),
+            bitmap.data(),
+            bitmap.size()
+        );
+        
+        if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+            return APP_ERROR_ENCLAVE_CALL;
+        }
+        
+        for (size_t k = 0; k < count; k++) {
+            unique_valid[begin + k] = (bitmap[k / 8] >> (k % 8)) & 1;
+        }
+    }
+    
+    for (size_t i = 0; i < proofs.size(); i++) {
+        if (unique_of[i] != SIZE_MAX) {
+            valid[i] = unique_valid[unique_of[i]] != 0;
+        }
+    }
+    
     return APP_SUCCESS;
 }
 
-void SGXSmartContractApp::destroy_enclave() {
-    if (enclave_initialized && enclave_id != 0) {
-        sgx_destroy_enclave(enclave_id);
-        enclave_id = 0;
-        enclave_initialized = false;
-        print_success("Enclave已销毁");
+app_status_t SGXSmartContractApp::get_signing_public_key(std::vector<uint8_t>& public_key) {
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    uint8_t key[64];
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_get_signing_public_key(enclave_id, &enclave_ret, key);
+    if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+        return APP_ERROR_ENCLAVE_CALL;
     }
+    
+    public_key.assign(key, key + sizeof(key));
+    return APP_SUCCESS;
 }
 
-app_status_t SGXSmartContractApp::load_contract_from_file(const std::string& filename, SmartContract& contract) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        print_error("无法打开合约文件: " + filename);
-        return APP_ERROR_FILE_IO;
+app_status_t SGXSmartContractApp::set_execution_backend(uint32_t backend) {
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
     }
     
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_set_execution_backend(enclave_id, &enclave_ret, backend);
     
-    if (size > MAX_CONTRACT_SIZE) {
-        print_error("合约文件过大: " + std::to_string(size) + " bytes");
+    if (ret != SGX_SUCCESS) {
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    if (enclave_ret != SGX_SUCCESS) {
         return APP_ERROR_INVALID_PARAM;
     }
     
-    contract.bytecode.resize(size);
-    file.read(reinterpret_cast<char*>(contract.bytecode.data()), size);
-    contract.name = filename;
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::set_jit_threshold(uint32_t call_threshold) {
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_set_jit_threshold(enclave_id, &enclave_ret, call_threshold);
+    
+    if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+        return APP_ERROR_ENCLAVE_CALL;
+    }
     
-    print_success("加载合约成功: " + std::to_string(size) + " bytes");
     return APP_SUCCESS;
 }
 
-app_status_t SGXSmartContractApp::execute_contract(const SmartContract& contract,
-                                                  const std::vector<uint8_t>& input_data,
-                                                  ExecutionResult& result) {
+app_status_t SGXSmartContractApp::enable_shared_ring(size_t size) {
     if (!enclave_initialized) {
-        print_error("Enclave未初始化");
         return APP_ERROR_ENCLAVE_INIT;
     }
     
-    if (contract.bytecode.empty()) {
-        print_error("合约字节码为空");
-        return APP_ERROR_INVALID_PARAM;
+    std::unique_ptr<SharedRing> ring(new SharedRing(size));
+    if (!ring->data()) {
+        return APP_ERROR_MEMORY;
     }
     
-    // 准备执行参数
-    const uint8_t* contract_code = contract.bytecode.data();
-    size_t code_size = contract.bytecode.size();
-    const uint8_t* input = input_data.empty() ? nullptr : input_data.data();
-    size_t input_size = input_data.size();
+    // 替换已注册的缓冲区前须保证没有执行仍在使用它
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_register_shared_ring(enclave_id, &enclave_ret, ring->data(), ring->size());
     
-    // 结果缓冲区
-    uint8_t result_buffer[MAX_OUTPUT_SIZE];
-    size_t result_size = sizeof(result_buffer);
-    uint8_t execution_hash[32];
+    if (ret != SGX_SUCCESS) {
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    if (enclave_ret != SGX_SUCCESS) {
+        return APP_ERROR_INVALID_PARAM;
+    }
     
-    // 记录开始时间
-    auto start_time = std::chrono::high_resolution_clock::now();
+    shared_ring = std::move(ring);
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::configure_state(bool persistent, uint64_t cache_budget) {
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
     
-    // 调用Enclave执行合约
-    sgx_status_t ret = SGX_ERROR_UNEXPECTED;
     sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_configure_state(enclave_id, &enclave_ret, persistent ? 1 : 0, cache_budget);
     
-    ret = ecall_execute_contract(
-        enclave_id,
-        &enclave_ret,
-        contract_code,
-        code_size,
-        input,
-        input_size,
-        contract.gas_limit,
-        result_buffer,
-        &result_size,
-        execution_hash
-    );
+    if (ret != SGX_SUCCESS) {
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    if (enclave_ret != SGX_SUCCESS) {
+        return APP_ERROR_INVALID_PARAM;
+    }
+    
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::get_memory_stats(enclave_memory_stats_t& stats) {
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
     
-    // 记录结束时间
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_get_memory_stats(enclave_id, &enclave_ret,
+                                              reinterpret_cast<uint8_t*>(&stats), sizeof(stats));
     
     if (ret != SGX_SUCCESS) {
-        result.success = false;
-        result.error_message = "SGX调用失败: 0x" + std::to_string(ret);
         return APP_ERROR_ENCLAVE_CALL;
     }
-    
     if (enclave_ret != SGX_SUCCESS) {
-        result.success = false;
-        result.error_message = "合约执行失败: 0x" + std::to_string(enclave_ret);
+        return APP_ERROR_INVALID_PARAM;
+    }
+    
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::drain_audit_log(size_t& record_count) {
+    record_count = 0;
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    audit_record_t records[AUDIT_DRAIN_MAX_RECORDS];
+    uint32_t count = 0;
+    uint64_t dropped = 0;
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_drain_audit_log(enclave_id, &enclave_ret, reinterpret_cast<uint8_t*>(records),
+                                             sizeof(records), &count, &dropped);
+    
+    if (ret != SGX_SUCCESS) {
         return APP_ERROR_ENCLAVE_CALL;
     }
+    if (enclave_ret != SGX_SUCCESS) {
+        return APP_ERROR_INVALID_PARAM;
+    }
     
-    // 填充执行结果
-    result.success = true;
-    result.output.assign(result_buffer, result_buffer + result_size);
-    result.execution_hash.assign(execution_hash, execution_hash + 32);
-    result.gas_used = duration.count(); // 使用执行时间作为gas消耗的近似值
+    record_count = count;
+    return AuditLog::instance().write(records, count) ? APP_SUCCESS : APP_ERROR_FILE_IO;
+}
+
+app_status_t SGXSmartContractApp::set_profiling(bool enable, bool cycles) {
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
+    
+    uint32_t flags = enable ? (PROFILE_FLAG_ENABLED | (cycles ? PROFILE_FLAG_CYCLES : 0)) : 0;
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_set_profiling(enclave_id, &enclave_ret, flags);
+    
+    if (ret != SGX_SUCCESS) {
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    if (enclave_ret != SGX_SUCCESS) {
+        return APP_ERROR_INVALID_PARAM;
+    }
     
+    profiling_enabled = enable;
     return APP_SUCCESS;
 }
 
-app_status_t SGXSmartContractApp::generate_execution_proof(const SmartContract& contract,
-                                                          const std::vector<uint8_t>& input_data,
-                                                          ExecutionProof& proof) {
+app_status_t SGXSmartContractApp::apply_runtime_config() {
     if (!enclave_initialized) {
         return APP_ERROR_ENCLAVE_INIT;
     }
     
-    uint8_t proof_data[1024];
-    size_t proof_size = sizeof(proof_data);
+    // 工作线程数和批次大小在每次执行时读取配置，这里只需调整Enclave和审计读取线程
+    bool profiling = Config::get_bool("performance.enable_profiling", false);
+    runtime_config_t settings;
+    memset(&settings, 0, sizeof(settings));
+    int code_budget_kb = Config::get_int("performance.code_cache_budget_kb", 0);
+    int state_budget_kb = Config::get_int("state.cache_budget_kb", 0);
+    int result_budget_kb = Config::get_bool("performance.result_cache.enabled", false)
+                               ? Config::get_int("performance.result_cache.budget_kb", 1024) : 0;
+    settings.code_cache_budget = static_cast<uint64_t>(std::max(code_budget_kb, 0)) * 1024;
+    settings.state_cache_budget = static_cast<uint64_t>(std::max(state_budget_kb, 0)) * 1024;
+    settings.result_cache_budget = static_cast<uint64_t>(std::max(result_budget_kb, 0)) * 1024;
+    // 周期统计依赖Enclave内可用的rdtsc
+    settings.profile_flags = profiling ? (PROFILE_FLAG_ENABLED |
+        (Config::get_bool("development.enable_performance_counters", false) ? PROFILE_FLAG_CYCLES : 0)) : 0;
     
-    sgx_status_t ret = SGX_ERROR_UNEXPECTED;
     sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_configure_runtime(enclave_id, &enclave_ret,
+                                               reinterpret_cast<const uint8_t*>(&settings), sizeof(settings));
+    if (ret != SGX_SUCCESS) {
+        AppUtils::print_sgx_status(ret, "ecall_configure_runtime");
+        return APP_ERROR_ENCLAVE_CALL;
+    }
+    if (enclave_ret != SGX_SUCCESS) {
+        AppUtils::print_sgx_status(enclave_ret, "调整运行时配置");
+        return APP_ERROR_INVALID_PARAM;
+    }
+    profiling_enabled = profiling;
     
-    ret = ecall_generate_proof(
-        enclave_id,
-        &enclave_ret,
-        const_cast<uint8_t*>(contract.bytecode.data()),
-        contract.bytecode.size(),
-        proof_data,
-        proof_size
-    );
+    if (audit_reader) {
+        audit_reader->set_interval(static_cast<uint32_t>(Config::get_int("security.audit_read_interval_ms", 100)));
+    }
+    return APP_SUCCESS;
+}
+
+app_status_t SGXSmartContractApp::get_profile(std::vector<uint8_t>& snapshot, bool reset) {
+    if (!enclave_initialized) {
+        return APP_ERROR_ENCLAVE_INIT;
+    }
     
-    if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
-        proof.is_valid = false;
+    // 快照大小有上限，一次ECALL即可取回
+    snapshot.resize(PROFILE_MAX_SNAPSHOT_SIZE);
+    size_t snapshot_size = 0;
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_get_profile(enclave_id, &enclave_ret, snapshot.data(), snapshot.size(),
+                                         &snapshot_size, reset ? 1 : 0);
+    
+    if (ret != SGX_SUCCESS) {
+        snapshot.clear();
         return APP_ERROR_ENCLAVE_CALL;
     }
+    if (enclave_ret != SGX_SUCCESS) {
+        snapshot.clear();
+        return APP_ERROR_INVALID_PARAM;
+    }
     
-    proof.proof_data.assign(proof_data, proof_data + proof_size);
-    proof.is_valid = true;
-    
+    snapshot.resize(snapshot_size);
     return APP_SUCCESS;
 }
 
@@ -250,7 +1593,7 @@ SmartContract SGXSmartContractApp::create_sample_contract() {
     contract.bytecode.push_back(0x03); // OP_ADD
     
     // HALT
-    contract.bytecode.push_back(0x18); // OP_HALT
+    contract.bytecode.push_back(0xFF); // OP_HALT
     
     return contract;
 }
@@ -331,4 +1674,70 @@ void print_app_info() {
     std::cout << "作者: chord233" << std::endl;
     std::cout << "描述: 基于Intel SGX的智能合约安全执行和验证系统" << std::endl;
     std::cout << "==============================" << std::endl;
-}
\ No newline at end of file
+}
+
+std::string sealed_signing_key_path() {
+    return Config::get_string("crypto.sealed_key_file", Config::data_directory + "/signing_key.sealed");
+}
+
+void build_gas_schedule(gas_schedule_t& schedule) {
+    memset(&schedule, 0, sizeof(schedule));
+    schedule.version = GAS_SCHEDULE_VERSION;
+    
+    // 配置项未给出或为负数时使用标准值
+    auto cost = [](const std::string& name, uint32_t standard) {
+        int value = Config::get_int("smart_contract.gas_costs." + name, static_cast<int>(standard));
+        if (value < 0) {
+            print_warning("忽略无效的Gas配置: " + name);
+            return standard;
+        }
+        return static_cast<uint32_t>(value);
+    };
+    
+#define GAS_SCHEDULE_ENTRY(opcode, name, gas) schedule.costs[opcode] = cost(name, gas);
+    GAS_SCHEDULE_STANDARD(GAS_SCHEDULE_ENTRY)
+#undef GAS_SCHEDULE_ENTRY
+    schedule.hash_word_cost = cost("HASH_WORD", GAS_STANDARD_HASH_WORD);
+    schedule.vector_word_cost = cost("VECTOR_WORD", GAS_STANDARD_VECTOR_WORD);
+}
+
+bool load_sealed_signing_key(sgx_enclave_id_t eid, const std::string& filename) {
+    if (!AppUtils::file_exists(filename)) {
+        return false;
+    }
+    
+    std::vector<uint8_t> sealed = AppUtils::read_file(filename);
+    if (sealed.empty() || sealed.size() > SIGNING_KEY_SEALED_MAX_SIZE) {
+        print_warning("密封的签名密钥文件无效: " + filename);
+        return false;
+    }
+    
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_load_signing_key(eid, &enclave_ret, sealed.data(), sealed.size());
+    if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS) {
+        // 密钥由其他签名者或平台密封时无法解封，改用新密钥
+        print_warning("无法解封签名密钥，将生成新密钥: 0x" + std::to_string(ret != SGX_SUCCESS ? ret : enclave_ret));
+        return false;
+    }
+    
+    return true;
+}
+
+bool store_sealed_signing_key(sgx_enclave_id_t eid, const std::string& filename) {
+    std::vector<uint8_t> sealed(SIGNING_KEY_SEALED_MAX_SIZE);
+    size_t sealed_size = 0;
+    
+    sgx_status_t enclave_ret = SGX_ERROR_UNEXPECTED;
+    sgx_status_t ret = ecall_export_signing_key(eid, &enclave_ret, sealed.data(), sealed.size(), &sealed_size);
+    if (ret != SGX_SUCCESS || enclave_ret != SGX_SUCCESS || sealed_size > sealed.size()) {
+        return false;
+    }
+    sealed.resize(sealed_size);
+    
+    size_t slash = filename.find_last_of('/');
+    if (slash != std::string::npos) {
+        AppUtils::create_directory(filename.substr(0, slash));
+    }
+    
+    return AppUtils::write_file(filename, sealed);
+}
@@ -0,0 +1,88 @@
+#include "shared_ring.h"
+#include "enclave_shared.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+size_t align_up(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+SharedRing::SharedRing(size_t size) : buffer(nullptr), capacity(0) {
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t length = align_up(size, page_size);
+
+    void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+        buffer = static_cast<uint8_t*>(memory);
+        capacity = length;
+    }
+}
+
+SharedRing::~SharedRing() {
+    if (buffer) {
+        munmap(buffer, capacity);
+    }
+}
+
+bool SharedRing::acquire(size_t size, Span& span) {
+    size_t aligned = align_up(size > 0 ? size : 1, SHARED_RING_ALIGN);
+    if (!buffer || aligned > capacity) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        if (blocks.empty()) {
+            span.offset = 0;
+            break;
+        }
+
+        size_t tail = blocks.front().offset;
+        size_t head = blocks.back().offset + blocks.back().size;
+        if (blocks.back().offset >= tail) {
+            // 未回绕：优先使用末尾的空间，不够时回绕到开头（末尾剩余部分跳过）
+            if (capacity - head >= aligned) {
+                span.offset = head;
+                break;
+            }
+            if (tail >= aligned) {
+                span.offset = 0;
+                break;
+            }
+        } else if (tail - head >= aligned) {
+            span.offset = head;
+            break;
+        }
+
+        space_available.wait(lock);
+    }
+
+    span.size = size;
+    blocks.push_back(Block{ span.offset, aligned, false });
+    return true;
+}
+
+void SharedRing::release(const Span& span) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Block& block : blocks) {
+        if (block.offset == span.offset && !block.released) {
+            block.released = true;
+            break;
+        }
+    }
+
+    bool reclaimed = false;
+    while (!blocks.empty() && blocks.front().released) {
+        blocks.pop_front();
+        reclaimed = true;
+    }
+
+    if (reclaimed) {
+        space_available.notify_all();
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef SHARED_RING_H
+#define SHARED_RING_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * 与Enclave共享的不可信环形缓冲区（ecall_register_shared_ring注册）
+ * 调用方按先后顺序预留连续区域，区域可以乱序释放，最早的区域释放后空间才被回收。
+ * 所有接口均为线程安全
+ */
+class SharedRing {
+public:
+    // 预留的区域
+    struct Span {
+        size_t offset;                      // 相对缓冲区起始的偏移（按SHARED_RING_ALIGN对齐）
+        size_t size;                        // 区域大小
+    };
+
+private:
+    struct Block {
+        size_t offset;
+        size_t size;
+        bool released;
+    };
+
+    uint8_t* buffer;
+    size_t capacity;
+    std::deque<Block> blocks;               // 按预留顺序排列的未回收区域
+    std::mutex mutex;
+    std::condition_variable space_available;
+
+public:
+    /**
+     * 分配页对齐的共享缓冲区
+     * @param size 缓冲区大小（向上取整到页大小）
+     */
+    explicit SharedRing(size_t size);
+    ~SharedRing();
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+    /**
+     * 获取缓冲区起始地址
+     * @return 起始地址（分配失败时为nullptr）
+     */
+    uint8_t* data() const { return buffer; }
+
+    /**
+     * 获取缓冲区大小
+     * @return 字节数
+     */
+    size_t size() const { return capacity; }
+
+    /**
+     * 预留一段连续区域，空间不足时等待其他调用释放
+     * @param size 区域大小
+     * @param span 输出的区域
+     * @return 是否成功（超过缓冲区大小时立即返回false）
+     */
+    bool acquire(size_t size, Span& span);
+
+    /**
+     * 释放预留的区域
+     * @param span acquire返回的区域
+     */
+    void release(const Span& span);
+};
+
+#endif // SHARED_RING_H
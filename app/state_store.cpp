@@ -0,0 +1,398 @@
+#include "state_store.h"
+#include "app_utils.h"
+#include "enclave_shared.h"
+
+#include <mutex>
+#include <vector>
+#include <filesystem>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+// 日志文件头：魔数(8) | 格式版本(4) | 保留(4)
+const char STATE_LOG_MAGIC[8] = { 'S', 'G', 'X', 'S', 'T', 'L', 'O', 'G' };
+const uint32_t STATE_LOG_FORMAT_VERSION = 1;
+const uint64_t STATE_LOG_HEADER_SIZE = 16;
+
+// 废弃记录超过此大小且多于有效记录时压缩
+const uint64_t STATE_LOG_COMPACT_MIN_DEAD = 4 * 1024 * 1024;
+
+// 每条日志记录前的校验信息
+struct LogRecordPrefix {
+    uint32_t checksum;                      // 状态记录的FNV-1a校验和
+    uint32_t record_size;                   // 状态记录大小（含填充）
+};
+
+uint32_t record_checksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * 检查状态记录的头部和大小
+ * @return 记录大小（含填充），格式错误时为0
+ */
+size_t checked_record_size(const uint8_t* record, size_t available) {
+    if (available < sizeof(state_record_header_t)) {
+        return 0;
+    }
+
+    state_record_header_t header;
+    memcpy(&header, record, sizeof(header));
+    if (header.key_size == 0 || header.key_size > STATE_RECORD_MAX_KEY_SIZE ||
+        header.value_size > STATE_RECORD_MAX_VALUE_SIZE ||
+        ((header.flags & STATE_RECORD_FLAG_DELETED) && header.value_size != 0)) {
+        return 0;
+    }
+
+    size_t size = state_record_size(header.key_size, header.value_size);
+    return size <= available ? size : 0;
+}
+
+bool write_fully(int fd, const uint8_t* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+bool read_fully(int fd, uint8_t* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t count = pread(fd, data, size, static_cast<off_t>(offset));
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= static_cast<size_t>(count);
+        offset += static_cast<uint64_t>(count);
+    }
+    return true;
+}
+
+/**
+ * 把状态记录连同校验前缀追加到缓冲区
+ */
+void append_log_record(std::vector<uint8_t>& buffer, const uint8_t* record, size_t record_size) {
+    LogRecordPrefix prefix;
+    prefix.checksum = record_checksum(record, record_size);
+    prefix.record_size = static_cast<uint32_t>(record_size);
+
+    const uint8_t* prefix_bytes = reinterpret_cast<const uint8_t*>(&prefix);
+    buffer.insert(buffer.end(), prefix_bytes, prefix_bytes + sizeof(prefix));
+    buffer.insert(buffer.end(), record, record + record_size);
+}
+
+} // namespace
+
+StateStore::StateStore(const std::string& log_path, bool sync)
+    : path(log_path), sync_writes(sync), fd(-1), end_offset(0), live_bytes(0), dead_bytes(0) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (open_log() != APP_SUCCESS) {
+        Logger::error("无法打开状态日志: " + path);
+    }
+}
+
+StateStore::~StateStore() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+app_status_t StateStore::open_log() {
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(parent, ec);
+    }
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        return APP_ERROR_FILE_IO;
+    }
+
+    app_status_t status = recover();
+    if (status != APP_SUCCESS) {
+        close(fd);
+        fd = -1;
+    }
+    return status;
+}
+
+/**
+ * 顺序扫描日志重建索引，截断末尾写了一半的记录
+ */
+app_status_t StateStore::recover() {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return APP_ERROR_FILE_IO;
+    }
+    uint64_t file_size = static_cast<uint64_t>(st.st_size);
+
+    uint8_t file_header[STATE_LOG_HEADER_SIZE];
+    if (file_size < STATE_LOG_HEADER_SIZE) {
+        // 新文件（或连文件头都未写完）
+        memset(file_header, 0, sizeof(file_header));
+        memcpy(file_header, STATE_LOG_MAGIC, sizeof(STATE_LOG_MAGIC));
+        memcpy(file_header + sizeof(STATE_LOG_MAGIC), &STATE_LOG_FORMAT_VERSION, sizeof(STATE_LOG_FORMAT_VERSION));
+        if (ftruncate(fd, 0) != 0 || !write_fully(fd, file_header, sizeof(file_header), 0)) {
+            return APP_ERROR_FILE_IO;
+        }
+        end_offset = STATE_LOG_HEADER_SIZE;
+        return APP_SUCCESS;
+    }
+
+    uint32_t format_version = 0;
+    if (!read_fully(fd, file_header, sizeof(file_header), 0) ||
+        memcmp(file_header, STATE_LOG_MAGIC, sizeof(STATE_LOG_MAGIC)) != 0) {
+        Logger::error("状态日志格式错误: " + path);
+        return APP_ERROR_FILE_IO;
+    }
+    memcpy(&format_version, file_header + sizeof(STATE_LOG_MAGIC), sizeof(format_version));
+    if (format_version != STATE_LOG_FORMAT_VERSION) {
+        Logger::error("不支持的状态日志版本: " + std::to_string(format_version));
+        return APP_ERROR_FILE_IO;
+    }
+
+    // 整个日志一次读入，逐条校验
+    std::vector<uint8_t> data(file_size - STATE_LOG_HEADER_SIZE);
+    if (!data.empty() && !read_fully(fd, data.data(), data.size(), STATE_LOG_HEADER_SIZE)) {
+        return APP_ERROR_FILE_IO;
+    }
+
+    size_t offset = 0;
+    while (data.size() - offset >= sizeof(LogRecordPrefix)) {
+        LogRecordPrefix prefix;
+        memcpy(&prefix, data.data() + offset, sizeof(prefix));
+
+        const uint8_t* record = data.data() + offset + sizeof(prefix);
+        size_t available = data.size() - offset - sizeof(prefix);
+        if (prefix.record_size > available ||
+            checked_record_size(record, prefix.record_size) != prefix.record_size ||
+            record_checksum(record, prefix.record_size) != prefix.checksum) {
+            break;
+        }
+
+        uint32_t record_bytes = static_cast<uint32_t>(sizeof(prefix) + prefix.record_size);
+        apply_record(record, STATE_LOG_HEADER_SIZE + offset + sizeof(prefix), record_bytes);
+        offset += record_bytes;
+    }
+
+    end_offset = STATE_LOG_HEADER_SIZE + offset;
+    if (end_offset < file_size) {
+        Logger::warning("状态日志末尾有" + std::to_string(file_size - end_offset) + "字节不完整的记录，已截断");
+        if (ftruncate(fd, static_cast<off_t>(end_offset)) != 0) {
+            return APP_ERROR_FILE_IO;
+        }
+    }
+
+    return APP_SUCCESS;
+}
+
+/**
+ * 按版本把一条已写入日志的记录应用到索引
+ * @param record 状态记录
+ * @param record_offset 状态记录在日志中的偏移
+ * @param record_bytes 整条日志记录（含校验前缀）的字节数
+ * @return 是否成为该键的最新记录
+ */
+bool StateStore::apply_record(const uint8_t* record, uint64_t record_offset, uint32_t record_bytes) {
+    state_record_header_t header;
+    memcpy(&header, record, sizeof(header));
+
+    std::string key(reinterpret_cast<const char*>(record + sizeof(header)), header.key_size);
+    auto it = index.find(key);
+    if (it != index.end() && it->second.version >= header.version) {
+        dead_bytes += record_bytes;
+        return false;
+    }
+
+    if (it != index.end()) {
+        live_bytes -= it->second.record_bytes;
+        dead_bytes += it->second.record_bytes;
+    }
+
+    IndexEntry& entry = index[key];
+    entry.value_offset = record_offset + sizeof(header) + header.key_size;
+    entry.value_size = header.value_size;
+    entry.record_bytes = record_bytes;
+    entry.version = header.version;
+    entry.deleted = (header.flags & STATE_RECORD_FLAG_DELETED) != 0;
+    live_bytes += record_bytes;
+
+    return true;
+}
+
+int StateStore::get(const uint8_t* key, size_t key_size, uint8_t* value, size_t capacity,
+                    size_t* value_size, uint64_t* version) {
+    *value_size = 0;
+    *version = 0;
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (fd < 0) {
+        return -2;
+    }
+
+    auto it = index.find(std::string(reinterpret_cast<const char*>(key), key_size));
+    if (it == index.end()) {
+        return 1;
+    }
+
+    const IndexEntry& entry = it->second;
+    *version = entry.version;
+    if (entry.deleted) {
+        return 1;
+    }
+
+    *value_size = entry.value_size;
+    if (capacity < entry.value_size) {
+        return -1;
+    }
+
+    return read_fully(fd, value, entry.value_size, entry.value_offset) ? 0 : -2;
+}
+
+app_status_t StateStore::put_batch(const uint8_t* records, size_t records_size, uint32_t record_count) {
+    // 先校验全部记录，格式错误的批次整体拒绝
+    std::vector<uint8_t> buffer;
+    buffer.reserve(records_size + record_count * sizeof(LogRecordPrefix));
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < record_count; i++) {
+        size_t record_size = checked_record_size(records + offset, records_size - offset);
+        if (record_size == 0) {
+            return APP_ERROR_INVALID_PARAM;
+        }
+        append_log_record(buffer, records + offset, record_size);
+        offset += record_size;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (fd < 0) {
+        return APP_ERROR_FILE_IO;
+    }
+
+    uint64_t batch_offset = end_offset;
+    if (!write_fully(fd, buffer.data(), buffer.size(), batch_offset) ||
+        (sync_writes && fdatasync(fd) != 0)) {
+        // 写了一半的记录在下次打开时被截断，这里只需回退写入位置
+        ftruncate(fd, static_cast<off_t>(batch_offset));
+        return APP_ERROR_FILE_IO;
+    }
+    end_offset += buffer.size();
+
+    size_t position = 0;
+    while (position < buffer.size()) {
+        LogRecordPrefix prefix;
+        memcpy(&prefix, buffer.data() + position, sizeof(prefix));
+        uint32_t record_bytes = static_cast<uint32_t>(sizeof(prefix) + prefix.record_size);
+        apply_record(buffer.data() + position + sizeof(prefix),
+                     batch_offset + position + sizeof(prefix), record_bytes);
+        position += record_bytes;
+    }
+
+    if (dead_bytes > STATE_LOG_COMPACT_MIN_DEAD && dead_bytes > live_bytes) {
+        app_status_t status = compact();
+        if (status != APP_SUCCESS) {
+            Logger::warning("状态日志压缩失败，继续使用原日志");
+        }
+    }
+
+    return APP_SUCCESS;
+}
+
+/**
+ * 只保留每个键的最新记录，写入临时文件后原子替换（调用方持有写锁）
+ */
+app_status_t StateStore::compact() {
+    const std::string compact_path = path + ".compact";
+    int new_fd = ::open(compact_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (new_fd < 0) {
+        return APP_ERROR_FILE_IO;
+    }
+
+    std::vector<uint8_t> buffer;
+    buffer.resize(STATE_LOG_HEADER_SIZE, 0);
+    memcpy(buffer.data(), STATE_LOG_MAGIC, sizeof(STATE_LOG_MAGIC));
+    memcpy(buffer.data() + sizeof(STATE_LOG_MAGIC), &STATE_LOG_FORMAT_VERSION, sizeof(STATE_LOG_FORMAT_VERSION));
+
+    std::unordered_map<std::string, IndexEntry> new_index;
+    new_index.reserve(index.size());
+    std::vector<uint8_t> record;
+    bool ok = true;
+
+    for (const auto& item : index) {
+        const IndexEntry& entry = item.second;
+        uint32_t record_size = entry.record_bytes - static_cast<uint32_t>(sizeof(LogRecordPrefix));
+        uint64_t record_offset = entry.value_offset - item.first.size() - sizeof(state_record_header_t);
+
+        record.resize(record_size);
+        if (!read_fully(fd, record.data(), record_size, record_offset)) {
+            ok = false;
+            break;
+        }
+
+        IndexEntry moved = entry;
+        moved.value_offset = buffer.size() + sizeof(LogRecordPrefix) + (entry.value_offset - record_offset);
+        append_log_record(buffer, record.data(), record_size);
+        new_index.emplace(item.first, moved);
+    }
+
+    ok = ok && write_fully(new_fd, buffer.data(), buffer.size(), 0) && fsync(new_fd) == 0 &&
+         rename(compact_path.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        close(new_fd);
+        unlink(compact_path.c_str());
+        return APP_ERROR_FILE_IO;
+    }
+
+    close(fd);
+    fd = new_fd;
+    end_offset = buffer.size();
+    live_bytes = buffer.size() - STATE_LOG_HEADER_SIZE;
+    dead_bytes = 0;
+    index.swap(new_index);
+
+    return APP_SUCCESS;
+}
+
+size_t StateStore::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& item : index) {
+        if (!item.second.deleted) {
+            count++;
+        }
+    }
+    return count;
+}
+
+StateStore& StateStore::instance() {
+    static StateStore store(Config::get_string("state.log_file", Config::data_directory + "/state.log"),
+                            Config::get_bool("state.sync_writes", false));
+    return store;
+}
+
+// 状态OCALL实现
+extern "C" {
+    int ocall_state_read(const uint8_t* key, size_t key_size, uint8_t* value, size_t value_capacity,
+                         size_t* value_size, uint64_t* version) {
+        return StateStore::instance().get(key, key_size, value, value_capacity, value_size, version);
+    }
+
+    int ocall_state_write_batch(const uint8_t* records, size_t records_size, uint32_t record_count) {
+        return StateStore::instance().put_batch(records, records_size, record_count) == APP_SUCCESS ? 0 : -1;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include "app.h"
+
+#include <string>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * 主机侧合约状态存储：单个追加写入的日志文件加内存索引
+ * 日志记录为 校验和(4) | 记录大小(4) | enclave_shared.h中的状态记录，
+ * 打开时顺序扫描重建索引，末尾不完整或校验失败的记录被截断。
+ * 每个键保留版本最高的记录，废弃的记录超过有效记录时压缩日志。
+ * 所有接口均为线程安全
+ */
+class StateStore {
+private:
+    struct IndexEntry {
+        uint64_t value_offset;              // 值在日志中的偏移
+        uint32_t value_size;                // 值大小
+        uint32_t record_bytes;              // 整条日志记录占用的字节数
+        uint64_t version;                   // 状态版本
+        bool deleted;                       // 删除标记（保留以屏蔽版本更低的迟到记录）
+    };
+
+    std::string path;
+    bool sync_writes;
+    int fd;
+    uint64_t end_offset;
+    uint64_t live_bytes;
+    uint64_t dead_bytes;
+    std::unordered_map<std::string, IndexEntry> index;
+    mutable std::shared_mutex mutex;
+
+    app_status_t open_log();
+    app_status_t recover();
+    bool apply_record(const uint8_t* record, uint64_t record_offset, uint32_t record_bytes);
+    app_status_t compact();
+
+public:
+    /**
+     * 创建状态存储并打开日志（不存在时创建），打开失败时所有操作返回错误
+     * @param log_path 日志文件路径
+     * @param sync 每次写回后是否调用fdatasync
+     */
+    StateStore(const std::string& log_path, bool sync = false);
+    ~StateStore();
+
+    StateStore(const StateStore&) = delete;
+    StateStore& operator=(const StateStore&) = delete;
+
+    /**
+     * 读取状态值，直接读入调用方的缓冲区
+     * @param key 状态键
+     * @param key_size 键大小
+     * @param value 输出缓冲区
+     * @param capacity 缓冲区大小
+     * @param value_size 输出值大小（缓冲区太小时为所需大小）
+     * @param version 输出状态版本（不存在时为已删除记录的版本或0）
+     * @return 0存在，1不存在，-1缓冲区太小，-2读取失败
+     */
+    int get(const uint8_t* key, size_t key_size, uint8_t* value, size_t capacity,
+            size_t* value_size, uint64_t* version);
+
+    /**
+     * 追加一批状态记录（一次写入），版本不高于现有记录的项被忽略
+     * @param records 状态记录缓冲区
+     * @param records_size 缓冲区大小
+     * @param record_count 记录数量
+     * @return 应用状态码
+     */
+    app_status_t put_batch(const uint8_t* records, size_t records_size, uint32_t record_count);
+
+    /**
+     * 获取有效状态项数量
+     * @return 键数量（不含已删除的键）
+     */
+    size_t size() const;
+
+    /**
+     * 进程内共享的存储实例，供OCALL使用
+     * 路径取自配置state.log_file（默认data目录下的state.log）
+     * @return 存储实例
+     */
+    static StateStore& instance();
+};
+
+#endif // STATE_STORE_H
@@ -0,0 +1,78 @@
+#include "worker_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+WorkerPool::WorkerPool(size_t thread_count, const std::vector<int>& cpus) : active_tasks(0), stopping(false) {
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+
+    // 所有工作线程共用同一CPU集合，由调度器在集合内均衡
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+
+    workers.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; i++) {
+        workers.emplace_back(&WorkerPool::worker_loop, this);
+        if (CPU_COUNT(&cpu_set) > 0) {
+            pthread_setaffinity_np(workers.back().native_handle(), sizeof(cpu_set), &cpu_set);
+        }
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+        active_tasks++;
+    }
+    task_available.notify_one();
+}
+
+void WorkerPool::wait_all() {
+    std::unique_lock<std::mutex> lock(mutex);
+    tasks_done.wait(lock, [this]() { return active_tasks == 0; });
+}
+
+void WorkerPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_available.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active_tasks--;
+            if (active_tasks == 0) {
+                tasks_done.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * 固定大小的工作线程池
+ * 每个工作线程独占一个Enclave TCS，线程数不应超过TCSNum
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable task_available;
+    std::condition_variable tasks_done;
+    size_t active_tasks;
+    bool stopping;
+
+    void worker_loop();
+
+public:
+    /**
+     * 创建线程池
+     * @param thread_count 工作线程数（至少为1）
+     * @param cpus 工作线程绑定的CPU（为空时不绑定）
+     */
+    explicit WorkerPool(size_t thread_count, const std::vector<int>& cpus = std::vector<int>());
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * 提交任务
+     * @param task 任务函数
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * 等待所有已提交的任务完成
+     */
+    void wait_all();
+
+    /**
+     * 获取工作线程数
+     * @return 线程数
+     */
+    size_t size() const { return workers.size(); }
+};
+
+#endif // WORKER_POOL_H
@@ -154,6 +154,18 @@ build_enclave() {
         "enclave/enclave.cpp"           # 主Enclave实现
         "enclave/contract_verifier.cpp" # 智能合约验证器
         "enclave/crypto_utils.cpp"     # 加密工具函数
+        "enclave/contract_decoder.cpp" # 字节码预解码器
+        "enclave/code_cache.cpp"       # 已解码字节码缓存
+        "enclave/contract_threaded.cpp" # 线程化分派解释器
+        "enclave/contract_jit.cpp"     # 热点合约JIT编译
+        "enclave/merkle_tree.cpp"      # 批量执行证明的Merkle根
+        "enclave/state_cache.cpp"      # 合约状态写回缓存
+        "enclave/exec_arena.cpp"       # 每线程执行槽与临时分配区
+        "enclave/exec_snapshot.cpp"    # 分片执行的密封快照
+        "enclave/slab_alloc.cpp"       # 状态项和内存页的小对象分配器
+        "enclave/exec_profile.cpp"     # 按合约统计的执行剖析
+        "enclave/audit_ring.cpp"       # 审计记录环形缓冲区
+        "enclave/block_exec.cpp"       # 区块乐观并行执行
         "enclave_t.c"                  # EDL生成的可信代理代码
     )
     
@@ -197,6 +209,7 @@ build_enclave() {
         -Wl,--no-undefined -nostdlib -nodefaultlibs -nostartfiles \
         -L$SGX_SDK/lib64 \
         -Wl,--whole-archive -lsgx_trts -Wl,--no-whole-archive \
+        -Wl,--whole-archive -lsgx_tswitchless -Wl,--no-whole-archive \
         -Wl,--start-group -lsgx_tstdc -lsgx_tcxx -lsgx_tcrypto -lsgx_tservice -Wl,--end-group \
         -Wl,-Bstatic -Wl,-Bsymbolic -Wl,--no-undefined \
         -Wl,-pie,-eenclave_entry -Wl,--export-dynamic \
@@ -255,6 +268,16 @@ build_app() {
     local app_sources=(
         "app/main.cpp"      # 主程序入口
         "app/app_utils.cpp" # 应用程序工具函数
+        "app/sgx_utils.cpp" # SGX智能合约应用类
+        "app/worker_pool.cpp" # 并行执行工作线程池
+        "app/benchmark.cpp" # 性能基准测试
+        "app/merkle_proof.cpp" # 批量证明的包含路径
+        "app/proof_verifier.cpp" # 主机侧并行证明验证
+        "app/state_store.cpp" # 日志结构的合约状态存储
+        "app/shared_ring.cpp" # 与Enclave共享的环形缓冲区
+        "app/async_executor.cpp" # 异步提交与完成队列
+        "app/profile_report.cpp" # 剖析快照解析与报告
+        "app/audit_log.cpp" # 审计日志读取线程与轮转写入
         "enclave_u.c"       # EDL生成的不可信代理代码
     )
     
@@ -278,6 +301,7 @@ build_app() {
         g++ -c "$source" -o "$obj_file" \
             -I$SGX_SDK/include \
             -Iapp \
+            -Ienclave \
             -std=c++17 \
             -O2 \
             -D_FORTIFY_SOURCE=2 \
@@ -291,6 +315,7 @@ build_app() {
     g++ "${app_objects[@]}" -o bin/sgx-smart-contract-demo \
         -L$SGX_SDK/lib64 \
         -lsgx_urts \
+        -lsgx_uswitchless \
         -lsgx_uae_service \
         -lssl \
         -lcrypto \
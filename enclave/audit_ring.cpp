@@ -0,0 +1,134 @@
+#include "audit_ring.h"
+#include "enclave_t.h"
+
+#include <sgx_thread.h>
+#include <string.h>
+
+#define AUDIT_RING_MASK         (AUDIT_RING_CAPACITY - 1)
+
+static_assert((AUDIT_RING_CAPACITY & AUDIT_RING_MASK) == 0, "AUDIT_RING_CAPACITY must be a power of two");
+
+// 槽位带序号：序号等于写入位置时可写，等于写入位置+1时可读。
+// 保存的是序号减去槽位下标，零初始化即为初始状态，不需要初始化函数
+typedef struct {
+    uint64_t turn;
+    audit_record_t record;
+} audit_slot_t;
+
+static audit_slot_t g_slots[AUDIT_RING_CAPACITY];
+static uint64_t g_enqueue_pos = 0;
+static uint64_t g_dequeue_pos = 0;                  // 由g_drain_mutex保护
+static uint64_t g_dropped = 0;
+
+// 串行化取出（包括缓冲区满时的OCALL），写入不加锁
+static sgx_thread_mutex_t g_drain_mutex = SGX_THREAD_MUTEX_INITIALIZER;
+static audit_record_t g_flush_buffer[AUDIT_DRAIN_MAX_RECORDS];
+
+static uint64_t load_sequence(uint64_t index) {
+    return __atomic_load_n(&g_slots[index].turn, __ATOMIC_ACQUIRE) + index;
+}
+
+static void store_sequence(uint64_t index, uint64_t sequence) {
+    __atomic_store_n(&g_slots[index].turn, sequence - index, __ATOMIC_RELEASE);
+}
+
+/**
+ * 写入一条记录
+ * @return 是否成功（缓冲区满时为false）
+ */
+static bool try_push(const audit_record_t* record) {
+    uint64_t pos = __atomic_load_n(&g_enqueue_pos, __ATOMIC_RELAXED);
+    uint64_t index;
+    while (true) {
+        index = pos & AUDIT_RING_MASK;
+        int64_t diff = (int64_t)(load_sequence(index) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&g_enqueue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&g_enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(&g_slots[index].record, record, sizeof(*record));
+    g_slots[index].record.sequence = pos;
+    store_sequence(index, pos + 1);
+    return true;
+}
+
+/**
+ * 取出已写完的记录（调用方持有g_drain_mutex）
+ */
+static uint32_t drain_locked(audit_record_t* records, uint32_t max_records) {
+    uint32_t count = 0;
+    while (count < max_records) {
+        uint64_t index = g_dequeue_pos & AUDIT_RING_MASK;
+        if (load_sequence(index) != g_dequeue_pos + 1) {
+            break;
+        }
+        memcpy(&records[count++], &g_slots[index].record, sizeof(audit_record_t));
+        store_sequence(index, g_dequeue_pos + AUDIT_RING_CAPACITY);
+        g_dequeue_pos++;
+    }
+    return count;
+}
+
+/**
+ * 缓冲区满时把全部记录一次写回主机，写回失败的记录计入丢弃数
+ */
+static void flush_to_host(void) {
+    sgx_thread_mutex_lock(&g_drain_mutex);
+
+    uint32_t count;
+    while ((count = drain_locked(g_flush_buffer, AUDIT_DRAIN_MAX_RECORDS)) > 0) {
+        int host_ret = -1;
+        sgx_status_t ret = ocall_audit_write_batch(&host_ret, (const uint8_t*)g_flush_buffer,
+                                                   count * sizeof(audit_record_t), count);
+        if (ret != SGX_SUCCESS || host_ret != 0) {
+            __atomic_fetch_add(&g_dropped, count, __ATOMIC_RELAXED);
+        }
+    }
+
+    sgx_thread_mutex_unlock(&g_drain_mutex);
+}
+
+void audit_ring_record(uint32_t event, uint32_t level, const sgx_sha256_hash_t* code_hash,
+                       const uint8_t* data, size_t data_size, uint64_t gas_used, sgx_status_t status) {
+    audit_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.event = event;
+    record.level = level;
+    record.status = (uint32_t)status;
+    record.data_size = (uint32_t)data_size;
+    record.gas_used = gas_used;
+    if (code_hash) {
+        memcpy(record.code_hash, *code_hash, sizeof(record.code_hash));
+    }
+    if (data && data_size > 0) {
+        memcpy(record.data, data, data_size < AUDIT_RECORD_DATA_SIZE ? data_size : AUDIT_RECORD_DATA_SIZE);
+    }
+
+    // 缓冲区满说明读取线程没有跟上（或未启动），由写入线程一次写回后重试
+    while (!try_push(&record)) {
+        flush_to_host();
+    }
+}
+
+uint32_t audit_ring_drain(audit_record_t* records, uint32_t max_records) {
+    if (!records || max_records == 0) {
+        return 0;
+    }
+
+    sgx_thread_mutex_lock(&g_drain_mutex);
+    uint32_t count = drain_locked(records, max_records);
+    sgx_thread_mutex_unlock(&g_drain_mutex);
+    return count;
+}
+
+uint64_t audit_ring_dropped(void) {
+    return __atomic_load_n(&g_dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,52 @@
+#ifndef AUDIT_RING_H
+#define AUDIT_RING_H
+
+#include "enclave.h"
+#include "enclave_shared.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 审计记录环形缓冲区：写入无锁，取出由一把互斥锁串行化。
+// 正常情况下由主机读取线程定期通过ecall_drain_audit_log取走，
+// 缓冲区满时写入线程以一次ocall_audit_write_batch取出全部记录后再写入
+
+#define AUDIT_RING_CAPACITY     1024    // 槽位数（2的幂）
+
+/**
+ * 写入一条审计记录
+ * @param event AUDIT_EVENT_*
+ * @param level 日志级别
+ * @param code_hash 字节码哈希
+ * @param data 数据（可为NULL，只保留前AUDIT_RECORD_DATA_SIZE字节）
+ * @param data_size 数据大小
+ * @param gas_used 消耗的Gas
+ * @param status 执行状态
+ */
+void audit_ring_record(uint32_t event, uint32_t level, const sgx_sha256_hash_t* code_hash,
+                       const uint8_t* data, size_t data_size, uint64_t gas_used, sgx_status_t status);
+
+/**
+ * 取出审计记录
+ * @param records 输出缓冲区
+ * @param max_records 最多取出的记录数
+ * @return 取出的记录数
+ */
+uint32_t audit_ring_drain(audit_record_t* records, uint32_t max_records);
+
+/**
+ * 获取因写回主机失败而丢弃的记录数
+ * @return 记录数
+ */
+uint64_t audit_ring_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIT_RING_H
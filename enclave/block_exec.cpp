@@ -0,0 +1,642 @@
+#include "block_exec.h"
+#include "exec_arena.h"
+#include "slab_alloc.h"
+#include "crypto_utils.h"
+
+#include <sgx_spinlock.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define NO_TX                   UINT32_MAX      // 没有前序事务（版本取自区块开始时的状态项）
+#define NO_CONTRACT             UINT32_MAX      // 未启用状态持久化
+#define ALL_PAGES_MASK          (VM_MEMORY_PAGE_COUNT == 64 ? ~0ull : (1ull << VM_MEMORY_PAGE_COUNT) - 1)
+
+// 页的版本：写入者事务和写入者的执行次数
+typedef struct {
+    uint32_t writer;
+    uint32_t incarnation;
+} page_version_t;
+
+// 事务的执行记录。乐观执行阶段每个事务只被一个线程执行一次，
+// done置位（release）前写好写集，其他线程读到done后只读不写；提交阶段只有提交线程访问
+typedef struct {
+    block_tx_t tx;
+    uint32_t contract;                              // 合约下标（NO_CONTRACT表示没有共享状态）
+    uint32_t prev;                                  // 同一合约的前一个事务
+    uint32_t done;                                  // 是否已执行（原子）
+    uint32_t incarnation;                           // 执行次数
+    uint64_t read_mask;                             // 读集（页位图）
+    page_version_t read_versions[VM_MEMORY_PAGE_COUNT];  // 读到的各页版本
+    uint64_t write_mask;                            // 写集（页位图，失败的执行为0）
+    uint8_t* pages[VM_MEMORY_PAGE_COUNT];           // 写集各页的内容（slab分配）
+    sgx_status_t status;                            // 执行结果
+    uint32_t state;
+    uint64_t gas_used;
+    sgx_sha256_hash_t execution_hash;
+    uint8_t* result;                                // 结果数据副本
+    size_t result_size;
+} block_entry_t;
+
+// 区块涉及的合约
+typedef struct {
+    state_cache_entry_t* entry;                     // 持有引用的状态项
+    uint64_t base_version;                          // 区块开始时的状态版本
+    size_t base_size;                               // 区块开始时的状态大小
+    uint8_t* base_image;                            // 区块开始时的合约内存（VM_MEMORY_SIZE，末尾补零）
+    uint32_t last;                                  // 该合约的最后一个事务
+} block_contract_t;
+
+// 区块（reserved为false时空闲，占用、查找和释放由g_block_lock保护）
+typedef struct {
+    uint32_t id;
+    bool reserved;                                  // 槽已被占用（id在区块就绪后才分配）
+    uint32_t closing;                               // 已开始提交，不再领取事务（原子）
+    uint32_t active;                                // 正在执行的线程数（原子）
+    uint32_t next_tx;                               // 下一个待领取的事务（原子）
+    uint32_t executions;                            // 乐观执行次数（原子）
+    uint8_t* jobs;                                  // 请求副本
+    uint32_t tx_count;
+    block_entry_t* txs;
+    uint32_t contract_count;
+    block_contract_t* contracts;
+} block_session_t;
+
+static sgx_spinlock_t g_block_lock = SGX_SPINLOCK_INITIALIZER;
+static block_session_t g_sessions[BLOCK_MAX_SESSIONS];
+static uint32_t g_next_block_id = 1;
+
+/**
+ * 释放事务的写集
+ */
+static void release_pages(block_entry_t* tx) {
+    for (uint64_t mask = tx->write_mask; mask; mask &= mask - 1) {
+        size_t page = (size_t)__builtin_ctzll(mask);
+        slab_free(tx->pages[page], VM_MEMORY_PAGE_SIZE);
+        tx->pages[page] = NULL;
+    }
+    tx->write_mask = 0;
+}
+
+/**
+ * 释放区块的全部资源并归还区块槽
+ */
+static void close_session(block_session_t* session) {
+    for (uint32_t i = 0; session->txs && i < session->tx_count; i++) {
+        release_pages(&session->txs[i]);
+        free(session->txs[i].result);
+    }
+    for (uint32_t i = 0; session->contracts && i < session->contract_count; i++) {
+        if (session->contracts[i].entry) {
+            state_cache_release(session->contracts[i].entry);
+        }
+        free(session->contracts[i].base_image);
+    }
+    free(session->txs);
+    free(session->contracts);
+    free(session->jobs);
+
+    sgx_spin_lock(&g_block_lock);
+    memset(session, 0, sizeof(*session));
+    sgx_spin_unlock(&g_block_lock);
+}
+
+/**
+ * 解析批量请求，计算字节码哈希（记录无效的任务直接标记为已执行）
+ */
+static sgx_status_t parse_jobs(block_session_t* session, size_t jobs_size) {
+    // 携带字节码的事务的哈希一次多缓冲计算
+    sha256_job_t* hash_jobs = (sha256_job_t*)malloc((size_t)session->tx_count * sizeof(sha256_job_t));
+    if (!hash_jobs) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    size_t hash_count = 0;
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < session->tx_count; i++) {
+        batch_job_header_t header;
+        if (jobs_size - offset < sizeof(header)) {
+            free(hash_jobs);
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        memcpy(&header, session->jobs + offset, sizeof(header));
+
+        size_t record_size = batch_job_record_size(header.code_size, header.input_size);
+        if (record_size > jobs_size - offset) {
+            free(hash_jobs);
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+
+        block_entry_t* entry = &session->txs[i];
+        block_tx_t* tx = &entry->tx;
+        tx->code = session->jobs + offset + sizeof(header);
+        tx->code_size = header.code_size;
+        tx->input = header.input_size ? tx->code + header.code_size : NULL;
+        tx->input_size = header.input_size;
+        tx->gas_limit = header.gas_limit;
+        entry->contract = NO_CONTRACT;
+        entry->prev = NO_TX;
+        offset += record_size;
+
+        if (header.flags & BATCH_JOB_FLAG_BY_HASH) {
+            memcpy(tx->code_hash, header.code_hash, sizeof(tx->code_hash));
+            tx->code = NULL;
+        } else if (header.code_size == 0) {
+            entry->status = SGX_ERROR_INVALID_PARAMETER;
+            entry->done = 1;
+        } else {
+            hash_jobs[hash_count].data = tx->code;
+            hash_jobs[hash_count].size = tx->code_size;
+            hash_jobs[hash_count].hash = tx->code_hash;
+            hash_count++;
+        }
+    }
+
+    sgx_status_t ret = compute_sha256_multi(hash_jobs, hash_count);
+    free(hash_jobs);
+    return ret;
+}
+
+/**
+ * 按字节码哈希把事务分组到合约，读取并固定各合约在区块开始时的状态
+ */
+static sgx_status_t load_contracts(block_session_t* session) {
+    session->contracts = (block_contract_t*)calloc(session->tx_count, sizeof(block_contract_t));
+    if (!session->contracts) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (uint32_t i = 0; i < session->tx_count; i++) {
+        block_entry_t* tx = &session->txs[i];
+        if (tx->done) {
+            continue;
+        }
+
+        // 一个区块通常只涉及少量合约，线性查找即可
+        uint32_t index = 0;
+        while (index < session->contract_count &&
+               memcmp(session->txs[session->contracts[index].last].tx.code_hash,
+                      tx->tx.code_hash, sizeof(sgx_sha256_hash_t)) != 0) {
+            index++;
+        }
+
+        block_contract_t* contract = &session->contracts[index];
+        if (index == session->contract_count) {
+            uint8_t key[1 + sizeof(sgx_sha256_hash_t)];
+            key[0] = STATE_KEY_PREFIX_CONTRACT;
+            memcpy(key + 1, tx->tx.code_hash, sizeof(sgx_sha256_hash_t));
+
+            contract->base_image = (uint8_t*)calloc(1, VM_MEMORY_SIZE);
+            if (!contract->base_image) {
+                return SGX_ERROR_OUT_OF_MEMORY;
+            }
+            session->contract_count++;
+            sgx_status_t ret = state_cache_acquire(key, sizeof(key), &contract->entry);
+            if (ret != SGX_SUCCESS) {
+                contract->entry = NULL;
+                return ret;
+            }
+
+            sgx_spin_lock(&contract->entry->lock);
+            const state_item_t* item = &contract->entry->item;
+            contract->base_version = item->version;
+            contract->base_size = item->value_size < VM_MEMORY_SIZE ? item->value_size : VM_MEMORY_SIZE;
+            if (contract->base_size > 0) {
+                memcpy(contract->base_image, item->value, contract->base_size);
+            }
+            sgx_spin_unlock(&contract->entry->lock);
+            tx->prev = NO_TX;
+        } else {
+            tx->prev = contract->last;
+        }
+
+        contract->last = i;
+        tx->contract = index;
+    }
+    return SGX_SUCCESS;
+}
+
+/**
+ * 从同一合约的事务链（从head开始向前）中查找各页的最新版本，未执行的事务跳过
+ * @param image 输出合约内存（可为NULL，只查找版本）
+ * @param mask 要查找的页
+ * @param versions 输出各页的版本
+ */
+static void latest_pages(const block_session_t* session, uint32_t contract, uint32_t head,
+                         uint64_t mask, uint8_t* image, page_version_t* versions) {
+    for (uint32_t j = head; j != NO_TX && mask; j = session->txs[j].prev) {
+        const block_entry_t* writer = &session->txs[j];
+        if (!__atomic_load_n(&writer->done, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        for (uint64_t found = writer->write_mask & mask; found; found &= found - 1) {
+            size_t page = (size_t)__builtin_ctzll(found);
+            if (image) {
+                memcpy(image + page * VM_MEMORY_PAGE_SIZE, writer->pages[page], VM_MEMORY_PAGE_SIZE);
+            }
+            versions[page].writer = j;
+            versions[page].incarnation = writer->incarnation;
+        }
+        mask &= ~writer->write_mask;
+    }
+
+    const uint8_t* base = session->contracts[contract].base_image;
+    for (; mask; mask &= mask - 1) {
+        size_t page = (size_t)__builtin_ctzll(mask);
+        if (image) {
+            memcpy(image + page * VM_MEMORY_PAGE_SIZE, base + page * VM_MEMORY_PAGE_SIZE, VM_MEMORY_PAGE_SIZE);
+        }
+        versions[page].writer = NO_TX;
+        versions[page].incarnation = 0;
+    }
+}
+
+/**
+ * 检查事务读到的各页是否仍是最新版本（调用时前序事务均已确定）
+ */
+static bool reads_current(const block_session_t* session, uint32_t index) {
+    const block_entry_t* tx = &session->txs[index];
+    if (tx->contract == NO_CONTRACT || tx->read_mask == 0) {
+        return true;
+    }
+
+    page_version_t versions[VM_MEMORY_PAGE_COUNT];
+    latest_pages(session, tx->contract, tx->prev, tx->read_mask, NULL, versions);
+    for (uint64_t mask = tx->read_mask; mask; mask &= mask - 1) {
+        size_t page = (size_t)__builtin_ctzll(mask);
+        if (versions[page].writer != tx->read_versions[page].writer ||
+            versions[page].incarnation != tx->read_versions[page].incarnation) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * 执行一个事务并发布结果和写集
+ */
+static void execute_tx(block_session_t* session, uint32_t index, block_execute_fn execute, void* arg) {
+    block_entry_t* tx = &session->txs[index];
+    page_version_t versions[VM_MEMORY_PAGE_COUNT];
+    uint8_t* image = NULL;
+    sgx_status_t ret = SGX_SUCCESS;
+
+    if (tx->contract != NO_CONTRACT) {
+        image = (uint8_t*)exec_scratch_alloc(VM_MEMORY_SIZE);
+        if (image) {
+            latest_pages(session, tx->contract, tx->prev, ALL_PAGES_MASK, image, versions);
+        } else {
+            ret = SGX_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    contract_execution_context_t* context = NULL;
+    if (ret == SGX_SUCCESS) {
+        ret = execute(&tx->tx, image, image ? VM_MEMORY_SIZE : 0, arg, &context);
+    }
+    exec_scratch_free(image);
+
+    release_pages(tx);
+    free(tx->result);
+    tx->result = NULL;
+    tx->result_size = 0;
+    tx->read_mask = 0;
+    tx->state = (uint32_t)(context ? context->state : CONTRACT_STATE_ERROR);
+    tx->gas_used = context ? context->gas_used : 0;
+
+    if (context) {
+        // 部分写入的页同样依赖写入前的内容
+        tx->read_mask = (context->read_pages | context->write_pages) & ALL_PAGES_MASK;
+        memcpy(tx->read_versions, versions, sizeof(versions));
+    }
+
+    if (ret == SGX_SUCCESS) {
+        memcpy(tx->execution_hash, context->execution_hash, sizeof(tx->execution_hash));
+        if (context->result_size > 0) {
+            tx->result = (uint8_t*)malloc(context->result_size);
+            if (tx->result) {
+                memcpy(tx->result, context->result_data, context->result_size);
+                tx->result_size = context->result_size;
+            } else {
+                ret = SGX_ERROR_OUT_OF_MEMORY;
+            }
+        }
+    }
+
+    // 与commit_contract_state一致，只有成功完成的执行修改状态
+    if (ret == SGX_SUCCESS && context->state == CONTRACT_STATE_COMPLETED && tx->contract != NO_CONTRACT) {
+        for (uint64_t mask = context->write_pages & ALL_PAGES_MASK; mask; mask &= mask - 1) {
+            size_t page = (size_t)__builtin_ctzll(mask);
+            uint8_t* copy = (uint8_t*)slab_alloc(VM_MEMORY_PAGE_SIZE);
+            if (!copy) {
+                release_pages(tx);
+                ret = SGX_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+            memcpy(copy, context->memory_pages[page], VM_MEMORY_PAGE_SIZE);
+            tx->pages[page] = copy;
+            tx->write_mask |= 1ull << page;
+        }
+    }
+
+    tx->status = ret;
+    tx->incarnation++;
+    __atomic_store_n(&tx->done, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * 查找打开的区块（调用方持有g_block_lock）
+ */
+static block_session_t* find_session(uint32_t block_id) {
+    for (uint32_t i = 0; i < BLOCK_MAX_SESSIONS && block_id != 0; i++) {
+        if (g_sessions[i].id == block_id) {
+            return &g_sessions[i];
+        }
+    }
+    return NULL;
+}
+
+sgx_status_t block_exec_begin(const uint8_t* jobs, size_t jobs_size, uint32_t job_count,
+                              bool persistent, uint32_t* block_id) {
+    if (!jobs || !block_id || job_count == 0 || job_count > BATCH_MAX_JOBS ||
+        jobs_size > BATCH_MAX_REQUEST_SIZE) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 先占用区块槽，准备好之后才分配id，其他线程在此之前找不到该区块
+    sgx_spin_lock(&g_block_lock);
+    block_session_t* session = NULL;
+    for (uint32_t i = 0; i < BLOCK_MAX_SESSIONS && !session; i++) {
+        if (!g_sessions[i].reserved) {
+            session = &g_sessions[i];
+            session->reserved = true;
+        }
+    }
+    sgx_spin_unlock(&g_block_lock);
+    if (!session) {
+        return SGX_ERROR_BUSY;
+    }
+
+    // 请求缓冲区在ECALL返回后释放，复制一份供后续的执行线程使用
+    session->jobs = (uint8_t*)malloc(jobs_size > 0 ? jobs_size : 1);
+    session->tx_count = job_count;
+    session->txs = (block_entry_t*)calloc(job_count, sizeof(block_entry_t));
+    if (!session->jobs || !session->txs) {
+        close_session(session);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(session->jobs, jobs, jobs_size);
+
+    sgx_status_t ret = parse_jobs(session, jobs_size);
+    if (ret == SGX_SUCCESS && persistent) {
+        ret = load_contracts(session);
+    }
+    if (ret != SGX_SUCCESS) {
+        close_session(session);
+        return ret;
+    }
+
+    sgx_spin_lock(&g_block_lock);
+    session->id = g_next_block_id++;
+    if (g_next_block_id == 0) {
+        g_next_block_id = 1;
+    }
+    *block_id = session->id;
+    sgx_spin_unlock(&g_block_lock);
+
+    return SGX_SUCCESS;
+}
+
+sgx_status_t block_exec_run(uint32_t block_id, block_execute_fn execute, void* arg) {
+    if (!execute) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    sgx_spin_lock(&g_block_lock);
+    block_session_t* session = find_session(block_id);
+    if (!session || session->closing) {
+        sgx_spin_unlock(&g_block_lock);
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    __atomic_fetch_add(&session->active, 1, __ATOMIC_RELAXED);
+    sgx_spin_unlock(&g_block_lock);
+
+    while (!__atomic_load_n(&session->closing, __ATOMIC_RELAXED)) {
+        uint32_t index = __atomic_fetch_add(&session->next_tx, 1, __ATOMIC_RELAXED);
+        if (index >= session->tx_count) {
+            break;
+        }
+        if (!session->txs[index].done) {
+            execute_tx(session, index, execute, arg);
+            __atomic_fetch_add(&session->executions, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    __atomic_fetch_sub(&session->active, 1, __ATOMIC_RELEASE);
+    return SGX_SUCCESS;
+}
+
+/**
+ * 拼接合约的最终内存，与区块开始时的状态不同时返回true
+ */
+static bool final_image(const block_session_t* session, uint32_t contract, uint8_t* image, size_t* image_size) {
+    const block_contract_t* info = &session->contracts[contract];
+    page_version_t versions[VM_MEMORY_PAGE_COUNT];
+    latest_pages(session, contract, info->last, ALL_PAGES_MASK, image, versions);
+
+    // 末尾的零字节不写回，装入时重新补零
+    size_t size = VM_MEMORY_SIZE;
+    while (size > 0 && image[size - 1] == 0) {
+        size--;
+    }
+    *image_size = size;
+    return size != info->base_size || memcmp(image, info->base_image, size) != 0;
+}
+
+// 提交时要写回的状态项
+typedef struct {
+    state_cache_entry_t* entry;
+    uint64_t base_version;
+    uint8_t* image;
+    size_t image_size;
+} state_write_t;
+
+static int compare_writes(const void* a, const void* b) {
+    uintptr_t left = (uintptr_t)((const state_write_t*)a)->entry;
+    uintptr_t right = (uintptr_t)((const state_write_t*)b)->entry;
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+/**
+ * 把各合约的最终内存写回状态项：按地址顺序锁住全部要修改的状态项的执行锁，
+ * 版本都未变化时才写入，区块外的执行修改过任何一个状态项时整个区块都不提交
+ */
+static sgx_status_t commit_state(block_session_t* session, state_txn_t* txn, uint32_t* updates) {
+    *updates = 0;
+    if (session->contract_count == 0) {
+        return SGX_SUCCESS;
+    }
+
+    state_write_t* writes = (state_write_t*)calloc(session->contract_count, sizeof(state_write_t));
+    if (!writes) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    sgx_status_t ret = SGX_SUCCESS;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < session->contract_count && ret == SGX_SUCCESS; i++) {
+        state_write_t* write = &writes[count];
+        write->image = (uint8_t*)malloc(VM_MEMORY_SIZE);
+        if (!write->image) {
+            ret = SGX_ERROR_OUT_OF_MEMORY;
+        } else if (final_image(session, i, write->image, &write->image_size)) {
+            write->entry = session->contracts[i].entry;
+            write->base_version = session->contracts[i].base_version;
+            count++;
+        } else {
+            free(write->image);
+            write->image = NULL;
+        }
+    }
+
+    uint32_t updated = 0;
+    if (ret == SGX_SUCCESS && count > 0) {
+        qsort(writes, count, sizeof(state_write_t), compare_writes);
+        // 合约内存只在持有exec_mutex时修改，锁住全部执行锁后版本检查和写入之间不会插入其他提交
+        for (uint32_t i = 0; i < count; i++) {
+            sgx_thread_mutex_lock(&writes[i].entry->exec_mutex);
+        }
+        for (uint32_t i = 0; i < count && ret == SGX_SUCCESS; i++) {
+            if (writes[i].entry->item.version != writes[i].base_version) {
+                ret = SGX_ERROR_INVALID_STATE;
+            }
+        }
+        // 全零时写入空值而不是删除，与commit_contract_state一致
+        for (; updated < count && ret == SGX_SUCCESS; updated++) {
+            sgx_spin_lock(&writes[updated].entry->lock);
+            ret = state_cache_update(writes[updated].entry, writes[updated].image, writes[updated].image_size);
+            sgx_spin_unlock(&writes[updated].entry->lock);
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            sgx_thread_mutex_unlock(&writes[i].entry->exec_mutex);
+        }
+    }
+
+    // 已写入的状态项都加入事务，即使后面的写入失败也会写回主机
+    for (uint32_t i = 0; i < updated; i++) {
+        sgx_status_t add_ret = state_txn_add(txn, writes[i].entry);
+        if (ret == SGX_SUCCESS) {
+            ret = add_ret;
+        }
+    }
+    if (ret == SGX_SUCCESS) {
+        *updates = count;
+    }
+
+    for (uint32_t i = 0; i < session->contract_count; i++) {
+        free(writes[i].image);
+    }
+    free(writes);
+    return ret;
+}
+
+/**
+ * 按批量结果格式输出各事务的结果
+ */
+static void write_results(const block_session_t* session, uint8_t* results, size_t results_size) {
+    size_t records_size = (size_t)session->tx_count * sizeof(batch_result_t);
+    batch_result_t* records = (batch_result_t*)results;
+    uint8_t* result_data = results + records_size;
+    size_t data_capacity = results_size - records_size;
+    size_t data_used = 0;
+    memset(records, 0, records_size);
+
+    for (uint32_t i = 0; i < session->tx_count; i++) {
+        const block_entry_t* tx = &session->txs[i];
+        batch_result_t* record = &records[i];
+        sgx_status_t ret = tx->status;
+        record->state = tx->state;
+        record->gas_used = tx->gas_used;
+        memcpy(record->code_hash, tx->tx.code_hash, sizeof(record->code_hash));
+
+        if (ret == SGX_SUCCESS) {
+            memcpy(record->execution_hash, tx->execution_hash, HASH_SIZE);
+
+            // 结果数据依次追加到数据区
+            if (tx->result_size > data_capacity - data_used) {
+                ret = SGX_ERROR_INVALID_PARAMETER;
+            } else if (tx->result_size > 0) {
+                memcpy(result_data + data_used, tx->result, tx->result_size);
+                record->result_offset = (uint32_t)data_used;
+                record->result_size = (uint32_t)tx->result_size;
+                data_used += tx->result_size;
+            }
+        }
+
+        record->status = (uint32_t)ret;
+    }
+}
+
+sgx_status_t block_exec_commit(uint32_t block_id, block_execute_fn execute, void* arg,
+                               uint8_t* results, size_t results_size, state_txn_t* txn,
+                               block_exec_stats_t* stats) {
+    sgx_spin_lock(&g_block_lock);
+    block_session_t* session = find_session(block_id);
+    if (!session || session->closing) {
+        sgx_spin_unlock(&g_block_lock);
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    __atomic_store_n(&session->closing, 1, __ATOMIC_RELAXED);
+    sgx_spin_unlock(&g_block_lock);
+
+    // 已进入的线程在当前事务结束后退出，通常此时主机已等待所有执行线程返回
+    while (__atomic_load_n(&session->active, __ATOMIC_ACQUIRE) != 0) {
+        // 忙等
+    }
+
+    if (!execute || !results || !txn ||
+        results_size < (size_t)session->tx_count * sizeof(batch_result_t)) {
+        close_session(session);
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 按顺序确定每个事务：前序事务都已确定，读到的版本过期就基于确定的状态重新执行
+    uint32_t executions = __atomic_load_n(&session->executions, __ATOMIC_RELAXED);
+    uint32_t reexecutions = 0;
+    for (uint32_t i = 0; i < session->tx_count; i++) {
+        if (!session->txs[i].done) {
+            execute_tx(session, i, execute, arg);
+            executions++;
+        } else if (!reads_current(session, i)) {
+            execute_tx(session, i, execute, arg);
+            reexecutions++;
+        }
+    }
+
+    write_results(session, results, results_size);
+
+    uint32_t updates = 0;
+    sgx_status_t ret = commit_state(session, txn, &updates);
+
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+        stats->tx_count = session->tx_count;
+        stats->contract_count = session->contract_count;
+        stats->executions = executions;
+        stats->reexecutions = reexecutions;
+        stats->state_updates = updates;
+    }
+
+    close_session(session);
+    return ret;
+}
+
+void block_exec_reset(void) {
+    for (uint32_t i = 0; i < BLOCK_MAX_SESSIONS; i++) {
+        sgx_spin_lock(&g_block_lock);
+        bool open = g_sessions[i].reserved;
+        sgx_spin_unlock(&g_block_lock);
+        if (open) {
+            close_session(&g_sessions[i]);
+        }
+    }
+}
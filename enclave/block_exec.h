@@ -0,0 +1,101 @@
+#ifndef BLOCK_EXEC_H
+#define BLOCK_EXEC_H
+
+#include "enclave.h"
+#include "enclave_shared.h"
+#include "state_cache.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 区块执行：一批事务（批量任务记录）由多个线程乐观并行执行，按批次顺序确定性地提交。
+//
+// 启用状态持久化时每个合约对应一个状态项，冲突按（合约，内存页）检测：
+//   - 执行时合约内存按页取自已执行完的前序同合约事务写入的最新版本，没有则取区块开始时的状态项；
+//     读集为OP_LOAD/OP_HASH读过与OP_STORE写过的页（部分写入的页也依赖原内容），
+//     每页记录读到的版本（写入者事务及其执行次数），写集为OP_STORE写过的页的内容
+//   - 提交时按顺序校验，前序事务均已确定时读到的版本仍是最新的则结果有效，
+//     否则基于已确定的状态重新执行，因此只有冲突的事务会执行两次
+//   - 最后把各合约的最终内存写回状态项；区块开始后状态项被区块外的执行修改过
+//     （state_item_t::version变化）则整个区块不提交
+// 读写集由contract_execution_context_t::read_pages/write_pages记录，JIT后端不维护，区块执行改走线程化分派。
+// 未启用状态持久化时事务之间没有共享状态，只有并行执行
+
+#define BLOCK_MAX_SESSIONS      4       // 同时打开的区块数
+
+// 解析后的事务（字节码和输入指向区块内的请求副本）
+typedef struct {
+    sgx_sha256_hash_t code_hash;            // 字节码哈希
+    const uint8_t* code;                    // 字节码（按哈希引用时为NULL）
+    size_t code_size;                       // 字节码大小
+    const uint8_t* input;                   // 输入数据（为空时为NULL）
+    size_t input_size;                      // 输入数据大小
+    uint64_t gas_limit;                     // Gas限制
+} block_tx_t;
+
+/**
+ * 执行一个事务，由调用方提供（在ECALL的执行槽中执行）
+ * @param tx 事务
+ * @param memory_image 合约内存的初始映像（为NULL时内存清零）
+ * @param memory_image_size 映像大小
+ * @param arg 调用方参数
+ * @param context 输出执行后的上下文（下次调用前有效）
+ * @return SGX状态码
+ */
+typedef sgx_status_t (*block_execute_fn)(const block_tx_t* tx, const uint8_t* memory_image,
+                                         size_t memory_image_size, void* arg,
+                                         contract_execution_context_t** context);
+
+/**
+ * 打开区块：复制并解析批量请求，启用状态持久化时获取并固定所涉及合约的状态项
+ * @param jobs 批量请求（Enclave内）
+ * @param jobs_size 请求大小
+ * @param job_count 事务数量（1到BATCH_MAX_JOBS）
+ * @param persistent 是否启用状态持久化
+ * @param block_id 输出区块编号
+ * @return SGX状态码（区块数达到BLOCK_MAX_SESSIONS时返回SGX_ERROR_BUSY）
+ */
+sgx_status_t block_exec_begin(const uint8_t* jobs, size_t jobs_size, uint32_t job_count,
+                              bool persistent, uint32_t* block_id);
+
+/**
+ * 参与执行区块：领取尚未执行的事务并乐观执行，直到全部领取完毕，可由多个线程同时调用
+ * @param block_id 区块编号
+ * @param execute 执行函数
+ * @param arg 执行函数的参数
+ * @return SGX状态码（区块不存在或已开始提交时返回SGX_ERROR_INVALID_PARAMETER）
+ */
+sgx_status_t block_exec_run(uint32_t block_id, block_execute_fn execute, void* arg);
+
+/**
+ * 提交并关闭区块：等待执行中的线程退出，按顺序校验、重新执行冲突的事务（包括未被领取的事务），
+ * 写回合约状态并输出批量结果。无论成功与否区块都会关闭
+ * @param block_id 区块编号
+ * @param execute 执行函数
+ * @param arg 执行函数的参数
+ * @param results 批量结果缓冲区（batch_result_t[job_count] | 结果数据区）
+ * @param results_size 缓冲区大小
+ * @param txn 修改过的状态项加入的事务
+ * @param stats 输出调度统计（可为NULL）
+ * @return SGX状态码（状态项在区块期间被修改时返回SGX_ERROR_INVALID_STATE，此时不写回任何状态）
+ */
+sgx_status_t block_exec_commit(uint32_t block_id, block_execute_fn execute, void* arg,
+                               uint8_t* results, size_t results_size, state_txn_t* txn,
+                               block_exec_stats_t* stats);
+
+/**
+ * 关闭所有区块并释放资源（ecall_destroy_enclave时调用，调用时不应有线程在执行区块）
+ */
+void block_exec_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLOCK_EXEC_H
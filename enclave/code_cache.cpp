@@ -0,0 +1,362 @@
+#include "code_cache.h"
+#include "contract_decoder.h"
+#include "contract_verifier.h"
+#include "contract_jit.h"
+#include "enclave.h"
+
+#include <sgx_tcrypto.h>
+#include <sgx_spinlock.h>
+#include <string.h>
+#include <stdlib.h>
+
+// 缓存全局状态（由g_cache_lock保护，临界区内不做验证和解码）
+static sgx_spinlock_t g_cache_lock = SGX_SPINLOCK_INITIALIZER;
+static bool g_cache_initialized = false;
+static code_cache_entry_t* g_buckets[CODE_CACHE_BUCKET_COUNT];
+static code_cache_entry_t* g_lru_head = NULL;
+static code_cache_entry_t* g_lru_tail = NULL;
+static code_cache_stats_t g_stats;
+
+/**
+ * 计算哈希桶索引（SHA-256输出本身分布均匀，直接取前4字节）
+ */
+static size_t bucket_index(const sgx_sha256_hash_t* code_hash) {
+    uint32_t prefix;
+    memcpy(&prefix, *code_hash, sizeof(prefix));
+    return prefix % CODE_CACHE_BUCKET_COUNT;
+}
+
+static void lru_unlink(code_cache_entry_t* entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        g_lru_head = entry->lru_next;
+    }
+
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        g_lru_tail = entry->lru_prev;
+    }
+
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void lru_push_front(code_cache_entry_t* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = g_lru_head;
+    if (g_lru_head) {
+        g_lru_head->lru_prev = entry;
+    }
+    g_lru_head = entry;
+    if (!g_lru_tail) {
+        g_lru_tail = entry;
+    }
+}
+
+static code_cache_entry_t* find_entry(const sgx_sha256_hash_t* code_hash) {
+    code_cache_entry_t* entry = g_buckets[bucket_index(code_hash)];
+    while (entry) {
+        if (memcmp(entry->program->code_hash, *code_hash, sizeof(sgx_sha256_hash_t)) == 0) {
+            return entry;
+        }
+        entry = entry->bucket_next;
+    }
+    return NULL;
+}
+
+/**
+ * 从哈希桶和LRU链表中移除并释放缓存项
+ */
+static void remove_entry(code_cache_entry_t* entry) {
+    code_cache_entry_t** link = &g_buckets[bucket_index(&entry->program->code_hash)];
+    while (*link && *link != entry) {
+        link = &(*link)->bucket_next;
+    }
+    if (*link) {
+        *link = entry->bucket_next;
+    }
+
+    lru_unlink(entry);
+
+    g_stats.bytes_used -= entry->footprint;
+    g_stats.entry_count--;
+
+    jit_free_code(entry->jit);
+    free_decoded_contract(entry->program);
+    free(entry);
+}
+
+/**
+ * 从LRU尾部淘汰未被引用的缓存项，直到腾出所需空间
+ */
+static bool evict_for(size_t required) {
+    code_cache_entry_t* entry = g_lru_tail;
+
+    while (g_stats.bytes_used + required > g_stats.budget && entry) {
+        code_cache_entry_t* prev = entry->lru_prev;
+        if (entry->refcount == 0) {
+            remove_entry(entry);
+            g_stats.evictions++;
+        }
+        entry = prev;
+    }
+
+    return g_stats.bytes_used + required <= g_stats.budget;
+}
+
+/**
+ * 命中时将缓存项移到LRU头部并增加引用
+ */
+static void touch_entry(code_cache_entry_t* entry) {
+    lru_unlink(entry);
+    lru_push_front(entry);
+    entry->refcount++;
+}
+
+/**
+ * 移除所有未被引用的缓存项（调用方持有g_cache_lock）
+ */
+static void flush_unlocked(void) {
+    code_cache_entry_t* entry = g_lru_head;
+    while (entry) {
+        code_cache_entry_t* next = entry->lru_next;
+        if (entry->refcount == 0) {
+            remove_entry(entry);
+        }
+        entry = next;
+    }
+}
+
+/**
+ * 验证、解码并插入未命中的合约（调用方未持有g_cache_lock）
+ * @param validated 字节码是否已验证（为true时跳过validate_contract_code）
+ * @param evict 空间不足时是否淘汰其他缓存项
+ * @param entry 输出的缓存项（持有一个引用）
+ */
+static sgx_status_t insert_program(const sgx_sha256_hash_t* code_hash, const uint8_t* code, size_t code_size,
+                                   bool validated, bool evict, code_cache_entry_t** entry) {
+    if (code_size > MAX_DECODE_CODE_SIZE) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    sgx_status_t ret;
+    if (!validated) {
+        ret = validate_contract_code(code, code_size);
+        if (ret != SGX_SUCCESS) {
+            return ret;
+        }
+    }
+
+    decoded_contract_t* program = NULL;
+    ret = decode_contract_code(code, code_size, code_hash, &program);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+
+    code_cache_entry_t* created = (code_cache_entry_t*)malloc(sizeof(code_cache_entry_t));
+    if (!created) {
+        free_decoded_contract(program);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    memset(created, 0, sizeof(*created));
+    created->program = program;
+    created->footprint = decoded_contract_footprint(program) + sizeof(code_cache_entry_t);
+    created->refcount = 1;
+
+    sgx_spin_lock(&g_cache_lock);
+
+    // 解码期间其他线程可能已插入同一合约
+    code_cache_entry_t* found = find_entry(code_hash);
+    if (found) {
+        touch_entry(found);
+        sgx_spin_unlock(&g_cache_lock);
+        free_decoded_contract(program);
+        free(created);
+        *entry = found;
+        return SGX_SUCCESS;
+    }
+
+    bool fits = evict ? evict_for(created->footprint)
+                      : g_stats.bytes_used + created->footprint <= g_stats.budget;
+    if (created->footprint > g_stats.budget || !fits) {
+        sgx_spin_unlock(&g_cache_lock);
+        free_decoded_contract(program);
+        free(created);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t index = bucket_index(code_hash);
+    created->bucket_next = g_buckets[index];
+    g_buckets[index] = created;
+    lru_push_front(created);
+
+    g_stats.bytes_used += created->footprint;
+    g_stats.entry_count++;
+
+    sgx_spin_unlock(&g_cache_lock);
+
+    *entry = created;
+    return SGX_SUCCESS;
+}
+
+/**
+ * 初始化字节码缓存
+ */
+sgx_status_t code_cache_init(size_t budget) {
+    if (budget == 0) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    sgx_spin_lock(&g_cache_lock);
+
+    if (g_cache_initialized) {
+        flush_unlocked();
+    } else {
+        memset(g_buckets, 0, sizeof(g_buckets));
+        memset(&g_stats, 0, sizeof(g_stats));
+        g_lru_head = NULL;
+        g_lru_tail = NULL;
+    }
+
+    g_stats.budget = budget;
+    g_cache_initialized = true;
+
+    sgx_spin_unlock(&g_cache_lock);
+
+    return SGX_SUCCESS;
+}
+
+/**
+ * 调整内存预算
+ */
+sgx_status_t code_cache_set_budget(size_t budget) {
+    if (budget == 0) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    sgx_spin_lock(&g_cache_lock);
+
+    if (!g_cache_initialized) {
+        sgx_spin_unlock(&g_cache_lock);
+        return SGX_ERROR_INVALID_STATE;
+    }
+
+    g_stats.budget = budget;
+    evict_for(0);
+
+    sgx_spin_unlock(&g_cache_lock);
+
+    return SGX_SUCCESS;
+}
+
+/**
+ * 获取已解码的合约
+ */
+sgx_status_t code_cache_acquire(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    code_cache_entry_t** entry
+) {
+    if (!code_hash || !entry) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    *entry = NULL;
+
+    sgx_spin_lock(&g_cache_lock);
+
+    if (!g_cache_initialized) {
+        sgx_spin_unlock(&g_cache_lock);
+        return SGX_ERROR_INVALID_STATE;
+    }
+
+    // 命中：跳过验证和解码
+    code_cache_entry_t* found = find_entry(code_hash);
+    if (found) {
+        touch_entry(found);
+        g_stats.hits++;
+        sgx_spin_unlock(&g_cache_lock);
+        *entry = found;
+        return SGX_SUCCESS;
+    }
+
+    g_stats.misses++;
+    sgx_spin_unlock(&g_cache_lock);
+
+    // 仅按哈希查找
+    if (!code) {
+        return SGX_ERROR_CONTRACT_NOT_CACHED;
+    }
+
+    return insert_program(code_hash, code, code_size, false, true, entry);
+}
+
+/**
+ * 预加载合约
+ */
+sgx_status_t code_cache_preload(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    bool validated
+) {
+    if (!code_hash || !code) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    sgx_spin_lock(&g_cache_lock);
+    bool ready = g_cache_initialized;
+    bool cached = ready && find_entry(code_hash) != NULL;
+    sgx_spin_unlock(&g_cache_lock);
+
+    if (!ready) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    if (cached) {
+        return SGX_SUCCESS;
+    }
+
+    code_cache_entry_t* entry = NULL;
+    sgx_status_t ret = insert_program(code_hash, code, code_size, validated, false, &entry);
+    code_cache_release(entry);
+    return ret;
+}
+
+/**
+ * 释放缓存项引用
+ */
+void code_cache_release(code_cache_entry_t* entry) {
+    if (!entry) {
+        return;
+    }
+
+    sgx_spin_lock(&g_cache_lock);
+    if (entry->refcount > 0) {
+        entry->refcount--;
+    }
+    sgx_spin_unlock(&g_cache_lock);
+}
+
+/**
+ * 清空缓存
+ */
+void code_cache_flush(void) {
+    sgx_spin_lock(&g_cache_lock);
+    flush_unlocked();
+    sgx_spin_unlock(&g_cache_lock);
+}
+
+/**
+ * 获取缓存统计
+ */
+void code_cache_get_stats(code_cache_stats_t* stats) {
+    if (stats) {
+        sgx_spin_lock(&g_cache_lock);
+        memcpy(stats, &g_stats, sizeof(g_stats));
+        sgx_spin_unlock(&g_cache_lock);
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef CODE_CACHE_H
+#define CODE_CACHE_H
+
+#include "enclave.h"
+#include "contract_decoder.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 所有接口均为线程安全，缓存项在引用期间不会被淘汰
+
+// 默认EPC内存预算
+#define CODE_CACHE_DEFAULT_BUDGET   (2 * 1024 * 1024)  // 2MB
+#define CODE_CACHE_BUCKET_COUNT     1024
+
+// 缓存项
+typedef struct code_cache_entry {
+    decoded_contract_t* program;            // 已验证并解码的合约
+    size_t footprint;                       // 占用内存
+    uint32_t refcount;                      // 引用计数（非零时不会被淘汰）
+    uint32_t call_count;                    // 调用次数（JIT分层编译使用）
+    uint32_t jit_attempted;                 // 是否已尝试编译
+    struct jit_code* jit;                   // 编译后的本地代码（可为NULL）
+    struct code_cache_entry* lru_prev;      // LRU链表（头部为最近使用）
+    struct code_cache_entry* lru_next;
+    struct code_cache_entry* bucket_next;   // 哈希桶链表
+} code_cache_entry_t;
+
+// 缓存统计
+typedef struct {
+    uint64_t hits;                          // 命中次数
+    uint64_t misses;                        // 未命中次数
+    uint64_t evictions;                     // 淘汰次数
+    size_t entry_count;                     // 缓存项数量
+    size_t bytes_used;                      // 已用内存
+    size_t budget;                          // 内存预算
+} code_cache_stats_t;
+
+/**
+ * 初始化字节码缓存
+ * @param budget 内存预算（字节）
+ * @return SGX状态码
+ */
+sgx_status_t code_cache_init(size_t budget);
+
+/**
+ * 调整内存预算，超出新预算的未引用缓存项立即淘汰（仍被引用的缓存项在释放后的插入时淘汰）
+ * @param budget 内存预算（字节）
+ * @return SGX状态码
+ */
+sgx_status_t code_cache_set_budget(size_t budget);
+
+/**
+ * 获取已解码的合约，未命中时验证、解码并插入缓存
+ * 返回的缓存项持有一个引用，使用完毕后必须调用code_cache_release
+ * @param code_hash 字节码哈希
+ * @param code 合约字节码（为NULL时只查找缓存）
+ * @param code_size 字节码大小
+ * @param entry 输出的缓存项
+ * @return SGX状态码（合约过大或超出预算时返回SGX_ERROR_OUT_OF_MEMORY，
+ *         只查找缓存且未命中时返回SGX_ERROR_CONTRACT_NOT_CACHED）
+ */
+sgx_status_t code_cache_acquire(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    code_cache_entry_t** entry
+);
+
+/**
+ * 预加载合约（不持有引用，已缓存时直接返回）。空间不足时不淘汰其他缓存项
+ * @param code_hash 字节码哈希（调用方保证与字节码一致）
+ * @param code 合约字节码
+ * @param code_size 字节码大小
+ * @param validated 字节码是否已验证（为true时跳过validate_contract_code）
+ * @return SGX状态码（超出预算时返回SGX_ERROR_OUT_OF_MEMORY）
+ */
+sgx_status_t code_cache_preload(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    bool validated
+);
+
+/**
+ * 释放缓存项引用
+ * @param entry 缓存项
+ */
+void code_cache_release(code_cache_entry_t* entry);
+
+/**
+ * 清空缓存（跳过仍被引用的缓存项）
+ */
+void code_cache_flush(void);
+
+/**
+ * 获取缓存统计
+ * @param stats 输出统计
+ */
+void code_cache_get_stats(code_cache_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CODE_CACHE_H
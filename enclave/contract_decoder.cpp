@@ -0,0 +1,707 @@
+#include "contract_decoder.h"
+#include "contract_verifier.h"
+#include "enclave.h"
+
+#include <sgx_tcrypto.h>
+#include <string.h>
+#include <stdlib.h>
+
+// 虚拟机栈容量
+#define VM_STACK_CAPACITY   (sizeof(((vm_stack_t*)0)->data) / sizeof(uint64_t))
+
+// 块内常量跟踪的栈深度上限
+#define DECODER_CONST_SLOTS 32
+
+// 解码过程中的临时状态
+typedef struct {
+    const uint8_t* code;                    // 合约字节码
+    uint32_t size;                          // 字节码大小
+    uint32_t* index_map;                    // 字节偏移 -> 指令索引
+    uint32_t* worklist;                     // 待解码的跳转目标
+    uint32_t worklist_count;                // 待解码目标数量
+    decoded_instr_t* instrs;                // 指令缓冲区
+    uint32_t instr_count;                   // 指令数量
+    uint32_t instr_capacity;                // 缓冲区容量
+} decoder_state_t;
+
+/**
+ * 追加一条解码指令
+ */
+static decoded_instr_t* emit_instr(decoder_state_t* state, uint8_t opcode, uint32_t pc) {
+    if (state->instr_count == state->instr_capacity) {
+        uint32_t new_capacity = state->instr_capacity * 2;
+        decoded_instr_t* grown = (decoded_instr_t*)realloc(state->instrs, new_capacity * sizeof(decoded_instr_t));
+        if (!grown) {
+            return NULL;
+        }
+        state->instrs = grown;
+        state->instr_capacity = new_capacity;
+    }
+
+    decoded_instr_t* instr = &state->instrs[state->instr_count++];
+    memset(instr, 0, sizeof(*instr));
+    instr->opcode = opcode;
+    instr->pc = pc;
+    instr->target = DECODED_INVALID_INDEX;
+    return instr;
+}
+
+/**
+ * 读取4字节跳转地址
+ */
+static uint32_t read_jump_target(const uint8_t* code, uint32_t pc) {
+    uint32_t target;
+    memcpy(&target, &code[pc + 1], 4);
+    return target;
+}
+
+/**
+ * 从指定偏移开始线性解码，直到遇到已解码的指令或执行流终止
+ */
+static sgx_status_t decode_stream(decoder_state_t* state, uint32_t start) {
+    uint32_t pc = start;
+
+    while (true) {
+        decoded_instr_t* instr;
+
+        // 越过代码末尾
+        if (pc >= state->size) {
+            return emit_instr(state, DECODED_OP_END, pc) ? SGX_SUCCESS : SGX_ERROR_OUT_OF_MEMORY;
+        }
+
+        // 与已解码的指令流衔接
+        if (state->index_map[pc] != DECODED_INVALID_INDEX) {
+            instr = emit_instr(state, DECODED_OP_GOTO, pc);
+            if (!instr) {
+                return SGX_ERROR_OUT_OF_MEMORY;
+            }
+            instr->target = state->index_map[pc];
+            return SGX_SUCCESS;
+        }
+
+        contract_opcode_t opcode = (contract_opcode_t)state->code[pc];
+        uint32_t gas_cost = (uint32_t)get_opcode_gas_cost(opcode);
+        state->index_map[pc] = state->instr_count;
+
+        switch (opcode) {
+            case OP_PUSH:
+                // 与execute_instruction相同的边界条件
+                if (pc + 8 >= state->size) {
+                    instr = emit_instr(state, DECODED_OP_FAIL, pc);
+                    if (!instr) return SGX_ERROR_OUT_OF_MEMORY;
+                    instr->gas_cost = gas_cost;
+                    instr->operand = opcode;
+                    return SGX_SUCCESS;
+                }
+                instr = emit_instr(state, OP_PUSH, pc);
+                if (!instr) return SGX_ERROR_OUT_OF_MEMORY;
+                instr->gas_cost = gas_cost;
+                memcpy(&instr->operand, &state->code[pc + 1], 8);
+                pc += 9;
+                break;
+
+            case OP_JMP: {
+                uint32_t target = (pc + 4 < state->size) ? read_jump_target(state->code, pc) : state->size;
+                if (target >= state->size) {
+                    instr = emit_instr(state, DECODED_OP_FAIL, pc);
+                    if (!instr) return SGX_ERROR_OUT_OF_MEMORY;
+                    instr->gas_cost = gas_cost;
+                    instr->operand = opcode;
+                    return SGX_SUCCESS;
+                }
+                instr = emit_instr(state, OP_JMP, pc);
+                if (!instr) return SGX_ERROR_OUT_OF_MEMORY;
+                instr->gas_cost = gas_cost;
+                instr->operand = target;
+                state->worklist[state->worklist_count++] = target;
+                return SGX_SUCCESS;
+            }
+
+            case OP_JMPIF: {
+                uint32_t target = (pc + 4 < state->size) ? read_jump_target(state->code, pc) : state->size;
+                instr = emit_instr(state, OP_JMPIF, pc);
+                if (!instr) return SGX_ERROR_OUT_OF_MEMORY;
+                instr->gas_cost = gas_cost;
+                if (target >= state->size) {
+                    instr->flags |= DECODED_FLAG_BAD_TARGET;
+                } else {
+                    instr->operand = target;
+                    state->worklist[state->worklist_count++] = target;
+                }
+                // 条件不成立时跳过4字节跳转地址
+                pc += 5;
+                break;
+            }
+
+            case OP_HALT:
+                instr = emit_instr(state, OP_HALT, pc);
+                if (!instr) return SGX_ERROR_OUT_OF_MEMORY;
+                instr->gas_cost = gas_cost;
+                return SGX_SUCCESS;
+
+            case OP_NOP:
+            case OP_POP:
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:
+            case OP_DIV:
+            case OP_MOD:
+            case OP_AND:
+            case OP_OR:
+            case OP_XOR:
+            case OP_NOT:
+            case OP_EQ:
+            case OP_LT:
+            case OP_GT:
+            case OP_LOAD:
+            case OP_STORE:
+            case OP_HASH:
+            case OP_VERIFY:
+            case OP_COPY:
+            case OP_VADD:
+            case OP_VXOR:
+            case OP_VCMP:
+            case OP_VSUM:
+            case OP_INPUT:
+                instr = emit_instr(state, (uint8_t)opcode, pc);
+                if (!instr) return SGX_ERROR_OUT_OF_MEMORY;
+                instr->gas_cost = gas_cost;
+                pc += 1;
+                break;
+
+            default:
+                // OP_CALL/OP_RET等未实现的操作码在执行时失败
+                instr = emit_instr(state, DECODED_OP_FAIL, pc);
+                if (!instr) return SGX_ERROR_OUT_OF_MEMORY;
+                instr->gas_cost = gas_cost;
+                instr->operand = opcode;
+                return SGX_SUCCESS;
+        }
+    }
+}
+
+/**
+ * 判断指令是否结束基本块
+ * OP_HASH、向量指令和OP_INPUT的Gas与数据长度有关，总是块的最后一条指令，块入口只预扣操作码本身的Gas。
+ * OP_INPUT还可能挂起执行，作为块尾保证恢复时从块边界之后继续
+ */
+static bool ends_block(uint8_t opcode) {
+    switch (opcode) {
+        case OP_HASH:
+        case OP_INPUT:
+        case OP_COPY:
+        case OP_VADD:
+        case OP_VXOR:
+        case OP_VCMP:
+        case OP_VSUM:
+        case OP_JMP:
+        case OP_JMPIF:
+        case OP_HALT:
+        case DECODED_OP_FAIL:
+        case DECODED_OP_END:
+        case DECODED_OP_GOTO:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * 获取指令的出栈和入栈数量
+ */
+static void get_stack_effect(uint8_t opcode, int32_t* pops, int32_t* pushes) {
+    switch (opcode) {
+        case OP_PUSH:
+            *pops = 0; *pushes = 1;
+            break;
+        case OP_POP:
+        case OP_JMPIF:
+            *pops = 1; *pushes = 0;
+            break;
+        case OP_NOT:
+        case OP_LOAD:
+        case OP_VERIFY:
+            *pops = 1; *pushes = 1;
+            break;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_MOD:
+        case OP_AND:
+        case OP_OR:
+        case OP_XOR:
+        case OP_EQ:
+        case OP_LT:
+        case OP_GT:
+        case OP_HASH:
+            *pops = 2; *pushes = 1;
+            break;
+        case OP_STORE:
+            *pops = 2; *pushes = 0;
+            break;
+        case OP_VSUM:
+        case OP_INPUT:
+            *pops = 2; *pushes = 1;
+            break;
+        case OP_VCMP:
+            *pops = 3; *pushes = 1;
+            break;
+        case OP_COPY:
+        case OP_VADD:
+        case OP_VXOR:
+            *pops = 3; *pushes = 0;
+            break;
+        default:
+            *pops = 0; *pushes = 0;
+            break;
+    }
+}
+
+/**
+ * 统计块头之后直到块结束的栈深度需求和静态Gas
+ */
+static void fill_block_info(decoded_instr_t* instrs, uint32_t count, uint32_t header) {
+    int32_t depth = 0;
+    int32_t need = 0;
+    int32_t growth = 0;
+    uint32_t length = 0;
+    uint64_t gas = 0;
+
+    for (uint32_t i = header + 1; i < count && instrs[i].opcode != DECODED_OP_BLOCK; i++) {
+        int32_t pops, pushes;
+        get_stack_effect(instrs[i].opcode, &pops, &pushes);
+        if (pops - depth > need) {
+            need = pops - depth;
+        }
+        depth += pushes - pops;
+        if (depth > growth) {
+            growth = depth;
+        }
+        gas += instrs[i].gas_cost;
+        length++;
+        if (ends_block(instrs[i].opcode)) {
+            break;
+        }
+    }
+
+    // 超出栈容量的需求在执行时必然回退到逐条检查
+    instrs[header].block.stack_need = (uint16_t)(need > 0xFFFF ? 0xFFFF : need);
+    instrs[header].block.stack_growth = (uint16_t)(growth > 0xFFFF ? 0xFFFF : growth);
+    instrs[header].block.instr_count = length;
+
+    // 块入口一次性扣除的静态Gas
+    if (gas > UINT32_MAX) {
+        instrs[header].gas_cost = UINT32_MAX;
+        instrs[header].flags |= DECODED_FLAG_GAS_OVERFLOW;
+    } else {
+        instrs[header].gas_cost = (uint32_t)gas;
+    }
+}
+
+/**
+ * 在每个基本块前插入块头，并将跳转目标重定向到块头
+ */
+static sgx_status_t insert_block_headers(decoder_state_t* state) {
+    uint32_t count = state->instr_count;
+    if (count == 0) {
+        return SGX_SUCCESS;
+    }
+
+    uint8_t* leader = (uint8_t*)calloc(count, 1);
+    uint32_t* new_index = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (!leader || !new_index) {
+        free(leader);
+        free(new_index);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    // 入口、跳转目标和终止指令之后的指令开始新块
+    leader[0] = 1;
+    for (uint32_t i = 0; i < count; i++) {
+        const decoded_instr_t* instr = &state->instrs[i];
+        if (instr->target != DECODED_INVALID_INDEX) {
+            leader[instr->target] = 1;
+        }
+        if ((ends_block(instr->opcode) || instr->opcode == OP_JMPIF) && i + 1 < count) {
+            leader[i + 1] = 1;
+        }
+    }
+
+    // 只有衔接或结束的块不需要块头（它们不会是跳转目标）
+    uint32_t total = count;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t opcode = state->instrs[i].opcode;
+        if (opcode == DECODED_OP_END || opcode == DECODED_OP_GOTO) {
+            leader[i] = 0;
+        }
+        total += leader[i];
+    }
+
+    decoded_instr_t* instrs = (decoded_instr_t*)malloc(total * sizeof(decoded_instr_t));
+    if (!instrs) {
+        free(leader);
+        free(new_index);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (leader[i]) {
+            decoded_instr_t* header = &instrs[out++];
+            memset(header, 0, sizeof(*header));
+            header->opcode = DECODED_OP_BLOCK;
+            header->pc = state->instrs[i].pc;
+            header->target = DECODED_INVALID_INDEX;
+        }
+        new_index[i] = out;
+        instrs[out++] = state->instrs[i];
+    }
+
+    for (uint32_t i = 0; i < total; i++) {
+        if (instrs[i].opcode == DECODED_OP_BLOCK) {
+            fill_block_info(instrs, total, i);
+        } else if (instrs[i].target != DECODED_INVALID_INDEX) {
+            instrs[i].target = new_index[instrs[i].target] - 1;
+        }
+    }
+
+    free(leader);
+    free(new_index);
+    free(state->instrs);
+    state->instrs = instrs;
+    state->instr_count = total;
+    state->instr_capacity = total;
+
+    return SGX_SUCCESS;
+}
+
+/**
+ * 把后继指令解析为块头：跳过衔接指令，执行结束的后继返回DECODED_INVALID_INDEX
+ */
+static uint32_t resolve_successor(const decoded_instr_t* instrs, uint32_t count, uint32_t ip) {
+    // 每条衔接指令都指向已解码的指令，最多经过count步
+    for (uint32_t steps = 0; ip < count && steps < count; steps++) {
+        if (instrs[ip].opcode != DECODED_OP_GOTO) {
+            return instrs[ip].opcode == DECODED_OP_END ? DECODED_INVALID_INDEX : ip;
+        }
+        ip = instrs[ip].target;
+    }
+    return count;
+}
+
+/**
+ * 记录后继块的入口栈深度，同一块从不同路径进入时深度必须相同
+ */
+static bool enter_block(const decoded_instr_t* instrs, uint32_t count, uint32_t ip, int32_t depth,
+                        int32_t* entry_depth, uint32_t* pending, uint32_t* pending_count) {
+    uint32_t header = resolve_successor(instrs, count, ip);
+    if (header == DECODED_INVALID_INDEX) {
+        return true;
+    }
+    if (header >= count || instrs[header].opcode != DECODED_OP_BLOCK) {
+        return false;
+    }
+    if (entry_depth[header] < 0) {
+        entry_depth[header] = depth;
+        pending[(*pending_count)++] = header;
+        return true;
+    }
+    return entry_depth[header] == depth;
+}
+
+/**
+ * 从入口的空栈开始沿控制流传播每个块的入口栈深度
+ * 所有可达块满足块头的栈需求和增长上限时，块头的栈边界检查可以省略
+ * @return 是否证明了栈安全（max_depth为执行中的最大栈深度）
+ */
+static bool prove_stack_bounds(const decoded_instr_t* instrs, uint32_t count, uint32_t* max_depth) {
+    int32_t* entry_depth = (int32_t*)malloc(count * sizeof(int32_t));
+    uint32_t* pending = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (!entry_depth || !pending) {
+        free(entry_depth);
+        free(pending);
+        return false;
+    }
+
+    memset(entry_depth, 0xFF, count * sizeof(int32_t));
+    uint32_t pending_count = 0;
+    int32_t deepest = 0;
+    bool safe = enter_block(instrs, count, 0, 0, entry_depth, pending, &pending_count);
+
+    while (safe && pending_count > 0) {
+        uint32_t header = pending[--pending_count];
+        const decoded_instr_t* block = &instrs[header];
+        int32_t depth = entry_depth[header];
+
+        if (depth < block->block.stack_need ||
+            depth + block->block.stack_growth > (int32_t)VM_STACK_CAPACITY) {
+            safe = false;
+            break;
+        }
+        if (depth + block->block.stack_growth > deepest) {
+            deepest = depth + block->block.stack_growth;
+        }
+
+        uint32_t last = header + block->block.instr_count;
+        for (uint32_t i = header + 1; i <= last; i++) {
+            int32_t pops, pushes;
+            get_stack_effect(instrs[i].opcode, &pops, &pushes);
+            depth += pushes - pops;
+        }
+
+        // 块的后继：跳转目标和顺序执行的下一条指令
+        const decoded_instr_t* end = &instrs[last];
+        switch (end->opcode) {
+            case OP_JMP:
+            case DECODED_OP_GOTO:
+                safe = enter_block(instrs, count, end->target, depth, entry_depth, pending, &pending_count);
+                break;
+            case OP_JMPIF:
+                if (!(end->flags & DECODED_FLAG_BAD_TARGET)) {
+                    safe = enter_block(instrs, count, end->target, depth, entry_depth, pending, &pending_count);
+                }
+                safe = safe && enter_block(instrs, count, last + 1, depth, entry_depth, pending, &pending_count);
+                break;
+            case OP_HALT:
+            case DECODED_OP_FAIL:
+            case DECODED_OP_END:
+                break;
+            default:
+                safe = enter_block(instrs, count, last + 1, depth, entry_depth, pending, &pending_count);
+                break;
+        }
+    }
+
+    free(entry_depth);
+    free(pending);
+    *max_depth = safe ? (uint32_t)deepest : 0;
+    return safe;
+}
+
+/**
+ * 折叠两个常量的二元运算，返回操作码是否可以折叠
+ */
+static bool fold_constant(uint8_t opcode, uint64_t a, uint64_t b, uint64_t* result) {
+    switch (opcode) {
+        case OP_ADD: *result = a + b; return true;
+        case OP_SUB: *result = a - b; return true;
+        case OP_MUL: *result = a * b; return true;
+        case OP_AND: *result = a & b; return true;
+        case OP_OR:  *result = a | b; return true;
+        case OP_XOR: *result = a ^ b; return true;
+        default:     return false;
+    }
+}
+
+/**
+ * 判断常量地址的8字节访问是否在合约内存内且不跨页
+ */
+static bool is_safe_address(uint64_t address) {
+    return address < VM_MEMORY_SIZE - 8 && address % VM_MEMORY_PAGE_SIZE <= VM_MEMORY_PAGE_SIZE - 8;
+}
+
+/**
+ * 在块内跟踪由OP_PUSH及其常量运算产生的栈元素，地址为常量的内存访问标记DECODED_FLAG_ADDR_SAFE
+ * 块入口之前的栈元素视为未知，跟踪深度超出上限时从头开始
+ */
+static void mark_constant_addresses(decoded_instr_t* instrs, uint32_t count) {
+    bool known[DECODER_CONST_SLOTS];
+    uint64_t value[DECODER_CONST_SLOTS];
+    uint32_t top = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        decoded_instr_t* instr = &instrs[i];
+        int32_t pops, pushes;
+        uint64_t folded;
+
+        switch (instr->opcode) {
+            case DECODED_OP_BLOCK:
+                top = 0;
+                continue;
+
+            case OP_LOAD:
+                if (top >= 1 && known[top - 1] && is_safe_address(value[top - 1])) {
+                    instr->flags |= DECODED_FLAG_ADDR_SAFE;
+                }
+                break;
+
+            case OP_STORE:
+                if (top >= 2 && known[top - 2] && is_safe_address(value[top - 2])) {
+                    instr->flags |= DECODED_FLAG_ADDR_SAFE;
+                }
+                break;
+
+            case OP_PUSH:
+                if (top == DECODER_CONST_SLOTS) {
+                    top = 0;
+                }
+                known[top] = true;
+                value[top++] = instr->operand;
+                continue;
+
+            default:
+                if (top >= 2 && known[top - 2] && known[top - 1] &&
+                    fold_constant(instr->opcode, value[top - 2], value[top - 1], &folded)) {
+                    top--;
+                    value[top - 1] = folded;
+                    continue;
+                }
+                break;
+        }
+
+        // 其余指令的结果视为未知
+        get_stack_effect(instr->opcode, &pops, &pushes);
+        top = (uint32_t)pops > top ? 0 : top - (uint32_t)pops;
+        for (int32_t n = 0; n < pushes; n++) {
+            if (top == DECODER_CONST_SLOTS) {
+                top = 0;
+            }
+            known[top++] = false;
+        }
+    }
+}
+
+/**
+ * 解码合约字节码
+ */
+sgx_status_t decode_contract_code(
+    const uint8_t* code,
+    size_t size,
+    const sgx_sha256_hash_t* code_hash,
+    decoded_contract_t** program
+) {
+    if (!code || !code_hash || !program || size == 0 || size > MAX_DECODE_CODE_SIZE) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    *program = NULL;
+
+    decoder_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.code = code;
+    state.size = (uint32_t)size;
+    state.instr_capacity = state.size + 16;
+
+    // 每条跳转指令至少占5字节，工作列表容量以字节数为上界
+    state.index_map = (uint32_t*)malloc(size * sizeof(uint32_t));
+    state.worklist = (uint32_t*)malloc((size + 1) * sizeof(uint32_t));
+    state.instrs = (decoded_instr_t*)malloc(state.instr_capacity * sizeof(decoded_instr_t));
+
+    sgx_status_t ret = SGX_SUCCESS;
+    if (!state.index_map || !state.worklist || !state.instrs) {
+        ret = SGX_ERROR_OUT_OF_MEMORY;
+        goto cleanup;
+    }
+
+    memset(state.index_map, 0xFF, size * sizeof(uint32_t));
+
+    // 从入口开始解码，跳转目标落在操作数中间时会产生独立的指令流
+    state.worklist[state.worklist_count++] = 0;
+    while (state.worklist_count > 0) {
+        uint32_t start = state.worklist[--state.worklist_count];
+        if (state.index_map[start] != DECODED_INVALID_INDEX) {
+            continue;
+        }
+        ret = decode_stream(&state, start);
+        if (ret != SGX_SUCCESS) {
+            goto cleanup;
+        }
+    }
+
+    // 解析跳转目标
+    for (uint32_t i = 0; i < state.instr_count; i++) {
+        decoded_instr_t* instr = &state.instrs[i];
+        if ((instr->opcode == OP_JMP || instr->opcode == OP_JMPIF) &&
+            !(instr->flags & DECODED_FLAG_BAD_TARGET)) {
+            instr->target = state.index_map[instr->operand];
+        }
+    }
+
+    ret = insert_block_headers(&state);
+    if (ret != SGX_SUCCESS) {
+        goto cleanup;
+    }
+
+    mark_constant_addresses(state.instrs, state.instr_count);
+
+    {
+        // 头部与指令数组放在同一块内存中
+        size_t instrs_size = state.instr_count * sizeof(decoded_instr_t);
+        decoded_contract_t* result = (decoded_contract_t*)malloc(sizeof(decoded_contract_t) + instrs_size);
+        if (!result) {
+            ret = SGX_ERROR_OUT_OF_MEMORY;
+            goto cleanup;
+        }
+
+        memcpy(result->code_hash, code_hash, sizeof(sgx_sha256_hash_t));
+        result->code_size = state.size;
+        result->instr_count = state.instr_count;
+        result->flags = 0;
+        result->max_stack_depth = 0;
+        if (prove_stack_bounds(state.instrs, state.instr_count, &result->max_stack_depth)) {
+            result->flags |= DECODED_PROGRAM_STACK_SAFE;
+        }
+        result->instrs = (decoded_instr_t*)(result + 1);
+        memcpy(result->instrs, state.instrs, instrs_size);
+
+        *program = result;
+    }
+
+cleanup:
+    free(state.index_map);
+    free(state.worklist);
+    free(state.instrs);
+
+    return ret;
+}
+
+/**
+ * 计算块内从指定指令到块末尾的静态Gas
+ */
+uint64_t decoded_remaining_block_gas(const decoded_contract_t* program, uint32_t ip) {
+    // 向前找到所在块的块头
+    uint32_t header = ip;
+    while (header > 0 && program->instrs[header].opcode != DECODED_OP_BLOCK) {
+        header--;
+    }
+
+    uint32_t end = header + program->instrs[header].block.instr_count;
+    uint64_t gas = 0;
+    for (uint32_t i = ip; i <= end && i < program->instr_count; i++) {
+        gas += program->instrs[i].gas_cost;
+    }
+    return gas;
+}
+
+/**
+ * 查找字节码偏移对应的指令索引
+ */
+uint32_t decoded_find_pc(const decoded_contract_t* program, uint32_t pc) {
+    for (uint32_t i = 0; i < program->instr_count; i++) {
+        const decoded_instr_t* instr = &program->instrs[i];
+        if (instr->pc == pc && instr->opcode != DECODED_OP_BLOCK &&
+            instr->opcode != DECODED_OP_GOTO && instr->opcode != DECODED_OP_END) {
+            return i;
+        }
+    }
+    return DECODED_INVALID_INDEX;
+}
+
+/**
+ * 释放解码结果
+ */
+void free_decoded_contract(decoded_contract_t* program) {
+    free(program);
+}
+
+/**
+ * 计算解码结果占用的内存
+ */
+size_t decoded_contract_footprint(const decoded_contract_t* program) {
+    if (!program) {
+        return 0;
+    }
+
+    return sizeof(decoded_contract_t) + program->instr_count * sizeof(decoded_instr_t);
+}
@@ -0,0 +1,117 @@
+#ifndef CONTRACT_DECODER_H
+#define CONTRACT_DECODER_H
+
+#include "enclave.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 可解码的最大字节码大小（更大的合约直接由字节码解释器执行）
+#define MAX_DECODE_CODE_SIZE    (64 * 1024)    // 64KB
+
+// 无效的指令索引
+#define DECODED_INVALID_INDEX   0xFFFFFFFFu
+
+// 解码后的伪操作码（不会出现在合法字节码中）
+typedef enum {
+    DECODED_OP_FAIL = 0xF0,     // 执行失败：操作数截断、跳转越界或未实现的操作码
+    DECODED_OP_END = 0xF1,      // 程序计数器越过代码末尾，执行停止
+    DECODED_OP_GOTO = 0xF2,     // 解码流之间的衔接，不消耗Gas
+    DECODED_OP_BLOCK = 0xF3     // 基本块头，记录块内栈深度需求和静态Gas成本
+} decoded_pseudo_op_t;
+
+// 解码标志
+#define DECODED_FLAG_BAD_TARGET 0x01    // OP_JMPIF跳转目标无效，条件成立时执行失败
+#define DECODED_FLAG_GAS_OVERFLOW 0x02  // 块的静态Gas超出32位，只能逐条计量
+#define DECODED_FLAG_ADDR_SAFE  0x04    // OP_LOAD/OP_STORE的地址是块内常量，已证明不越界且不跨页
+
+// 程序标志
+#define DECODED_PROGRAM_STACK_SAFE 0x01 // 所有可达块的入口栈深度唯一且满足块的栈需求，执行中不会栈下溢或上溢
+
+// 解码后的指令
+typedef struct {
+    uint8_t opcode;                         // 操作码（contract_opcode_t或伪操作码）
+    uint8_t flags;                          // 解码标志
+    uint16_t reserved;                      // 保留
+    uint32_t pc;                            // 指令在字节码中的偏移
+    uint32_t target;                        // 跳转目标指令索引
+    uint32_t gas_cost;                      // 指令Gas成本（块头为块内所有指令的Gas之和）
+    union {
+        uint64_t operand;                   // 立即数操作数
+        struct {
+            uint16_t stack_need;            // 块入口需要的最小栈深度
+            uint16_t stack_growth;          // 块内相对入口的最大栈增长
+            uint32_t instr_count;           // 块内指令数（不含块头）
+        } block;                            // DECODED_OP_BLOCK的块信息
+    };
+} decoded_instr_t;
+
+// 解码后的合约
+typedef struct {
+    sgx_sha256_hash_t code_hash;            // 字节码哈希
+    uint32_t code_size;                     // 字节码大小
+    uint32_t instr_count;                   // 指令数量
+    uint32_t flags;                         // 程序标志（静态分析结果）
+    uint32_t max_stack_depth;               // 静态分析得出的最大栈深度（DECODED_PROGRAM_STACK_SAFE时有效）
+    decoded_instr_t* instrs;                // 指令数组
+} decoded_contract_t;
+
+/**
+ * 将已验证的合约字节码解码为指令数组
+ * 操作数和跳转目标在解码时解析，执行语义与字节码解释器完全一致
+ * 每个基本块前插入DECODED_OP_BLOCK块头，跳转目标指向块头
+ * 解码后静态分析各块入口的栈深度和块内常量地址，供快速执行路径省略运行时检查
+ * @param code 合约字节码（必须已通过validate_contract_code）
+ * @param size 字节码大小
+ * @param code_hash 字节码哈希
+ * @param program 输出的解码结果（使用free_decoded_contract释放）
+ * @return SGX状态码
+ */
+sgx_status_t decode_contract_code(
+    const uint8_t* code,
+    size_t size,
+    const sgx_sha256_hash_t* code_hash,
+    decoded_contract_t** program
+);
+
+/**
+ * 计算块内从指定指令到块末尾的静态Gas
+ * 用于块入口已扣除整块Gas、块内出错时退还未执行部分
+ * @param program 解码结果
+ * @param ip 指令索引（必须位于某个块内）
+ * @return Gas数量
+ */
+uint64_t decoded_remaining_block_gas(const decoded_contract_t* program, uint32_t ip);
+
+/**
+ * 查找字节码偏移对应的指令索引（每个偏移最多解码一次，用于从快照恢复执行）
+ * @param program 解码结果
+ * @param pc 字节码偏移
+ * @return 指令索引（该偏移未被解码时为DECODED_INVALID_INDEX）
+ */
+uint32_t decoded_find_pc(const decoded_contract_t* program, uint32_t pc);
+
+/**
+ * 释放解码结果
+ * @param program 解码结果
+ */
+void free_decoded_contract(decoded_contract_t* program);
+
+/**
+ * 计算解码结果占用的内存
+ * @param program 解码结果
+ * @return 字节数
+ */
+size_t decoded_contract_footprint(const decoded_contract_t* program);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTRACT_DECODER_H
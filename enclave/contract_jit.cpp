@@ -0,0 +1,663 @@
+#include "contract_jit.h"
+#include "contract_verifier.h"
+#include "contract_decoder.h"
+#include "code_cache.h"
+#include "enclave.h"
+
+#include <sgx_rsrv_mem_mngr.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * 模板式JIT：每条解码指令展开为固定的x86-64指令序列。
+ *
+ * 寄存器约定（只使用调用者保存的寄存器，无需序言和尾声）：
+ *   rdi  jit_frame_t指针    rsi  栈底
+ *   r8   栈顶元素之后       r9   已使用Gas
+ *   r10  Gas限制            r11  合约内存页表
+ *   rax/rcx/rdx  临时寄存器，退出时ecx为指令索引
+ *
+ * 块入口的栈检查和整块Gas扣除与线程化解释器相同；检查不通过、出错或遇到OP_HASH、向量指令时
+ * 写回状态并返回jit_exit_t，由execute_jit_contract处理。
+ * OP_LOAD/OP_STORE只处理页内访问（未分配的页读零页），跨页访问和首次写入某页时旁路退出。
+ */
+
+#define JIT_PAGE_SIZE           4096
+#define JIT_MAX_INSTR_BYTES     128    // 单条解码指令展开后的最大字节数
+#define JIT_EXIT_COUNT          7
+
+// x86条件码
+#define CC_B    0x2
+#define CC_AE   0x3
+#define CC_E    0x4
+#define CC_NE   0x5
+#define CC_A    0x7
+
+static_assert(offsetof(jit_frame_t, dirty_pages) == 56 && VM_MEMORY_PAGE_SIZE == 256,
+              "OP_LOAD/OP_STORE templates hardcode the page bitmap offset and page shift");
+
+// 调用阈值（0表示禁用JIT）
+static uint32_t g_call_threshold = JIT_DEFAULT_CALL_THRESHOLD;
+
+typedef uint32_t (*jit_entry_t)(jit_frame_t* frame);
+
+// 代码生成缓冲区
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    bool overflow;
+} jit_buffer_t;
+
+// 待回填的块跳转
+typedef struct {
+    uint32_t pos;                           // rel32字段的偏移
+    uint32_t target;                        // 目标块头的指令索引
+} jit_fixup_t;
+
+static void emit(jit_buffer_t* buf, const uint8_t* bytes, size_t count) {
+    if (buf->size + count > buf->capacity) {
+        buf->overflow = true;
+        return;
+    }
+    memcpy(buf->data + buf->size, bytes, count);
+    buf->size += count;
+}
+
+#define EMIT(buf, ...) do { \
+        static const uint8_t bytes_[] = { __VA_ARGS__ }; \
+        emit(buf, bytes_, sizeof(bytes_)); \
+    } while (0)
+
+static void emit_u8(jit_buffer_t* buf, uint8_t value) {
+    emit(buf, &value, 1);
+}
+
+static void emit_u32(jit_buffer_t* buf, uint32_t value) {
+    emit(buf, (const uint8_t*)&value, 4);
+}
+
+static void emit_u64(jit_buffer_t* buf, uint64_t value) {
+    emit(buf, (const uint8_t*)&value, 8);
+}
+
+/**
+ * jmp rel32 到已生成的位置
+ */
+static void emit_jmp_to(jit_buffer_t* buf, size_t target) {
+    emit_u8(buf, 0xE9);
+    emit_u32(buf, (uint32_t)(target - (buf->size + 4)));
+}
+
+/**
+ * 无条件退出：mov ecx, ip; jmp exit
+ */
+static void emit_exit(jit_buffer_t* buf, size_t exit_offset, uint32_t ip) {
+    emit_u8(buf, 0xB9);
+    emit_u32(buf, ip);
+    emit_jmp_to(buf, exit_offset);
+}
+
+/**
+ * 条件退出：条件不成立时短跳过退出序列，pre为退出前需要执行的指令
+ */
+static void emit_exit_if(jit_buffer_t* buf, uint8_t cc, size_t exit_offset, uint32_t ip,
+                         const uint8_t* pre, size_t pre_size) {
+    emit_u8(buf, (uint8_t)(0x70 | (cc ^ 1)));
+    emit_u8(buf, (uint8_t)(pre_size + 10));
+    if (pre_size > 0) {
+        emit(buf, pre, pre_size);
+    }
+    emit_exit(buf, exit_offset, ip);
+}
+
+/**
+ * 跳转到块头，目标偏移在所有指令生成后回填
+ */
+static void emit_jmp_block(jit_buffer_t* buf, jit_fixup_t* fixups, uint32_t* fixup_count,
+                           bool conditional, uint32_t target) {
+    if (conditional) {
+        EMIT(buf, 0x0F, 0x85);                          // jne rel32
+    } else {
+        EMIT(buf, 0xE9);                                // jmp rel32
+    }
+    fixups[*fixup_count].pos = (uint32_t)buf->size;
+    fixups[*fixup_count].target = target;
+    (*fixup_count)++;
+    emit_u32(buf, 0);
+}
+
+/**
+ * 生成块头：栈边界检查和整块Gas扣除（已证明栈安全的程序省略栈边界检查）
+ */
+static void emit_block_header(jit_buffer_t* buf, const decoded_instr_t* instr, uint32_t ip,
+                              bool stack_safe, size_t fallback) {
+    uint32_t need = stack_safe ? 0 : instr->block.stack_need;
+    uint32_t growth = stack_safe ? 0 : instr->block.stack_growth;
+    const uint32_t capacity = (uint32_t)(sizeof(((vm_stack_t*)0)->data) / sizeof(uint64_t));
+
+    if (need > 0 || growth > 0) {
+        EMIT(buf, 0x4C, 0x89, 0xC1);                    // mov rcx, r8
+        EMIT(buf, 0x48, 0x29, 0xF1);                    // sub rcx, rsi
+    }
+    if (need > 0) {
+        EMIT(buf, 0x48, 0x81, 0xF9);                    // cmp rcx, need * 8
+        emit_u32(buf, need * 8);
+        emit_exit_if(buf, CC_B, fallback, ip, NULL, 0);
+    }
+    if (growth > capacity) {
+        emit_exit(buf, fallback, ip);
+        return;
+    }
+    if (growth > 0) {
+        EMIT(buf, 0x48, 0x81, 0xF9);                    // cmp rcx, (capacity - growth) * 8
+        emit_u32(buf, (capacity - growth) * 8);
+        emit_exit_if(buf, CC_A, fallback, ip, NULL, 0);
+    }
+
+    if (instr->flags & DECODED_FLAG_GAS_OVERFLOW) {
+        emit_exit(buf, fallback, ip);
+        return;
+    }
+    if (instr->gas_cost > 0) {
+        emit_u8(buf, 0xB8);                             // mov eax, gas
+        emit_u32(buf, instr->gas_cost);
+        EMIT(buf, 0x4C, 0x01, 0xC8);                    // add rax, r9
+        emit_exit_if(buf, CC_B, fallback, ip, NULL, 0); // jc
+        EMIT(buf, 0x4C, 0x39, 0xD0);                    // cmp rax, r10
+        emit_exit_if(buf, CC_A, fallback, ip, NULL, 0);
+        EMIT(buf, 0x49, 0x89, 0xC1);                    // mov r9, rax
+    }
+}
+
+/**
+ * 生成二元运算：[r8-16] op= [r8-8]; r8 -= 8
+ */
+static void emit_binary_alu(jit_buffer_t* buf, uint8_t opcode) {
+    EMIT(buf, 0x49, 0x8B, 0x40, 0xF8);                  // mov rax, [r8-8]
+    emit_u8(buf, 0x49);
+    emit_u8(buf, opcode);                               // op [r8-16], rax
+    EMIT(buf, 0x40, 0xF0);
+    EMIT(buf, 0x49, 0x83, 0xE8, 0x08);                  // sub r8, 8
+}
+
+/**
+ * 生成比较运算：[r8-16] = ([r8-16] cc [r8-8]); r8 -= 8
+ */
+static void emit_compare(jit_buffer_t* buf, uint8_t setcc) {
+    EMIT(buf, 0x49, 0x8B, 0x40, 0xF0);                  // mov rax, [r8-16]
+    EMIT(buf, 0x49, 0x3B, 0x40, 0xF8);                  // cmp rax, [r8-8]
+    EMIT(buf, 0x0F);
+    emit_u8(buf, setcc);                                // setcc al
+    EMIT(buf, 0xC0);
+    EMIT(buf, 0x0F, 0xB6, 0xC0);                        // movzx eax, al
+    EMIT(buf, 0x49, 0x89, 0x40, 0xF0);                  // mov [r8-16], rax
+    EMIT(buf, 0x49, 0x83, 0xE8, 0x08);                  // sub r8, 8
+}
+
+/**
+ * 生成除法和取模，除数为0时执行失败
+ */
+static void emit_divide(jit_buffer_t* buf, bool modulo, uint32_t ip, size_t error) {
+    EMIT(buf, 0x49, 0x8B, 0x48, 0xF8);                  // mov rcx, [r8-8]
+    EMIT(buf, 0x49, 0x83, 0xE8, 0x08);                  // sub r8, 8
+    EMIT(buf, 0x48, 0x85, 0xC9);                        // test rcx, rcx
+    emit_exit_if(buf, CC_E, error, ip, NULL, 0);
+    EMIT(buf, 0x49, 0x8B, 0x40, 0xF8);                  // mov rax, [r8-8]
+    EMIT(buf, 0x31, 0xD2);                              // xor edx, edx
+    EMIT(buf, 0x48, 0xF7, 0xF1);                        // div rcx
+    if (modulo) {
+        EMIT(buf, 0x49, 0x89, 0x50, 0xF8);              // mov [r8-8], rdx
+    } else {
+        EMIT(buf, 0x49, 0x89, 0x40, 0xF8);              // mov [r8-8], rax
+    }
+}
+
+/**
+ * 把rax中已检查边界的地址拆分为页号(rax)和页内偏移(rdx)，跨页访问时旁路退出
+ */
+static void emit_page_split(jit_buffer_t* buf, uint32_t ip, size_t memory_exit) {
+    EMIT(buf, 0x0F, 0xB6, 0xD0);                        // movzx edx, al
+    EMIT(buf, 0x81, 0xFA);                              // cmp edx, VM_MEMORY_PAGE_SIZE - 8
+    emit_u32(buf, VM_MEMORY_PAGE_SIZE - 8);
+    emit_exit_if(buf, CC_A, memory_exit, ip, NULL, 0);
+    EMIT(buf, 0xC1, 0xE8, 0x08);                        // shr eax, 8
+}
+
+/**
+ * 拆分静态分析已证明不越界且不跨页的常量地址，不生成检查
+ */
+static void emit_page_split_unchecked(jit_buffer_t* buf) {
+    EMIT(buf, 0x0F, 0xB6, 0xD0);                        // movzx edx, al
+    EMIT(buf, 0xC1, 0xE8, 0x08);                        // shr eax, 8
+}
+
+/**
+ * 生成全部代码
+ */
+static sgx_status_t generate_code(const decoded_contract_t* program, jit_buffer_t* buf,
+                                  uint32_t* offsets, jit_fixup_t* fixups, size_t* entry) {
+    static const uint8_t pop_one[] = { 0x49, 0x83, 0xE8, 0x08 };          // sub r8, 8
+    static const uint8_t pop_two[] = { 0x49, 0x83, 0xE8, 0x10 };          // sub r8, 16
+    const uint32_t memory_limit = (uint32_t)(VM_MEMORY_SIZE - 8);
+    size_t exits[JIT_EXIT_COUNT];
+    uint32_t fixup_count = 0;
+
+    // 退出桩：写回栈顶、Gas和指令索引，返回退出原因
+    for (uint32_t kind = 0; kind < JIT_EXIT_COUNT; kind++) {
+        exits[kind] = buf->size;
+        EMIT(buf, 0x4C, 0x89, 0x47, 0x08);              // mov [rdi+8], r8
+        EMIT(buf, 0x4C, 0x89, 0x4F, 0x10);              // mov [rdi+16], r9
+        EMIT(buf, 0x89, 0x4F, 0x28);                    // mov [rdi+40], ecx
+        emit_u8(buf, 0xB8);                             // mov eax, kind
+        emit_u32(buf, kind);
+        EMIT(buf, 0xC3);                                // ret
+    }
+
+    // 入口：从帧中加载状态后跳转到恢复地址
+    *entry = buf->size;
+    EMIT(buf, 0x48, 0x8B, 0x37);                        // mov rsi, [rdi]
+    EMIT(buf, 0x4C, 0x8B, 0x47, 0x08);                  // mov r8, [rdi+8]
+    EMIT(buf, 0x4C, 0x8B, 0x4F, 0x10);                  // mov r9, [rdi+16]
+    EMIT(buf, 0x4C, 0x8B, 0x57, 0x18);                  // mov r10, [rdi+24]
+    EMIT(buf, 0x4C, 0x8B, 0x5F, 0x20);                  // mov r11, [rdi+32]
+    EMIT(buf, 0xFF, 0x67, 0x30);                        // jmp [rdi+48]
+
+    for (uint32_t ip = 0; ip < program->instr_count && !buf->overflow; ip++) {
+        const decoded_instr_t* instr = &program->instrs[ip];
+        offsets[ip] = (uint32_t)buf->size;
+
+        switch (instr->opcode) {
+            case DECODED_OP_BLOCK:
+                emit_block_header(buf, instr, ip, (program->flags & DECODED_PROGRAM_STACK_SAFE) != 0,
+                                  exits[JIT_EXIT_FALLBACK]);
+                break;
+
+            case OP_NOP:
+                break;
+
+            case OP_PUSH:
+                if ((int64_t)instr->operand == (int64_t)(int32_t)instr->operand) {
+                    EMIT(buf, 0x49, 0xC7, 0x00);        // mov qword [r8], imm32
+                    emit_u32(buf, (uint32_t)instr->operand);
+                } else {
+                    EMIT(buf, 0x48, 0xB8);              // mov rax, imm64
+                    emit_u64(buf, instr->operand);
+                    EMIT(buf, 0x49, 0x89, 0x00);        // mov [r8], rax
+                }
+                EMIT(buf, 0x49, 0x83, 0xC0, 0x08);      // add r8, 8
+                break;
+
+            case OP_POP:
+                emit(buf, pop_one, sizeof(pop_one));
+                break;
+
+            case OP_ADD: emit_binary_alu(buf, 0x01); break;
+            case OP_SUB: emit_binary_alu(buf, 0x29); break;
+            case OP_AND: emit_binary_alu(buf, 0x21); break;
+            case OP_OR:  emit_binary_alu(buf, 0x09); break;
+            case OP_XOR: emit_binary_alu(buf, 0x31); break;
+
+            case OP_MUL:
+                EMIT(buf, 0x49, 0x8B, 0x40, 0xF0);      // mov rax, [r8-16]
+                EMIT(buf, 0x49, 0x0F, 0xAF, 0x40, 0xF8); // imul rax, [r8-8]
+                EMIT(buf, 0x49, 0x89, 0x40, 0xF0);      // mov [r8-16], rax
+                emit(buf, pop_one, sizeof(pop_one));
+                break;
+
+            case OP_DIV: emit_divide(buf, false, ip, exits[JIT_EXIT_ERROR]); break;
+            case OP_MOD: emit_divide(buf, true, ip, exits[JIT_EXIT_ERROR]); break;
+
+            case OP_NOT:
+                EMIT(buf, 0x49, 0xF7, 0x50, 0xF8);      // not qword [r8-8]
+                break;
+
+            case OP_EQ: emit_compare(buf, 0x94); break; // sete
+            case OP_LT: emit_compare(buf, 0x92); break; // setb
+            case OP_GT: emit_compare(buf, 0x97); break; // seta
+
+            case OP_JMP:
+            case DECODED_OP_GOTO:
+                emit_jmp_block(buf, fixups, &fixup_count, false, instr->target);
+                break;
+
+            case OP_JMPIF:
+                emit(buf, pop_one, sizeof(pop_one));
+                EMIT(buf, 0x49, 0x83, 0x38, 0x00);      // cmp qword [r8], 0
+                if (instr->flags & DECODED_FLAG_BAD_TARGET) {
+                    emit_exit_if(buf, CC_NE, exits[JIT_EXIT_ERROR], ip, NULL, 0);
+                } else {
+                    emit_jmp_block(buf, fixups, &fixup_count, true, instr->target);
+                }
+                break;
+
+            case OP_LOAD:
+                EMIT(buf, 0x49, 0x8B, 0x40, 0xF8);      // mov rax, [r8-8]
+                if (instr->flags & DECODED_FLAG_ADDR_SAFE) {
+                    emit_page_split_unchecked(buf);
+                } else {
+                    EMIT(buf, 0x48, 0x3D);              // cmp rax, memory_limit
+                    emit_u32(buf, memory_limit);
+                    emit_exit_if(buf, CC_AE, exits[JIT_EXIT_ERROR], ip, pop_one, sizeof(pop_one));
+                    emit_page_split(buf, ip, exits[JIT_EXIT_MEMORY]);
+                }
+                EMIT(buf, 0x49, 0x8B, 0x04, 0xC3);      // mov rax, [r11+rax*8]
+                EMIT(buf, 0x48, 0x8B, 0x04, 0x10);      // mov rax, [rax+rdx]
+                EMIT(buf, 0x49, 0x89, 0x40, 0xF8);      // mov [r8-8], rax
+                break;
+
+            case OP_STORE:
+                // 旁路退出时栈保持执行前的状态，由解释器重新执行整条指令
+                EMIT(buf, 0x49, 0x8B, 0x48, 0xF8);      // mov rcx, [r8-8]
+                EMIT(buf, 0x49, 0x8B, 0x40, 0xF0);      // mov rax, [r8-16]
+                if (instr->flags & DECODED_FLAG_ADDR_SAFE) {
+                    emit_page_split_unchecked(buf);
+                } else {
+                    EMIT(buf, 0x48, 0x3D);              // cmp rax, memory_limit
+                    emit_u32(buf, memory_limit);
+                    emit_exit_if(buf, CC_AE, exits[JIT_EXIT_ERROR], ip, pop_two, sizeof(pop_two));
+                    emit_page_split(buf, ip, exits[JIT_EXIT_MEMORY]);
+                }
+                EMIT(buf, 0x48, 0x0F, 0xA3, 0x47, 0x38); // bt [rdi+56], rax
+                emit_exit_if(buf, CC_AE, exits[JIT_EXIT_MEMORY], ip, NULL, 0);
+                EMIT(buf, 0x49, 0x8B, 0x04, 0xC3);      // mov rax, [r11+rax*8]
+                EMIT(buf, 0x48, 0x89, 0x0C, 0x10);      // mov [rax+rdx], rcx
+                emit(buf, pop_two, sizeof(pop_two));
+                break;
+
+            case OP_VERIFY:
+                // 简化：总是返回验证成功
+                EMIT(buf, 0x49, 0xC7, 0x40, 0xF8, 0x01, 0x00, 0x00, 0x00); // mov qword [r8-8], 1
+                break;
+
+            case OP_HASH:
+                emit_exit(buf, exits[JIT_EXIT_HASH], ip);
+                break;
+
+            case OP_COPY:
+            case OP_VADD:
+            case OP_VXOR:
+            case OP_VCMP:
+            case OP_VSUM:
+            case OP_INPUT:
+                emit_exit(buf, exits[JIT_EXIT_VECTOR], ip);
+                break;
+
+            case OP_HALT:
+                emit_exit(buf, exits[JIT_EXIT_HALT], ip);
+                break;
+
+            case DECODED_OP_END:
+                emit_exit(buf, exits[JIT_EXIT_END], ip);
+                break;
+
+            default:
+                // DECODED_OP_FAIL及未实现的操作码
+                emit_exit(buf, exits[JIT_EXIT_ERROR], ip);
+                break;
+        }
+    }
+
+    if (buf->overflow) {
+        return SGX_ERROR_FEATURE_NOT_SUPPORTED;
+    }
+
+    // 回填块跳转
+    for (uint32_t i = 0; i < fixup_count; i++) {
+        uint32_t rel = offsets[fixups[i].target] - (fixups[i].pos + 4);
+        memcpy(buf->data + fixups[i].pos, &rel, 4);
+    }
+
+    return SGX_SUCCESS;
+}
+
+/**
+ * 设置JIT调用次数阈值
+ */
+void jit_set_call_threshold(uint32_t threshold) {
+    __atomic_store_n(&g_call_threshold, threshold, __ATOMIC_RELAXED);
+}
+
+/**
+ * 编译已解码的合约
+ */
+sgx_status_t jit_compile_contract(const decoded_contract_t* program, jit_code_t** code) {
+    if (!program || !code || program->instr_count == 0) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    *code = NULL;
+
+#if defined(__x86_64__)
+    size_t capacity = 256 + (size_t)program->instr_count * JIT_MAX_INSTR_BYTES;
+    if (capacity > JIT_MAX_CODE_SIZE) {
+        return SGX_ERROR_FEATURE_NOT_SUPPORTED;
+    }
+
+    jit_buffer_t buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.data = (uint8_t*)malloc(capacity);
+    buf.capacity = capacity;
+
+    uint32_t* offsets = (uint32_t*)malloc(program->instr_count * sizeof(uint32_t));
+    jit_fixup_t* fixups = (jit_fixup_t*)malloc(program->instr_count * sizeof(jit_fixup_t));
+    jit_code_t* result = (jit_code_t*)malloc(sizeof(jit_code_t));
+
+    sgx_status_t ret = SGX_SUCCESS;
+    size_t entry = 0;
+    if (!buf.data || !offsets || !fixups || !result) {
+        ret = SGX_ERROR_OUT_OF_MEMORY;
+    } else {
+        ret = generate_code(program, &buf, offsets, fixups, &entry);
+    }
+
+    if (ret == SGX_SUCCESS) {
+        // 写入保留内存后去掉写权限
+        size_t size = (buf.size + JIT_PAGE_SIZE - 1) & ~(size_t)(JIT_PAGE_SIZE - 1);
+        void* base = sgx_alloc_rsrv_mem(size);
+        if (!base) {
+            ret = SGX_ERROR_OUT_OF_MEMORY;
+        } else {
+            memcpy(base, buf.data, buf.size);
+            ret = sgx_tprotect_rsrv_mem(base, size, SGX_PROT_READ | SGX_PROT_EXEC);
+            if (ret != SGX_SUCCESS) {
+                sgx_free_rsrv_mem(base, size);
+            } else {
+                result->base = base;
+                result->size = size;
+                result->offsets = offsets;
+                result->instr_count = program->instr_count;
+                result->entry = (uint32_t)entry;
+                *code = result;
+            }
+        }
+    }
+
+    free(buf.data);
+    free(fixups);
+    if (ret != SGX_SUCCESS) {
+        free(offsets);
+        free(result);
+    }
+
+    return ret;
+#else
+    (void)program;
+    return SGX_ERROR_FEATURE_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * 释放本地代码
+ */
+void jit_free_code(jit_code_t* code) {
+    if (!code) {
+        return;
+    }
+
+    sgx_free_rsrv_mem(code->base, code->size);
+    free(code->offsets);
+    free(code);
+}
+
+/**
+ * 获取缓存项的本地代码
+ */
+jit_code_t* jit_get_code(code_cache_entry_t* entry) {
+    jit_code_t* code = __atomic_load_n(&entry->jit, __ATOMIC_ACQUIRE);
+    if (code) {
+        return code;
+    }
+
+    uint32_t threshold = __atomic_load_n(&g_call_threshold, __ATOMIC_RELAXED);
+    if (threshold == 0) {
+        return NULL;
+    }
+
+    uint32_t calls = __atomic_add_fetch(&entry->call_count, 1, __ATOMIC_RELAXED);
+    if (calls < threshold) {
+        return NULL;
+    }
+
+    // 每个合约只尝试编译一次
+    uint32_t expected = 0;
+    if (!__atomic_compare_exchange_n(&entry->jit_attempted, &expected, 1, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+
+    if (jit_compile_contract(entry->program, &code) != SGX_SUCCESS) {
+        return NULL;
+    }
+
+    __atomic_store_n(&entry->jit, code, __ATOMIC_RELEASE);
+    return code;
+}
+
+/**
+ * 从指令ip（块头或块间的衔接指令）进入本地代码，处理旁路退出直到执行结束
+ */
+static sgx_status_t run_jit(contract_execution_context_t* context, const decoded_contract_t* program,
+                            const jit_code_t* code, uint32_t ip) {
+    sgx_status_t ret = SGX_SUCCESS;
+    const uint8_t* base = (const uint8_t*)code->base;
+    jit_entry_t entry = (jit_entry_t)(base + code->entry);
+
+    jit_frame_t frame;
+    frame.stack_base = context->stack.data;
+    frame.sp = context->stack.data + context->stack.top;
+    frame.gas_used = context->gas_used;
+    frame.gas_limit = context->gas_limit;
+    frame.memory_pages = context->memory_pages;
+    frame.exit_ip = 0;
+    frame.reserved = 0;
+    frame.resume = base + code->offsets[ip];
+    frame.dirty_pages = context->dirty_pages;
+
+    while (true) {
+        uint32_t reason = entry(&frame);
+
+        context->stack.top = (size_t)(frame.sp - frame.stack_base);
+        context->gas_used = frame.gas_used;
+        context->dirty_pages = frame.dirty_pages;
+        const decoded_instr_t* instr = &program->instrs[frame.exit_ip];
+        context->pc = instr->pc;
+
+        if (reason == JIT_EXIT_HASH || reason == JIT_EXIT_MEMORY || reason == JIT_EXIT_VECTOR) {
+            // 旁路执行OP_HASH、向量指令或需要跨页、分配页的内存访问，Gas已在块入口扣除；
+            // OP_HASH和向量指令按数据长度计价，与线程化解释器相同，先退回预扣的Gas再由通用实现一起计量
+            uint64_t precharged = reason == JIT_EXIT_MEMORY ? 0 : instr->gas_cost;
+            context->gas_used -= precharged;
+            ret = execute_instruction(context, (contract_opcode_t)instr->opcode);
+            context->gas_used += precharged;
+            if (ret == SGX_SUCCESS) {
+                frame.sp = context->stack.data + context->stack.top;
+                frame.gas_used = context->gas_used;
+                frame.dirty_pages = context->dirty_pages;
+                frame.resume = base + code->offsets[frame.exit_ip + 1];
+                continue;
+            }
+            reason = JIT_EXIT_ERROR;
+        } else if (reason == JIT_EXIT_ERROR) {
+            ret = SGX_ERROR_CONTRACT_EXECUTION_FAILED;
+        }
+
+        switch (reason) {
+            case JIT_EXIT_HALT:
+                context->pc = instr->pc + 1;
+                context->state = CONTRACT_STATE_COMPLETED;
+                break;
+
+            case JIT_EXIT_END:
+                break;
+
+            case JIT_EXIT_FALLBACK:
+                // 栈边界或Gas不足以执行整块，逐条检查直到结束
+                ret = resume_decoded_contract(context, program, frame.exit_ip);
+                break;
+
+            default:
+                // 出错的指令及块内其后的指令不消耗Gas
+                context->gas_used -= decoded_remaining_block_gas(program, frame.exit_ip);
+                context->state = contract_error_state(ret);
+                break;
+        }
+        break;
+    }
+
+    return ret;
+}
+
+/**
+ * 执行已编译的智能合约
+ */
+sgx_status_t execute_jit_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program,
+    const jit_code_t* code
+) {
+    if (!verifier || !context || !program || !code || !verifier->initialized ||
+        code->instr_count != program->instr_count) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 初始化执行上下文（字节码已在解码前验证）
+    sgx_status_t ret = prepare_contract_execution(context);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+
+    ret = run_jit(context, program, code, 0);
+
+    return finish_contract_execution(verifier, context, ret);
+}
+
+/**
+ * 从已恢复或挂起的上下文继续执行本地代码
+ */
+sgx_status_t continue_jit_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program,
+    const jit_code_t* code
+) {
+    if (!verifier || !context || !program || !code || !verifier->initialized ||
+        code->instr_count != program->instr_count) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    uint32_t ip = decoded_find_pc(program, (uint32_t)context->pc);
+    if (ip == DECODED_INVALID_INDEX) {
+        return continue_contract_execution(verifier, context, program);
+    }
+
+    // 与continue_threaded_contract相同：逐条执行完当前块，再从下一个块头进入本地代码
+    context->state = CONTRACT_STATE_RUNNING;
+    sgx_status_t ret = step_decoded_contract(context, program, &ip);
+    if (ret == SGX_SUCCESS && context->state == CONTRACT_STATE_RUNNING) {
+        ret = run_jit(context, program, code, ip);
+    }
+
+    return finish_contract_execution(verifier, context, ret);
+}
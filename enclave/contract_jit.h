@@ -0,0 +1,123 @@
+#ifndef CONTRACT_JIT_H
+#define CONTRACT_JIT_H
+
+#include "enclave.h"
+#include "contract_verifier.h"
+#include "contract_decoder.h"
+#include "code_cache.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 默认调用次数阈值（达到后将合约编译为本地代码，0表示禁用JIT）
+#define JIT_DEFAULT_CALL_THRESHOLD  64
+
+// 单个合约的本地代码上限
+#define JIT_MAX_CODE_SIZE           (1024 * 1024)  // 1MB
+
+// 本地代码退出原因
+typedef enum {
+    JIT_EXIT_HALT = 0,          // 执行OP_HALT
+    JIT_EXIT_END = 1,           // 越过代码末尾
+    JIT_EXIT_ERROR = 2,         // 执行失败，块内未执行部分的Gas需要退还
+    JIT_EXIT_FALLBACK = 3,      // 块入口检查不通过，转入逐条检查的解码路径
+    JIT_EXIT_HASH = 4,          // 旁路退出：OP_HASH由解释器执行并计量按长度计价的Gas后继续本地代码
+    JIT_EXIT_MEMORY = 5,        // 旁路退出：跨页或写入未分配页的OP_LOAD/OP_STORE由解释器执行
+    JIT_EXIT_VECTOR = 6         // 旁路退出：向量指令和OP_INPUT由解释器执行并计量与长度相关的Gas
+} jit_exit_t;
+
+/*
+ * 本地代码与解释器之间交换的状态，字段偏移在代码生成中硬编码，不得调整顺序
+ */
+typedef struct {
+    uint64_t* stack_base;                   // 0: 栈底
+    uint64_t* sp;                           // 8: 栈顶元素之后
+    uint64_t gas_used;                      // 16: 已使用Gas
+    uint64_t gas_limit;                     // 24: Gas限制
+    const uint8_t* const* memory_pages;     // 32: 合约内存页表（本地代码只写入dirty_pages中已分配的页）
+    uint32_t exit_ip;                       // 40: 退出时的指令索引
+    uint32_t reserved;                      // 44: 保留
+    const void* resume;                     // 48: 进入本地代码后跳转的地址
+    uint64_t dirty_pages;                   // 56: 已分配的内存页位图
+} jit_frame_t;
+
+// 编译后的合约
+typedef struct jit_code {
+    void* base;                             // 保留内存中的代码区（只读可执行）
+    size_t size;                            // 代码区大小（页对齐）
+    uint32_t* offsets;                      // 指令索引 -> 代码偏移
+    uint32_t instr_count;                   // 指令数量
+    uint32_t entry;                         // 入口（加载帧状态）的代码偏移
+} jit_code_t;
+
+/**
+ * 设置JIT调用次数阈值
+ * @param threshold 阈值（0表示禁用，1表示首次执行即编译）
+ */
+void jit_set_call_threshold(uint32_t threshold);
+
+/**
+ * 将已解码的合约编译为x86-64本地代码
+ * 代码写入SGX保留内存后改为只读可执行
+ * @param program 已验证并解码的合约
+ * @param code 输出的本地代码（使用jit_free_code释放）
+ * @return SGX状态码（非x86-64或代码过大时返回SGX_ERROR_FEATURE_NOT_SUPPORTED）
+ */
+sgx_status_t jit_compile_contract(const decoded_contract_t* program, jit_code_t** code);
+
+/**
+ * 释放本地代码
+ * @param code 本地代码
+ */
+void jit_free_code(jit_code_t* code);
+
+/**
+ * 获取缓存项的本地代码，调用次数达到阈值时编译
+ * 编译失败的合约不再重试，继续由解释器执行
+ * @param entry 已持有引用的缓存项
+ * @return 本地代码（尚未编译或禁用时为NULL）
+ */
+jit_code_t* jit_get_code(code_cache_entry_t* entry);
+
+/**
+ * 执行已编译的智能合约
+ * 结果、Gas使用量和执行哈希与execute_contract完全一致
+ * @param verifier 验证器实例
+ * @param context 执行上下文
+ * @param program 已验证并解码的合约
+ * @param code 由program编译的本地代码
+ * @return SGX状态码
+ */
+sgx_status_t execute_jit_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program,
+    const jit_code_t* code
+);
+
+/**
+ * 从已恢复pc、栈、内存和已用Gas的上下文继续执行本地代码（不再初始化上下文）
+ * 当前块的剩余指令逐条检查执行，之后从下一个块头进入本地代码
+ * @param verifier 验证器实例
+ * @param context 执行上下文
+ * @param program 已验证并解码的合约
+ * @param code 由program编译的本地代码
+ * @return SGX状态码
+ */
+sgx_status_t continue_jit_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program,
+    const jit_code_t* code
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTRACT_JIT_H
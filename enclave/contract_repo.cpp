@@ -0,0 +1,179 @@
+#include "contract_repo.h"
+#include "code_cache.h"
+#include "contract_decoder.h"
+#include "contract_verifier.h"
+
+#include <sgx_trts.h>
+#include <sgx_tseal.h>
+#include <string.h>
+#include <stdlib.h>
+
+static_assert(sizeof(sgx_sealed_data_t) + sizeof(contract_repo_meta_t) <= CONTRACT_REPO_MAX_META_SIZE,
+              "CONTRACT_REPO_MAX_META_SIZE cannot hold the sealed metadata");
+
+/**
+ * 区间[offset, offset + size)是否位于文件内
+ */
+static bool range_in_file(uint64_t offset, uint64_t size, size_t file_size) {
+    return offset <= file_size && size <= file_size - offset;
+}
+
+/**
+ * 解封条目的元数据（sealed已复制进Enclave）
+ */
+static sgx_status_t unseal_metadata(const uint8_t* sealed, uint32_t sealed_size, contract_repo_meta_t* meta) {
+    const sgx_sealed_data_t* blob = (const sgx_sealed_data_t*)sealed;
+    if (sealed_size < sizeof(sgx_sealed_data_t) ||
+        sgx_get_add_mac_txt_len(blob) != 0 ||
+        sgx_get_encrypt_txt_len(blob) != sizeof(contract_repo_meta_t) ||
+        sealed_size < sgx_calc_sealed_data_size(0, sizeof(contract_repo_meta_t))) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    uint32_t unsealed_size = sizeof(contract_repo_meta_t);
+    sgx_status_t ret = sgx_unseal_data(blob, NULL, NULL, (uint8_t*)meta, &unsealed_size);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+
+    if (unsealed_size != sizeof(contract_repo_meta_t) || meta->version != CONTRACT_REPO_META_VERSION ||
+        !(meta->flags & CONTRACT_REPO_META_VALIDATED)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    return SGX_SUCCESS;
+}
+
+/**
+ * 验证字节码并密封其元数据
+ */
+sgx_status_t contract_repo_seal_metadata(
+    const uint8_t* code,
+    size_t code_size,
+    uint8_t* sealed,
+    size_t capacity,
+    size_t* sealed_size
+) {
+    if (!code || code_size == 0 || code_size > MAX_DECODE_CODE_SIZE || !sealed || !sealed_size) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    uint32_t required_size = sgx_calc_sealed_data_size(0, sizeof(contract_repo_meta_t));
+    *sealed_size = required_size;
+    if (capacity < required_size) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    sgx_status_t ret = validate_contract_code(code, code_size);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+
+    contract_repo_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    meta.version = CONTRACT_REPO_META_VERSION;
+    meta.flags = CONTRACT_REPO_META_VALIDATED;
+    meta.code_size = (uint32_t)code_size;
+
+    ret = sgx_sha256_msg(code, (uint32_t)code_size, &meta.code_hash);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+
+    return sgx_seal_data(0, NULL, sizeof(meta), (const uint8_t*)&meta,
+                         required_size, (sgx_sealed_data_t*)sealed);
+}
+
+/**
+ * 把仓库中的合约预加载到字节码缓存
+ */
+sgx_status_t contract_repo_warm(
+    const uint8_t* repository,
+    size_t repository_size,
+    uint32_t* loaded,
+    uint32_t* rejected
+) {
+    if (!repository || !loaded || !rejected || repository_size < sizeof(contract_repo_header_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    *loaded = 0;
+    *rejected = 0;
+
+    if (!sgx_is_outside_enclave(repository, repository_size)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 主机内存可能随时被修改，所有字段先复制进Enclave再检查和使用
+    contract_repo_header_t header;
+    memcpy(&header, repository, sizeof(header));
+    if (memcmp(header.magic, CONTRACT_REPO_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CONTRACT_REPO_VERSION ||
+        header.file_size != repository_size ||
+        header.entry_count > CONTRACT_REPO_MAX_ENTRIES ||
+        header.index_offset < sizeof(header) ||
+        !range_in_file(header.index_offset, (uint64_t)header.entry_count * sizeof(contract_repo_index_t),
+                       repository_size)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t* code = (uint8_t*)malloc(MAX_DECODE_CODE_SIZE);
+    if (!code) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    uint8_t sealed[CONTRACT_REPO_MAX_META_SIZE];
+    sgx_status_t ret = SGX_SUCCESS;
+
+    for (uint32_t i = 0; i < header.entry_count; i++) {
+        contract_repo_index_t entry;
+        memcpy(&entry, repository + header.index_offset + (uint64_t)i * sizeof(entry), sizeof(entry));
+
+        if (entry.meta_size > sizeof(sealed) || entry.code_size == 0 || entry.code_size > MAX_DECODE_CODE_SIZE ||
+            !range_in_file(entry.meta_offset, entry.meta_size, repository_size) ||
+            !range_in_file(entry.code_offset, entry.code_size, repository_size)) {
+            (*rejected)++;
+            continue;
+        }
+
+        memcpy(sealed, repository + entry.meta_offset, entry.meta_size);
+        contract_repo_meta_t meta;
+        if (unseal_metadata(sealed, entry.meta_size, &meta) != SGX_SUCCESS ||
+            meta.code_size != entry.code_size ||
+            memcmp(meta.code_hash, entry.code_hash, sizeof(meta.code_hash)) != 0) {
+            (*rejected)++;
+            continue;
+        }
+
+        // 元数据只证明该哈希的字节码已验证，复制进来的字节码须与之一致
+        memcpy(code, repository + entry.code_offset, entry.code_size);
+        sgx_sha256_hash_t code_hash;
+        ret = sgx_sha256_msg(code, entry.code_size, &code_hash);
+        if (ret != SGX_SUCCESS) {
+            break;
+        }
+        if (memcmp(code_hash, meta.code_hash, sizeof(code_hash)) != 0) {
+            (*rejected)++;
+            continue;
+        }
+
+        ret = code_cache_preload(&code_hash, code, entry.code_size, true);
+        if (ret == SGX_ERROR_OUT_OF_MEMORY) {
+            // 预算已满，剩余的合约在首次执行时照常加载
+            ret = SGX_SUCCESS;
+            break;
+        }
+        if (ret != SGX_SUCCESS) {
+            if (ret == SGX_ERROR_INVALID_STATE) {
+                break;
+            }
+            (*rejected)++;
+            ret = SGX_SUCCESS;
+            continue;
+        }
+        (*loaded)++;
+    }
+
+    free(code);
+    return ret;
+}
@@ -0,0 +1,72 @@
+#ifndef CONTRACT_REPO_H
+#define CONTRACT_REPO_H
+
+#include "enclave.h"
+#include "enclave_shared.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 合约仓库（文件格式见enclave_shared.h）：主机映射整个文件，预热时一次ECALL
+// 把其中的合约解码进字节码缓存，元数据证明字节码已通过本Enclave的验证，因此跳过验证
+
+// 元数据明文格式版本（验证规则变化时递增，旧元数据随之失效，合约回到首次执行时验证）
+#define CONTRACT_REPO_META_VERSION      2
+
+// 元数据标志
+#define CONTRACT_REPO_META_VALIDATED    0x01    // 字节码已通过validate_contract_code
+
+// 元数据明文，按MRSIGNER策略密封
+typedef struct {
+    uint32_t version;                       // CONTRACT_REPO_META_VERSION
+    uint32_t flags;                         // 元数据标志
+    uint32_t code_size;                     // 字节码大小
+    uint32_t reserved;                      // 保留
+    sgx_sha256_hash_t code_hash;            // 字节码哈希
+} contract_repo_meta_t;
+
+/**
+ * 验证字节码并密封其元数据
+ * @param code 合约字节码（Enclave内）
+ * @param code_size 字节码大小（不超过MAX_DECODE_CODE_SIZE）
+ * @param sealed 输出缓冲区
+ * @param capacity 缓冲区大小
+ * @param sealed_size 输出元数据大小（缓冲区不足时为所需大小）
+ * @return SGX状态码（字节码无效时返回验证错误）
+ */
+sgx_status_t contract_repo_seal_metadata(
+    const uint8_t* code,
+    size_t code_size,
+    uint8_t* sealed,
+    size_t capacity,
+    size_t* sealed_size
+);
+
+/**
+ * 把仓库中的合约预加载到字节码缓存
+ * 仓库须整体位于Enclave之外，每个条目的元数据和字节码先复制进Enclave再解封、核对哈希；
+ * 元数据无效或哈希不符的条目被拒绝，缓存预算用尽时停止（已缓存的合约不被淘汰）
+ * @param repository 映射的仓库文件
+ * @param repository_size 文件大小
+ * @param loaded 输出已在缓存中的合约数量
+ * @param rejected 输出被拒绝的条目数量
+ * @return SGX状态码（文件头或索引无效时返回SGX_ERROR_INVALID_PARAMETER）
+ */
+sgx_status_t contract_repo_warm(
+    const uint8_t* repository,
+    size_t repository_size,
+    uint32_t* loaded,
+    uint32_t* rejected
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTRACT_REPO_H
@@ -0,0 +1,251 @@
+#include "contract_threaded.h"
+#include "contract_verifier.h"
+#include "contract_decoder.h"
+#include "enclave.h"
+
+#include <string.h>
+
+// 虚拟机栈容量
+#define VM_STACK_CAPACITY   (sizeof(((vm_stack_t*)0)->data) / sizeof(uint64_t))
+
+// 分派表填充（未使用的操作码均指向失败处理）
+#define FAIL_8      &&op_fail, &&op_fail, &&op_fail, &&op_fail, \
+                    &&op_fail, &&op_fail, &&op_fail, &&op_fail
+#define FAIL_64     FAIL_8, FAIL_8, FAIL_8, FAIL_8, FAIL_8, FAIL_8, FAIL_8, FAIL_8
+
+/**
+ * 线程化分派主循环
+ * 块头检查通过后，块内指令不再逐条检查栈边界和Gas：整块的静态Gas在入口一次性扣除，
+ * 块内出错时退还出错指令及其后的Gas，与字节码解释器逐条计量的结果一致。
+ * 解码时已证明栈安全的程序（DECODED_PROGRAM_STACK_SAFE）块头也不再检查栈边界。
+ * ip必须是块头或块间的衔接指令
+ */
+static sgx_status_t run_threaded(contract_execution_context_t* context, const decoded_contract_t* program,
+                                 uint32_t ip) {
+    // 按操作码索引的处理入口，顺序必须与contract_opcode_t和decoded_pseudo_op_t一致
+    static const void* const dispatch_table[256] = {
+        &&op_nop, &&op_push, &&op_pop, &&op_add, &&op_sub, &&op_mul, &&op_div, &&op_mod,        // 0x00-0x07
+        &&op_and, &&op_or, &&op_xor, &&op_not, &&op_eq, &&op_lt, &&op_gt, &&op_jmp,             // 0x08-0x0F
+        &&op_jmpif, &&op_fail, &&op_fail, &&op_load, &&op_store, &&op_metered, &&op_verify, &&op_metered, // 0x10-0x17
+        &&op_metered, &&op_metered, &&op_metered, &&op_metered, &&op_metered, &&op_fail, &&op_fail, &&op_fail, // 0x18-0x1F
+        FAIL_64, FAIL_64, FAIL_64, FAIL_8, FAIL_8,                                               // 0x20-0xEF
+        &&op_fail, &&op_end, &&op_goto, &&op_block, &&op_fail, &&op_fail, &&op_fail, &&op_fail,  // 0xF0-0xF7
+        &&op_fail, &&op_fail, &&op_fail, &&op_fail, &&op_fail, &&op_fail, &&op_fail, &&op_halt   // 0xF8-0xFF
+    };
+    // 静态分析证明栈安全的程序使用的分派表：块头只检查Gas，其余与dispatch_table相同
+    static const void* const verified_table[256] = {
+        &&op_nop, &&op_push, &&op_pop, &&op_add, &&op_sub, &&op_mul, &&op_div, &&op_mod,        // 0x00-0x07
+        &&op_and, &&op_or, &&op_xor, &&op_not, &&op_eq, &&op_lt, &&op_gt, &&op_jmp,             // 0x08-0x0F
+        &&op_jmpif, &&op_fail, &&op_fail, &&op_load, &&op_store, &&op_metered, &&op_verify, &&op_metered, // 0x10-0x17
+        &&op_metered, &&op_metered, &&op_metered, &&op_metered, &&op_metered, &&op_fail, &&op_fail, &&op_fail, // 0x18-0x1F
+        FAIL_64, FAIL_64, FAIL_64, FAIL_8, FAIL_8,                                               // 0x20-0xEF
+        &&op_fail, &&op_end, &&op_goto, &&op_block_gas, &&op_fail, &&op_fail, &&op_fail, &&op_fail, // 0xF0-0xF7
+        &&op_fail, &&op_fail, &&op_fail, &&op_fail, &&op_fail, &&op_fail, &&op_fail, &&op_halt   // 0xF8-0xFF
+    };
+    const void* const* const table =
+        (program->flags & DECODED_PROGRAM_STACK_SAFE) ? verified_table : dispatch_table;
+
+    const decoded_instr_t* const instrs = program->instrs;
+    const decoded_instr_t* instr = instrs + ip;
+    uint64_t* const stack_base = context->stack.data;
+    uint64_t* sp = stack_base + context->stack.top;  // 指向栈顶元素之后
+    uint64_t gas_used = context->gas_used;
+    const uint64_t gas_limit = context->gas_limit;
+    sgx_status_t ret = SGX_SUCCESS;
+    uint64_t a, b;
+
+#define DISPATCH()      goto *table[instr->opcode]
+#define NEXT()          do { instr++; DISPATCH(); } while (0)
+#define BINARY_OP(expr) do { b = sp[-1]; a = sp[-2]; sp--; sp[-1] = (expr); NEXT(); } while (0)
+
+    DISPATCH();
+
+op_block:
+    // 整块的栈下溢和上溢检查，不通过时由逐条检查的路径给出准确的出错位置
+    if ((size_t)(sp - stack_base) < instr->block.stack_need ||
+        (size_t)(sp - stack_base) + instr->block.stack_growth > VM_STACK_CAPACITY) {
+        goto checked_fallback;
+    }
+op_block_gas:
+    // Gas不足以执行整块时，最后这个块逐条计量，在准确的位置耗尽Gas
+    if ((instr->flags & DECODED_FLAG_GAS_OVERFLOW) || gas_used + instr->gas_cost > gas_limit) {
+        goto checked_fallback;
+    }
+    gas_used += instr->gas_cost;
+    instr++;
+    DISPATCH();
+
+op_nop:
+    NEXT();
+
+op_push:
+    *sp++ = instr->operand;
+    NEXT();
+
+op_pop:
+    sp--;
+    NEXT();
+
+op_add:     BINARY_OP(a + b);
+op_sub:     BINARY_OP(a - b);
+op_mul:     BINARY_OP(a * b);
+op_and:     BINARY_OP(a & b);
+op_or:      BINARY_OP(a | b);
+op_xor:     BINARY_OP(a ^ b);
+op_eq:      BINARY_OP((a == b) ? 1 : 0);
+op_lt:      BINARY_OP((a < b) ? 1 : 0);
+op_gt:      BINARY_OP((a > b) ? 1 : 0);
+
+op_div:
+    b = *--sp;
+    if (b == 0) goto execution_failed;
+    sp[-1] = sp[-1] / b;
+    NEXT();
+
+op_mod:
+    b = *--sp;
+    if (b == 0) goto execution_failed;
+    sp[-1] = sp[-1] % b;
+    NEXT();
+
+op_not:
+    sp[-1] = ~sp[-1];
+    NEXT();
+
+op_jmp:
+    instr = instrs + instr->target;
+    DISPATCH();
+
+op_jmpif:
+    a = *--sp;
+    if (a != 0) {
+        if (instr->flags & DECODED_FLAG_BAD_TARGET) goto execution_failed;
+        instr = instrs + instr->target;
+        DISPATCH();
+    }
+    NEXT();
+
+op_load:
+    a = sp[-1];
+    if (a >= VM_MEMORY_SIZE - 8) {
+        sp--;
+        goto execution_failed;
+    }
+    sp[-1] = vm_memory_load(context, a);
+    NEXT();
+
+op_store:
+    b = sp[-1];
+    a = sp[-2];
+    sp -= 2;
+    if (a >= VM_MEMORY_SIZE - 8) goto execution_failed;
+    ret = vm_memory_store(context, a, b);
+    if (ret != SGX_SUCCESS) goto execution_error;
+    NEXT();
+
+
+op_verify:
+    // 简化：总是返回验证成功
+    sp[-1] = 1;
+    NEXT();
+
+op_metered:
+    // OP_HASH和向量指令的开销远大于分派，直接复用通用实现。它们结束基本块，块入口只预扣了
+    // 操作码本身的Gas，先退回再由通用实现连同按数据长度计价的Gas一起计量
+    context->stack.top = (size_t)(sp - stack_base);
+    context->gas_used = gas_used - instr->gas_cost;
+    ret = execute_instruction(context, (contract_opcode_t)instr->opcode);
+    sp = stack_base + context->stack.top;
+    gas_used = context->gas_used + instr->gas_cost;
+    if (ret != SGX_SUCCESS) goto execution_error;
+    NEXT();
+
+op_fail:
+    goto execution_failed;
+
+op_goto:
+    instr = instrs + instr->target;
+    DISPATCH();
+
+op_halt:
+    context->pc = instr->pc + 1;
+    context->state = CONTRACT_STATE_COMPLETED;
+    goto done;
+
+op_end:
+    context->pc = instr->pc;
+    goto done;
+
+execution_failed:
+    ret = SGX_ERROR_CONTRACT_EXECUTION_FAILED;
+execution_error:
+    // 出错的指令不消耗Gas
+    gas_used -= decoded_remaining_block_gas(program, (uint32_t)(instr - instrs));
+    context->pc = instr->pc;
+    context->state = contract_error_state(ret);
+    goto done;
+
+checked_fallback:
+    context->stack.top = (size_t)(sp - stack_base);
+    context->gas_used = gas_used;
+    return resume_decoded_contract(context, program, (uint32_t)(instr - instrs));
+
+done:
+    context->stack.top = (size_t)(sp - stack_base);
+    context->gas_used = gas_used;
+    return ret;
+
+#undef DISPATCH
+#undef NEXT
+#undef BINARY_OP
+}
+
+/**
+ * 以直接线程化分派执行已解码的智能合约
+ */
+sgx_status_t execute_threaded_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program
+) {
+    if (!verifier || !context || !program || !verifier->initialized) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 初始化执行上下文（字节码已在解码前验证）
+    sgx_status_t ret = prepare_contract_execution(context);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+
+    ret = run_threaded(context, program, 0);
+
+    return finish_contract_execution(verifier, context, ret);
+}
+
+/**
+ * 从已恢复或挂起的上下文继续线程化执行
+ */
+sgx_status_t continue_threaded_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program
+) {
+    if (!verifier || !context || !program || !verifier->initialized) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    uint32_t ip = decoded_find_pc(program, (uint32_t)context->pc);
+    if (ip == DECODED_INVALID_INDEX) {
+        return continue_contract_execution(verifier, context, program);
+    }
+
+    // 块头已在挂起前退还了块内未执行部分的Gas，先逐条执行完当前块，再从下一个块头进入快速路径
+    context->state = CONTRACT_STATE_RUNNING;
+    sgx_status_t ret = step_decoded_contract(context, program, &ip);
+    if (ret == SGX_SUCCESS && context->state == CONTRACT_STATE_RUNNING) {
+        ret = run_threaded(context, program, ip);
+    }
+
+    return finish_contract_execution(verifier, context, ret);
+}
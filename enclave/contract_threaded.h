@@ -0,0 +1,49 @@
+#ifndef CONTRACT_THREADED_H
+#define CONTRACT_THREADED_H
+
+#include "enclave.h"
+#include "contract_verifier.h"
+#include "contract_decoder.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 以直接线程化分派执行已解码的智能合约
+ * 栈指针和Gas计数保存在局部变量中，栈边界和块的静态Gas在基本块入口一次性检查，
+ * 检查不通过的块（包括Gas即将耗尽的最后一个块）回退到resume_decoded_contract逐条执行。
+ * 结果、Gas使用量和执行哈希与execute_contract完全一致
+ * @param verifier 验证器实例
+ * @param context 执行上下文
+ * @param program 已验证并解码的合约
+ * @return SGX状态码
+ */
+sgx_status_t execute_threaded_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program
+);
+
+/**
+ * 从已恢复pc、栈、内存和已用Gas的上下文继续线程化执行（不再初始化上下文）
+ * 当前块的剩余指令逐条检查执行，之后回到块入口检查的快速路径；
+ * 用于OP_INPUT等待流式输入挂起后继续，结果与不中断的执行一致
+ * @param verifier 验证器实例
+ * @param context 执行上下文
+ * @param program 已验证并解码的合约
+ * @return SGX状态码
+ */
+sgx_status_t continue_threaded_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTRACT_THREADED_H
@@ -1,24 +1,44 @@
 #include "contract_verifier.h"
+#include "contract_decoder.h"
 #include "enclave.h"
 #include "enclave_t.h"
 #include "crypto_utils.h"
+#include "slab_alloc.h"
+#include "exec_profile.h"
+#include "vm_vector.h"
+#include "input_stream.h"
 
 #include <sgx_trts.h>
 #include <sgx_tcrypto.h>
 #include <string.h>
 #include <stdlib.h>
 
-// 简化的Gas成本表（演示版本）
-static const uint64_t GAS_COSTS[] = {
-    [OP_NOP] = 1,
-    [OP_PUSH] = 3,
-    [OP_POP] = 2,
-    [OP_ADD] = 3,
-    [OP_SUB] = 3,
-    [OP_MUL] = 5,
-    [OP_HALT] = 0
-    // 其他操作码已简化
-};
+// 复制输入时每次哈希的块大小
+#define INPUT_HASH_CHUNK_SIZE   (4 * 1024)
+
+static_assert(VM_MEMORY_PAGE_COUNT <= 64 && VM_MEMORY_SIZE % VM_MEMORY_PAGE_SIZE == 0,
+              "dirty_pages cannot cover contract memory");
+
+const uint8_t vm_zero_page[VM_MEMORY_PAGE_SIZE] = { 0 };
+
+// 所有上下文持有的内存页数量
+static size_t g_memory_pages = 0;
+
+// 当前Gas表：init_contract_verifier装入标准Gas表，ecall_init_contract_verifier随后可替换为配置的Gas表
+static gas_schedule_t g_gas_schedule;
+
+/**
+ * 生成标准Gas表（见enclave_shared.h中的GAS_SCHEDULE_STANDARD）
+ */
+static void standard_gas_schedule(gas_schedule_t* schedule) {
+    memset(schedule, 0, sizeof(*schedule));
+    schedule->version = GAS_SCHEDULE_VERSION;
+    schedule->hash_word_cost = GAS_STANDARD_HASH_WORD;
+    schedule->vector_word_cost = GAS_STANDARD_VECTOR_WORD;
+#define GAS_STANDARD_ENTRY(op, name, gas) schedule->costs[op] = gas;
+    GAS_SCHEDULE_STANDARD(GAS_STANDARD_ENTRY)
+#undef GAS_STANDARD_ENTRY
+}
 
 /**
  * 初始化合约验证器
@@ -29,6 +49,7 @@ sgx_status_t init_contract_verifier(contract_verifier_t* verifier) {
     }
     
     memset(verifier, 0, sizeof(contract_verifier_t));
+    standard_gas_schedule(&g_gas_schedule);
     
     // 生成主密钥
     sgx_status_t ret = sgx_read_rand((uint8_t*)&verifier->master_key, sizeof(verifier->master_key));
@@ -51,99 +72,335 @@ sgx_status_t init_contract_verifier(contract_verifier_t* verifier) {
     return SGX_SUCCESS;
 }
 
+/**
+ * 装入Gas表
+ */
+sgx_status_t load_gas_schedule(const gas_schedule_t* schedule) {
+    if (!schedule) {
+        standard_gas_schedule(&g_gas_schedule);
+        return SGX_SUCCESS;
+    }
+    
+    // Gas为0的跳转会让循环永不耗尽Gas
+    if (schedule->version != GAS_SCHEDULE_VERSION || schedule->reserved != 0 ||
+        schedule->costs[OP_JMP] == 0 || schedule->costs[OP_JMPIF] == 0) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    memcpy(&g_gas_schedule, schedule, sizeof(g_gas_schedule));
+    return SGX_SUCCESS;
+}
+
+/**
+ * 获取操作码对应的指令长度（含操作数），未知操作码返回0
+ */
+static size_t get_instruction_length(contract_opcode_t opcode) {
+    switch (opcode) {
+        case OP_PUSH:
+            return 9;   // 8字节立即数
+        case OP_JMP:
+        case OP_JMPIF:
+            return 5;   // 4字节跳转地址
+        case OP_NOP:
+        case OP_POP:
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_MOD:
+        case OP_AND:
+        case OP_OR:
+        case OP_XOR:
+        case OP_NOT:
+        case OP_EQ:
+        case OP_LT:
+        case OP_GT:
+        case OP_CALL:
+        case OP_RET:
+        case OP_LOAD:
+        case OP_STORE:
+        case OP_HASH:
+        case OP_VERIFY:
+        case OP_COPY:
+        case OP_VADD:
+        case OP_VXOR:
+        case OP_VCMP:
+        case OP_VSUM:
+        case OP_INPUT:
+        case OP_HALT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
 /**
  * 验证合约字节码
+ * 按指令边界线性解码：操作数不会被当作操作码检查，最后一条指令必须是OP_HALT，
+ * 跳转目标必须落在指令起始位置（不能跳入立即数中间）
  */
 sgx_status_t validate_contract_code(const uint8_t* code, size_t size) {
     if (!code || size == 0 || size > MAX_CONTRACT_SIZE) {
         return SGX_ERROR_CONTRACT_INVALID;
     }
     
-    // 检查字节码格式
-    for (size_t i = 0; i < size; i++) {
-        contract_opcode_t opcode = (contract_opcode_t)code[i];
-        
-        // 验证操作码有效性
-        switch (opcode) {
-            case OP_NOP:
-            case OP_PUSH:
-            case OP_POP:
-            case OP_ADD:
-            case OP_SUB:
-            case OP_MUL:
-            case OP_DIV:
-            case OP_MOD:
-            case OP_AND:
-            case OP_OR:
-            case OP_XOR:
-            case OP_NOT:
-            case OP_EQ:
-            case OP_LT:
-            case OP_GT:
-            case OP_JMP:
-            case OP_JMPIF:
-            case OP_CALL:
-            case OP_RET:
-            case OP_LOAD:
-            case OP_STORE:
-            case OP_HASH:
-            case OP_VERIFY:
-            case OP_HALT:
-                break;
-            default:
-                // 对于PUSH指令，跳过操作数
-                if (opcode == OP_PUSH && i + 8 < size) {
-                    i += 8; // 跳过8字节操作数
-                } else if (opcode == OP_JMP || opcode == OP_JMPIF) {
-                    if (i + 4 < size) {
-                        i += 4; // 跳过4字节跳转地址
-                    }
-                } else {
-                    return SGX_ERROR_CONTRACT_INVALID;
-                }
-                break;
+    // 指令起始位置位图
+    uint8_t* starts = (uint8_t*)calloc((size + 7) / 8, 1);
+    if (!starts) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    
+    sgx_status_t ret = SGX_SUCCESS;
+    size_t last = 0;
+    
+    for (size_t pc = 0; pc < size; ) {
+        size_t length = get_instruction_length((contract_opcode_t)code[pc]);
+        if (length == 0 || length > size - pc) {
+            // 未知操作码或操作数被截断
+            ret = SGX_ERROR_CONTRACT_INVALID;
+            goto cleanup;
         }
+        starts[pc / 8] |= (uint8_t)(1u << (pc % 8));
+        last = pc;
+        pc += length;
     }
     
     // 检查是否以HALT指令结束
-    if (code[size - 1] != OP_HALT) {
-        return SGX_ERROR_CONTRACT_INVALID;
+    if (code[last] != OP_HALT) {
+        ret = SGX_ERROR_CONTRACT_INVALID;
+        goto cleanup;
+    }
+    
+    // 检查跳转目标
+    for (size_t pc = 0; pc < size; pc += get_instruction_length((contract_opcode_t)code[pc])) {
+        if (code[pc] == OP_JMP || code[pc] == OP_JMPIF) {
+            uint32_t target;
+            memcpy(&target, &code[pc + 1], 4);
+            if (target >= size || !(starts[target / 8] & (1u << (target % 8)))) {
+                ret = SGX_ERROR_CONTRACT_INVALID;
+                goto cleanup;
+            }
+        }
+    }
+    
+cleanup:
+    free(starts);
+    return ret;
+}
+
+/**
+ * 初始化执行上下文并分配结果缓冲区
+ */
+sgx_status_t prepare_contract_execution(contract_execution_context_t* context) {
+    context->pc = 0;
+    context->gas_used = 0;
+    context->input_offset = 0;
+    context->state = CONTRACT_STATE_RUNNING;
+    
+    // 栈顶以上的数据不会被读取，只重置栈顶
+    context->stack.top = 0;
+    
+    // 释放上次执行分配的页，再装入上次提交的合约状态（全零的页不分配）
+    reset_contract_memory(context);
+    
+    if (context->memory_image && context->memory_image_size > 0) {
+        size_t image_size = context->memory_image_size < VM_MEMORY_SIZE ?
+                            context->memory_image_size : VM_MEMORY_SIZE;
+        for (size_t offset = 0; offset < image_size; offset += VM_MEMORY_PAGE_SIZE) {
+            size_t length = image_size - offset < VM_MEMORY_PAGE_SIZE ? image_size - offset : VM_MEMORY_PAGE_SIZE;
+            if (memcmp(context->memory_image + offset, vm_zero_page, length) != 0) {
+                sgx_status_t ret = vm_memory_write(context, offset, context->memory_image + offset, length);
+                if (ret != SGX_SUCCESS) {
+                    return ret;
+                }
+            }
+        }
     }
     
+    // 装入映像不计入读写集
+    context->read_pages = 0;
+    context->write_pages = 0;
+    
+    // 结果缓冲区由调用方提供时复用（至少MAX_RESULT_SIZE），否则分配并由调用方释放
+    if (!context->result_data) {
+        context->result_data = (uint8_t*)malloc(MAX_RESULT_SIZE);
+        if (!context->result_data) {
+            return SGX_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    context->result_size = 0;
+    
     return SGX_SUCCESS;
 }
 
 /**
- * 执行智能合约
+ * 释放已分配的内存页
  */
-sgx_status_t execute_contract(contract_verifier_t* verifier, contract_execution_context_t* context) {
-    if (!verifier || !context || !verifier->initialized) {
-        return SGX_ERROR_INVALID_PARAMETER;
+void reset_contract_memory(contract_execution_context_t* context) {
+    uint64_t dirty = context->dirty_pages;
+    if (dirty) {
+        __atomic_fetch_sub(&g_memory_pages, (size_t)__builtin_popcountll(dirty), __ATOMIC_RELAXED);
+    }
+    while (dirty) {
+        size_t page = (size_t)__builtin_ctzll(dirty);
+        slab_free(context->page_buffers[page], VM_MEMORY_PAGE_SIZE);
+        dirty &= dirty - 1;
     }
+    context->dirty_pages = 0;
     
-    sgx_status_t ret = SGX_SUCCESS;
+    // 上下文可能刚被清零，页表每次都整表重置
+    for (size_t page = 0; page < VM_MEMORY_PAGE_COUNT; page++) {
+        context->memory_pages[page] = vm_zero_page;
+        context->page_buffers[page] = NULL;
+    }
+}
+
+/**
+ * 读取合约内存
+ */
+void vm_memory_read(const contract_execution_context_t* context, size_t address, void* data, size_t size) {
+    uint8_t* out = (uint8_t*)data;
+    while (size > 0) {
+        size_t offset = address % VM_MEMORY_PAGE_SIZE;
+        size_t length = VM_MEMORY_PAGE_SIZE - offset < size ? VM_MEMORY_PAGE_SIZE - offset : size;
+        memcpy(out, context->memory_pages[address / VM_MEMORY_PAGE_SIZE] + offset, length);
+        out += length;
+        address += length;
+        size -= length;
+    }
+}
+
+/**
+ * 计算一段合约内存的SHA256（范围位于一页内时直接计算，否则逐页更新）
+ */
+static sgx_status_t hash_memory(const contract_execution_context_t* context, size_t address, size_t size,
+                                sgx_sha256_hash_t* hash) {
+    // 地址可以等于VM_MEMORY_SIZE（长度为0），此时不访问页表
+    if (size == 0) {
+        return sgx_sha256_msg(vm_zero_page, 0, hash);
+    }
     
-    // 验证合约代码
-    ret = validate_contract_code(context->contract_code, context->code_size);
+    size_t offset = address % VM_MEMORY_PAGE_SIZE;
+    if (offset + size <= VM_MEMORY_PAGE_SIZE) {
+        return sgx_sha256_msg(context->memory_pages[address / VM_MEMORY_PAGE_SIZE] + offset, (uint32_t)size, hash);
+    }
+    
+    sgx_sha_state_handle_t sha_handle;
+    sgx_status_t ret = sgx_sha256_init(&sha_handle);
     if (ret != SGX_SUCCESS) {
         return ret;
     }
     
-    // 初始化执行上下文
-    context->pc = 0;
-    context->gas_used = 0;
-    context->state = CONTRACT_STATE_RUNNING;
-    memset(&context->stack, 0, sizeof(context->stack));
-    memset(context->memory, 0, sizeof(context->memory));
+    while (size > 0 && ret == SGX_SUCCESS) {
+        offset = address % VM_MEMORY_PAGE_SIZE;
+        size_t length = VM_MEMORY_PAGE_SIZE - offset < size ? VM_MEMORY_PAGE_SIZE - offset : size;
+        ret = sgx_sha256_update(context->memory_pages[address / VM_MEMORY_PAGE_SIZE] + offset,
+                                (uint32_t)length, sha_handle);
+        address += length;
+        size -= length;
+    }
     
-    // 分配结果缓冲区
-    context->result_data = (uint8_t*)malloc(MAX_RESULT_SIZE);
-    if (!context->result_data) {
-        return SGX_ERROR_OUT_OF_MEMORY;
+    if (ret == SGX_SUCCESS) {
+        ret = sgx_sha256_get_hash(sha_handle, hash);
     }
-    context->result_size = 0;
+    sgx_sha256_close(sha_handle);
+    
+    return ret;
+}
+
+/**
+ * 写入合约内存
+ */
+sgx_status_t vm_memory_write(contract_execution_context_t* context, size_t address, const void* data, size_t size) {
+    const uint8_t* in = (const uint8_t*)data;
+    while (size > 0) {
+        size_t page = address / VM_MEMORY_PAGE_SIZE;
+        size_t offset = address % VM_MEMORY_PAGE_SIZE;
+        size_t length = VM_MEMORY_PAGE_SIZE - offset < size ? VM_MEMORY_PAGE_SIZE - offset : size;
+        
+        if (!(context->dirty_pages & (1ull << page))) {
+            uint8_t* memory = (uint8_t*)slab_alloc(VM_MEMORY_PAGE_SIZE);
+            if (!memory) {
+                return SGX_ERROR_OUT_OF_MEMORY;
+            }
+            memset(memory, 0, VM_MEMORY_PAGE_SIZE);
+            context->page_buffers[page] = memory;
+            context->memory_pages[page] = memory;
+            context->dirty_pages |= 1ull << page;
+            __atomic_fetch_add(&g_memory_pages, 1, __ATOMIC_RELAXED);
+        }
+        
+        memcpy(context->page_buffers[page] + offset, in, length);
+        in += length;
+        address += length;
+        size -= length;
+    }
+    return SGX_SUCCESS;
+}
+
+/**
+ * 获取合约内存去掉末尾零字节后的长度
+ */
+size_t vm_memory_used_size(const contract_execution_context_t* context) {
+    uint64_t dirty = context->dirty_pages;
+    while (dirty) {
+        size_t page = 63 - (size_t)__builtin_clzll(dirty);
+        const uint8_t* memory = context->memory_pages[page];
+        for (size_t i = VM_MEMORY_PAGE_SIZE; i > 0; i--) {
+            if (memory[i - 1] != 0) {
+                return page * VM_MEMORY_PAGE_SIZE + i;
+            }
+        }
+        dirty &= ~(1ull << page);
+    }
+    return 0;
+}
+
+/**
+ * 比较合约内存的前size字节与给定数据
+ */
+bool vm_memory_matches(const contract_execution_context_t* context, const uint8_t* data, size_t size) {
+    for (size_t offset = 0; offset < size; offset += VM_MEMORY_PAGE_SIZE) {
+        size_t length = size - offset < VM_MEMORY_PAGE_SIZE ? size - offset : VM_MEMORY_PAGE_SIZE;
+        if (memcmp(context->memory_pages[offset / VM_MEMORY_PAGE_SIZE], data + offset, length) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * 获取所有执行上下文当前持有的内存页数量
+ */
+size_t vm_memory_pages_in_use(void) {
+    return __atomic_load_n(&g_memory_pages, __ATOMIC_RELAXED);
+}
+
+/**
+ * 计算执行哈希并更新验证器状态
+ */
+sgx_status_t finish_contract_execution(contract_verifier_t* verifier, contract_execution_context_t* context, sgx_status_t ret) {
+    // 计算执行哈希（流式输入在最后一块送达、输入哈希完成后再计算）
+    if (context->state == CONTRACT_STATE_COMPLETED &&
+        (!context->input_stream || context->input_stream->final)) {
+        ret = compute_execution_hash(context, &context->execution_hash);
+        if (ret != SGX_SUCCESS) {
+            context->state = CONTRACT_STATE_ERROR;
+        }
+    }
+    
+    // 更新验证器状态（多个TCS可能并发执行）
+    __atomic_fetch_add(&verifier->execution_counter, 1, __ATOMIC_RELAXED);
+    
+    return ret;
+}
+
+/**
+ * 从context->pc开始逐条解释执行字节码
+ */
+static sgx_status_t run_bytecode(contract_execution_context_t* context) {
+    sgx_status_t ret = SGX_SUCCESS;
     
-    // 执行合约字节码
     while (context->state == CONTRACT_STATE_RUNNING && context->pc < context->code_size) {
         contract_opcode_t opcode = (contract_opcode_t)context->contract_code[context->pc];
         
@@ -155,10 +412,10 @@ sgx_status_t execute_contract(contract_verifier_t* verifier, contract_execution_
             break;
         }
         
-        // 执行指令
+        // 执行指令（向量指令在其中另外计量与长度相关的Gas）
         ret = execute_instruction(context, opcode);
         if (ret != SGX_SUCCESS) {
-            context->state = CONTRACT_STATE_ERROR;
+            context->state = contract_error_state(ret);
             break;
         }
         
@@ -175,26 +432,413 @@ sgx_status_t execute_contract(contract_verifier_t* verifier, contract_execution_
         }
     }
     
-    // 计算执行哈希
-    if (context->state == CONTRACT_STATE_COMPLETED) {
-        ret = compute_execution_hash(context, &context->execution_hash);
+    return ret;
+}
+
+/**
+ * 执行智能合约
+ */
+sgx_status_t execute_contract(contract_verifier_t* verifier, contract_execution_context_t* context) {
+    if (!verifier || !context || !verifier->initialized) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    sgx_status_t ret = SGX_SUCCESS;
+    
+    // 验证合约代码
+    ret = validate_contract_code(context->contract_code, context->code_size);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    // 初始化执行上下文
+    ret = prepare_contract_execution(context);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    ret = run_bytecode(context);
+    
+    return finish_contract_execution(verifier, context, ret);
+}
+
+/**
+ * 从已恢复的上下文继续执行
+ */
+sgx_status_t continue_contract_execution(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program
+) {
+    if (!verifier || !context || !verifier->initialized) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    sgx_status_t ret = SGX_SUCCESS;
+    context->state = CONTRACT_STATE_RUNNING;
+    
+    uint32_t ip = program ? decoded_find_pc(program, (uint32_t)context->pc) : DECODED_INVALID_INDEX;
+    if (ip != DECODED_INVALID_INDEX) {
+        ret = resume_decoded_contract(context, program, ip);
+    } else {
+        if (!context->contract_code) {
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        ret = validate_contract_code(context->contract_code, context->code_size);
         if (ret != SGX_SUCCESS) {
-            context->state = CONTRACT_STATE_ERROR;
+            return ret;
+        }
+        ret = run_bytecode(context);
+    }
+    
+    return finish_contract_execution(verifier, context, ret);
+}
+
+/**
+ * 执行已解码的智能合约
+ */
+sgx_status_t execute_decoded_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program
+) {
+    if (!verifier || !context || !program || !verifier->initialized) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    // 初始化执行上下文（字节码已在解码前验证）
+    sgx_status_t ret = prepare_contract_execution(context);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    ret = resume_decoded_contract(context, program, 0);
+    
+    return finish_contract_execution(verifier, context, ret);
+}
+
+/**
+ * 从*ip开始逐条检查执行已解码的合约，to_block为true时停在下一个块头，*ip返回停止的位置
+ */
+static sgx_status_t run_decoded(
+    contract_execution_context_t* context,
+    const decoded_contract_t* program,
+    uint32_t* next,
+    bool to_block
+) {
+    sgx_status_t ret = SGX_SUCCESS;
+    uint32_t ip = *next;
+    exec_profile_record_t* profile = context->profile;
+    
+    // 从块中间恢复时找到所在块的块头
+    if (profile && program->instrs[ip].opcode != DECODED_OP_BLOCK) {
+        uint32_t header = ip;
+        while (header > 0 && program->instrs[header].opcode != DECODED_OP_BLOCK) {
+            header--;
+        }
+        if (program->instrs[header].opcode == DECODED_OP_BLOCK) {
+            exec_profile_resume_block(profile, program->instrs[header].pc);
         }
     }
     
-    // 更新验证器状态
-    verifier->execution_counter++;
+    while (context->state == CONTRACT_STATE_RUNNING) {
+        const decoded_instr_t* instr = &program->instrs[ip];
+        context->pc = instr->pc;
+        
+        // 越过代码末尾
+        if (instr->opcode == DECODED_OP_END) {
+            break;
+        }
+        
+        // 指令流衔接
+        if (instr->opcode == DECODED_OP_GOTO) {
+            ip = instr->target;
+            continue;
+        }
+        
+        // 块头只供快速路径使用，这里逐条指令计量Gas
+        if (instr->opcode == DECODED_OP_BLOCK) {
+            if (to_block) {
+                break;
+            }
+            if (profile) {
+                exec_profile_enter_block(profile, instr->pc);
+            }
+            ip++;
+            continue;
+        }
+        
+        // 检查Gas
+        if (!check_gas(context, instr->gas_cost)) {
+            context->state = CONTRACT_STATE_OUT_OF_GAS;
+            ret = SGX_ERROR_INSUFFICIENT_GAS;
+            break;
+        }
+        
+        // 执行指令，操作数和跳转目标已在解码时解析
+        uint64_t start_cycles = (profile && profile->cycles) ? exec_profile_cycles() : 0;
+        uint64_t start_gas = context->gas_used;
+        uint32_t next_ip = ip + 1;
+        uint64_t condition;
+        switch (instr->opcode) {
+            case OP_PUSH:
+                ret = stack_push(&context->stack, instr->operand);
+                context->pc += 8; // 与字节码解释器一致，出错时指向操作数末尾
+                break;
+                
+            case OP_JMP:
+                next_ip = instr->target;
+                break;
+                
+            case OP_JMPIF:
+                ret = stack_pop(&context->stack, &condition);
+                if (ret != SGX_SUCCESS) break;
+                if (condition != 0) {
+                    if (instr->flags & DECODED_FLAG_BAD_TARGET) {
+                        ret = SGX_ERROR_CONTRACT_EXECUTION_FAILED;
+                        break;
+                    }
+                    next_ip = instr->target;
+                }
+                break;
+                
+            case DECODED_OP_FAIL:
+                ret = SGX_ERROR_CONTRACT_EXECUTION_FAILED;
+                break;
+                
+            default:
+                // 无操作数的指令与字节码解释器共用实现
+                ret = execute_instruction(context, (contract_opcode_t)instr->opcode);
+                break;
+        }
+        
+        if (ret != SGX_SUCCESS) {
+            context->state = contract_error_state(ret);
+            break;
+        }
+        
+        // 消耗Gas
+        context->gas_used += instr->gas_cost;
+        
+        if (profile) {
+            exec_profile_instruction(profile, instr->opcode, context->gas_used - start_gas,
+                                     profile->cycles ? exec_profile_cycles() - start_cycles : 0);
+        }
+        
+        if (instr->opcode == OP_HALT) {
+            context->pc = instr->pc + 1;
+            context->state = CONTRACT_STATE_COMPLETED;
+            break;
+        }
+        
+        ip = next_ip;
+    }
     
+    *next = ip;
     return ret;
 }
 
+/**
+ * 从指定指令开始逐条检查执行已解码的合约
+ */
+sgx_status_t resume_decoded_contract(
+    contract_execution_context_t* context,
+    const decoded_contract_t* program,
+    uint32_t ip
+) {
+    return run_decoded(context, program, &ip, false);
+}
+
+/**
+ * 逐条检查执行到下一个块头
+ */
+sgx_status_t step_decoded_contract(
+    contract_execution_context_t* context,
+    const decoded_contract_t* program,
+    uint32_t* ip
+) {
+    return run_decoded(context, program, ip, true);
+}
+
+/**
+ * 检查内存范围（分开比较，避免地址与长度相加溢出）
+ */
+static bool memory_range_valid(uint64_t address, uint64_t size) {
+    return address <= VM_MEMORY_SIZE && size <= VM_MEMORY_SIZE - address;
+}
+
+/**
+ * 检查按数据长度计价的Gas：操作码本身的Gas由调用方在指令执行后扣除
+ * （块入口已扣除的后端在调用前退回），这里连同按字计价的部分一起检查
+ * @return 按字计价的Gas，不足时返回UINT64_MAX
+ */
+static uint64_t check_length_gas(const contract_execution_context_t* context, contract_opcode_t opcode,
+                                 uint64_t size, uint32_t word_cost) {
+    uint64_t gas_cost = (size + 7) / 8 * word_cost;
+    uint64_t total = get_opcode_gas_cost(opcode) + gas_cost;
+    if (context->gas_used + total > context->gas_limit) {
+        return UINT64_MAX;
+    }
+    return gas_cost;
+}
+
+/**
+ * 执行OP_HASH：栈顶为数据长度，其下为数据地址
+ * Gas检查在出栈之前，Gas不足时栈保持不变，按片执行时可从本指令恢复
+ */
+static sgx_status_t execute_hash_instruction(contract_execution_context_t* context) {
+    vm_stack_t* stack = &context->stack;
+    if (stack->top < 2) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    uint64_t size = stack->data[stack->top - 1];
+    uint64_t address = stack->data[stack->top - 2];
+    
+    if (!memory_range_valid(address, size)) {
+        return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
+    }
+    uint64_t gas_cost = check_length_gas(context, OP_HASH, size, g_gas_schedule.hash_word_cost);
+    if (gas_cost == UINT64_MAX) {
+        return SGX_ERROR_INSUFFICIENT_GAS;
+    }
+    
+    sgx_sha256_hash_t hash;
+    context->read_pages |= vm_memory_page_mask(address, size);
+    sgx_status_t ret = hash_memory(context, (size_t)address, (size_t)size, &hash);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    // 将哈希的前8字节压入栈
+    uint64_t result;
+    memcpy(&result, &hash, 8);
+    stack->top -= 2;
+    context->gas_used += gas_cost;
+    return stack_push(stack, result);
+}
+
+/**
+ * 执行向量指令：检查范围和Gas后出栈，范围读入连续缓冲区由vm_vector核心计算
+ * 源范围在写入目标之前整体读出，重叠的范围按指令执行前的内容计算；Gas不足时栈保持不变
+ */
+static sgx_status_t execute_vector_instruction(contract_execution_context_t* context, contract_opcode_t opcode) {
+    vm_stack_t* stack = &context->stack;
+    size_t argc = opcode == OP_VSUM ? 2 : 3;
+    if (stack->top < argc) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    uint64_t size = stack->data[stack->top - 1];
+    uint64_t src = stack->data[stack->top - 2];
+    uint64_t dst = opcode == OP_VSUM ? 0 : stack->data[stack->top - 3];
+    
+    if (!memory_range_valid(src, size) || !memory_range_valid(dst, size)) {
+        return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
+    }
+    if ((opcode == OP_VADD || opcode == OP_VSUM) && size % 8 != 0) {
+        return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
+    }
+    uint64_t gas_cost = check_length_gas(context, opcode, size, g_gas_schedule.vector_word_cost);
+    if (gas_cost == UINT64_MAX) {
+        return SGX_ERROR_INSUFFICIENT_GAS;
+    }
+    stack->top -= argc;
+    
+    uint8_t source[VM_MEMORY_SIZE];
+    uint8_t target[VM_MEMORY_SIZE];
+    sgx_status_t ret = SGX_SUCCESS;
+    context->read_pages |= vm_memory_page_mask(src, size);
+    vm_memory_read(context, (size_t)src, source, (size_t)size);
+    
+    switch (opcode) {
+        case OP_COPY:
+            context->write_pages |= vm_memory_page_mask(dst, size);
+            ret = vm_memory_write(context, (size_t)dst, source, (size_t)size);
+            break;
+            
+        case OP_VADD:
+        case OP_VXOR:
+            context->read_pages |= vm_memory_page_mask(dst, size);
+            context->write_pages |= vm_memory_page_mask(dst, size);
+            vm_memory_read(context, (size_t)dst, target, (size_t)size);
+            if (opcode == OP_VADD) {
+                vm_vector_add(target, source, (size_t)size / 8);
+            } else {
+                vm_vector_xor(target, source, (size_t)size);
+            }
+            ret = vm_memory_write(context, (size_t)dst, target, (size_t)size);
+            break;
+            
+        case OP_VCMP:
+            context->read_pages |= vm_memory_page_mask(dst, size);
+            vm_memory_read(context, (size_t)dst, target, (size_t)size);
+            ret = stack_push(stack, vm_vector_mismatch(target, source, (size_t)size));
+            break;
+            
+        default:
+            // OP_VSUM
+            ret = stack_push(stack, vm_vector_sum(source, (size_t)size / 8));
+            break;
+    }
+    
+    if (ret == SGX_SUCCESS) {
+        context->gas_used += gas_cost;
+    }
+    return ret;
+}
+
+/**
+ * 执行OP_INPUT：栈顶为长度，其下为目标地址
+ * 流式输入尚未送达请求的全部字节时返回SGX_ERROR_CONTRACT_INPUT_PENDING，栈和Gas保持不变，
+ * 下一块送达后重新执行本指令；输入已全部送达时只复制剩余的部分
+ */
+static sgx_status_t execute_input_instruction(contract_execution_context_t* context) {
+    vm_stack_t* stack = &context->stack;
+    if (stack->top < 2) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    uint64_t size = stack->data[stack->top - 1];
+    uint64_t address = stack->data[stack->top - 2];
+    
+    if (!memory_range_valid(address, size)) {
+        return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
+    }
+    
+    const uint8_t* data = NULL;
+    size_t available = 0;
+    if (context->input_stream) {
+        available = input_stream_available(context->input_stream, context->input_offset, &data);
+        if (available < size && !context->input_stream->final) {
+            return SGX_ERROR_CONTRACT_INPUT_PENDING;
+        }
+    } else if (context->input_offset < context->input_size) {
+        data = context->input_data + context->input_offset;
+        available = context->input_size - (size_t)context->input_offset;
+    }
+    
+    size_t length = available < size ? available : (size_t)size;
+    uint64_t gas_cost = check_length_gas(context, OP_INPUT, length, g_gas_schedule.vector_word_cost);
+    if (gas_cost == UINT64_MAX) {
+        return SGX_ERROR_INSUFFICIENT_GAS;
+    }
+    stack->top -= 2;
+    
+    context->write_pages |= vm_memory_page_mask(address, length);
+    sgx_status_t ret = vm_memory_write(context, (size_t)address, data, length);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    context->input_offset += length;
+    context->gas_used += gas_cost;
+    return stack_push(stack, length);
+}
+
 /**
  * 执行单个指令
  */
 sgx_status_t execute_instruction(contract_execution_context_t* context, contract_opcode_t opcode) {
     sgx_status_t ret = SGX_SUCCESS;
     uint64_t a, b, result;
+    uint32_t target;
     
     switch (opcode) {
         case OP_NOP:
@@ -320,11 +964,11 @@ sgx_status_t execute_instruction(contract_execution_context_t* context, contract
             if (context->pc + 4 >= context->code_size) {
                 return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
             }
-            memcpy(&result, &context->contract_code[context->pc + 1], 4);
-            if (result >= context->code_size) {
+            memcpy(&target, &context->contract_code[context->pc + 1], 4);
+            if (target >= context->code_size) {
                 return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
             }
-            context->pc = (size_t)result - 1; // -1因为主循环会+1
+            context->pc = (size_t)target - 1; // -1因为主循环会+1
             break;
             
         case OP_JMPIF:
@@ -335,11 +979,11 @@ sgx_status_t execute_instruction(contract_execution_context_t* context, contract
                 if (context->pc + 4 >= context->code_size) {
                     return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
                 }
-                memcpy(&result, &context->contract_code[context->pc + 1], 4);
-                if (result >= context->code_size) {
+                memcpy(&target, &context->contract_code[context->pc + 1], 4);
+                if (target >= context->code_size) {
                     return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
                 }
-                context->pc = (size_t)result - 1;
+                context->pc = (size_t)target - 1;
             } else {
                 context->pc += 4; // 跳过跳转地址
             }
@@ -350,12 +994,11 @@ sgx_status_t execute_instruction(contract_execution_context_t* context, contract
             ret = stack_pop(&context->stack, &a); // 键
             if (ret != SGX_SUCCESS) break;
             
-            // 这里应该调用存储接口
-            // 简化实现：从内存加载
-            if (a >= sizeof(context->memory) - 8) {
+            // 合约内存在启用状态持久化时映射到状态存储（见run_contract）
+            if (a >= VM_MEMORY_SIZE - 8) {
                 return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
             }
-            memcpy(&result, &context->memory[a], 8);
+            result = vm_memory_load(context, a);
             ret = stack_push(&context->stack, result);
             break;
             
@@ -366,31 +1009,16 @@ sgx_status_t execute_instruction(contract_execution_context_t* context, contract
             ret = stack_pop(&context->stack, &a); // 键
             if (ret != SGX_SUCCESS) break;
             
-            // 简化实现：存储到内存
-            if (a >= sizeof(context->memory) - 8) {
+            // 写入合约内存，执行成功后由run_contract提交为持久化状态
+            if (a >= VM_MEMORY_SIZE - 8) {
                 return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
             }
-            memcpy(&context->memory[a], &b, 8);
+            ret = vm_memory_store(context, a, b);
             break;
             
         case OP_HASH:
-            // 计算哈希
-            ret = stack_pop(&context->stack, &a); // 数据长度
-            if (ret != SGX_SUCCESS) break;
-            ret = stack_pop(&context->stack, &b); // 数据地址
-            if (ret != SGX_SUCCESS) break;
-            
-            if (b + a > sizeof(context->memory)) {
-                return SGX_ERROR_CONTRACT_EXECUTION_FAILED;
-            }
-            
-            sgx_sha256_hash_t hash;
-            ret = sgx_sha256_msg(&context->memory[b], (uint32_t)a, &hash);
-            if (ret != SGX_SUCCESS) break;
-            
-            // 将哈希的前8字节压入栈
-            memcpy(&result, &hash, 8);
-            ret = stack_push(&context->stack, result);
+            // 计算哈希，Gas按数据长度计价
+            ret = execute_hash_instruction(context);
             break;
             
         case OP_VERIFY:
@@ -401,6 +1029,19 @@ sgx_status_t execute_instruction(contract_execution_context_t* context, contract
             ret = stack_push(&context->stack, 1);
             break;
             
+        case OP_COPY:
+        case OP_VADD:
+        case OP_VXOR:
+        case OP_VCMP:
+        case OP_VSUM:
+            ret = execute_vector_instruction(context, opcode);
+            break;
+            
+        case OP_INPUT:
+            // 读取输入，Gas按复制的长度计价
+            ret = execute_input_instruction(context);
+            break;
+            
         case OP_HALT:
             // 停止执行
             context->state = CONTRACT_STATE_COMPLETED;
@@ -428,12 +1069,20 @@ sgx_status_t compute_execution_hash(const contract_execution_context_t* context,
         return ret;
     }
     
-    // 添加合约代码哈希
+    // 添加合约代码哈希（优先使用调用方已计算的哈希）
     sgx_sha256_hash_t code_hash;
-    ret = sgx_sha256_msg(context->contract_code, context->code_size, &code_hash);
-    if (ret != SGX_SUCCESS) {
-        sgx_sha256_close(sha_handle);
-        return ret;
+    if (context->code_hash) {
+        memcpy(code_hash, *context->code_hash, sizeof(code_hash));
+    } else {
+        if (context->code_size > MAX_CONTRACT_SIZE) {
+            sgx_sha256_close(sha_handle);
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        ret = sgx_sha256_msg(context->contract_code, (uint32_t)context->code_size, &code_hash);
+        if (ret != SGX_SUCCESS) {
+            sgx_sha256_close(sha_handle);
+            return ret;
+        }
     }
     
     ret = sgx_sha256_update((uint8_t*)&code_hash, sizeof(code_hash), sha_handle);
@@ -442,13 +1091,17 @@ sgx_status_t compute_execution_hash(const contract_execution_context_t* context,
         return ret;
     }
     
-    // 添加输入数据哈希
-    if (context->input_data && context->input_size > 0) {
+    // 添加输入数据哈希（优先使用复制输入时已计算的哈希）
+    if (context->input_size > 0 && (context->input_hash || context->input_data)) {
         sgx_sha256_hash_t input_hash;
-        ret = sgx_sha256_msg(context->input_data, context->input_size, &input_hash);
-        if (ret != SGX_SUCCESS) {
-            sgx_sha256_close(sha_handle);
-            return ret;
+        if (context->input_hash) {
+            memcpy(input_hash, *context->input_hash, sizeof(input_hash));
+        } else {
+            ret = copy_and_hash_input(NULL, context->input_data, context->input_size, &input_hash);
+            if (ret != SGX_SUCCESS) {
+                sgx_sha256_close(sha_handle);
+                return ret;
+            }
         }
         
         ret = sgx_sha256_update((uint8_t*)&input_hash, sizeof(input_hash), sha_handle);
@@ -481,14 +1134,47 @@ sgx_status_t compute_execution_hash(const contract_execution_context_t* context,
     return ret;
 }
 
+/**
+ * 复制输入数据并计算其哈希
+ */
+sgx_status_t copy_and_hash_input(uint8_t* dst, const uint8_t* src, size_t size, sgx_sha256_hash_t* digest) {
+    if ((!src && size > 0) || !digest) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    sgx_sha_state_handle_t sha_handle;
+    sgx_status_t ret = sgx_sha256_init(&sha_handle);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    // 按块交替复制和哈希，哈希读取的副本仍在缓存中
+    for (size_t offset = 0; offset < size && ret == SGX_SUCCESS; offset += INPUT_HASH_CHUNK_SIZE) {
+        size_t chunk = size - offset < INPUT_HASH_CHUNK_SIZE ? size - offset : INPUT_HASH_CHUNK_SIZE;
+        const uint8_t* hashed = src + offset;
+        if (dst) {
+            memcpy(dst + offset, src + offset, chunk);
+            hashed = dst + offset;
+        }
+        ret = sgx_sha256_update(hashed, (uint32_t)chunk, sha_handle);
+    }
+    
+    if (ret == SGX_SUCCESS) {
+        ret = sgx_sha256_get_hash(sha_handle, digest);
+    }
+    sgx_sha256_close(sha_handle);
+    
+    return ret;
+}
+
 /**
  * 获取操作码Gas成本
  */
 uint64_t get_opcode_gas_cost(contract_opcode_t opcode) {
-    if (opcode < sizeof(GAS_COSTS) / sizeof(GAS_COSTS[0])) {
-        return GAS_COSTS[opcode];
+    if ((uint32_t)opcode < sizeof(g_gas_schedule.costs) / sizeof(g_gas_schedule.costs[0])) {
+        return g_gas_schedule.costs[opcode];
     }
-    return 1; // 默认成本
+    return 0;
 }
 
 /**
@@ -552,5 +1238,5 @@ bool stack_is_full(const vm_stack_t* stack) {
  * 验证内存访问
  */
 bool validate_memory_access(const contract_execution_context_t* context, size_t address, size_t size) {
-    return context && (address + size <= sizeof(context->memory));
+    return context && (address + size <= VM_MEMORY_SIZE);
 }
\ No newline at end of file
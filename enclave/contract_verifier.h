@@ -3,11 +3,13 @@
 
 #include "enclave.h"
 #include "crypto_utils.h"
+#include "contract_decoder.h"
 
 #include <sgx_tcrypto.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,6 +24,7 @@ sgx_status_t init_contract_verifier(contract_verifier_t* verifier);
 
 /**
  * 验证合约字节码
+ * 按指令边界解码，检查操作码、操作数完整性、跳转目标落在指令起始位置及以OP_HALT结束
  * @param code 合约字节码
  * @param size 字节码大小
  * @return SGX状态码
@@ -36,6 +39,208 @@ sgx_status_t validate_contract_code(const uint8_t* code, size_t size);
  */
 sgx_status_t execute_contract(contract_verifier_t* verifier, contract_execution_context_t* context);
 
+/**
+ * 执行已解码的智能合约
+ * 跳过验证和解码，语义与execute_contract一致
+ * @param verifier 验证器实例
+ * @param context 执行上下文
+ * @param program 已验证并解码的合约
+ * @return SGX状态码
+ */
+sgx_status_t execute_decoded_contract(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program
+);
+
+/**
+ * 从指定指令开始逐条检查执行已解码的合约
+ * 上下文必须已由prepare_contract_execution初始化，不计算执行哈希
+ * @param context 执行上下文
+ * @param program 已验证并解码的合约
+ * @param ip 起始指令索引
+ * @return SGX状态码
+ */
+sgx_status_t resume_decoded_contract(
+    contract_execution_context_t* context,
+    const decoded_contract_t* program,
+    uint32_t ip
+);
+
+/**
+ * 从指定指令开始逐条检查执行到下一个块头，供快速路径从块中间（如等待输入的OP_INPUT）继续前使用。
+ * 上下文必须已初始化，遇到块头时停止且状态仍为CONTRACT_STATE_RUNNING
+ * @param context 执行上下文
+ * @param program 已验证并解码的合约
+ * @param ip 起始指令索引，返回停止时的指令索引
+ * @return SGX状态码
+ */
+sgx_status_t step_decoded_contract(
+    contract_execution_context_t* context,
+    const decoded_contract_t* program,
+    uint32_t* ip
+);
+
+/**
+ * 从已恢复pc、栈、内存和已用Gas的上下文继续执行（不再初始化上下文）
+ * 结果、Gas使用量和执行哈希与不中断的执行一致
+ * @param verifier 验证器实例
+ * @param context 执行上下文
+ * @param program 已解码的合约（为NULL或pc未被解码时由字节码解释器执行）
+ * @return SGX状态码
+ */
+sgx_status_t continue_contract_execution(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    const decoded_contract_t* program
+);
+
+/**
+ * 释放已分配的内存页，页表全部指向零页（dirty_pages清零）
+ * @param context 执行上下文
+ */
+void reset_contract_memory(contract_execution_context_t* context);
+
+/**
+ * 初始化执行上下文，未提供结果缓冲区时分配
+ * 只清零dirty_pages标记的内存页，首次使用的上下文必须整体清零
+ * @param context 执行上下文
+ * @return SGX状态码
+ */
+sgx_status_t prepare_contract_execution(contract_execution_context_t* context);
+
+/**
+ * 复制输入数据并计算其哈希，每块写入可信缓冲区后立即对副本更新哈希，
+ * 源数据只读取一次，主机并发修改不会使副本与哈希不一致
+ * @param dst 可信缓冲区（为NULL时直接对源数据计算哈希）
+ * @param src 输入数据
+ * @param size 输入大小
+ * @param digest 输出哈希
+ * @return SGX状态码
+ */
+sgx_status_t copy_and_hash_input(uint8_t* dst, const uint8_t* src, size_t size, sgx_sha256_hash_t* digest);
+
+// 未写过的内存页共享的零页（只读）
+extern const uint8_t vm_zero_page[VM_MEMORY_PAGE_SIZE];
+
+/**
+ * 读取合约内存，可跨页（未分配的页读出零）
+ * @param context 执行上下文
+ * @param address 已检查边界的起始地址
+ * @param data 输出缓冲区
+ * @param size 字节数
+ */
+void vm_memory_read(const contract_execution_context_t* context, size_t address, void* data, size_t size);
+
+/**
+ * 写入合约内存，可跨页，首次写入的页从slab分配并清零
+ * @param context 执行上下文
+ * @param address 已检查边界的起始地址
+ * @param data 数据
+ * @param size 字节数
+ * @return SGX状态码（分配内存页失败时返回SGX_ERROR_OUT_OF_MEMORY）
+ */
+sgx_status_t vm_memory_write(contract_execution_context_t* context, size_t address, const void* data, size_t size);
+
+/**
+ * 获取合约内存去掉末尾零字节后的长度（只扫描已分配的页）
+ * @param context 执行上下文
+ * @return 字节数
+ */
+size_t vm_memory_used_size(const contract_execution_context_t* context);
+
+/**
+ * 比较合约内存的前size字节与给定数据
+ * @param context 执行上下文
+ * @param data 数据
+ * @param size 字节数（不超过VM_MEMORY_SIZE）
+ * @return 是否相同
+ */
+bool vm_memory_matches(const contract_execution_context_t* context, const uint8_t* data, size_t size);
+
+/**
+ * 获取所有执行上下文当前持有的内存页数量
+ * @return 页数
+ */
+size_t vm_memory_pages_in_use(void);
+
+/**
+ * 指令出错时的执行状态：Gas不足为CONTRACT_STATE_OUT_OF_GAS，
+ * 等待流式输入为CONTRACT_STATE_SUSPENDED（可从出错的指令继续），其余为CONTRACT_STATE_ERROR
+ * @param ret 指令返回的SGX状态码
+ * @return 执行状态
+ */
+static inline contract_execution_state_t contract_error_state(sgx_status_t ret) {
+    if (ret == SGX_ERROR_INSUFFICIENT_GAS) {
+        return CONTRACT_STATE_OUT_OF_GAS;
+    }
+    return ret == SGX_ERROR_CONTRACT_INPUT_PENDING ? CONTRACT_STATE_SUSPENDED : CONTRACT_STATE_ERROR;
+}
+
+/**
+ * 计算一段合约内存覆盖的页位图
+ * @param address 已检查边界的起始地址
+ * @param size 字节数（为0时不覆盖任何页）
+ * @return 页位图
+ */
+static inline uint64_t vm_memory_page_mask(uint64_t address, uint64_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    uint64_t first = address / VM_MEMORY_PAGE_SIZE;
+    uint64_t last = (address + size - 1) / VM_MEMORY_PAGE_SIZE;
+    return ((2ull << last) - 1) & ~((1ull << first) - 1);
+}
+
+/**
+ * OP_LOAD读取8字节，页内访问直接读取，读过的页记入read_pages
+ * @param context 执行上下文
+ * @param address 已检查边界的地址
+ * @return 读出的值
+ */
+static inline uint64_t vm_memory_load(contract_execution_context_t* context, uint64_t address) {
+    size_t offset = address % VM_MEMORY_PAGE_SIZE;
+    uint64_t value;
+    context->read_pages |= vm_memory_page_mask(address, 8);
+    if (offset <= VM_MEMORY_PAGE_SIZE - 8) {
+        memcpy(&value, context->memory_pages[address / VM_MEMORY_PAGE_SIZE] + offset, 8);
+    } else {
+        vm_memory_read(context, address, &value, 8);
+    }
+    return value;
+}
+
+/**
+ * OP_STORE写入8字节，已分配页内的访问直接写入，写过的页记入write_pages
+ * @param context 执行上下文
+ * @param address 已检查边界的地址
+ * @param value 写入的值
+ * @return SGX状态码
+ */
+static inline sgx_status_t vm_memory_store(contract_execution_context_t* context, uint64_t address, uint64_t value) {
+    size_t page = address / VM_MEMORY_PAGE_SIZE;
+    size_t offset = address % VM_MEMORY_PAGE_SIZE;
+    context->write_pages |= vm_memory_page_mask(address, 8);
+    if (offset <= VM_MEMORY_PAGE_SIZE - 8 && (context->dirty_pages & (1ull << page))) {
+        memcpy(context->page_buffers[page] + offset, &value, 8);
+        return SGX_SUCCESS;
+    }
+    return vm_memory_write(context, address, &value, 8);
+}
+
+/**
+ * 执行结束后计算执行哈希并更新验证器状态
+ * @param verifier 验证器实例
+ * @param context 执行上下文
+ * @param ret 执行返回的状态码
+ * @return SGX状态码
+ */
+sgx_status_t finish_contract_execution(
+    contract_verifier_t* verifier,
+    contract_execution_context_t* context,
+    sgx_status_t ret
+);
+
 /**
  * 执行单个指令
  * @param context 执行上下文
@@ -52,6 +257,13 @@ sgx_status_t execute_instruction(contract_execution_context_t* context, contract
  */
 sgx_status_t compute_execution_hash(const contract_execution_context_t* context, sgx_sha256_hash_t* hash);
 
+/**
+ * 装入Gas表（ecall_init_contract_verifier时在解码任何合约之前调用一次）
+ * @param schedule Gas表，NULL时恢复标准Gas表
+ * @return SGX状态码（版本不符或OP_JMP/OP_JMPIF的Gas为0时返回SGX_ERROR_INVALID_PARAMETER）
+ */
+sgx_status_t load_gas_schedule(const gas_schedule_t* schedule);
+
 /**
  * 获取操作码Gas成本
  * @param opcode 操作码
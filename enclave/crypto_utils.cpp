@@ -313,7 +313,7 @@ sgx_status_t compute_hmac_sha256(
         return SGX_ERROR_INVALID_PARAMETER;
     }
     
-    return sgx_hmac_sha256_msg(data, (uint32_t)data_len, key, (uint32_t)key_len, hmac);
+    return sgx_hmac_sha256_msg(data, (int)data_len, key, (int)key_len, (unsigned char*)hmac, (int)sizeof(*hmac));
 }
 
 /**
@@ -214,6 +214,49 @@ sgx_status_t compute_sha256(
     sgx_sha256_hash_t* hash
 );
 
+// 多缓冲SHA-256引擎（按编号从低到高依次更快，检测后默认使用可用的最高编号）
+typedef enum {
+    SHA256_ENGINE_GENERIC = 0,              // 逐条调用sgx_sha256_msg
+    SHA256_ENGINE_AVX2 = 1,                 // AVX2，8路并行
+    SHA256_ENGINE_SHANI = 2,                // SHA扩展指令，逐条处理
+    SHA256_ENGINE_AVX512 = 3                // AVX-512，16路并行
+} sha256_engine_t;
+
+// 多缓冲哈希的一条消息
+typedef struct {
+    const uint8_t* data;                    // 消息（size为0时可为NULL）
+    size_t size;                            // 消息长度
+    uint8_t* hash;                          // 输出哈希（32字节）
+} sha256_job_t;
+
+/**
+ * 检测CPU特性并选择最快的可用引擎（ecall_init_contract_verifier时调用，CPUID经OCALL获取）
+ * @return 可用引擎的位图（1 << sha256_engine_t）
+ */
+uint32_t sha256_detect_engines(void);
+
+/**
+ * 指定多缓冲哈希使用的引擎（用于对比测试）
+ * @param engine sha256_engine_t
+ * @return SGX状态码（引擎不可用时返回SGX_ERROR_INVALID_PARAMETER）
+ */
+sgx_status_t sha256_set_engine(uint32_t engine);
+
+/**
+ * 获取当前引擎
+ * @return sha256_engine_t
+ */
+uint32_t sha256_get_engine(void);
+
+/**
+ * 多缓冲计算SHA256哈希：多条互不相关的短消息同时计算，
+ * 输出与逐条compute_sha256相同。消息少于4条时不使用多路引擎
+ * @param jobs 消息及输出位置
+ * @param count 消息数量
+ * @return SGX状态码
+ */
+sgx_status_t compute_sha256_multi(const sha256_job_t* jobs, size_t count);
+
 /**
  * 计算SHA3-256哈希
  * @param data 输入数据
@@ -2,28 +2,173 @@
 #include "enclave.h"
 #include "contract_verifier.h"
 #include "crypto_utils.h"
+#include "code_cache.h"
+#include "contract_threaded.h"
+#include "contract_jit.h"
+#include "merkle_tree.h"
+#include "state_cache.h"
+#include "exec_arena.h"
+#include "exec_snapshot.h"
+#include "exec_profile.h"
+#include "audit_ring.h"
+#include "block_exec.h"
+#include "contract_repo.h"
+#include "slab_alloc.h"
+#include "vm_vector.h"
+#include "input_stream.h"
+#include "result_cache.h"
 
 #include <sgx_trts.h>
 #include <sgx_tcrypto.h>
 #include <sgx_tseal.h>
 #include <sgx_utils.h>
 #include <sgx_tkey_exchange.h>
+#include <sgx_thread.h>
 
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 
-// 全局状态
+// 全局状态（初始化完成后只读，多个TCS可并发执行合约）
 static bool g_verifier_initialized = false;
 static contract_verifier_t g_verifier;
 static sgx_aes_gcm_128bit_key_t g_master_key;
+static sgx_thread_mutex_t g_init_mutex = SGX_THREAD_MUTEX_INITIALIZER;
+static uint32_t g_execution_backend = EXECUTION_BACKEND_THREADED;
+static uint32_t g_state_persistent = 0;
+
+// 执行证明签名密钥（在验证器初始化时生成或从密封数据恢复，之后只读）
+static bool g_signing_key_ready = false;
+static sgx_ec256_private_t g_signing_private_key;
+static sgx_ec256_public_t g_signing_public_key;
+
+// 密封的签名密钥格式版本
+#define SIGNING_KEY_BLOB_VERSION 1
+
+// 签名密钥的密封明文
+typedef struct {
+    uint32_t version;                       // 格式版本
+    uint32_t reserved;                      // 保留
+    sgx_ec256_private_t private_key;        // 私钥
+    sgx_ec256_public_t public_key;          // 公钥
+} signing_key_blob_t;
+
+static_assert(sizeof(execution_proof_t) == EXECUTION_PROOF_SIZE &&
+              offsetof(execution_proof_t, public_key) == EXECUTION_PROOF_PUBLIC_KEY_OFFSET &&
+              offsetof(execution_proof_t, signature) == EXECUTION_PROOF_SIGNATURE_OFFSET,
+              "execution_proof_t layout mismatch");
+
+// 每个线程的状态写回事务，在ECALL返回前提交
+static __thread state_txn_t t_state_txn;
+
+// 主机注册的共享环形缓冲区（不可信内存，g_shared_ring_lock保护指针和大小的一致读取）
+static sgx_spinlock_t g_shared_ring_lock = SGX_SPINLOCK_INITIALIZER;
+static uint8_t* g_shared_ring = NULL;
+static size_t g_shared_ring_size = 0;
+
+static_assert(MAX_STATE_VALUE_SIZE >= VM_MEMORY_SIZE, "state_item_t cannot hold a contract memory image");
+
+// 每个线程缓存的ECC上下文，首次签名或验证时打开（线程数受TCS数量限制）
+static __thread sgx_ecc_state_handle_t t_ecc_handle = NULL;
+
+// 流式输入会话（占用、查找和释放由g_input_session_lock保护，busy期间同一会话的其他调用返回SGX_ERROR_BUSY）
+typedef struct {
+    uint32_t id;                            // 会话id（0表示未就绪）
+    bool busy;                              // 是否有ECALL正在使用
+    bool started;                           // 是否已开始执行
+    bool finished;                          // 合约是否已停止执行（之后送入的块只计入输入哈希）
+    sgx_status_t status;                    // 停止执行时的状态码
+    uint32_t backend;                       // 打开时选定的执行后端
+    sgx_sha256_hash_t code_hash;            // 字节码哈希
+    code_cache_entry_t* cache_entry;        // 已解码的合约（打开期间持有引用）
+    jit_code_t* jit;                        // 本地代码（为NULL时不使用JIT）
+    state_cache_entry_t* state_entry;       // 持久化的合约状态（持有引用，不持锁）
+    uint64_t state_version;                 // 开始执行时的状态版本
+    contract_execution_context_t context;   // 会话独占的执行上下文
+    input_stream_t stream;                  // 流式输入
+} input_session_t;
+
+static sgx_spinlock_t g_input_session_lock = SGX_SPINLOCK_INITIALIZER;
+static input_session_t* g_input_sessions[INPUT_STREAM_MAX_SESSIONS];
+static uint32_t g_next_input_session_id = 1;
+
+/**
+ * 释放会话持有的缓存项、状态项、内存页和输入窗口
+ */
+static void free_input_session(input_session_t* session) {
+    if (session->cache_entry) {
+        code_cache_release(session->cache_entry);
+    }
+    if (session->state_entry) {
+        state_cache_release(session->state_entry);
+    }
+    reset_contract_memory(&session->context);
+    free(session->context.result_data);
+    input_stream_free(&session->stream);
+    free(session);
+}
+
+/**
+ * 检查验证器是否已初始化
+ */
+static bool verifier_ready(void) {
+    return __atomic_load_n(&g_verifier_initialized, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * 检查证明签名密钥是否可用
+ */
+static bool signing_key_ready(void) {
+    return __atomic_load_n(&g_signing_key_ready, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * 获取当前线程的ECC上下文
+ */
+static sgx_status_t get_ecc_handle(sgx_ecc_state_handle_t* handle) {
+    if (!t_ecc_handle) {
+        sgx_status_t ret = sgx_ecc256_open_context(&t_ecc_handle);
+        if (ret != SGX_SUCCESS) {
+            t_ecc_handle = NULL;
+            return ret;
+        }
+    }
+    
+    *handle = t_ecc_handle;
+    return SGX_SUCCESS;
+}
+
+/**
+ * 生成ECC256密钥对
+ */
+sgx_status_t generate_ec256_key_pair(sgx_ec256_private_t* private_key, sgx_ec256_public_t* public_key) {
+    if (!private_key || !public_key) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    sgx_ecc_state_handle_t ecc_handle;
+    sgx_status_t ret = get_ecc_handle(&ecc_handle);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    return sgx_ecc256_create_key_pair(private_key, public_key, ecc_handle);
+}
 
 /**
  * 初始化智能合约验证器
  */
-sgx_status_t ecall_init_contract_verifier(void) {
+sgx_status_t ecall_init_contract_verifier(const uint8_t* gas_schedule, size_t schedule_size) {
     sgx_status_t ret = SGX_SUCCESS;
     
+    if (gas_schedule && schedule_size != sizeof(gas_schedule_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    sgx_thread_mutex_lock(&g_init_mutex);
+    
     if (g_verifier_initialized) {
+        sgx_thread_mutex_unlock(&g_init_mutex);
         ocall_print_string("Contract verifier already initialized");
         return SGX_SUCCESS;
     }
@@ -31,6 +176,7 @@ sgx_status_t ecall_init_contract_verifier(void) {
     // 生成主密钥
     ret = sgx_read_rand((uint8_t*)&g_master_key, sizeof(g_master_key));
     if (ret != SGX_SUCCESS) {
+        sgx_thread_mutex_unlock(&g_init_mutex);
         ocall_print_string("Failed to generate master key");
         return ret;
     }
@@ -38,184 +184,1767 @@ sgx_status_t ecall_init_contract_verifier(void) {
     // 初始化合约验证器
     ret = init_contract_verifier(&g_verifier);
     if (ret != SGX_SUCCESS) {
+        sgx_thread_mutex_unlock(&g_init_mutex);
         ocall_print_string("Failed to initialize contract verifier");
         return ret;
     }
     
-    g_verifier_initialized = true;
-    ocall_print_string("Contract verifier initialized successfully");
+    // 装入Gas表，须在字节码缓存解码任何合约之前
+    if (gas_schedule) {
+        gas_schedule_t schedule;
+        memcpy(&schedule, gas_schedule, sizeof(schedule));
+        ret = load_gas_schedule(&schedule);
+        if (ret != SGX_SUCCESS) {
+            sgx_thread_mutex_unlock(&g_init_mutex);
+            ocall_print_string("Invalid gas schedule");
+            return ret;
+        }
+    }
+    
+    // 选择多缓冲SHA-256引擎和向量指令核心
+    sha256_detect_engines();
+    vm_vector_init();
+    
+    // 初始化已解码字节码缓存
+    ret = code_cache_init(CODE_CACHE_DEFAULT_BUDGET);
+    if (ret != SGX_SUCCESS) {
+        sgx_thread_mutex_unlock(&g_init_mutex);
+        ocall_print_string("Failed to initialize code cache");
+        return ret;
+    }
+    
+    // 初始化状态缓存（合约内存的持久化默认关闭，见ecall_configure_state）
+    ret = state_cache_init(STATE_CACHE_DEFAULT_BUDGET);
+    if (ret != SGX_SUCCESS) {
+        sgx_thread_mutex_unlock(&g_init_mutex);
+        ocall_print_string("Failed to initialize state cache");
+        return ret;
+    }
+    
+    // 未通过ecall_load_signing_key恢复密钥时生成新的证明签名密钥
+    if (!g_signing_key_ready) {
+        ret = generate_ec256_key_pair(&g_signing_private_key, &g_signing_public_key);
+        if (ret != SGX_SUCCESS) {
+            sgx_thread_mutex_unlock(&g_init_mutex);
+            ocall_print_string("Failed to generate signing key");
+            return ret;
+        }
+        __atomic_store_n(&g_signing_key_ready, true, __ATOMIC_RELEASE);
+    }
+    
+    __atomic_store_n(&g_verifier_initialized, true, __ATOMIC_RELEASE);
+    sgx_thread_mutex_unlock(&g_init_mutex);
+    ocall_print_string("Contract verifier initialized successfully");
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 销毁Enclave前清除签名密钥
+ */
+sgx_status_t ecall_destroy_enclave(void) {
+    sgx_thread_mutex_lock(&g_init_mutex);
+    __atomic_store_n(&g_signing_key_ready, false, __ATOMIC_RELEASE);
+    secure_memzero(&g_signing_private_key, sizeof(g_signing_private_key));
+    sgx_thread_mutex_unlock(&g_init_mutex);
+    
+    if (t_ecc_handle) {
+        sgx_ecc256_close_context(t_ecc_handle);
+        t_ecc_handle = NULL;
+    }
+    
+    block_exec_reset();
+    
+    // 关闭未取回结果的流式输入会话（正在使用的会话由使用者关闭）
+    input_session_t* sessions[INPUT_STREAM_MAX_SESSIONS];
+    uint32_t session_count = 0;
+    sgx_spin_lock(&g_input_session_lock);
+    for (uint32_t i = 0; i < INPUT_STREAM_MAX_SESSIONS; i++) {
+        if (g_input_sessions[i] && !g_input_sessions[i]->busy) {
+            sessions[session_count++] = g_input_sessions[i];
+            g_input_sessions[i] = NULL;
+        }
+    }
+    sgx_spin_unlock(&g_input_session_lock);
+    for (uint32_t i = 0; i < session_count; i++) {
+        free_input_session(sessions[i]);
+    }
+    
+    exec_slot_release();
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 生成执行证明
+ */
+sgx_status_t ecall_generate_proof(
+    uint8_t* data,
+    size_t data_size,
+    uint8_t* proof,
+    size_t proof_size
+) {
+    if (!data || !proof || data_size == 0 || proof_size < 64) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    // 模拟证明生成
+    memset(proof, 0xAB, proof_size);
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 创建远程证明报告
+ */
+sgx_status_t ecall_create_report(
+    uint8_t* report_data,
+    size_t data_size,
+    uint8_t* report_buffer,
+    size_t report_size
+) {
+    if (!report_data || !report_buffer || data_size == 0 || report_size < 432) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    // 模拟报告创建
+    memset(report_buffer, 0xCD, report_size);
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 开启剖析时改走解码解释器的逐条检查路径，执行结束后按字节码哈希合并统计
+ * 合约无法缓存时（过大或超出预算）不做剖析，按字节码解释器执行
+ * @param resumed 是否从快照恢复的上下文继续执行
+ */
+static sgx_status_t dispatch_profiled_contract(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    contract_execution_context_t* context,
+    bool resumed,
+    uint32_t flags
+) {
+    code_cache_entry_t* cache_entry = NULL;
+    sgx_status_t ret = code_cache_acquire(code_hash, code, code_size, &cache_entry);
+    if (ret != SGX_SUCCESS) {
+        if (ret == SGX_ERROR_OUT_OF_MEMORY && (code || resumed)) {
+            ret = resumed ? continue_contract_execution(&g_verifier, context, NULL)
+                          : execute_contract(&g_verifier, context);
+        }
+        return ret;
+    }
+    
+    bool cycles = (flags & PROFILE_FLAG_CYCLES) != 0;
+    uint64_t gas_start = context->gas_used;
+    context->code_size = cache_entry->program->code_size;
+    context->profile = exec_profile_begin(cycles);
+    
+    uint64_t start_cycles = cycles ? exec_profile_cycles() : 0;
+    ret = resumed ? continue_contract_execution(&g_verifier, context, cache_entry->program)
+                  : execute_decoded_contract(&g_verifier, context, cache_entry->program);
+    uint64_t elapsed = cycles ? exec_profile_cycles() - start_cycles : 0;
+    
+    exec_profile_commit(code_hash, context->profile, context->gas_used - gas_start, elapsed);
+    context->profile = NULL;
+    code_cache_release(cache_entry);
+    
+    return ret;
+}
+
+/**
+ * 按指定后端执行已填好参数的上下文，优先使用缓存的解码结果，无法缓存时回退到字节码解释器
+ * code为NULL时只按哈希查找已缓存的合约（字节码解释器后端此时使用逐条检查的解码路径）
+ */
+static sgx_status_t dispatch_on_backend(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    contract_execution_context_t* context,
+    uint32_t backend
+) {
+    uint32_t profile_flags = exec_profile_flags();
+    if (profile_flags & PROFILE_FLAG_ENABLED) {
+        return dispatch_profiled_contract(code_hash, code, code_size, context, false, profile_flags);
+    }
+    
+    if (backend == EXECUTION_BACKEND_INTERPRETER && code) {
+        return execute_contract(&g_verifier, context);
+    }
+    
+    code_cache_entry_t* cache_entry = NULL;
+    sgx_status_t ret = code_cache_acquire(code_hash, code, code_size, &cache_entry);
+    if (ret == SGX_SUCCESS) {
+        context->code_size = cache_entry->program->code_size;
+        jit_code_t* jit = (backend == EXECUTION_BACKEND_JIT) ? jit_get_code(cache_entry) : NULL;
+        if (jit) {
+            ret = execute_jit_contract(&g_verifier, context, cache_entry->program, jit);
+        } else if (backend == EXECUTION_BACKEND_THREADED || backend == EXECUTION_BACKEND_JIT) {
+            ret = execute_threaded_contract(&g_verifier, context, cache_entry->program);
+        } else {
+            ret = execute_decoded_contract(&g_verifier, context, cache_entry->program);
+        }
+        code_cache_release(cache_entry);
+    } else if (ret == SGX_ERROR_OUT_OF_MEMORY && code) {
+        ret = execute_contract(&g_verifier, context);
+    }
+    
+    return ret;
+}
+
+/**
+ * 按当前后端执行已填好参数的上下文
+ */
+static sgx_status_t dispatch_contract(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    contract_execution_context_t* context
+) {
+    return dispatch_on_backend(code_hash, code, code_size, context,
+                               __atomic_load_n(&g_execution_backend, __ATOMIC_RELAXED));
+}
+
+/**
+ * 获取合约内存映像的状态项，状态缓存被未写回的修改占满时先提交事务再重试一次
+ */
+static sgx_status_t acquire_contract_state(
+    const sgx_sha256_hash_t* code_hash,
+    state_txn_t* txn,
+    state_cache_entry_t** entry
+) {
+    uint8_t key[1 + sizeof(sgx_sha256_hash_t)];
+    key[0] = STATE_KEY_PREFIX_CONTRACT;
+    memcpy(key + 1, *code_hash, sizeof(sgx_sha256_hash_t));
+    
+    sgx_status_t ret = state_cache_acquire(key, sizeof(key), entry);
+    if (ret == SGX_ERROR_OUT_OF_MEMORY && txn->count > 0) {
+        ret = state_txn_commit(txn);
+        if (ret == SGX_SUCCESS) {
+            ret = state_cache_acquire(key, sizeof(key), entry);
+        }
+    }
+    
+    return ret;
+}
+
+/**
+ * 执行成功时把修改过的合约内存写回状态项并加入事务，失败的执行不改变状态
+ * 调用方持有entry->exec_mutex，返回前释放锁和引用
+ */
+static sgx_status_t commit_contract_state(
+    state_cache_entry_t* entry,
+    const contract_execution_context_t* context,
+    state_txn_t* txn,
+    sgx_status_t ret
+) {
+    // 末尾的零字节不写回，装入时重新补零
+    size_t image_size = 0;
+    bool changed = false;
+    if (ret == SGX_SUCCESS && context->state == CONTRACT_STATE_COMPLETED) {
+        image_size = vm_memory_used_size(context);
+        changed = image_size != entry->item.value_size ||
+                  !vm_memory_matches(context, entry->item.value, image_size);
+    }
+    if (changed) {
+        // 内存按页分散存放，拼接到临时分配区后写入状态项（全零时写入空值而不是删除）
+        uint8_t* image = (uint8_t*)exec_scratch_alloc(image_size > 0 ? image_size : 1);
+        if (image) {
+            vm_memory_read(context, 0, image, image_size);
+            sgx_spin_lock(&entry->lock);
+            ret = state_cache_update(entry, image, image_size);
+            sgx_spin_unlock(&entry->lock);
+            exec_scratch_free(image);
+        } else {
+            ret = SGX_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    sgx_thread_mutex_unlock(&entry->exec_mutex);
+    
+    if (changed && ret == SGX_SUCCESS) {
+        ret = state_txn_add(txn, entry);
+    }
+    state_cache_release(entry);
+    
+    return ret;
+}
+
+/**
+ * 把[user_check]输入复制到执行槽的临时分配区，复制的同时计算输入哈希
+ * 输入为空时副本为NULL，成功返回后由调用方以exec_scratch_free释放副本
+ */
+static sgx_status_t stage_input(
+    const uint8_t* input_data,
+    size_t input_size,
+    uint8_t** input_copy,
+    sgx_sha256_hash_t* input_hash
+) {
+    *input_copy = NULL;
+    if (input_size == 0) {
+        return SGX_SUCCESS;
+    }
+    if (!input_data || !sgx_is_outside_enclave(input_data, input_size)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    uint8_t* buffer = (uint8_t*)exec_scratch_alloc(input_size);
+    if (!buffer) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    
+    sgx_status_t ret = copy_and_hash_input(buffer, input_data, input_size, input_hash);
+    if (ret != SGX_SUCCESS) {
+        exec_scratch_free(buffer);
+        return ret;
+    }
+    
+    *input_copy = buffer;
+    return SGX_SUCCESS;
+}
+
+/**
+ * 为一次执行重置槽中复用的上下文，栈和内存由prepare_contract_execution或快照恢复按需清零
+ */
+static contract_execution_context_t* reset_context(
+    exec_slot_t* slot,
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    const uint8_t* input_data,
+    size_t input_size,
+    const sgx_sha256_hash_t* input_hash,
+    uint64_t gas_limit
+) {
+    contract_execution_context_t* context = &slot->context;
+    context->contract_code = code;
+    context->code_size = code_size;
+    context->input_data = input_data;
+    context->input_size = input_size;
+    context->input_offset = 0;
+    context->input_stream = NULL;
+    context->input_hash = input_hash;
+    context->result_data = slot->result_buffer;
+    context->result_size = 0;
+    context->gas_limit = gas_limit;
+    context->gas_used = 0;
+    context->pc = 0;
+    context->state = CONTRACT_STATE_INIT;
+    memset(context->execution_hash, 0, sizeof(context->execution_hash));
+    context->code_hash = code_hash;
+    context->memory_image = NULL;
+    context->memory_image_size = 0;
+    context->profile = NULL;
+    
+    return context;
+}
+
+/**
+ * 执行不持久化状态的合约，开启结果缓存时先按(字节码哈希, 输入哈希, Gas上限)查找，
+ * 成功完成的执行写入缓存。剖析开启时不使用缓存，统计反映实际执行
+ */
+static sgx_status_t run_stateless_contract(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    const uint8_t* input_data,
+    size_t input_size,
+    const sgx_sha256_hash_t* input_hash,
+    uint64_t gas_limit,
+    contract_execution_context_t* context
+) {
+    if (!result_cache_enabled() || (exec_profile_flags() & PROFILE_FLAG_ENABLED)) {
+        return dispatch_contract(code_hash, code, code_size, context);
+    }
+    
+    // 调用方未计算输入哈希时在这里计算（输入已在Enclave内），执行哈希同样使用该摘要
+    sgx_sha256_hash_t computed_hash;
+    if (input_size > 0 && !input_hash) {
+        sgx_status_t ret = copy_and_hash_input(NULL, input_data, input_size, &computed_hash);
+        if (ret != SGX_SUCCESS) {
+            return ret;
+        }
+        input_hash = &computed_hash;
+        context->input_hash = input_hash;
+    }
+    
+    sgx_sha256_hash_t key;
+    sgx_status_t ret = result_cache_key(code_hash, input_size > 0 ? input_hash : NULL, gas_limit, &key);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    if (result_cache_lookup(&key, context)) {
+        ret = SGX_SUCCESS;
+    } else {
+        ret = dispatch_contract(code_hash, code, code_size, context);
+        if (ret == SGX_SUCCESS && context->state == CONTRACT_STATE_COMPLETED) {
+            result_cache_insert(&key, context);
+        }
+    }
+    
+    // 局部摘要不能留在复用的上下文中
+    if (input_hash == &computed_hash) {
+        context->input_hash = NULL;
+    }
+    return ret;
+}
+    
+/**
+ * 执行合约
+ * 启用状态持久化时合约内存从上次提交的状态开始，执行成功后的修改加入txn，
+ * 同一合约的并发执行在其状态项的exec_mutex上串行化（等待的线程休眠，不占用CPU）
+ */
+static sgx_status_t run_contract(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    const uint8_t* input_data,
+    size_t input_size,
+    const sgx_sha256_hash_t* input_hash,
+    uint64_t gas_limit,
+    exec_slot_t* slot,
+    state_txn_t* txn
+) {
+    contract_execution_context_t* context = reset_context(slot, code_hash, code, code_size,
+                                                          input_data, input_size, input_hash, gas_limit);
+    
+    if (!__atomic_load_n(&g_state_persistent, __ATOMIC_RELAXED)) {
+        return run_stateless_contract(code_hash, code, code_size, input_data, input_size,
+                                      input_hash, gas_limit, context);
+    }
+    
+    state_cache_entry_t* state_entry = NULL;
+    sgx_status_t ret = acquire_contract_state(code_hash, txn, &state_entry);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    sgx_thread_mutex_lock(&state_entry->exec_mutex);
+    context->memory_image = state_entry->item.value;
+    context->memory_image_size = state_entry->item.value_size;
+    
+    ret = dispatch_contract(code_hash, code, code_size, context);
+    
+    return commit_contract_state(state_entry, context, txn, ret);
+}
+
+/**
+ * 从快照恢复的上下文继续执行，优先使用缓存的解码结果
+ */
+static sgx_status_t dispatch_resumed_contract(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    contract_execution_context_t* context
+) {
+    uint32_t profile_flags = exec_profile_flags();
+    if (profile_flags & PROFILE_FLAG_ENABLED) {
+        return dispatch_profiled_contract(code_hash, code, code_size, context, true, profile_flags);
+    }
+    
+    if (__atomic_load_n(&g_execution_backend, __ATOMIC_RELAXED) == EXECUTION_BACKEND_INTERPRETER) {
+        return continue_contract_execution(&g_verifier, context, NULL);
+    }
+    
+    code_cache_entry_t* cache_entry = NULL;
+    sgx_status_t ret = code_cache_acquire(code_hash, code, code_size, &cache_entry);
+    if (ret == SGX_SUCCESS) {
+        context->code_size = cache_entry->program->code_size;
+        ret = continue_contract_execution(&g_verifier, context, cache_entry->program);
+        code_cache_release(cache_entry);
+    } else if (ret == SGX_ERROR_OUT_OF_MEMORY) {
+        ret = continue_contract_execution(&g_verifier, context, NULL);
+    }
+    
+    return ret;
+}
+
+/**
+ * 执行合约的一个分片：从头或从快照开始，最多消耗slice_gas
+ * 用完本片Gas而未用完总Gas时状态为CONTRACT_STATE_SUSPENDED，并把上下文密封到next_snapshot。
+ * 启用状态持久化时只在最后一片提交合约内存，快照记录开始时的状态版本，
+ * 期间状态被其他执行修改过则恢复失败
+ */
+static sgx_status_t run_contract_slice(
+    const sgx_sha256_hash_t* code_hash,
+    const uint8_t* code,
+    size_t code_size,
+    const uint8_t* input_data,
+    size_t input_size,
+    const sgx_sha256_hash_t* input_hash,
+    uint64_t gas_limit,
+    uint64_t slice_gas,
+    const uint8_t* snapshot,
+    size_t snapshot_size,
+    uint8_t* next_snapshot,
+    size_t next_capacity,
+    size_t* next_size,
+    exec_slot_t* slot,
+    state_txn_t* txn
+) {
+    contract_execution_context_t* context = reset_context(slot, code_hash, code, code_size,
+                                                          input_data, input_size, input_hash, gas_limit);
+    
+    bool persistent = __atomic_load_n(&g_state_persistent, __ATOMIC_RELAXED);
+    state_cache_entry_t* state_entry = NULL;
+    sgx_status_t ret = SGX_SUCCESS;
+    if (persistent) {
+        ret = acquire_contract_state(code_hash, txn, &state_entry);
+        if (ret != SGX_SUCCESS) {
+            return ret;
+        }
+        sgx_thread_mutex_lock(&state_entry->exec_mutex);
+    }
+    
+    uint32_t flags = persistent ? EXEC_SNAPSHOT_FLAG_PERSISTENT : 0;
+    uint64_t state_version = state_entry ? state_entry->item.version : 0;
+    uint64_t slice_start = 0;
+    
+    if (snapshot) {
+        exec_snapshot_header_t header;
+        ret = exec_snapshot_restore(snapshot, snapshot_size, context, input_hash, &header);
+        if (ret == SGX_SUCCESS && header.gas_limit != gas_limit) {
+            ret = SGX_ERROR_INVALID_PARAMETER;
+        } else if (ret == SGX_SUCCESS && (header.flags != flags || header.state_version != state_version)) {
+            ret = SGX_ERROR_INVALID_STATE;
+        }
+        slice_start = context->gas_used;
+    } else if (state_entry) {
+        context->memory_image = state_entry->item.value;
+        context->memory_image_size = state_entry->item.value_size;
+    }
+    
+    if (ret == SGX_SUCCESS) {
+        if (slice_gas > 0 && slice_gas < gas_limit - slice_start) {
+            context->gas_limit = slice_start + slice_gas;
+        }
+        ret = snapshot ? dispatch_resumed_contract(code_hash, code, code_size, context)
+                       : dispatch_contract(code_hash, code, code_size, context);
+        
+        if (context->state == CONTRACT_STATE_OUT_OF_GAS && context->gas_limit < gas_limit) {
+            if (context->gas_used == slice_start) {
+                // 本片Gas不足以执行下一条指令，挂起也无法推进
+                ret = SGX_ERROR_INVALID_PARAMETER;
+            } else {
+                context->state = CONTRACT_STATE_SUSPENDED;
+                ret = exec_snapshot_seal(context, input_hash, gas_limit, flags, state_version,
+                                         next_snapshot, next_capacity, next_size);
+            }
+        }
+        context->gas_limit = gas_limit;
+    }
+    
+    if (state_entry) {
+        return commit_contract_state(state_entry, context, txn, ret);
+    }
+    return ret;
+}
+
+/**
+ * 验证智能合约执行
+ */
+sgx_status_t ecall_verify_contract_execution(
+    const uint8_t* contract_code,
+    size_t code_size,
+    const uint8_t* input_data,
+    size_t input_size,
+    uint8_t* execution_result,
+    size_t result_capacity,
+    size_t* result_size,
+    uint64_t* gas_used
+) {
+    sgx_status_t ret = SGX_SUCCESS;
+    
+    if (!verifier_ready()) {
+        ocall_print_string("Contract verifier not initialized");
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    // 输入为空时input_data可以为NULL，由stage_input检查
+    if (!contract_code || !execution_result || !result_size || !gas_used) {
+        ocall_print_string("Invalid parameters");
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    // 验证合约代码完整性
+    sgx_sha256_hash_t code_hash;
+    ret = sgx_sha256_msg(contract_code, code_size, &code_hash);
+    if (ret != SGX_SUCCESS) {
+        ocall_print_string("Failed to compute contract code hash");
+        return ret;
+    }
+    
+    // 记录审计日志（写入环形缓冲区，由主机批量取出）
+    audit_ring_record(AUDIT_EVENT_EXECUTION_STARTED, 1, &code_hash, NULL, 0, 0, SGX_SUCCESS);
+    
+    // 开始记录之后的每条错误路径都写入失败记录
+    contract_execution_context_t* context = NULL;
+    uint8_t* input_copy = NULL;
+    sgx_sha256_hash_t input_hash;
+    sgx_status_t commit_ret;
+    
+    // 执行合约验证
+    exec_slot_t* slot = exec_slot_acquire();
+    if (!slot) {
+        ret = SGX_ERROR_OUT_OF_MEMORY;
+        goto failed;
+    }
+    context = &slot->context;
+    
+    ret = stage_input(input_data, input_size, &input_copy, &input_hash);
+    if (ret != SGX_SUCCESS) {
+        ocall_print_string("Invalid input data");
+        goto failed;
+    }
+    
+    ret = run_contract(&code_hash, contract_code, code_size, input_copy, input_size,
+                       input_copy ? &input_hash : NULL, DEFAULT_GAS_LIMIT, slot, &t_state_txn);
+    commit_ret = state_txn_commit(&t_state_txn);
+    exec_scratch_free(input_copy);
+    if (ret == SGX_SUCCESS) {
+        ret = commit_ret;
+    }
+    if (ret != SGX_SUCCESS) {
+        ocall_print_string("Contract execution failed");
+        goto failed;
+    }
+    
+    // 复制执行结果
+    if (result_capacity < context->result_size) {
+        *result_size = context->result_size;
+        ret = SGX_ERROR_INVALID_PARAMETER;
+        goto failed;
+    }
+    
+    memcpy(execution_result, context->result_data, context->result_size);
+    *result_size = context->result_size;
+    *gas_used = context->gas_used;
+    
+    // 记录执行完成
+    audit_ring_record(AUDIT_EVENT_EXECUTION_COMPLETED, 1, &code_hash, execution_result, *result_size,
+                      context->gas_used, SGX_SUCCESS);
+    
+    return SGX_SUCCESS;
+    
+failed:
+    audit_ring_record(AUDIT_EVENT_EXECUTION_FAILED, 3, &code_hash, NULL, 0, context ? context->gas_used : 0, ret);
+    return ret;
+}
+
+/**
+ * 执行智能合约
+ */
+sgx_status_t ecall_execute_contract(
+    const uint8_t* contract_code,
+    size_t code_size,
+    const uint8_t* input_data,
+    size_t input_size,
+    uint64_t gas_limit,
+    uint8_t* result,
+    size_t result_capacity,
+    size_t* result_size,
+    uint8_t* execution_hash,
+    uint64_t* gas_used
+) {
+    sgx_status_t ret = SGX_SUCCESS;
+    
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    if (!contract_code || code_size == 0 || code_size > MAX_CONTRACT_SIZE ||
+        !result || !result_size || !execution_hash || !gas_used) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    *gas_used = 0;
+    
+    sgx_sha256_hash_t code_hash;
+    ret = sgx_sha256_msg(contract_code, (uint32_t)code_size, &code_hash);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    exec_slot_t* slot = exec_slot_acquire();
+    if (!slot) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    contract_execution_context_t* context = &slot->context;
+    
+    // 输入在复制进Enclave的同时计算哈希，执行哈希直接使用该摘要
+    uint8_t* input_copy = NULL;
+    sgx_sha256_hash_t input_hash;
+    ret = stage_input(input_data, input_size, &input_copy, &input_hash);
+    if (ret != SGX_SUCCESS) {
+        *result_size = 0;
+        return ret;
+    }
+    
+    ret = run_contract(&code_hash, contract_code, code_size, input_copy, input_size,
+                       input_copy ? &input_hash : NULL, gas_limit, slot, &t_state_txn);
+    sgx_status_t commit_ret = state_txn_commit(&t_state_txn);
+    exec_scratch_free(input_copy);
+    if (ret == SGX_SUCCESS) {
+        ret = commit_ret;
+    }
+    if (ret == SGX_SUCCESS) {
+        if (result_capacity < context->result_size) {
+            ret = SGX_ERROR_INVALID_PARAMETER;
+        } else {
+            memcpy(result, context->result_data, context->result_size);
+            memcpy(execution_hash, context->execution_hash, HASH_SIZE);
+        }
+    }
+    
+    *result_size = context->result_size;
+    *gas_used = context->gas_used;
+    
+    return ret;
+}
+
+/**
+ * 分片执行智能合约
+ */
+sgx_status_t ecall_execute_slice(
+    const uint8_t* contract_code,
+    size_t code_size,
+    const uint8_t* input_data,
+    size_t input_size,
+    uint64_t gas_limit,
+    uint64_t slice_gas,
+    const uint8_t* snapshot,
+    size_t snapshot_size,
+    uint8_t* next_snapshot,
+    size_t next_capacity,
+    size_t* next_size,
+    uint32_t* suspended,
+    uint64_t* gas_used,
+    uint8_t* result,
+    size_t result_capacity,
+    size_t* result_size,
+    uint8_t* execution_hash
+) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    if (!contract_code || code_size == 0 || code_size > MAX_CONTRACT_SIZE || (snapshot && snapshot_size == 0) ||
+        !next_snapshot || !next_size || !suspended || !gas_used || !result || !result_size || !execution_hash) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    *next_size = 0;
+    *suspended = 0;
+    *gas_used = 0;
+    *result_size = 0;
+    
+    sgx_sha256_hash_t code_hash;
+    sgx_status_t ret = sgx_sha256_msg(contract_code, (uint32_t)code_size, &code_hash);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    exec_slot_t* slot = exec_slot_acquire();
+    if (!slot) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    contract_execution_context_t* context = &slot->context;
+    
+    // 恢复时同样重新复制并哈希输入，快照只接受与首片相同的输入
+    uint8_t* input_copy = NULL;
+    sgx_sha256_hash_t input_hash;
+    ret = stage_input(input_data, input_size, &input_copy, &input_hash);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    ret = run_contract_slice(&code_hash, contract_code, code_size, input_copy, input_size,
+                             input_copy ? &input_hash : NULL, gas_limit, slice_gas,
+                             snapshot, snapshot_size, next_snapshot, next_capacity, next_size,
+                             slot, &t_state_txn);
+    sgx_status_t commit_ret = state_txn_commit(&t_state_txn);
+    exec_scratch_free(input_copy);
+    if (ret == SGX_SUCCESS) {
+        ret = commit_ret;
+    }
+    
+    *gas_used = context->gas_used;
+    if (ret == SGX_SUCCESS && context->state == CONTRACT_STATE_SUSPENDED) {
+        *suspended = 1;
+    } else if (ret == SGX_SUCCESS) {
+        if (result_capacity < context->result_size) {
+            ret = SGX_ERROR_INVALID_PARAMETER;
+        } else {
+            memcpy(result, context->result_data, context->result_size);
+            memcpy(execution_hash, context->execution_hash, HASH_SIZE);
+        }
+        *result_size = context->result_size;
+    }
+    
+    return ret;
+}
+
+/**
+ * 批量执行智能合约，一次Enclave切换处理多个任务
+ */
+sgx_status_t ecall_execute_batch(
+    const uint8_t* jobs,
+    size_t jobs_size,
+    uint32_t job_count,
+    uint8_t* results,
+    size_t results_size
+) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    if (!jobs || !results || job_count == 0 || job_count > BATCH_MAX_JOBS ||
+        jobs_size > BATCH_MAX_REQUEST_SIZE) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    size_t records_size = (size_t)job_count * sizeof(batch_result_t);
+    if (results_size < records_size) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    batch_result_t* records = (batch_result_t*)results;
+    uint8_t* result_data = results + records_size;
+    size_t data_capacity = results_size - records_size;
+    size_t data_used = 0;
+    memset(records, 0, records_size);
+    
+    // 执行前检查全部记录的边界，被拒绝的批次不会执行任何任务或修改任何状态
+    sha256_job_t* hash_jobs = (sha256_job_t*)malloc((size_t)job_count * sizeof(sha256_job_t));
+    if (!hash_jobs) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    size_t hash_count = 0;
+    size_t offset = 0;
+    for (uint32_t i = 0; i < job_count; i++) {
+        batch_job_header_t header;
+        if (jobs_size - offset < sizeof(header)) {
+            free(hash_jobs);
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        memcpy(&header, jobs + offset, sizeof(header));
+        
+        size_t record_size = batch_job_record_size(header.code_size, header.input_size);
+        if (record_size > jobs_size - offset) {
+            free(hash_jobs);
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        
+        // 携带字节码的任务的哈希一次多缓冲计算，直接写入结果记录
+        if (!(header.flags & BATCH_JOB_FLAG_BY_HASH) && header.code_size > 0) {
+            hash_jobs[hash_count].data = jobs + offset + sizeof(header);
+            hash_jobs[hash_count].size = header.code_size;
+            hash_jobs[hash_count].hash = records[i].code_hash;
+            hash_count++;
+        }
+        offset += record_size;
+    }
+    
+    sgx_status_t hash_ret = compute_sha256_multi(hash_jobs, hash_count);
+    free(hash_jobs);
+    if (hash_ret != SGX_SUCCESS) {
+        return hash_ret;
+    }
+    
+    exec_slot_t* slot = exec_slot_acquire();
+    if (!slot) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    contract_execution_context_t* context = &slot->context;
+    offset = 0;
+    
+    for (uint32_t i = 0; i < job_count; i++) {
+        // 解析任务记录，缓冲区已复制到Enclave内，边界已在上面检查
+        batch_job_header_t header;
+        if (jobs_size - offset < sizeof(header)) {
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        memcpy(&header, jobs + offset, sizeof(header));
+        
+        size_t record_size = batch_job_record_size(header.code_size, header.input_size);
+        if (record_size > jobs_size - offset) {
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        
+        const uint8_t* code = jobs + offset + sizeof(header);
+        const uint8_t* input = code + header.code_size;
+        offset += record_size;
+        
+        batch_result_t* record = &records[i];
+        sgx_sha256_hash_t code_hash;
+        sgx_status_t ret = SGX_SUCCESS;
+        
+        if (header.flags & BATCH_JOB_FLAG_BY_HASH) {
+            memcpy(code_hash, header.code_hash, sizeof(code_hash));
+            code = NULL;
+        } else if (header.code_size == 0) {
+            ret = SGX_ERROR_INVALID_PARAMETER;
+        } else {
+            memcpy(code_hash, record->code_hash, sizeof(code_hash));
+        }
+        
+        if (ret != SGX_SUCCESS) {
+            record->status = (uint32_t)ret;
+            continue;
+        }
+        
+        ret = run_contract(&code_hash, code, header.code_size,
+                           header.input_size ? input : NULL, header.input_size, NULL,
+                           header.gas_limit, slot, &t_state_txn);
+        
+        record->state = (uint32_t)context->state;
+        record->gas_used = context->gas_used;
+        memcpy(record->code_hash, code_hash, sizeof(code_hash));
+        
+        if (ret == SGX_SUCCESS) {
+            memcpy(record->execution_hash, context->execution_hash, HASH_SIZE);
+            
+            // 结果数据依次追加到数据区
+            if (context->result_size > data_capacity - data_used) {
+                ret = SGX_ERROR_INVALID_PARAMETER;
+            } else if (context->result_size > 0) {
+                memcpy(result_data + data_used, context->result_data, context->result_size);
+                record->result_offset = (uint32_t)data_used;
+                record->result_size = (uint32_t)context->result_size;
+                data_used += context->result_size;
+            }
+        }
+        
+        record->status = (uint32_t)ret;
+    }
+    
+    // 整个批次修改的状态一次写回
+    return state_txn_commit(&t_state_txn);
+}
+
+/**
+ * 在当前线程的执行槽中执行区块的一个事务（block_execute_fn），memory_image为该事务看到的合约内存
+ * JIT生成的代码不记录读写集，JIT后端在区块内改用线程化分派
+ */
+static sgx_status_t run_block_tx(
+    const block_tx_t* tx,
+    const uint8_t* memory_image,
+    size_t memory_image_size,
+    void* arg,
+    contract_execution_context_t** context_out
+) {
+    exec_slot_t* slot = (exec_slot_t*)arg;
+    contract_execution_context_t* context = reset_context(slot, &tx->code_hash, tx->code, tx->code_size,
+                                                          tx->input, tx->input_size, NULL, tx->gas_limit);
+    context->memory_image = memory_image;
+    context->memory_image_size = memory_image_size;
+    *context_out = context;
+    
+    uint32_t backend = __atomic_load_n(&g_execution_backend, __ATOMIC_RELAXED);
+    if (backend == EXECUTION_BACKEND_JIT) {
+        backend = EXECUTION_BACKEND_THREADED;
+    }
+    return dispatch_on_backend(&tx->code_hash, tx->code, tx->code_size, context, backend);
+}
+
+/**
+ * 打开区块
+ */
+sgx_status_t ecall_block_begin(const uint8_t* jobs, size_t jobs_size, uint32_t job_count, uint32_t* block_id) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    return block_exec_begin(jobs, jobs_size, job_count,
+                            __atomic_load_n(&g_state_persistent, __ATOMIC_RELAXED) != 0, block_id);
+}
+
+/**
+ * 参与执行区块，主机的每个执行线程调用一次，领取完所有事务后返回
+ */
+sgx_status_t ecall_block_execute(uint32_t block_id) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    exec_slot_t* slot = exec_slot_acquire();
+    if (!slot) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    
+    return block_exec_run(block_id, run_block_tx, slot);
+}
+
+/**
+ * 提交并关闭区块，区块修改的状态一次写回
+ */
+sgx_status_t ecall_block_commit(
+    uint32_t block_id,
+    uint8_t* results,
+    size_t results_size,
+    uint8_t* stats,
+    size_t stats_size
+) {
+    if (!stats || stats_size != sizeof(block_exec_stats_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    exec_slot_t* slot = exec_slot_acquire();
+    if (!slot) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    
+    block_exec_stats_t result;
+    memset(&result, 0, sizeof(result));
+    sgx_status_t ret = block_exec_commit(block_id, run_block_tx, slot, results, results_size,
+                                         &t_state_txn, &result);
+    sgx_status_t commit_ret = state_txn_commit(&t_state_txn);
+    if (ret == SGX_SUCCESS) {
+        ret = commit_ret;
+    }
+    memcpy(stats, &result, sizeof(result));
+    
+    return ret;
+}
+
+/**
+ * 注册共享环形缓冲区
+ */
+sgx_status_t ecall_register_shared_ring(uint8_t* ring, size_t ring_size) {
+    // 整块缓冲区必须位于Enclave之外，之后按偏移访问时不会触及可信内存
+    if ((ring == NULL) != (ring_size == 0) ||
+        (ring && !sgx_is_outside_enclave(ring, ring_size))) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    sgx_spin_lock(&g_shared_ring_lock);
+    g_shared_ring = ring;
+    g_shared_ring_size = ring_size;
+    sgx_spin_unlock(&g_shared_ring_lock);
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 取共享环形缓冲区中的一段，越界时返回NULL
+ */
+static uint8_t* shared_ring_span(uint8_t* ring, size_t ring_size, uint64_t offset, uint64_t length) {
+    if (offset > ring_size || length > ring_size - offset) {
+        return NULL;
+    }
+    return ring + offset;
+}
+
+/**
+ * 从共享环形缓冲区执行智能合约
+ * 输入在复制进Enclave的同时计算哈希（OP_INPUT和执行哈希读取同一副本）；字节码按哈希命中缓存时不复制，
+ * 未命中时复制到Enclave内并重新计算哈希，防止主机在两次读取之间修改
+ */
+sgx_status_t ecall_execute_shared(
+    uint64_t code_offset,
+    uint64_t code_size,
+    uint64_t input_offset,
+    uint64_t input_size,
+    uint64_t gas_limit,
+    uint64_t result_offset,
+    uint64_t result_capacity,
+    size_t* result_size,
+    uint8_t* execution_hash,
+    uint64_t* gas_used
+) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    sgx_spin_lock(&g_shared_ring_lock);
+    uint8_t* ring = g_shared_ring;
+    size_t ring_size = g_shared_ring_size;
+    sgx_spin_unlock(&g_shared_ring_lock);
+    
+    if (!ring) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    const uint8_t* code = shared_ring_span(ring, ring_size, code_offset, code_size);
+    const uint8_t* input = shared_ring_span(ring, ring_size, input_offset, input_size);
+    uint8_t* result = shared_ring_span(ring, ring_size, result_offset, result_capacity);
+    if (!code || !input || !result || code_size == 0 || code_size > SHARED_RING_MAX_CODE_SIZE ||
+        !result_size || !execution_hash || !gas_used) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    *gas_used = 0;
+    
+    sgx_sha256_hash_t code_hash;
+    sgx_status_t ret = sgx_sha256_msg(code, (uint32_t)code_size, &code_hash);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    // 优先按哈希使用已验证并缓存的合约
+    exec_slot_t* slot = exec_slot_acquire();
+    if (!slot) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    contract_execution_context_t* context = &slot->context;
+    
+    uint8_t* input_copy = NULL;
+    sgx_sha256_hash_t input_hash;
+    ret = stage_input(input, (size_t)input_size, &input_copy, &input_hash);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    const sgx_sha256_hash_t* staged_hash = input_copy ? &input_hash : NULL;
+    
+    ret = run_contract(&code_hash, NULL, (size_t)code_size, input_copy, (size_t)input_size,
+                       staged_hash, gas_limit, slot, &t_state_txn);
+    
+    if (ret == SGX_ERROR_CONTRACT_NOT_CACHED) {
+        uint8_t* code_copy = (uint8_t*)exec_scratch_alloc((size_t)code_size);
+        if (!code_copy) {
+            state_txn_commit(&t_state_txn);
+            exec_scratch_free(input_copy);
+            return SGX_ERROR_OUT_OF_MEMORY;
+        }
+        memcpy(code_copy, code, (size_t)code_size);
+        
+        sgx_sha256_hash_t copy_hash;
+        ret = sgx_sha256_msg(code_copy, (uint32_t)code_size, &copy_hash);
+        if (ret == SGX_SUCCESS && memcmp(copy_hash, code_hash, sizeof(code_hash)) != 0) {
+            ret = SGX_ERROR_INVALID_PARAMETER;
+        }
+        if (ret == SGX_SUCCESS) {
+            ret = run_contract(&code_hash, code_copy, (size_t)code_size, input_copy,
+                               (size_t)input_size, staged_hash, gas_limit, slot, &t_state_txn);
+        }
+        exec_scratch_free(code_copy);
+    }
+    
+    sgx_status_t commit_ret = state_txn_commit(&t_state_txn);
+    exec_scratch_free(input_copy);
+    if (ret == SGX_SUCCESS) {
+        ret = commit_ret;
+    }
+    if (ret == SGX_SUCCESS) {
+        if (result_capacity < context->result_size) {
+            ret = SGX_ERROR_INVALID_PARAMETER;
+        } else {
+            memcpy(result, context->result_data, context->result_size);
+            memcpy(execution_hash, context->execution_hash, HASH_SIZE);
+        }
+    }
+    
+    *result_size = context->result_size;
+    *gas_used = context->gas_used;
+    
+    return ret;
+}
+
+/**
+ * 查找会话并标记为使用中，不存在时返回SGX_ERROR_INVALID_PARAMETER
+ */
+static sgx_status_t take_input_session(uint32_t session_id, input_session_t** session) {
+    sgx_status_t ret = SGX_ERROR_INVALID_PARAMETER;
+    *session = NULL;
+    
+    sgx_spin_lock(&g_input_session_lock);
+    for (uint32_t i = 0; i < INPUT_STREAM_MAX_SESSIONS && session_id != 0; i++) {
+        input_session_t* candidate = g_input_sessions[i];
+        if (candidate && candidate->id == session_id) {
+            if (candidate->busy) {
+                ret = SGX_ERROR_BUSY;
+            } else {
+                candidate->busy = true;
+                *session = candidate;
+                ret = SGX_SUCCESS;
+            }
+            break;
+        }
+    }
+    sgx_spin_unlock(&g_input_session_lock);
+    
+    return ret;
+}
+
+/**
+ * 从会话表中移除使用中的会话（关闭会话）
+ */
+static void remove_input_session(input_session_t* session) {
+    sgx_spin_lock(&g_input_session_lock);
+    for (uint32_t i = 0; i < INPUT_STREAM_MAX_SESSIONS; i++) {
+        if (g_input_sessions[i] == session) {
+            g_input_sessions[i] = NULL;
+            break;
+        }
+    }
+    sgx_spin_unlock(&g_input_session_lock);
+}
+
+/**
+ * 结束对会话的使用
+ */
+static void put_input_session(input_session_t* session) {
+    sgx_spin_lock(&g_input_session_lock);
+    session->busy = false;
+    sgx_spin_unlock(&g_input_session_lock);
+}
+
+/**
+ * 执行会话直到合约停止或等待下一块输入，首次执行时装入持久化的合约状态
+ * 会话不做剖析；字节码解释器后端使用逐条检查的解码路径（会话只保存解码结果）
+ */
+static sgx_status_t run_input_session(input_session_t* session) {
+    contract_execution_context_t* context = &session->context;
+    const decoded_contract_t* program = session->cache_entry->program;
+    bool threaded = session->backend == EXECUTION_BACKEND_THREADED || session->backend == EXECUTION_BACKEND_JIT;
+    sgx_status_t ret = SGX_SUCCESS;
+    
+    if (!session->started) {
+        session->started = true;
+        // 状态项的执行锁只在首次执行（装入映像）时持有，提交时按版本检查期间是否被其他执行修改
+        if (session->state_entry) {
+            sgx_thread_mutex_lock(&session->state_entry->exec_mutex);
+            session->state_version = session->state_entry->item.version;
+            context->memory_image = session->state_entry->item.value;
+            context->memory_image_size = session->state_entry->item.value_size;
+        }
+        if (session->jit) {
+            ret = execute_jit_contract(&g_verifier, context, program, session->jit);
+        } else if (threaded) {
+            ret = execute_threaded_contract(&g_verifier, context, program);
+        } else {
+            ret = execute_decoded_contract(&g_verifier, context, program);
+        }
+        if (session->state_entry) {
+            sgx_thread_mutex_unlock(&session->state_entry->exec_mutex);
+        }
+        context->memory_image = NULL;
+        context->memory_image_size = 0;
+    } else if (session->jit) {
+        ret = continue_jit_contract(&g_verifier, context, program, session->jit);
+    } else if (threaded) {
+        ret = continue_threaded_contract(&g_verifier, context, program);
+    } else {
+        ret = continue_contract_execution(&g_verifier, context, program);
+    }
+    
+    if (ret == SGX_ERROR_CONTRACT_INPUT_PENDING && context->state == CONTRACT_STATE_SUSPENDED) {
+        return SGX_SUCCESS;
+    }
+    session->finished = true;
+    session->status = ret;
+    return ret;
+}
+
+/**
+ * 打开流式输入会话
+ */
+sgx_status_t ecall_input_stream_open(
+    const uint8_t* contract_code,
+    size_t code_size,
+    uint64_t gas_limit,
+    uint32_t* session_id
+) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    if (!contract_code || code_size == 0 || !session_id) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    *session_id = 0;
+    
+    exec_slot_t* slot = exec_slot_acquire();
+    if (!slot) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    
+    input_session_t* session = (input_session_t*)calloc(1, sizeof(input_session_t));
+    if (!session) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    
+    sgx_status_t ret = sgx_sha256_msg(contract_code, (uint32_t)code_size, &session->code_hash);
+    if (ret == SGX_SUCCESS) {
+        ret = input_stream_init(&session->stream);
+    }
+    if (ret == SGX_SUCCESS) {
+        session->context.result_data = (uint8_t*)malloc(MAX_RESULT_SIZE);
+        ret = session->context.result_data ? SGX_SUCCESS : SGX_ERROR_OUT_OF_MEMORY;
+    }
+    // 执行跨越多次ECALL，会话持有解码结果的引用；无法缓存的合约不能流式执行
+    if (ret == SGX_SUCCESS) {
+        ret = code_cache_acquire(&session->code_hash, contract_code, code_size, &session->cache_entry);
+    }
+    if (ret == SGX_SUCCESS) {
+        session->backend = __atomic_load_n(&g_execution_backend, __ATOMIC_RELAXED);
+        if (session->backend == EXECUTION_BACKEND_JIT) {
+            session->jit = jit_get_code(session->cache_entry);
+        }
+        if (__atomic_load_n(&g_state_persistent, __ATOMIC_RELAXED)) {
+            ret = acquire_contract_state(&session->code_hash, &t_state_txn, &session->state_entry);
+            sgx_status_t commit_ret = state_txn_commit(&t_state_txn);
+            if (ret == SGX_SUCCESS) {
+                ret = commit_ret;
+            }
+        }
+    }
+    if (ret != SGX_SUCCESS) {
+        free_input_session(session);
+        return ret;
+    }
+    
+    contract_execution_context_t* context = &session->context;
+    context->code_size = session->cache_entry->program->code_size;
+    context->input_stream = &session->stream;
+    context->gas_limit = gas_limit;
+    context->code_hash = &session->code_hash;
+    context->state = CONTRACT_STATE_INIT;
+    
+    // 先占用会话槽再分配id，其他线程在此之前找不到该会话
+    ret = SGX_ERROR_BUSY;
+    sgx_spin_lock(&g_input_session_lock);
+    for (uint32_t i = 0; i < INPUT_STREAM_MAX_SESSIONS; i++) {
+        if (!g_input_sessions[i]) {
+            session->id = g_next_input_session_id++;
+            if (g_next_input_session_id == 0) {
+                g_next_input_session_id = 1;
+            }
+            g_input_sessions[i] = session;
+            *session_id = session->id;
+            ret = SGX_SUCCESS;
+            break;
+        }
+    }
+    sgx_spin_unlock(&g_input_session_lock);
+    
+    if (ret != SGX_SUCCESS) {
+        free_input_session(session);
+    }
+    return ret;
+}
+
+/**
+ * 送入一块输入并继续执行
+ */
+sgx_status_t ecall_input_stream_feed(
+    uint32_t session_id,
+    const uint8_t* chunk,
+    size_t chunk_size,
+    uint32_t final,
+    uint32_t* completed
+) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    if (!completed) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    *completed = 0;
+    
+    input_session_t* session = NULL;
+    sgx_status_t ret = take_input_session(session_id, &session);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    contract_execution_context_t* context = &session->context;
+    input_stream_t* stream = &session->stream;
+    if (session->finished && session->status != SGX_SUCCESS) {
+        ret = session->status;
+        put_input_session(session);
+        return ret;
+    }
+    
+    // 合约停止后窗口中的数据都不再需要
+    uint64_t consumed = session->finished ? stream->window_offset + stream->window_size : context->input_offset;
+    ret = input_stream_append(stream, consumed, chunk, chunk_size, final != 0);
+    if (ret == SGX_SUCCESS) {
+        context->input_size = (size_t)stream->total_size;
+        if (stream->final) {
+            context->input_hash = &stream->input_hash;
+        }
+        if (!session->finished) {
+            ret = run_input_session(session);
+        } else if (stream->final && context->state == CONTRACT_STATE_COMPLETED) {
+            ret = compute_execution_hash(context, &context->execution_hash);
+            session->status = ret;
+        }
+    } else if (ret != SGX_ERROR_INVALID_PARAMETER) {
+        // 输入哈希可能已计入部分数据，会话只能关闭；被拒绝的参数不改变会话
+        session->finished = true;
+        session->status = ret;
+    }
+    
+    *completed = session->finished ? 1 : 0;
+    put_input_session(session);
+    
+    return ret;
+}
+
+/**
+ * 关闭流式输入会话并取回结果
+ */
+sgx_status_t ecall_input_stream_close(
+    uint32_t session_id,
+    uint8_t* result,
+    size_t result_capacity,
+    size_t* result_size,
+    uint8_t* execution_hash,
+    uint64_t* gas_used
+) {
+    if (!result || !result_size || !execution_hash || !gas_used) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    *result_size = 0;
+    *gas_used = 0;
+    
+    input_session_t* session = NULL;
+    sgx_status_t ret = take_input_session(session_id, &session);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    // 合约未停止或最后一块未送达时放弃执行
+    contract_execution_context_t* context = &session->context;
+    ret = session->finished && session->stream.final ? session->status : SGX_ERROR_INVALID_STATE;
+    
+    // 缓冲区不足时保留会话（状态尚未提交），调用方可按result_size重试
+    if (ret == SGX_SUCCESS && result_capacity < context->result_size) {
+        *result_size = context->result_size;
+        put_input_session(session);
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    remove_input_session(session);
+    
+    if (session->state_entry) {
+        // commit_contract_state释放状态项的锁和引用，写回的临时内存来自当前线程的执行槽
+        state_cache_entry_t* entry = session->state_entry;
+        session->state_entry = NULL;
+        if (!exec_slot_acquire()) {
+            state_cache_release(entry);
+            free_input_session(session);
+            return SGX_ERROR_OUT_OF_MEMORY;
+        }
+        sgx_thread_mutex_lock(&entry->exec_mutex);
+        if (ret == SGX_SUCCESS && session->started && entry->item.version != session->state_version) {
+            ret = SGX_ERROR_INVALID_STATE;
+        }
+        ret = commit_contract_state(entry, context, &t_state_txn, ret);
+        sgx_status_t commit_ret = state_txn_commit(&t_state_txn);
+        if (ret == SGX_SUCCESS) {
+            ret = commit_ret;
+        }
+    }
+    
+    if (ret == SGX_SUCCESS) {
+        memcpy(result, context->result_data, context->result_size);
+        memcpy(execution_hash, context->execution_hash, HASH_SIZE);
+    }
+    
+    *result_size = context->result_size;
+    *gas_used = context->gas_used;
+    free_input_session(session);
+    
+    return ret;
+}
+
+/**
+ * 加载密封的证明签名密钥
+ */
+sgx_status_t ecall_load_signing_key(const uint8_t* sealed_key, size_t sealed_size) {
+    if (!sealed_key || sealed_size < sizeof(sgx_sealed_data_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    const sgx_sealed_data_t* sealed = (const sgx_sealed_data_t*)sealed_key;
+    if (sgx_get_add_mac_txt_len(sealed) != 0 ||
+        sgx_get_encrypt_txt_len(sealed) != sizeof(signing_key_blob_t) ||
+        sealed_size < sgx_calc_sealed_data_size(0, sizeof(signing_key_blob_t))) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    signing_key_blob_t blob;
+    uint32_t blob_size = sizeof(blob);
+    sgx_status_t ret = sgx_unseal_data(sealed, NULL, NULL, (uint8_t*)&blob, &blob_size);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    if (blob_size != sizeof(blob) || blob.version != SIGNING_KEY_BLOB_VERSION) {
+        secure_memzero(&blob, sizeof(blob));
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    sgx_ecc_state_handle_t ecc_handle;
+    int point_valid = 0;
+    ret = get_ecc_handle(&ecc_handle);
+    if (ret == SGX_SUCCESS) {
+        ret = sgx_ecc256_check_point(&blob.public_key, ecc_handle, &point_valid);
+    }
+    if (ret == SGX_SUCCESS && !point_valid) {
+        ret = SGX_ERROR_INVALID_PARAMETER;
+    }
+    if (ret != SGX_SUCCESS) {
+        secure_memzero(&blob, sizeof(blob));
+        return ret;
+    }
+    
+    // 密钥在验证器初始化后只读，初始化完成后不再替换
+    sgx_thread_mutex_lock(&g_init_mutex);
+    if (g_verifier_initialized) {
+        sgx_thread_mutex_unlock(&g_init_mutex);
+        secure_memzero(&blob, sizeof(blob));
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    memcpy(&g_signing_private_key, &blob.private_key, sizeof(g_signing_private_key));
+    memcpy(&g_signing_public_key, &blob.public_key, sizeof(g_signing_public_key));
+    __atomic_store_n(&g_signing_key_ready, true, __ATOMIC_RELEASE);
+    sgx_thread_mutex_unlock(&g_init_mutex);
+    
+    secure_memzero(&blob, sizeof(blob));
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 导出密封的证明签名密钥
+ */
+sgx_status_t ecall_export_signing_key(
+    uint8_t* sealed_key,
+    size_t sealed_capacity,
+    size_t* sealed_size
+) {
+    if (!sealed_key || !sealed_size) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    if (!signing_key_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    uint32_t required_size = sgx_calc_sealed_data_size(0, sizeof(signing_key_blob_t));
+    *sealed_size = required_size;
+    if (sealed_capacity < required_size) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    signing_key_blob_t blob;
+    memset(&blob, 0, sizeof(blob));
+    blob.version = SIGNING_KEY_BLOB_VERSION;
+    memcpy(&blob.private_key, &g_signing_private_key, sizeof(blob.private_key));
+    memcpy(&blob.public_key, &g_signing_public_key, sizeof(blob.public_key));
+    
+    // 默认策略按MRSIGNER密封，同一签名者的后续版本可以继续使用该密钥
+    sgx_status_t ret = sgx_seal_data(0, NULL, sizeof(blob), (const uint8_t*)&blob,
+                                     required_size, (sgx_sealed_data_t*)sealed_key);
+    secure_memzero(&blob, sizeof(blob));
     
-    return SGX_SUCCESS;
+    return ret;
 }
 
 /**
- * 生成执行证明
+ * 验证字节码并密封其元数据
  */
-sgx_status_t ecall_generate_proof(
-    uint8_t* data,
-    size_t data_size,
-    uint8_t* proof,
-    size_t proof_size
+sgx_status_t ecall_seal_contract_metadata(
+    const uint8_t* code,
+    size_t code_size,
+    uint8_t* sealed,
+    size_t capacity,
+    size_t* sealed_size
 ) {
-    if (!data || !proof || data_size == 0 || proof_size < 64) {
-        return SGX_ERROR_INVALID_PARAMETER;
+    return contract_repo_seal_metadata(code, code_size, sealed, capacity, sealed_size);
+}
+
+/**
+ * 从合约仓库预热字节码缓存
+ */
+sgx_status_t ecall_warm_code_cache(
+    const uint8_t* repository,
+    size_t repository_size,
+    uint32_t* loaded,
+    uint32_t* rejected
+) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
     }
     
-    // 模拟证明生成
-    memset(proof, 0xAB, proof_size);
-    
-    return SGX_SUCCESS;
+    return contract_repo_warm(repository, repository_size, loaded, rejected);
 }
 
 /**
- * 创建远程证明报告
+ * 获取证明签名公钥
  */
-sgx_status_t ecall_create_report(
-    uint8_t* report_data,
-    size_t data_size,
-    uint8_t* report_buffer,
-    size_t report_size
-) {
-    if (!report_data || !report_buffer || data_size == 0 || report_size < 432) {
+sgx_status_t ecall_get_signing_public_key(uint8_t* public_key) {
+    if (!public_key) {
         return SGX_ERROR_INVALID_PARAMETER;
     }
     
-    // 模拟报告创建
-    memset(report_buffer, 0xCD, report_size);
+    if (!signing_key_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    memcpy(public_key, &g_signing_public_key, sizeof(g_signing_public_key));
     
     return SGX_SUCCESS;
 }
 
 /**
- * 验证智能合约执行
+ * 用签名密钥为执行哈希（或批量证明的根摘要）生成证明
  */
-sgx_status_t ecall_verify_contract_execution(
-    const uint8_t* contract_code,
-    size_t code_size,
-    const uint8_t* input_data,
-    size_t input_size,
-    uint8_t* execution_result,
-    size_t* result_size,
-    uint64_t* gas_used
-) {
-    sgx_status_t ret = SGX_SUCCESS;
-    
-    if (!g_verifier_initialized) {
-        ocall_print_string("Contract verifier not initialized");
+static sgx_status_t sign_execution_proof(const uint8_t* execution_hash, execution_proof_t* proof) {
+    if (!signing_key_ready()) {
         return SGX_ERROR_INVALID_STATE;
     }
     
-    if (!contract_code || !input_data || !execution_result || !result_size || !gas_used) {
-        ocall_print_string("Invalid parameters");
-        return SGX_ERROR_INVALID_PARAMETER;
-    }
-    
-    // 验证合约代码完整性
-    sgx_sha256_hash_t code_hash;
-    ret = sgx_sha256_msg(contract_code, code_size, &code_hash);
+    sgx_ecc_state_handle_t ecc_handle;
+    sgx_status_t ret = get_ecc_handle(&ecc_handle);
     if (ret != SGX_SUCCESS) {
-        ocall_print_string("Failed to compute contract code hash");
         return ret;
     }
     
-    // 记录审计日志
-    ocall_audit_log(1, "Contract execution started", (uint8_t*)&code_hash, sizeof(code_hash));
+    memset(proof, 0, sizeof(*proof));
     
-    // 执行合约验证
-    contract_execution_context_t context;
-    memset(&context, 0, sizeof(context));
+    // 复制执行哈希
+    memcpy(proof->execution_hash, execution_hash, 32);
     
-    context.contract_code = contract_code;
-    context.code_size = code_size;
-    context.input_data = input_data;
-    context.input_size = input_size;
-    context.gas_limit = 1000000; // 默认gas限制
+    // 获取当前时间戳
+    ocall_get_timestamp(&proof->timestamp);
     
-    ret = execute_contract(&g_verifier, &context);
+    // 生成随机nonce
+    ret = sgx_read_rand(proof->nonce, sizeof(proof->nonce));
     if (ret != SGX_SUCCESS) {
-        ocall_print_string("Contract execution failed");
         return ret;
     }
     
-    // 复制执行结果
-    if (*result_size < context.result_size) {
-        *result_size = context.result_size;
+    // 使用enclave签名密钥对签名之前的所有字段签名
+    memcpy(&proof->public_key, &g_signing_public_key, sizeof(proof->public_key));
+    return sgx_ecdsa_sign((const uint8_t*)proof, offsetof(execution_proof_t, signature),
+                          &g_signing_private_key, &proof->signature, ecc_handle);
+}
+
+/**
+ * 生成执行证明
+ */
+sgx_status_t ecall_generate_execution_proof(
+    const uint8_t* execution_hash,
+    uint8_t* proof_buffer,
+    size_t proof_capacity,
+    size_t* proof_size
+) {
+    if (!execution_hash || !proof_buffer || !proof_size) {
         return SGX_ERROR_INVALID_PARAMETER;
     }
     
-    memcpy(execution_result, context.result_data, context.result_size);
-    *result_size = context.result_size;
-    *gas_used = context.gas_used;
+    *proof_size = sizeof(execution_proof_t);
+    if (proof_capacity < sizeof(execution_proof_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
     
-    // 记录执行完成
-    ocall_audit_log(1, "Contract execution completed", execution_result, *result_size);
+    // 结果缓存中的执行复用首次签名的证明，不再重新签名
+    execution_proof_t proof;
+    bool memoized = result_cache_enabled();
+    if (!memoized || !result_cache_find_proof(execution_hash, &proof)) {
+        sgx_status_t ret = sign_execution_proof(execution_hash, &proof);
+        if (ret != SGX_SUCCESS) {
+            return ret;
+        }
+        if (memoized) {
+            result_cache_attach_proof(&proof);
+        }
+    }
+    
+    // 复制证明到输出缓冲区
+    memcpy(proof_buffer, &proof, sizeof(proof));
     
     return SGX_SUCCESS;
 }
 
 /**
- * 生成执行证明
+ * 生成批量执行证明
+ * 只对执行哈希组成的Merkle树的根签名，各执行的包含路径由主机根据同一组哈希计算
  */
-sgx_status_t ecall_generate_execution_proof(
-    const uint8_t* execution_hash,
+sgx_status_t ecall_generate_batch_proof(
+    const uint8_t* execution_hashes,
+    size_t hashes_size,
     uint8_t* proof_buffer,
+    size_t proof_capacity,
     size_t* proof_size
 ) {
-    sgx_status_t ret = SGX_SUCCESS;
-    
-    if (!execution_hash || !proof_buffer || !proof_size) {
+    if (!execution_hashes || !proof_buffer || !proof_size) {
         return SGX_ERROR_INVALID_PARAMETER;
     }
     
-    // 创建执行证明结构
-    execution_proof_t proof;
-    memset(&proof, 0, sizeof(proof));
+    if (hashes_size == 0 || hashes_size % 32 != 0 || hashes_size / 32 > MERKLE_MAX_LEAVES) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
     
-    // 复制执行哈希
-    memcpy(proof.execution_hash, execution_hash, 32);
+    *proof_size = sizeof(execution_proof_t);
+    if (proof_capacity < sizeof(execution_proof_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
     
-    // 获取当前时间戳
-    ocall_get_timestamp(&proof.timestamp);
+    uint32_t leaf_count = (uint32_t)(hashes_size / 32);
+    sgx_sha256_hash_t root;
+    sgx_sha256_hash_t digest;
     
-    // 生成随机nonce
-    ret = sgx_read_rand(proof.nonce, sizeof(proof.nonce));
+    sgx_status_t ret = merkle_compute_root(execution_hashes, leaf_count, &root);
     if (ret != SGX_SUCCESS) {
         return ret;
     }
     
-    // 计算证明签名
-    sgx_ecc_state_handle_t ecc_handle;
-    ret = sgx_ecc256_open_context(&ecc_handle);
+    ret = merkle_batch_digest(&root, leaf_count, &digest);
     if (ret != SGX_SUCCESS) {
         return ret;
     }
     
-    // 使用enclave私钥签名
-    uint8_t proof_data[sizeof(execution_proof_t) - sizeof(sgx_ec256_signature_t)];
-    memcpy(proof_data, &proof, sizeof(proof_data));
-    
-    sgx_ec256_private_t private_key;
-    ret = generate_ec256_key_pair(&private_key, &proof.public_key);
+    execution_proof_t proof;
+    ret = sign_execution_proof(digest, &proof);
     if (ret != SGX_SUCCESS) {
-        sgx_ecc256_close_context(ecc_handle);
         return ret;
     }
     
-    ret = sgx_ecdsa_sign(proof_data, sizeof(proof_data), &private_key, &proof.signature, ecc_handle);
-    sgx_ecc256_close_context(ecc_handle);
+    memcpy(proof_buffer, &proof, sizeof(proof));
     
-    if (ret != SGX_SUCCESS) {
-        return ret;
+    return SGX_SUCCESS;
+}
+
+/**
+ * 检查单条执行证明：执行哈希一致、由本Enclave签名密钥签名且签名有效
+ */
+static sgx_status_t check_execution_proof(
+    const execution_proof_t* proof,
+    const uint8_t* execution_hash,
+    sgx_ecc_state_handle_t ecc_handle,
+    int* is_valid
+) {
+    *is_valid = 0;
+    
+    // 验证执行哈希
+    if (memcmp(proof->execution_hash, execution_hash, 32) != 0) {
+        return SGX_SUCCESS; // 哈希不匹配，但不是错误
     }
     
-    // 复制证明到输出缓冲区
-    if (*proof_size < sizeof(proof)) {
-        *proof_size = sizeof(proof);
-        return SGX_ERROR_INVALID_PARAMETER;
+    // 只接受本Enclave签名密钥生成的证明
+    if (memcmp(&proof->public_key, &g_signing_public_key, sizeof(g_signing_public_key)) != 0) {
+        return SGX_SUCCESS;
     }
     
-    memcpy(proof_buffer, &proof, sizeof(proof));
-    *proof_size = sizeof(proof);
+    // 验证签名
+    uint8_t verify_result;
+    sgx_status_t ret = sgx_ecdsa_verify((const uint8_t*)proof, offsetof(execution_proof_t, signature),
+                                        &g_signing_public_key, &proof->signature, &verify_result, ecc_handle);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    *is_valid = (verify_result == SGX_EC_VALID) ? 1 : 0;
     
     return SGX_SUCCESS;
 }
@@ -229,8 +1958,6 @@ sgx_status_t ecall_verify_execution_proof(
     const uint8_t* execution_hash,
     int* is_valid
 ) {
-    sgx_status_t ret = SGX_SUCCESS;
-    
     if (!proof || !execution_hash || !is_valid) {
         return SGX_ERROR_INVALID_PARAMETER;
     }
@@ -241,38 +1968,234 @@ sgx_status_t ecall_verify_execution_proof(
         return SGX_ERROR_INVALID_PARAMETER;
     }
     
-    execution_proof_t* exec_proof = (execution_proof_t*)proof;
+    if (!signing_key_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
     
-    // 验证执行哈希
-    if (memcmp(exec_proof->execution_hash, execution_hash, 32) != 0) {
-        return SGX_SUCCESS; // 哈希不匹配，但不是错误
+    sgx_ecc_state_handle_t ecc_handle;
+    sgx_status_t ret = get_ecc_handle(&ecc_handle);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    execution_proof_t exec_proof;
+    memcpy(&exec_proof, proof, sizeof(exec_proof));
+    
+    return check_execution_proof(&exec_proof, execution_hash, ecc_handle, is_valid);
+}
+
+/**
+ * 批量验证执行证明
+ * 所有证明共用当前线程的ECC上下文，结果按位写入valid_bitmap（第i条对应第i/8字节的第i%8位）
+ */
+sgx_status_t ecall_verify_execution_proofs(
+    const uint8_t* proofs,
+    size_t proofs_size,
+    const uint8_t* execution_hashes,
+    size_t hashes_size,
+    uint32_t proof_count,
+    uint8_t* valid_bitmap,
+    size_t bitmap_size
+) {
+    if (!proofs || !execution_hashes || !valid_bitmap ||
+        proof_count == 0 || proof_count > PROOF_VERIFY_MAX_BATCH) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    if (proofs_size != (size_t)proof_count * sizeof(execution_proof_t) ||
+        hashes_size != (size_t)proof_count * 32 ||
+        bitmap_size < ((size_t)proof_count + 7) / 8) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    if (!signing_key_ready()) {
+        return SGX_ERROR_INVALID_STATE;
     }
     
-    // 验证签名
     sgx_ecc_state_handle_t ecc_handle;
-    ret = sgx_ecc256_open_context(&ecc_handle);
+    sgx_status_t ret = get_ecc_handle(&ecc_handle);
     if (ret != SGX_SUCCESS) {
         return ret;
     }
     
-    uint8_t proof_data[sizeof(execution_proof_t) - sizeof(sgx_ec256_signature_t)];
-    memcpy(proof_data, exec_proof, sizeof(proof_data));
+    memset(valid_bitmap, 0, bitmap_size);
     
-    uint8_t verify_result;
-    ret = sgx_ecdsa_verify(proof_data, sizeof(proof_data), &exec_proof->public_key, 
-                          &exec_proof->signature, &verify_result, ecc_handle);
+    for (uint32_t i = 0; i < proof_count; i++) {
+        execution_proof_t exec_proof;
+        memcpy(&exec_proof, proofs + (size_t)i * sizeof(execution_proof_t), sizeof(exec_proof));
+        
+        int is_valid = 0;
+        ret = check_execution_proof(&exec_proof, execution_hashes + (size_t)i * 32, ecc_handle, &is_valid);
+        if (ret != SGX_SUCCESS) {
+            return ret;
+        }
+        
+        if (is_valid) {
+            valid_bitmap[i / 8] |= (uint8_t)(1u << (i % 8));
+        }
+    }
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 选择合约执行后端
+ */
+sgx_status_t ecall_set_execution_backend(uint32_t backend) {
+    if (backend != EXECUTION_BACKEND_INTERPRETER &&
+        backend != EXECUTION_BACKEND_DECODED &&
+        backend != EXECUTION_BACKEND_THREADED &&
+        backend != EXECUTION_BACKEND_JIT) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    // 正在执行的合约继续使用已选择的后端
+    __atomic_store_n(&g_execution_backend, backend, __ATOMIC_RELAXED);
     
-    sgx_ecc256_close_context(ecc_handle);
+    return SGX_SUCCESS;
+}
+
+/**
+ * 设置JIT编译的调用次数阈值
+ */
+sgx_status_t ecall_set_jit_threshold(uint32_t call_threshold) {
+    jit_set_call_threshold(call_threshold);
+    return SGX_SUCCESS;
+}
+
+/**
+ * 配置合约状态持久化
+ */
+sgx_status_t ecall_configure_state(uint32_t persistent, uint64_t cache_budget) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
     
+    sgx_status_t ret = state_cache_init(cache_budget ? (size_t)cache_budget : STATE_CACHE_DEFAULT_BUDGET);
     if (ret != SGX_SUCCESS) {
         return ret;
     }
     
-    *is_valid = (verify_result == SGX_EC_VALID) ? 1 : 0;
+    __atomic_store_n(&g_state_persistent, persistent ? 1u : 0u, __ATOMIC_RELAXED);
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 调整运行时设置
+ */
+sgx_status_t ecall_configure_runtime(const uint8_t* config, size_t config_size) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    if (!config || config_size != sizeof(runtime_config_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    runtime_config_t settings;
+    memcpy(&settings, config, sizeof(settings));
+    if (settings.reserved != 0 ||
+        (settings.profile_flags & ~(uint32_t)(PROFILE_FLAG_ENABLED | PROFILE_FLAG_CYCLES))) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    sgx_status_t ret = code_cache_set_budget(settings.code_cache_budget ? (size_t)settings.code_cache_budget
+                                                                         : CODE_CACHE_DEFAULT_BUDGET);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    ret = state_cache_init(settings.state_cache_budget ? (size_t)settings.state_cache_budget
+                                                       : STATE_CACHE_DEFAULT_BUDGET);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    result_cache_set_budget((size_t)settings.result_cache_budget);
+    
+    return ecall_set_profiling(settings.profile_flags);
+}
+
+/**
+ * 获取Enclave内存占用统计
+ */
+sgx_status_t ecall_get_memory_stats(uint8_t* stats, size_t stats_size) {
+    if (!stats || stats_size != sizeof(enclave_memory_stats_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    exec_pool_stats_t pool;
+    state_cache_stats_t cache;
+    slab_stats_t slab;
+    exec_pool_get_stats(&pool);
+    state_cache_get_stats(&cache);
+    slab_get_stats(&slab);
+    
+    enclave_memory_stats_t result;
+    memset(&result, 0, sizeof(result));
+    result.context_bytes = pool.bytes_per_context;
+    result.slot_bytes = pool.bytes_per_slot;
+    result.slot_count = pool.slot_count;
+    result.memory_pages = pool.memory_pages;
+    result.memory_page_size = VM_MEMORY_PAGE_SIZE;
+    result.state_entries = cache.entry_count;
+    result.state_bytes = cache.bytes_used;
+    result.state_budget = cache.budget;
+    result.slab_bytes_reserved = slab.bytes_reserved;
+    result.slab_bytes_in_use = slab.bytes_in_use;
+    memcpy(stats, &result, sizeof(result));
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 取出审计记录
+ */
+sgx_status_t ecall_drain_audit_log(uint8_t* records, size_t capacity, uint32_t* record_count, uint64_t* dropped) {
+    if (!records || !record_count || !dropped) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    size_t max_records = capacity / sizeof(audit_record_t);
+    if (max_records > AUDIT_DRAIN_MAX_RECORDS) {
+        max_records = AUDIT_DRAIN_MAX_RECORDS;
+    }
+    
+    *record_count = audit_ring_drain((audit_record_t*)records, (uint32_t)max_records);
+    *dropped = audit_ring_dropped();
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 设置执行剖析标志
+ */
+sgx_status_t ecall_set_profiling(uint32_t flags) {
+    if (flags & ~(uint32_t)(PROFILE_FLAG_ENABLED | PROFILE_FLAG_CYCLES)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    // 周期统计依附于剖析，单独设置无意义
+    if (!(flags & PROFILE_FLAG_ENABLED)) {
+        flags = 0;
+    }
+    exec_profile_configure(flags);
     
     return SGX_SUCCESS;
 }
 
+/**
+ * 导出执行剖析快照
+ */
+sgx_status_t ecall_get_profile(uint8_t* snapshot, size_t capacity, size_t* snapshot_size, uint32_t reset) {
+    if (!snapshot || !snapshot_size) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    return exec_profile_snapshot(snapshot, capacity, snapshot_size, reset != 0);
+}
+
 /**
  * 获取enclave测量值
  */
@@ -378,37 +2301,90 @@ sgx_status_t ecall_create_report(
 
 /**
  * 处理智能合约状态更新
+ * 经由状态缓存读写，写入和删除在返回前写回主机
+ * result：0成功，-1不存在，-3缓冲区太小（value_size为所需大小）
  */
 sgx_status_t ecall_handle_state_update(
     const uint8_t* state_key,
     size_t key_size,
     uint8_t* state_value,
+    size_t value_capacity,
     size_t* value_size,
     int operation,
     int* result
 ) {
-    if (!state_key || !state_value || !value_size || !result) {
+    if (!verifier_ready()) {
+        return SGX_ERROR_INVALID_STATE;
+    }
+    
+    if (!state_key || key_size == 0 || key_size >= MAX_STATE_KEY_SIZE ||
+        !state_value || !value_size || !result) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    if (operation == 1 && (*value_size > value_capacity || *value_size > MAX_STATE_VALUE_SIZE)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    if (operation < 0 || operation > 2) {
         return SGX_ERROR_INVALID_PARAMETER;
     }
     
+    uint8_t key[MAX_STATE_KEY_SIZE];
+    key[0] = STATE_KEY_PREFIX_USER;
+    memcpy(key + 1, state_key, key_size);
+    
+    state_cache_entry_t* entry = NULL;
+    sgx_status_t ret = state_cache_acquire(key, key_size + 1, &entry);
+    if (ret != SGX_SUCCESS) {
+        return ret;
+    }
+    
+    bool modified = false;
     *result = 0;
     
+    sgx_spin_lock(&entry->lock);
+    bool exists = (entry->flags & STATE_ENTRY_FLAG_EXISTS) != 0;
     switch (operation) {
         case 0: // 读取
-            ocall_storage_read(state_key, key_size, state_value, value_size, result);
+            if (!exists) {
+                *value_size = 0;
+                *result = -1;
+            } else if (value_capacity < entry->item.value_size) {
+                *value_size = entry->item.value_size;
+                *result = -3;
+            } else {
+                if (entry->item.value_size > 0) {
+                    memcpy(state_value, entry->item.value, entry->item.value_size);
+                }
+                *value_size = entry->item.value_size;
+            }
             break;
             
         case 1: // 写入
-            ocall_storage_write(state_key, key_size, state_value, *value_size, result);
+            ret = state_cache_update(entry, state_value, *value_size);
+            modified = (ret == SGX_SUCCESS);
             break;
             
         case 2: // 删除
-            ocall_storage_delete(state_key, key_size, result);
+            if (exists) {
+                ret = state_cache_update(entry, NULL, 0);
+                modified = (ret == SGX_SUCCESS);
+            } else {
+                *result = -1;
+            }
             break;
-            
-        default:
-            return SGX_ERROR_INVALID_PARAMETER;
     }
+    sgx_spin_unlock(&entry->lock);
     
-    return SGX_SUCCESS;
-}
\ No newline at end of file
+    if (modified) {
+        ret = state_txn_add(&t_state_txn, entry);
+        sgx_status_t commit_ret = state_txn_commit(&t_state_txn);
+        if (ret == SGX_SUCCESS) {
+            ret = commit_ret;
+        }
+    }
+    state_cache_release(entry);
+    
+    return ret;
+}
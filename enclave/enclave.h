@@ -7,6 +7,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "enclave_shared.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -20,13 +22,11 @@ extern "C" {
 #define HASH_SIZE               32
 #define NONCE_SIZE              16
 #define DEFAULT_GAS_LIMIT       1000000
+#define VM_MEMORY_SIZE          4096           // 合约临时内存大小
+#define VM_MEMORY_PAGE_SIZE     256            // 合约内存按页在首次写入时分配
+#define VM_MEMORY_PAGE_COUNT    (VM_MEMORY_SIZE / VM_MEMORY_PAGE_SIZE)
 
-// 错误码定义
-#define SGX_ERROR_CONTRACT_INVALID          (SGX_ERROR_UNEXPECTED + 0x1001)
-#define SGX_ERROR_CONTRACT_EXECUTION_FAILED (SGX_ERROR_UNEXPECTED + 0x1002)
-#define SGX_ERROR_INSUFFICIENT_GAS          (SGX_ERROR_UNEXPECTED + 0x1003)
-#define SGX_ERROR_STATE_ACCESS_DENIED       (SGX_ERROR_UNEXPECTED + 0x1004)
-#define SGX_ERROR_PROOF_GENERATION_FAILED   (SGX_ERROR_UNEXPECTED + 0x1005)
+// 错误码定义见enclave_shared.h
 
 // 合约操作码
 typedef enum {
@@ -53,6 +53,16 @@ typedef enum {
     OP_STORE = 0x14,
     OP_HASH = 0x15,
     OP_VERIFY = 0x16,
+    // 向量指令：长度以字节为单位（可为0），范围须位于合约内存内，
+    // Gas为操作码本身的Gas加上8字节字数 * gas_schedule_t::vector_word_cost
+    OP_COPY = 0x17,     // 弹出len、src、dst：复制src起的len字节到dst（允许重叠）
+    OP_VADD = 0x18,     // 弹出len、src、dst：dst处的64位字逐个加上src处的对应字（len须为8的倍数）
+    OP_VXOR = 0x19,     // 弹出len、src、dst：dst处的字节逐个异或src处的对应字节
+    OP_VCMP = 0x1A,     // 弹出len、b、a：压入两段内存第一个不同字节的偏移，完全相同时为len
+    OP_VSUM = 0x1B,     // 弹出len、addr：压入addr处64位字的回绕和（len须为8的倍数）
+    // 弹出len、addr：从输入的当前读取位置复制至多len字节到addr，压入实际复制的字节数（输入读完时小于len），
+    // Gas另加复制的8字节字数 * vector_word_cost；流式输入尚未送达时挂起，等下一块送达后重新执行本指令
+    OP_INPUT = 0x1C,
     OP_HALT = 0xFF
 } contract_opcode_t;
 
@@ -62,7 +72,8 @@ typedef enum {
     CONTRACT_STATE_RUNNING,
     CONTRACT_STATE_COMPLETED,
     CONTRACT_STATE_ERROR,
-    CONTRACT_STATE_OUT_OF_GAS
+    CONTRACT_STATE_OUT_OF_GAS,
+    CONTRACT_STATE_SUSPENDED                // 分片执行用完本片Gas（可从快照恢复），或OP_INPUT等待流式输入
 } contract_execution_state_t;
 
 // 虚拟机栈
@@ -75,17 +86,28 @@ typedef struct {
 typedef struct {
     const uint8_t* contract_code;           // 合约字节码
     size_t code_size;                       // 字节码大小
-    const uint8_t* input_data;              // 输入数据
-    size_t input_size;                      // 输入数据大小
-    uint8_t* result_data;                   // 执行结果
+    const uint8_t* input_data;              // 输入数据（Enclave内的副本，OP_INPUT从中读取）
+    size_t input_size;                      // 输入数据大小（流式输入为已送入的总大小）
+    uint64_t input_offset;                  // OP_INPUT的读取位置
+    const struct input_stream* input_stream; // 流式输入（为NULL时输入为input_data，见input_stream.h）
+    uint8_t* result_data;                   // 执行结果（MAX_RESULT_SIZE，为NULL时由prepare_contract_execution分配）
     size_t result_size;                     // 结果大小
     uint64_t gas_limit;                     // Gas限制
     uint64_t gas_used;                      // 已使用Gas
     size_t pc;                              // 程序计数器
     contract_execution_state_t state;       // 执行状态
     vm_stack_t stack;                       // 虚拟机栈
-    uint8_t memory[4096];                   // 临时内存
+    const uint8_t* memory_pages[VM_MEMORY_PAGE_COUNT]; // 临时内存页表，供读取（未写过的页指向共享的只读零页）
+    uint8_t* page_buffers[VM_MEMORY_PAGE_COUNT]; // 写时分配的可写页（只有dirty_pages中的页非NULL）
     sgx_sha256_hash_t execution_hash;       // 执行哈希
+    const sgx_sha256_hash_t* code_hash;     // 预计算的字节码哈希（为NULL时重新计算）
+    const sgx_sha256_hash_t* input_hash;    // 预计算的输入哈希（为NULL时由compute_execution_hash计算）
+    const uint8_t* memory_image;            // 持久化的合约内存映像（为NULL时内存清零）
+    size_t memory_image_size;               // 映像大小（不超过memory）
+    uint64_t dirty_pages;                   // 已分配的内存页位图（VM_MEMORY_PAGE_SIZE为单位，其余页为零页）
+    uint64_t read_pages;                    // 本次执行OP_LOAD/OP_HASH和向量指令读过的页位图（JIT后端不记录，见block_exec.h）
+    uint64_t write_pages;                   // 本次执行OP_STORE和向量指令写过的页位图（同上）
+    struct exec_profile_record* profile;    // 剖析记录（为NULL时不统计，见exec_profile.h）
 } contract_execution_context_t;
 
 // 合约验证器
@@ -107,12 +129,12 @@ typedef struct {
 
 // 状态存储项
 typedef struct {
-    uint8_t key[MAX_STATE_KEY_SIZE];        // 状态键
+    uint8_t* key;                           // 状态键（不超过MAX_STATE_KEY_SIZE）
     size_t key_size;                        // 键大小
-    uint8_t value[MAX_STATE_VALUE_SIZE];    // 状态值
+    uint8_t* value;                         // 状态值（不超过MAX_STATE_VALUE_SIZE，为空时为NULL）
     size_t value_size;                      // 值大小
+    size_t value_capacity;                  // 值缓冲区大小
     uint64_t version;                       // 版本号
-    sgx_sha256_hash_t hash;                 // 哈希值
 } state_item_t;
 
 // 审计日志级别
@@ -151,6 +173,7 @@ sgx_status_t execute_contract(contract_verifier_t* verifier, contract_execution_
 
 /**
  * 验证合约字节码
+ * 按指令边界解码，检查操作码、操作数完整性、跳转目标落在指令起始位置及以OP_HALT结束
  * @param code 字节码
  * @param size 字节码大小
  * @return SGX状态码
@@ -0,0 +1,357 @@
+#ifndef ENCLAVE_SHARED_H
+#define ENCLAVE_SHARED_H
+
+// 主机与Enclave共享的定义，不依赖可信运行时
+
+#include <sgx_error.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 错误码定义
+#define SGX_ERROR_CONTRACT_INVALID          ((sgx_status_t)(SGX_ERROR_UNEXPECTED + 0x1001))
+#define SGX_ERROR_CONTRACT_EXECUTION_FAILED ((sgx_status_t)(SGX_ERROR_UNEXPECTED + 0x1002))
+#define SGX_ERROR_INSUFFICIENT_GAS          ((sgx_status_t)(SGX_ERROR_UNEXPECTED + 0x1003))
+#define SGX_ERROR_STATE_ACCESS_DENIED       ((sgx_status_t)(SGX_ERROR_UNEXPECTED + 0x1004))
+#define SGX_ERROR_PROOF_GENERATION_FAILED   ((sgx_status_t)(SGX_ERROR_UNEXPECTED + 0x1005))
+#define SGX_ERROR_CONTRACT_NOT_CACHED       ((sgx_status_t)(SGX_ERROR_UNEXPECTED + 0x1006))
+#define SGX_ERROR_CONTRACT_INPUT_PENDING    ((sgx_status_t)(SGX_ERROR_UNEXPECTED + 0x1007))  // OP_INPUT等待流式输入的下一块
+
+// 合约执行后端（结果和执行哈希完全一致，可用于交叉验证）
+typedef enum {
+    EXECUTION_BACKEND_INTERPRETER = 0,      // 逐字节解释执行，不使用字节码缓存
+    EXECUTION_BACKEND_DECODED = 1,          // 已解码指令逐条检查执行
+    EXECUTION_BACKEND_THREADED = 2,         // 直接线程化分派，按基本块检查栈边界
+    EXECUTION_BACKEND_JIT = 3               // 线程化分派，调用次数达到阈值后编译为本地代码
+} execution_backend_t;
+
+// Gas表：ecall_init_contract_verifier时装入一次，此后不再变化（已解码的合约和本地代码中的Gas据此生成）
+#define GAS_SCHEDULE_VERSION        1
+
+// 标准Gas表：X(操作码, 配置名, Gas)，smart_contract.gas_costs.<配置名>覆盖对应项。
+// 未列出的操作码无法通过验证；OP_CALL/OP_RET尚未实现，执行时失败。
+// OP_HASH、向量指令和OP_INPUT另按数据长度计价，见HASH_WORD和VECTOR_WORD
+#define GAS_SCHEDULE_STANDARD(X)    \
+    X(0x00, "NOP", 1)               \
+    X(0x01, "PUSH", 3)              \
+    X(0x02, "POP", 2)               \
+    X(0x03, "ADD", 3)               \
+    X(0x04, "SUB", 3)               \
+    X(0x05, "MUL", 5)               \
+    X(0x06, "DIV", 5)               \
+    X(0x07, "MOD", 5)               \
+    X(0x08, "AND", 3)               \
+    X(0x09, "OR", 3)                \
+    X(0x0A, "XOR", 3)               \
+    X(0x0B, "NOT", 3)               \
+    X(0x0C, "EQ", 3)                \
+    X(0x0D, "LT", 3)                \
+    X(0x0E, "GT", 3)                \
+    X(0x0F, "JMP", 8)               \
+    X(0x10, "JMPIF", 10)            \
+    X(0x11, "CALL", 0)              \
+    X(0x12, "RET", 0)               \
+    X(0x13, "LOAD", 3)              \
+    X(0x14, "STORE", 3)             \
+    X(0x15, "HASH", 30)             \
+    X(0x16, "VERIFY", 3000)         \
+    X(0x17, "COPY", 3)              \
+    X(0x18, "VADD", 3)              \
+    X(0x19, "VXOR", 3)              \
+    X(0x1A, "VCMP", 3)              \
+    X(0x1B, "VSUM", 3)              \
+    X(0x1C, "INPUT", 3)             \
+    X(0xFF, "HALT", 0)
+
+#define GAS_STANDARD_HASH_WORD      6       // OP_HASH每8字节字的Gas（配置名HASH_WORD）
+#define GAS_STANDARD_VECTOR_WORD    1       // 向量指令和OP_INPUT每8字节字的Gas（配置名VECTOR_WORD）
+
+typedef struct {
+    uint32_t version;                       // GAS_SCHEDULE_VERSION
+    uint32_t hash_word_cost;                // OP_HASH每8字节字的Gas
+    uint32_t vector_word_cost;              // 向量指令和OP_INPUT每8字节字的Gas
+    uint32_t reserved;                      // 保留，须为0
+    uint32_t costs[256];                    // 按操作码索引的Gas（OP_JMP/OP_JMPIF不能为0，否则循环不消耗Gas）
+} gas_schedule_t;
+
+// 执行证明（execution_proof_t）大小：执行哈希32 + 时间戳8 + nonce16 + 公钥64 + 签名64
+// 签名为对签名字段之前所有字节的ECDSA P-256签名，公钥和签名均为SGX的小端格式
+#define EXECUTION_PROOF_SIZE        184
+#define EXECUTION_PROOF_PUBLIC_KEY_OFFSET   56
+#define EXECUTION_PROOF_SIGNATURE_OFFSET    120
+
+// 单次批量验证的证明数量上限
+#define PROOF_VERIFY_MAX_BATCH      4096
+
+// 密封后的证明签名密钥的最大大小（主机据此分配缓冲区）
+#define SIGNING_KEY_SEALED_MAX_SIZE 1024
+
+/*
+ * 批量执行证明：N个执行哈希组成Merkle树，只对根签名一次
+ *   叶子 = SHA256(0x00 | 执行哈希)
+ *   内部节点 = SHA256(0x01 | 左 | 右)，某层节点数为奇数时最后一个节点直接上移
+ *   签名对象 = SHA256(0x02 | 根 | 叶子数量(小端32位))，写入execution_proof_t的execution_hash
+ */
+#define MERKLE_MAX_LEAVES           65536
+#define MERKLE_MAX_DEPTH            16      // 包含路径的最大长度
+#define MERKLE_LEAF_PREFIX          0x00
+#define MERKLE_NODE_PREFIX          0x01
+#define MERKLE_ROOT_PREFIX          0x02
+
+/*
+ * 共享环形缓冲区：主机预先注册一块不可信内存（ecall_register_shared_ring），
+ * ecall_execute_shared按偏移读取字节码和输入、把结果直接写入其中，省去EDL的复制和Enclave堆分配。
+ * 各区域的偏移按SHARED_RING_ALIGN对齐
+ */
+#define SHARED_RING_ALIGN           64
+#define SHARED_RING_MAX_CODE_SIZE   (1024 * 1024)  // 1MB，未缓存的字节码复制到Enclave内的上限
+
+/*
+ * 分片执行：ecall_execute_slice每次最多消耗slice_gas，执行未完成时输出密封的执行快照，
+ * 下次调用从快照继续（同一签名者的任一Enclave实例均可恢复）。
+ * 快照只包含pc、已用Gas、栈上的有效元素和写过的内存页，主机按此大小分配缓冲区
+ */
+#define EXEC_SNAPSHOT_MAX_SEALED_SIZE   8192
+
+/*
+ * 流式输入：ecall_input_stream_open打开一次执行，主机用ecall_input_stream_feed按块送入输入，
+ * 合约通过OP_INPUT读取，读到尚未送达的部分时挂起到下一块送达；输入逐块计入输入哈希，
+ * Enclave内只保留当前块和上一块未读完的尾部，占用与输入总大小无关。
+ * 送入最后一块后由ecall_input_stream_close取回结果和执行哈希
+ */
+#define INPUT_STREAM_MAX_CHUNK          (64 * 1024)    // 每次送入的最大字节数
+#define INPUT_STREAM_MAX_SESSIONS       64             // 同时打开的会话数上限
+
+// Enclave内存占用统计（ecall_get_memory_stats），用于估算EPC用量
+typedef struct {
+    uint64_t context_bytes;                 // 每个执行上下文的固定大小（不含内存页）
+    uint64_t slot_bytes;                    // 每个执行槽占用的堆内存（上下文、结果缓冲区和临时分配区）
+    uint64_t slot_count;                    // 已创建的执行槽数量
+    uint64_t memory_pages;                  // 执行上下文当前持有的内存页数量
+    uint64_t memory_page_size;              // 内存页大小
+    uint64_t state_entries;                 // 状态缓存项数量
+    uint64_t state_bytes;                   // 状态缓存占用（键和值按实际大小分配）
+    uint64_t state_budget;                  // 状态缓存预算
+    uint64_t slab_bytes_reserved;           // 小对象分配器从堆中申请的内存
+    uint64_t slab_bytes_in_use;             // 小对象分配器中已分配的对象
+} enclave_memory_stats_t;
+
+// 可在运行时调整的Enclave设置（ecall_configure_runtime），主机在配置文件变化后一次传入全部字段
+typedef struct {
+    uint64_t code_cache_budget;             // 字节码缓存预算（0表示默认值），缩小时立即淘汰未引用的缓存项
+    uint64_t state_cache_budget;            // 状态缓存预算（0表示默认值）
+    uint32_t profile_flags;                 // PROFILE_FLAG_*组合，0表示关闭剖析
+    uint32_t reserved;                      // 保留，须为0
+    uint64_t result_cache_budget;           // 确定性执行结果缓存预算（0表示关闭，只在未启用状态持久化时使用）
+} runtime_config_t;
+
+// 执行剖析（ecall_set_profiling / ecall_get_profile）
+#define PROFILE_FLAG_ENABLED        0x01    // 按字节码哈希统计操作码、基本块和Gas（执行改走解码解释器）
+#define PROFILE_FLAG_CYCLES         0x02    // 另以rdtsc统计周期数（SGX1的Enclave内rdtsc会触发异常，仅在SGX2或模拟模式下开启）
+#define PROFILE_VERSION             2
+#define PROFILE_OPCODE_SLOTS        32      // 操作码统计槽：小于31的操作码各占一槽，OP_HALT和其余操作码计入最后一槽
+#define PROFILE_MAX_BLOCKS          32      // 每个合约统计的基本块数量上限
+#define PROFILE_MAX_CONTRACTS       64      // 统计的合约数量上限
+
+/*
+ * 剖析快照为：
+ *   profile_snapshot_header_t | contract_count条记录
+ * 每条记录为 profile_contract_t | profile_block_t[block_count]
+ */
+typedef struct {
+    uint32_t version;                       // PROFILE_VERSION
+    uint32_t flags;                         // 当前的剖析标志
+    uint32_t contract_count;                // 合约记录数量
+    uint32_t executions_dropped;            // 合约表满后未能统计的执行次数
+    uint64_t profiled_executions;           // 已统计的执行次数
+    uint64_t code_cache_hits;               // 字节码缓存命中次数（自Enclave创建起累计，下同）
+    uint64_t code_cache_misses;
+    uint64_t code_cache_evictions;
+    uint64_t state_cache_hits;              // 状态缓存命中次数
+    uint64_t state_cache_misses;
+    uint64_t state_cache_evictions;
+    uint64_t result_cache_hits;             // 结果缓存命中次数
+    uint64_t result_cache_misses;
+    uint64_t result_cache_evictions;
+    uint64_t result_cache_proof_hits;       // 复用已签名证明的次数
+} profile_snapshot_header_t;
+
+typedef struct {
+    uint8_t code_hash[32];                  // 字节码哈希
+    uint64_t executions;                    // 执行次数
+    uint64_t gas_used;                      // 累计Gas
+    uint64_t cycles;                        // 累计周期数（未启用PROFILE_FLAG_CYCLES时为0）
+    uint32_t block_count;                   // 其后的基本块记录数量
+    uint32_t blocks_dropped;                // 超出PROFILE_MAX_BLOCKS未能统计的块入口次数
+    uint64_t opcode_counts[PROFILE_OPCODE_SLOTS];   // 各操作码的执行次数
+    uint64_t opcode_cycles[PROFILE_OPCODE_SLOTS];   // 各操作码的累计周期数
+} profile_contract_t;
+
+typedef struct {
+    uint32_t start_pc;                      // 块首指令的字节码偏移
+    uint32_t reserved;
+    uint64_t entries;                       // 进入次数
+    uint64_t gas_used;                      // 块内指令累计消耗的Gas
+} profile_block_t;
+
+// 剖析快照的最大大小
+#define PROFILE_MAX_SNAPSHOT_SIZE   (sizeof(profile_snapshot_header_t) + \
+    PROFILE_MAX_CONTRACTS * (sizeof(profile_contract_t) + PROFILE_MAX_BLOCKS * sizeof(profile_block_t)))
+
+/**
+ * 获取操作码的剖析统计槽
+ * @param opcode 操作码
+ * @return 槽索引
+ */
+static inline uint32_t profile_opcode_slot(uint32_t opcode) {
+    return opcode < PROFILE_OPCODE_SLOTS - 1 ? opcode : PROFILE_OPCODE_SLOTS - 1;
+}
+
+// 审计日志：Enclave把固定大小的记录放入环形缓冲区，由主机读取线程（ecall_drain_audit_log）
+// 或缓冲区满时的一次ocall_audit_write_batch批量取出，单次执行不产生额外的切换
+#define AUDIT_EVENT_EXECUTION_STARTED   1
+#define AUDIT_EVENT_EXECUTION_COMPLETED 2
+#define AUDIT_EVENT_EXECUTION_FAILED    3
+#define AUDIT_RECORD_DATA_SIZE          32      // 记录中保留的数据前缀大小
+#define AUDIT_DRAIN_MAX_RECORDS         256     // 一次取出的最大记录数
+
+typedef struct {
+    uint64_t sequence;                      // 记录序号（连续递增，缺失的序号表示记录被丢弃）
+    uint32_t event;                         // AUDIT_EVENT_*
+    uint32_t level;                         // 0 DEBUG，1 INFO，2 WARNING，3 ERROR
+    uint32_t status;                        // 执行失败时的sgx_status_t
+    uint32_t data_size;                     // 原始数据大小（data只保留前AUDIT_RECORD_DATA_SIZE字节）
+    uint64_t gas_used;                      // 执行完成时消耗的Gas
+    uint8_t code_hash[32];                  // 字节码哈希
+    uint8_t data[AUDIT_RECORD_DATA_SIZE];   // 数据前缀（执行完成时为结果）
+} audit_record_t;
+
+/*
+ * 合约状态写回：Enclave在提交时把一次执行（或一个批次）的脏状态项合并为一次OCALL，
+ * 缓冲区由record_count条记录依次组成，每条记录为：
+ *   state_record_header_t | 键(key_size) | 值(value_size) | 填充至8字节对齐
+ * 主机按version保留每个键的最新记录，STATE_RECORD_FLAG_DELETED表示删除
+ */
+#define STATE_RECORD_ALIGN          8
+#define STATE_RECORD_MAX_KEY_SIZE   256             // 与enclave.h中的MAX_STATE_KEY_SIZE一致
+#define STATE_RECORD_MAX_VALUE_SIZE (4 * 1024)      // 与enclave.h中的MAX_STATE_VALUE_SIZE一致
+#define STATE_RECORD_FLAG_DELETED   0x01
+
+typedef struct {
+    uint32_t key_size;                      // 键大小
+    uint32_t value_size;                    // 值大小（删除时为0）
+    uint32_t flags;                         // 记录标志
+    uint32_t reserved;                      // 保留
+    uint64_t version;                       // 状态版本（每次修改递增）
+} state_record_header_t;
+
+/**
+ * 计算单条状态记录的大小（含对齐填充）
+ * @param key_size 键大小
+ * @param value_size 值大小
+ * @return 记录字节数
+ */
+static inline size_t state_record_size(size_t key_size, size_t value_size) {
+    size_t size = sizeof(state_record_header_t) + key_size + value_size;
+    return (size + STATE_RECORD_ALIGN - 1) & ~(size_t)(STATE_RECORD_ALIGN - 1);
+}
+
+// 批量执行限制
+#define BATCH_MAX_JOBS              1024
+#define BATCH_MAX_REQUEST_SIZE      (1024 * 1024)  // 1MB
+#define BATCH_RESULT_DATA_SIZE      (64 * 1024)    // 64KB
+#define BATCH_RECORD_ALIGN          8
+
+// 批量任务标志
+#define BATCH_JOB_FLAG_BY_HASH      0x01    // 按字节码哈希引用已缓存的合约，不携带字节码
+
+/*
+ * 批量请求缓冲区由job_count条记录依次组成，每条记录为：
+ *   batch_job_header_t | 字节码(code_size) | 输入数据(input_size) | 填充至8字节对齐
+ */
+typedef struct {
+    uint32_t flags;                         // 任务标志
+    uint32_t code_size;                     // 字节码大小（按哈希引用时为0）
+    uint32_t input_size;                    // 输入数据大小
+    uint32_t reserved;                      // 保留
+    uint64_t gas_limit;                     // Gas限制
+    uint8_t code_hash[32];                  // 字节码哈希（仅按哈希引用时使用）
+} batch_job_header_t;
+
+/*
+ * 批量结果缓冲区为：
+ *   batch_result_t[job_count] | 结果数据区
+ * result_offset相对于结果数据区起始位置
+ */
+typedef struct {
+    uint32_t status;                        // sgx_status_t
+    uint32_t state;                         // contract_execution_state_t
+    uint64_t gas_used;                      // 已使用Gas
+    uint32_t result_offset;                 // 结果数据偏移
+    uint32_t result_size;                   // 结果数据大小
+    uint8_t code_hash[32];                  // 字节码哈希（可用于后续按哈希引用）
+    uint8_t execution_hash[32];             // 执行哈希
+} batch_result_t;
+
+/**
+ * 计算单条批量任务记录的大小（含对齐填充）
+ * @param code_size 字节码大小
+ * @param input_size 输入数据大小
+ * @return 记录字节数
+ */
+static inline size_t batch_job_record_size(size_t code_size, size_t input_size) {
+    size_t size = sizeof(batch_job_header_t) + code_size + input_size;
+    return (size + BATCH_RECORD_ALIGN - 1) & ~(size_t)(BATCH_RECORD_ALIGN - 1);
+}
+
+/*
+ * 区块执行复用批量请求和批量结果的格式（见ecall_block_begin和ecall_block_commit），
+ * 提交时输出本区块的调度统计
+ */
+typedef struct {
+    uint32_t tx_count;                      // 事务数量
+    uint32_t contract_count;                // 涉及的合约（状态项）数量
+    uint32_t executions;                    // 并行乐观执行的次数
+    uint32_t reexecutions;                  // 读集校验失败后按顺序重新执行的次数
+    uint32_t state_updates;                 // 提交时写回的状态项数量
+    uint32_t reserved;                      // 保留
+} block_exec_stats_t;
+
+// 合约仓库文件
+#define CONTRACT_REPO_MAGIC         "SGXCREPO"
+#define CONTRACT_REPO_VERSION       1
+#define CONTRACT_REPO_ALIGN         8
+#define CONTRACT_REPO_MAX_ENTRIES   65536
+#define CONTRACT_REPO_MAX_META_SIZE 1024            // 单个密封元数据的大小上限
+
+/*
+ * 合约仓库为单个只读文件，主机整体映射后交给ecall_warm_code_cache：
+ *   contract_repo_header_t | 条目数据 | contract_repo_index_t[entry_count]
+ * 每个条目的数据为 密封的元数据 | 字节码，各自填充至8字节对齐；
+ * 索引按code_hash升序排列（主机二分查找），偏移均相对于文件起始位置。
+ * 元数据由ecall_seal_contract_metadata在验证字节码后密封，预热时据此跳过验证
+ */
+typedef struct {
+    uint8_t magic[8];                       // CONTRACT_REPO_MAGIC
+    uint32_t version;                       // CONTRACT_REPO_VERSION
+    uint32_t entry_count;                   // 条目数量
+    uint64_t index_offset;                  // 索引偏移
+    uint64_t file_size;                     // 文件大小
+} contract_repo_header_t;
+
+typedef struct {
+    uint8_t code_hash[32];                  // 字节码哈希
+    uint64_t meta_offset;                   // 密封元数据偏移
+    uint64_t code_offset;                   // 字节码偏移
+    uint32_t meta_size;                     // 密封元数据大小
+    uint32_t code_size;                     // 字节码大小
+} contract_repo_index_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ENCLAVE_SHARED_H
@@ -0,0 +1,147 @@
+#include "exec_arena.h"
+#include "enclave.h"
+#include "contract_verifier.h"
+
+#include <sgx_spinlock.h>
+#include <string.h>
+#include <stdlib.h>
+
+// 临时分配的块头：记录块的起止偏移，用于按相反顺序释放时回收
+typedef struct {
+    size_t begin;                           // 块头所在的偏移（释放后的已用字节数）
+    size_t end;                             // 块末尾的偏移
+} scratch_header_t;
+
+#define SCRATCH_HEADER_SIZE     ((sizeof(scratch_header_t) + EXEC_ARENA_ALIGN - 1) / EXEC_ARENA_ALIGN * EXEC_ARENA_ALIGN)
+#define SLOT_HEADER_SIZE        ((sizeof(exec_slot_t) + EXEC_ARENA_ALIGN - 1) / EXEC_ARENA_ALIGN * EXEC_ARENA_ALIGN)
+#define ARENA_SIZE              (MAX_RESULT_SIZE + EXEC_ARENA_SCRATCH_SIZE)
+
+// 槽池（由g_pool_lock保护）
+static sgx_spinlock_t g_pool_lock = SGX_SPINLOCK_INITIALIZER;
+static exec_slot_t* g_free_slots = NULL;
+static uint32_t g_slot_count = 0;
+static uint32_t g_free_count = 0;
+static size_t g_arena_peak = 0;
+static uint64_t g_scratch_fallbacks = 0;
+
+// 当前线程持有的槽
+static __thread exec_slot_t* t_slot = NULL;
+
+/**
+ * 分配新槽，上下文和分配区一次分配，上下文清零后由prepare_contract_execution设置内存页表
+ */
+static exec_slot_t* create_slot(void) {
+    uint8_t* memory = (uint8_t*)malloc(SLOT_HEADER_SIZE + ARENA_SIZE);
+    if (!memory) {
+        return NULL;
+    }
+
+    exec_slot_t* slot = (exec_slot_t*)memory;
+    memset(slot, 0, sizeof(*slot));
+    slot->arena = memory + SLOT_HEADER_SIZE;
+    slot->result_buffer = slot->arena;
+    slot->arena_floor = MAX_RESULT_SIZE;
+    slot->arena_used = slot->arena_floor;
+    slot->arena_peak = slot->arena_floor;
+
+    return slot;
+}
+
+exec_slot_t* exec_slot_acquire(void) {
+    exec_slot_t* slot = t_slot;
+    if (!slot) {
+        sgx_spin_lock(&g_pool_lock);
+        slot = g_free_slots;
+        if (slot) {
+            g_free_slots = slot->next;
+            g_free_count--;
+        }
+        sgx_spin_unlock(&g_pool_lock);
+
+        if (!slot) {
+            slot = create_slot();
+            if (!slot) {
+                return NULL;
+            }
+            __atomic_fetch_add(&g_slot_count, 1, __ATOMIC_RELAXED);
+        }
+        slot->next = NULL;
+        t_slot = slot;
+    }
+
+    slot->arena_used = slot->arena_floor;
+    return slot;
+}
+
+void exec_slot_release(void) {
+    exec_slot_t* slot = t_slot;
+    if (!slot) {
+        return;
+    }
+    t_slot = NULL;
+    reset_contract_memory(&slot->context);
+
+    sgx_spin_lock(&g_pool_lock);
+    if (slot->arena_peak > g_arena_peak) {
+        g_arena_peak = slot->arena_peak;
+    }
+    slot->next = g_free_slots;
+    g_free_slots = slot;
+    g_free_count++;
+    sgx_spin_unlock(&g_pool_lock);
+}
+
+void* exec_scratch_alloc(size_t size) {
+    exec_slot_t* slot = t_slot;
+    if (slot && size <= ARENA_SIZE) {
+        size_t block = SCRATCH_HEADER_SIZE + (size + EXEC_ARENA_ALIGN - 1) / EXEC_ARENA_ALIGN * EXEC_ARENA_ALIGN;
+        if (block <= ARENA_SIZE - slot->arena_used) {
+            scratch_header_t* header = (scratch_header_t*)(slot->arena + slot->arena_used);
+            header->begin = slot->arena_used;
+            header->end = slot->arena_used + block;
+            slot->arena_used = header->end;
+            if (slot->arena_used > slot->arena_peak) {
+                slot->arena_peak = slot->arena_used;
+            }
+            return (uint8_t*)header + SCRATCH_HEADER_SIZE;
+        }
+    }
+
+    __atomic_fetch_add(&g_scratch_fallbacks, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void exec_scratch_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    exec_slot_t* slot = t_slot;
+    uint8_t* bytes = (uint8_t*)ptr;
+    if (slot && bytes >= slot->arena + slot->arena_floor && bytes < slot->arena + ARENA_SIZE) {
+        const scratch_header_t* header = (const scratch_header_t*)(bytes - SCRATCH_HEADER_SIZE);
+        if (header->end == slot->arena_used) {
+            slot->arena_used = header->begin;
+        }
+        return;
+    }
+
+    free(ptr);
+}
+
+void exec_pool_get_stats(exec_pool_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    sgx_spin_lock(&g_pool_lock);
+    stats->slot_count = __atomic_load_n(&g_slot_count, __ATOMIC_RELAXED);
+    stats->free_count = g_free_count;
+    stats->bytes_per_slot = SLOT_HEADER_SIZE + ARENA_SIZE;
+    stats->bytes_per_context = sizeof(contract_execution_context_t);
+    stats->arena_peak = g_arena_peak;
+    sgx_spin_unlock(&g_pool_lock);
+
+    stats->scratch_fallbacks = __atomic_load_n(&g_scratch_fallbacks, __ATOMIC_RELAXED);
+    stats->memory_pages = vm_memory_pages_in_use();
+}
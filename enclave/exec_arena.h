@@ -0,0 +1,79 @@
+#ifndef EXEC_ARENA_H
+#define EXEC_ARENA_H
+
+#include "enclave.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 每个TCS（线程）占用一个执行槽，槽包含复用的执行上下文、结果缓冲区和临时分配区。
+// 线程首次执行时从池中取槽（池为空时分配），ecall_destroy_enclave时归还，
+// 槽本身不释放，Enclave堆的使用量只随并发线程数增长，与执行次数无关
+
+// 每个槽的临时分配区大小（超过时exec_scratch_alloc回退到堆）
+#define EXEC_ARENA_SCRATCH_SIZE     (MAX_INPUT_SIZE + 64 * 1024)  // 输入副本加写回记录等，128KB
+#define EXEC_ARENA_ALIGN            16
+
+// 执行槽
+typedef struct exec_slot {
+    contract_execution_context_t context;   // 复用的执行上下文（创建时清零）
+    uint8_t* result_buffer;                 // 结果缓冲区（MAX_RESULT_SIZE，位于分配区起始处）
+    uint8_t* arena;                         // 分配区
+    size_t arena_floor;                     // 分配区中常驻部分的大小（结果缓冲区）
+    size_t arena_used;                      // 已用字节数
+    size_t arena_peak;                      // 已用字节数的峰值
+    struct exec_slot* next;                 // 空闲链表
+} exec_slot_t;
+
+// 执行槽池统计
+typedef struct {
+    uint32_t slot_count;                    // 已创建的槽数量
+    uint32_t free_count;                    // 池中空闲的槽数量
+    size_t bytes_per_slot;                  // 每个槽占用的堆内存
+    size_t bytes_per_context;               // 执行上下文的固定大小（不含内存页）
+    size_t memory_pages;                    // 所有上下文当前持有的内存页（VM_MEMORY_PAGE_SIZE）
+    size_t arena_peak;                      // 已归还的槽分配区用量的峰值
+    uint64_t scratch_fallbacks;             // 临时分配回退到堆的次数
+} exec_pool_stats_t;
+
+/**
+ * 获取当前线程的执行槽并清空其临时分配区，在每个执行合约的ECALL入口调用
+ * @return 执行槽（内存不足时为NULL）
+ */
+exec_slot_t* exec_slot_acquire(void);
+
+/**
+ * 将当前线程的执行槽归还到池中，槽上下文持有的内存页同时释放
+ */
+void exec_slot_release(void);
+
+/**
+ * 从当前线程的分配区分配临时内存，分配区不足或没有执行槽时回退到malloc
+ * 内存在下次exec_slot_acquire前有效，释放顺序与分配相反时空间立即复用
+ * @param size 大小
+ * @return 内存指针（失败时为NULL）
+ */
+void* exec_scratch_alloc(size_t size);
+
+/**
+ * 释放exec_scratch_alloc分配的内存
+ * @param ptr 内存指针（可为NULL）
+ */
+void exec_scratch_free(void* ptr);
+
+/**
+ * 获取执行槽池统计
+ * @param stats 输出统计
+ */
+void exec_pool_get_stats(exec_pool_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXEC_ARENA_H
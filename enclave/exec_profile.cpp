@@ -0,0 +1,224 @@
+#include "exec_profile.h"
+#include "code_cache.h"
+#include "state_cache.h"
+#include "result_cache.h"
+
+#include <sgx_spinlock.h>
+#include <string.h>
+
+// 块表按块首偏移开放寻址，Enclave内用profile_block_t::reserved标记已占用的槽位（导出时清零）
+#define BLOCK_SLOT_USED 1
+
+// 合约统计（由g_profile_lock保护，执行期间只写线程局部记录）
+typedef struct {
+    bool used;
+    profile_contract_t summary;
+    profile_block_t blocks[PROFILE_MAX_BLOCKS];
+} profile_entry_t;
+
+static uint32_t g_profile_flags = 0;
+static sgx_spinlock_t g_profile_lock = SGX_SPINLOCK_INITIALIZER;
+static profile_entry_t g_entries[PROFILE_MAX_CONTRACTS];
+static uint32_t g_contract_count = 0;
+static uint32_t g_executions_dropped = 0;
+static uint64_t g_profiled_executions = 0;
+
+static __thread exec_profile_record_t t_record;
+
+/**
+ * 在块表中查找块，不存在时占用空位
+ * @param inserted 输出是否新占用了槽位（可为NULL）
+ * @return 块下标（表满时为PROFILE_MAX_BLOCKS）
+ */
+static uint32_t find_block(profile_block_t* blocks, uint32_t start_pc, bool* inserted) {
+    for (uint32_t i = 0; i < PROFILE_MAX_BLOCKS; i++) {
+        uint32_t index = (start_pc + i) % PROFILE_MAX_BLOCKS;
+        if (blocks[index].reserved != BLOCK_SLOT_USED) {
+            blocks[index].start_pc = start_pc;
+            blocks[index].reserved = BLOCK_SLOT_USED;
+            if (inserted) {
+                *inserted = true;
+            }
+            return index;
+        }
+        if (blocks[index].start_pc == start_pc) {
+            return index;
+        }
+    }
+    return PROFILE_MAX_BLOCKS;
+}
+
+/**
+ * 在合约表中查找合约，不存在时占用空位（调用方持有g_profile_lock）
+ * @return 合约记录（表满时为NULL）
+ */
+static profile_entry_t* find_entry(const sgx_sha256_hash_t* code_hash) {
+    uint32_t prefix;
+    memcpy(&prefix, *code_hash, sizeof(prefix));
+
+    for (uint32_t i = 0; i < PROFILE_MAX_CONTRACTS; i++) {
+        profile_entry_t* entry = &g_entries[(prefix + i) % PROFILE_MAX_CONTRACTS];
+        if (!entry->used) {
+            memset(entry, 0, sizeof(*entry));
+            entry->used = true;
+            memcpy(entry->summary.code_hash, *code_hash, sizeof(entry->summary.code_hash));
+            g_contract_count++;
+            return entry;
+        }
+        if (memcmp(entry->summary.code_hash, *code_hash, sizeof(entry->summary.code_hash)) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void exec_profile_configure(uint32_t flags) {
+    __atomic_store_n(&g_profile_flags, flags, __ATOMIC_RELAXED);
+}
+
+uint32_t exec_profile_flags(void) {
+    return __atomic_load_n(&g_profile_flags, __ATOMIC_RELAXED);
+}
+
+exec_profile_record_t* exec_profile_begin(bool cycles) {
+    exec_profile_record_t* record = &t_record;
+    memset(record, 0, sizeof(*record));
+    record->current_block = PROFILE_MAX_BLOCKS;
+    record->cycles = cycles;
+    return record;
+}
+
+void exec_profile_enter_block(exec_profile_record_t* record, uint32_t start_pc) {
+    record->current_block = find_block(record->blocks, start_pc, NULL);
+    if (record->current_block < PROFILE_MAX_BLOCKS) {
+        record->blocks[record->current_block].entries++;
+    } else {
+        record->blocks_dropped++;
+    }
+}
+
+void exec_profile_resume_block(exec_profile_record_t* record, uint32_t start_pc) {
+    record->current_block = find_block(record->blocks, start_pc, NULL);
+}
+
+void exec_profile_commit(const sgx_sha256_hash_t* code_hash, const exec_profile_record_t* record,
+                         uint64_t gas_used, uint64_t cycles) {
+    if (!code_hash || !record) {
+        return;
+    }
+
+    sgx_spin_lock(&g_profile_lock);
+    profile_entry_t* entry = find_entry(code_hash);
+    if (!entry) {
+        g_executions_dropped++;
+        sgx_spin_unlock(&g_profile_lock);
+        return;
+    }
+
+    profile_contract_t* summary = &entry->summary;
+    summary->executions++;
+    summary->gas_used += gas_used;
+    summary->cycles += cycles;
+    summary->blocks_dropped += record->blocks_dropped;
+    for (uint32_t i = 0; i < PROFILE_OPCODE_SLOTS; i++) {
+        summary->opcode_counts[i] += record->opcode_counts[i];
+        summary->opcode_cycles[i] += record->opcode_cycles[i];
+    }
+
+    for (uint32_t i = 0; i < PROFILE_MAX_BLOCKS; i++) {
+        const profile_block_t* block = &record->blocks[i];
+        if (block->reserved != BLOCK_SLOT_USED) {
+            continue;
+        }
+        bool inserted = false;
+        uint32_t index = find_block(entry->blocks, block->start_pc, &inserted);
+        if (index == PROFILE_MAX_BLOCKS) {
+            summary->blocks_dropped += (uint32_t)block->entries;
+            continue;
+        }
+        if (inserted) {
+            summary->block_count++;
+        }
+        entry->blocks[index].entries += block->entries;
+        entry->blocks[index].gas_used += block->gas_used;
+    }
+
+    g_profiled_executions++;
+    sgx_spin_unlock(&g_profile_lock);
+}
+
+sgx_status_t exec_profile_snapshot(uint8_t* buffer, size_t capacity, size_t* size, bool reset) {
+    if (!size || (!buffer && capacity > 0)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 缓存统计有各自的锁，先于剖析锁读取
+    code_cache_stats_t code_stats;
+    state_cache_stats_t state_stats;
+    result_cache_stats_t result_stats;
+    code_cache_get_stats(&code_stats);
+    state_cache_get_stats(&state_stats);
+    result_cache_get_stats(&result_stats);
+
+    profile_snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.version = PROFILE_VERSION;
+    header.flags = exec_profile_flags();
+    header.code_cache_hits = code_stats.hits;
+    header.code_cache_misses = code_stats.misses;
+    header.code_cache_evictions = code_stats.evictions;
+    header.state_cache_hits = state_stats.hits;
+    header.state_cache_misses = state_stats.misses;
+    header.state_cache_evictions = state_stats.evictions;
+    header.result_cache_hits = result_stats.hits;
+    header.result_cache_misses = result_stats.misses;
+    header.result_cache_evictions = result_stats.evictions;
+    header.result_cache_proof_hits = result_stats.proof_hits;
+
+    sgx_spin_lock(&g_profile_lock);
+
+    size_t needed = sizeof(header);
+    for (uint32_t i = 0; i < PROFILE_MAX_CONTRACTS; i++) {
+        if (g_entries[i].used) {
+            needed += sizeof(profile_contract_t) + g_entries[i].summary.block_count * sizeof(profile_block_t);
+        }
+    }
+    *size = needed;
+    if (needed > capacity) {
+        sgx_spin_unlock(&g_profile_lock);
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    header.contract_count = g_contract_count;
+    header.executions_dropped = g_executions_dropped;
+    header.profiled_executions = g_profiled_executions;
+    memcpy(buffer, &header, sizeof(header));
+
+    uint8_t* cursor = buffer + sizeof(header);
+    for (uint32_t i = 0; i < PROFILE_MAX_CONTRACTS; i++) {
+        const profile_entry_t* entry = &g_entries[i];
+        if (!entry->used) {
+            continue;
+        }
+        memcpy(cursor, &entry->summary, sizeof(entry->summary));
+        cursor += sizeof(entry->summary);
+        for (uint32_t j = 0; j < PROFILE_MAX_BLOCKS; j++) {
+            if (entry->blocks[j].reserved == BLOCK_SLOT_USED) {
+                profile_block_t block = entry->blocks[j];
+                block.reserved = 0;
+                memcpy(cursor, &block, sizeof(block));
+                cursor += sizeof(block);
+            }
+        }
+    }
+
+    if (reset) {
+        memset(g_entries, 0, sizeof(g_entries));
+        g_contract_count = 0;
+        g_executions_dropped = 0;
+        g_profiled_executions = 0;
+    }
+
+    sgx_spin_unlock(&g_profile_lock);
+    return SGX_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#ifndef EXEC_PROFILE_H
+#define EXEC_PROFILE_H
+
+#include "enclave.h"
+#include "enclave_shared.h"
+#include "contract_decoder.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 执行剖析：开启后每次执行在当前线程的记录中累加操作码、基本块和Gas，
+// 执行结束后按字节码哈希合并到全局表（只在合并时加锁）。
+// 剖析由解码解释器的逐条检查路径完成，线程化分派和JIT的快速路径不受影响
+
+// 单次执行的剖析记录（线程局部）
+typedef struct exec_profile_record {
+    uint64_t opcode_counts[PROFILE_OPCODE_SLOTS];
+    uint64_t opcode_cycles[PROFILE_OPCODE_SLOTS];
+    profile_block_t blocks[PROFILE_MAX_BLOCKS];   // 按块首偏移开放寻址
+    uint32_t blocks_dropped;
+    uint32_t current_block;                       // 当前块在blocks中的下标（PROFILE_MAX_BLOCKS表示未统计）
+    bool cycles;                                  // 是否统计周期数
+} exec_profile_record_t;
+
+/**
+ * 设置剖析标志
+ * @param flags PROFILE_FLAG_*组合（0表示关闭）
+ */
+void exec_profile_configure(uint32_t flags);
+
+/**
+ * 获取剖析标志
+ * @return PROFILE_FLAG_*组合
+ */
+uint32_t exec_profile_flags(void);
+
+/**
+ * 清空当前线程的剖析记录，开始一次执行的统计
+ * @param cycles 是否统计周期数
+ * @return 记录（供context->profile使用）
+ */
+exec_profile_record_t* exec_profile_begin(bool cycles);
+
+/**
+ * 读取时间戳计数器（未启用周期统计时不应调用）
+ * @return 周期数
+ */
+static inline uint64_t exec_profile_cycles(void) {
+    uint32_t low, high;
+    __asm__ __volatile__("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * 记录进入基本块（解码解释器遇到DECODED_OP_BLOCK时调用）
+ * @param record 剖析记录
+ * @param start_pc 块首指令的字节码偏移
+ */
+void exec_profile_enter_block(exec_profile_record_t* record, uint32_t start_pc);
+
+/**
+ * 从快照在块中间恢复执行时设置当前块，其余指令的Gas计入该块（不计为一次块入口）
+ * @param record 剖析记录
+ * @param start_pc 所在块块首指令的字节码偏移
+ */
+void exec_profile_resume_block(exec_profile_record_t* record, uint32_t start_pc);
+
+/**
+ * 记录执行完成的一条指令
+ * @param record 剖析记录
+ * @param opcode 操作码
+ * @param gas 指令消耗的Gas
+ * @param cycles 指令耗用的周期数（未统计时为0）
+ */
+static inline void exec_profile_instruction(exec_profile_record_t* record, uint32_t opcode,
+                                            uint64_t gas, uint64_t cycles) {
+    uint32_t slot = profile_opcode_slot(opcode);
+    record->opcode_counts[slot]++;
+    record->opcode_cycles[slot] += cycles;
+    if (record->current_block < PROFILE_MAX_BLOCKS) {
+        record->blocks[record->current_block].gas_used += gas;
+    }
+}
+
+/**
+ * 把一次执行的记录合并到该合约的全局统计
+ * @param code_hash 字节码哈希
+ * @param record 剖析记录
+ * @param gas_used 本次执行消耗的Gas
+ * @param cycles 本次执行的周期数（未统计时为0）
+ */
+void exec_profile_commit(const sgx_sha256_hash_t* code_hash, const exec_profile_record_t* record,
+                         uint64_t gas_used, uint64_t cycles);
+
+/**
+ * 导出剖析快照（格式见enclave_shared.h），同时附带字节码缓存和状态缓存的命中统计
+ * @param buffer 输出缓冲区
+ * @param capacity 缓冲区大小（PROFILE_MAX_SNAPSHOT_SIZE总是足够）
+ * @param size 输出的快照大小（缓冲区不足时为所需大小）
+ * @param reset 导出后是否清空合约统计
+ * @return SGX状态码（缓冲区不足时为SGX_ERROR_INVALID_PARAMETER）
+ */
+sgx_status_t exec_profile_snapshot(uint8_t* buffer, size_t capacity, size_t* size, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXEC_PROFILE_H
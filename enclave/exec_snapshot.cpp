@@ -0,0 +1,162 @@
+#include "exec_snapshot.h"
+#include "exec_arena.h"
+#include "contract_verifier.h"
+#include "enclave.h"
+
+#include <sgx_tseal.h>
+#include <string.h>
+
+#define STACK_CAPACITY      (sizeof(((vm_stack_t*)0)->data) / sizeof(uint64_t))
+#define MAX_PLAINTEXT_SIZE  (sizeof(exec_snapshot_header_t) + \
+                             sizeof(((vm_stack_t*)0)->data) + \
+                             VM_MEMORY_SIZE)
+
+static_assert(sizeof(sgx_sealed_data_t) + MAX_PLAINTEXT_SIZE <= EXEC_SNAPSHOT_MAX_SEALED_SIZE,
+              "EXEC_SNAPSHOT_MAX_SEALED_SIZE cannot hold a full snapshot");
+
+/**
+ * 快照明文大小
+ */
+static size_t plaintext_size(uint64_t stack_top, uint64_t dirty_pages) {
+    return sizeof(exec_snapshot_header_t) + stack_top * sizeof(uint64_t) +
+           (size_t)__builtin_popcountll(dirty_pages) * VM_MEMORY_PAGE_SIZE;
+}
+
+/**
+ * 密封执行快照
+ */
+sgx_status_t exec_snapshot_seal(
+    const contract_execution_context_t* context,
+    const sgx_sha256_hash_t* input_hash,
+    uint64_t gas_limit,
+    uint32_t flags,
+    uint64_t state_version,
+    uint8_t* sealed,
+    size_t capacity,
+    size_t* sealed_size
+) {
+    if (!context || !context->code_hash || !sealed || !sealed_size) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    exec_snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.version = EXEC_SNAPSHOT_VERSION;
+    header.flags = flags;
+    header.pc = context->pc;
+    header.gas_used = context->gas_used;
+    header.gas_limit = gas_limit;
+    header.stack_top = context->stack.top;
+    header.dirty_pages = context->dirty_pages;
+    header.state_version = state_version;
+    header.input_offset = context->input_offset;
+    memcpy(header.code_hash, *context->code_hash, sizeof(header.code_hash));
+    if (input_hash) {
+        memcpy(header.input_hash, *input_hash, sizeof(header.input_hash));
+    }
+
+    size_t size = plaintext_size(header.stack_top, header.dirty_pages);
+    uint32_t required_size = sgx_calc_sealed_data_size(0, (uint32_t)size);
+    *sealed_size = required_size;
+    if (required_size == UINT32_MAX || capacity < required_size) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t* plaintext = (uint8_t*)exec_scratch_alloc(size);
+    if (!plaintext) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    // 只保存栈上的有效元素和写过的内存页
+    uint8_t* cursor = plaintext;
+    memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+    memcpy(cursor, context->stack.data, header.stack_top * sizeof(uint64_t));
+    cursor += header.stack_top * sizeof(uint64_t);
+    for (uint64_t dirty = header.dirty_pages; dirty; dirty &= dirty - 1) {
+        size_t page = (size_t)__builtin_ctzll(dirty);
+        memcpy(cursor, context->memory_pages[page], VM_MEMORY_PAGE_SIZE);
+        cursor += VM_MEMORY_PAGE_SIZE;
+    }
+
+    sgx_status_t ret = sgx_seal_data(0, NULL, (uint32_t)size, plaintext,
+                                     required_size, (sgx_sealed_data_t*)sealed);
+    secure_memzero(plaintext, size);
+    exec_scratch_free(plaintext);
+
+    return ret;
+}
+
+/**
+ * 解封快照并恢复执行上下文
+ */
+sgx_status_t exec_snapshot_restore(
+    const uint8_t* sealed,
+    size_t sealed_size,
+    contract_execution_context_t* context,
+    const sgx_sha256_hash_t* input_hash,
+    exec_snapshot_header_t* header
+) {
+    if (!sealed || !context || !context->code_hash || !header ||
+        sealed_size < sizeof(sgx_sealed_data_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    const sgx_sealed_data_t* blob = (const sgx_sealed_data_t*)sealed;
+    uint32_t size = sgx_get_encrypt_txt_len(blob);
+    if (sgx_get_add_mac_txt_len(blob) != 0 || size < sizeof(exec_snapshot_header_t) ||
+        size > MAX_PLAINTEXT_SIZE || sealed_size < sgx_calc_sealed_data_size(0, size)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t* plaintext = (uint8_t*)exec_scratch_alloc(size);
+    if (!plaintext) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    uint32_t unsealed_size = size;
+    sgx_status_t ret = sgx_unseal_data(blob, NULL, NULL, plaintext, &unsealed_size);
+    if (ret == SGX_SUCCESS) {
+        memcpy(header, plaintext, sizeof(*header));
+
+        sgx_sha256_hash_t expected_input;
+        memset(expected_input, 0, sizeof(expected_input));
+        if (input_hash) {
+            memcpy(expected_input, *input_hash, sizeof(expected_input));
+        }
+
+        // 密封保证快照由本Enclave产生，这里检查它属于同一次执行
+        uint64_t page_mask = (VM_MEMORY_PAGE_COUNT >= 64) ? ~0ull : ((1ull << VM_MEMORY_PAGE_COUNT) - 1);
+        if (unsealed_size != size || header->version != EXEC_SNAPSHOT_VERSION ||
+            header->stack_top > STACK_CAPACITY || (header->dirty_pages & ~page_mask) != 0 ||
+            plaintext_size(header->stack_top, header->dirty_pages) != size ||
+            header->gas_used > header->gas_limit || header->pc > context->code_size ||
+            header->input_offset > context->input_size ||
+            memcmp(header->code_hash, *context->code_hash, sizeof(header->code_hash)) != 0 ||
+            memcmp(header->input_hash, expected_input, sizeof(expected_input)) != 0) {
+            ret = SGX_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    if (ret == SGX_SUCCESS) {
+        const uint8_t* cursor = plaintext + sizeof(*header);
+        context->pc = (size_t)header->pc;
+        context->gas_used = header->gas_used;
+        context->input_offset = header->input_offset;
+        context->stack.top = (size_t)header->stack_top;
+        memcpy(context->stack.data, cursor, header->stack_top * sizeof(uint64_t));
+        cursor += header->stack_top * sizeof(uint64_t);
+
+        reset_contract_memory(context);
+        for (uint64_t dirty = header->dirty_pages; dirty && ret == SGX_SUCCESS; dirty &= dirty - 1) {
+            size_t page = (size_t)__builtin_ctzll(dirty);
+            ret = vm_memory_write(context, page * VM_MEMORY_PAGE_SIZE, cursor, VM_MEMORY_PAGE_SIZE);
+            cursor += VM_MEMORY_PAGE_SIZE;
+        }
+    }
+
+    secure_memzero(plaintext, size);
+    exec_scratch_free(plaintext);
+
+    return ret;
+}
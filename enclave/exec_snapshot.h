@@ -0,0 +1,85 @@
+#ifndef EXEC_SNAPSHOT_H
+#define EXEC_SNAPSHOT_H
+
+#include "enclave.h"
+#include "enclave_shared.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 快照明文格式版本
+#define EXEC_SNAPSHOT_VERSION       2
+
+// 快照标志
+#define EXEC_SNAPSHOT_FLAG_PERSISTENT   0x01    // 执行开始时启用了状态持久化
+
+/*
+ * 快照明文：头部 | 栈上的有效元素(stack_top * 8) | dirty_pages标记的内存页(每页VM_MEMORY_PAGE_SIZE)
+ * 按MRSIGNER策略密封，同一签名者的任一Enclave实例均可恢复
+ */
+typedef struct {
+    uint32_t version;                       // EXEC_SNAPSHOT_VERSION
+    uint32_t flags;                         // 快照标志
+    uint64_t pc;                            // 下一条待执行指令的偏移
+    uint64_t gas_used;                      // 已使用Gas
+    uint64_t gas_limit;                     // 整个执行的Gas限制
+    uint64_t stack_top;                     // 栈上的元素数量
+    uint64_t dirty_pages;                   // 快照包含的内存页位图
+    uint64_t state_version;                 // 执行开始时合约状态的版本（未启用持久化时为0）
+    uint64_t input_offset;                  // OP_INPUT的读取位置
+    sgx_sha256_hash_t code_hash;            // 字节码哈希
+    sgx_sha256_hash_t input_hash;           // 输入哈希（输入为空时全零）
+} exec_snapshot_header_t;
+
+/**
+ * 把挂起的执行上下文密封为快照
+ * @param context 执行上下文（pc指向下一条待执行的指令）
+ * @param input_hash 输入哈希（输入为空时为NULL）
+ * @param gas_limit 整个执行的Gas限制
+ * @param flags 快照标志
+ * @param state_version 执行开始时合约状态的版本
+ * @param sealed 输出缓冲区
+ * @param capacity 缓冲区大小（不小于EXEC_SNAPSHOT_MAX_SEALED_SIZE时总能放下）
+ * @param sealed_size 输出快照大小
+ * @return SGX状态码
+ */
+sgx_status_t exec_snapshot_seal(
+    const contract_execution_context_t* context,
+    const sgx_sha256_hash_t* input_hash,
+    uint64_t gas_limit,
+    uint32_t flags,
+    uint64_t state_version,
+    uint8_t* sealed,
+    size_t capacity,
+    size_t* sealed_size
+);
+
+/**
+ * 解封快照并恢复执行上下文的pc、已用Gas、输入读取位置、栈和内存
+ * 快照必须由同一字节码和输入产生，否则返回SGX_ERROR_INVALID_PARAMETER
+ * @param sealed 密封的快照
+ * @param sealed_size 快照大小
+ * @param context 执行上下文（已设置code_hash等参数，内存满足dirty_pages约定）
+ * @param input_hash 输入哈希（输入为空时为NULL）
+ * @param header 输出快照头部
+ * @return SGX状态码
+ */
+sgx_status_t exec_snapshot_restore(
+    const uint8_t* sealed,
+    size_t sealed_size,
+    contract_execution_context_t* context,
+    const sgx_sha256_hash_t* input_hash,
+    exec_snapshot_header_t* header
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EXEC_SNAPSHOT_H
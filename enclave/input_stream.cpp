@@ -0,0 +1,107 @@
+#include "input_stream.h"
+
+#include <sgx_trts.h>
+#include <string.h>
+#include <stdlib.h>
+
+// 复制输入时每次哈希的块大小（与copy_and_hash_input相同，哈希读取的副本仍在缓存中）
+#define INPUT_STREAM_HASH_CHUNK     (4 * 1024)
+
+/**
+ * 初始化流式输入
+ */
+sgx_status_t input_stream_init(input_stream_t* stream) {
+    if (!stream) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(stream, 0, sizeof(*stream));
+    stream->window = (uint8_t*)malloc(INPUT_STREAM_WINDOW_SIZE);
+    if (!stream->window) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    sgx_status_t ret = sgx_sha256_init(&stream->sha_handle);
+    if (ret != SGX_SUCCESS) {
+        free(stream->window);
+        stream->window = NULL;
+        stream->sha_handle = NULL;
+    }
+    return ret;
+}
+
+/**
+ * 丢弃已读取的部分并追加新块
+ */
+sgx_status_t input_stream_append(input_stream_t* stream, uint64_t read_offset,
+                                 const uint8_t* chunk, size_t size, bool final) {
+    if (!stream || !stream->window || stream->final || size > INPUT_STREAM_MAX_CHUNK ||
+        (size > 0 && (!chunk || !sgx_is_outside_enclave(chunk, size)))) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    if (read_offset < stream->window_offset || read_offset > stream->window_offset + stream->window_size) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 未读取的尾部移到窗口起始处
+    size_t consumed = (size_t)(read_offset - stream->window_offset);
+    size_t tail = stream->window_size - consumed;
+    if (tail + size > INPUT_STREAM_WINDOW_SIZE) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    memmove(stream->window, stream->window + consumed, tail);
+    stream->window_offset = read_offset;
+    stream->window_size = tail;
+
+    sgx_status_t ret = SGX_SUCCESS;
+    for (size_t offset = 0; offset < size && ret == SGX_SUCCESS; offset += INPUT_STREAM_HASH_CHUNK) {
+        size_t length = size - offset < INPUT_STREAM_HASH_CHUNK ? size - offset : INPUT_STREAM_HASH_CHUNK;
+        uint8_t* copy = stream->window + stream->window_size;
+        memcpy(copy, chunk + offset, length);
+        stream->window_size += length;
+        ret = sgx_sha256_update(copy, (uint32_t)length, stream->sha_handle);
+    }
+    // 之后的错误不能报告为参数错误，调用方据此区分流是否还可以继续使用
+    if (ret != SGX_SUCCESS) {
+        return ret == SGX_ERROR_INVALID_PARAMETER ? SGX_ERROR_UNEXPECTED : ret;
+    }
+    stream->total_size += size;
+
+    if (final) {
+        ret = sgx_sha256_get_hash(stream->sha_handle, &stream->input_hash);
+        if (ret != SGX_SUCCESS) {
+            return ret == SGX_ERROR_INVALID_PARAMETER ? SGX_ERROR_UNEXPECTED : ret;
+        }
+        sgx_sha256_close(stream->sha_handle);
+        stream->sha_handle = NULL;
+        stream->final = true;
+    }
+    return SGX_SUCCESS;
+}
+
+/**
+ * 获取已送达的输入
+ */
+size_t input_stream_available(const input_stream_t* stream, uint64_t offset, const uint8_t** data) {
+    uint64_t end = stream->window_offset + stream->window_size;
+    if (offset < stream->window_offset || offset >= end) {
+        *data = NULL;
+        return 0;
+    }
+    *data = stream->window + (size_t)(offset - stream->window_offset);
+    return (size_t)(end - offset);
+}
+
+/**
+ * 释放流式输入
+ */
+void input_stream_free(input_stream_t* stream) {
+    if (!stream) {
+        return;
+    }
+    if (stream->sha_handle) {
+        sgx_sha256_close(stream->sha_handle);
+    }
+    free(stream->window);
+    memset(stream, 0, sizeof(*stream));
+}
@@ -0,0 +1,69 @@
+#ifndef INPUT_STREAM_H
+#define INPUT_STREAM_H
+
+#include "enclave.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 流式输入的窗口：上一块中合约尚未读取的尾部 | 新送入的块。
+// 合约只在OP_INPUT请求的字节（不超过VM_MEMORY_SIZE）尚未全部送达时等待，
+// 因此送入新块时保留的尾部小于VM_MEMORY_SIZE，窗口大小固定
+#define INPUT_STREAM_WINDOW_SIZE    (VM_MEMORY_SIZE + INPUT_STREAM_MAX_CHUNK)
+
+// 流式输入
+typedef struct input_stream {
+    uint8_t* window;                        // 窗口缓冲区（INPUT_STREAM_WINDOW_SIZE）
+    size_t window_size;                     // 窗口中的有效字节数
+    uint64_t window_offset;                 // 窗口起始处在输入中的偏移
+    uint64_t total_size;                    // 已送入的字节数
+    bool final;                             // 是否已送入最后一块
+    sgx_sha_state_handle_t sha_handle;      // 输入哈希的增量状态（final后关闭）
+    sgx_sha256_hash_t input_hash;           // 输入哈希（final后有效）
+} input_stream_t;
+
+/**
+ * 初始化流式输入
+ * @param stream 流式输入
+ * @return SGX状态码
+ */
+sgx_status_t input_stream_init(input_stream_t* stream);
+
+/**
+ * 丢弃已读取的部分后把新块复制到窗口末尾，复制的同时计入输入哈希；final为true时完成输入哈希
+ * @param stream 流式输入
+ * @param read_offset 合约的读取位置（之前的字节不再需要）
+ * @param chunk 输入块（位于不可信内存）
+ * @param size 块大小（不超过INPUT_STREAM_MAX_CHUNK）
+ * @param final 是否为最后一块
+ * @return SGX状态码（SGX_ERROR_INVALID_PARAMETER表示参数被拒绝且流未改变，其他错误时输入哈希可能已计入部分数据）
+ */
+sgx_status_t input_stream_append(input_stream_t* stream, uint64_t read_offset,
+                                 const uint8_t* chunk, size_t size, bool final);
+
+/**
+ * 获取从指定位置开始已送达的输入
+ * @param stream 流式输入
+ * @param offset 输入中的偏移（不小于窗口起始处）
+ * @param data 输出数据指针
+ * @return 可读取的字节数
+ */
+size_t input_stream_available(const input_stream_t* stream, uint64_t offset, const uint8_t** data);
+
+/**
+ * 释放流式输入
+ * @param stream 流式输入
+ */
+void input_stream_free(input_stream_t* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INPUT_STREAM_H
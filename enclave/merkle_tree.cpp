@@ -0,0 +1,98 @@
+#include "merkle_tree.h"
+#include "crypto_utils.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+// 每次多缓冲哈希的节点数
+#define MERKLE_HASH_CHUNK   64
+
+/**
+ * 多缓冲计算一层节点：第i个输出为SHA256(prefix | 第arity*i个起的arity个输入)
+ * 每组消息先复制出来再计算，输出可以与输入重叠（out不超过in的位置）
+ */
+static sgx_status_t hash_level(uint8_t prefix, const uint8_t* in, uint32_t arity, uint32_t count, uint8_t* out) {
+    uint8_t messages[MERKLE_HASH_CHUNK][1 + 2 * SGX_SHA256_HASH_SIZE];
+    sha256_job_t jobs[MERKLE_HASH_CHUNK];
+    size_t message_size = 1 + (size_t)arity * SGX_SHA256_HASH_SIZE;
+    
+    for (uint32_t base = 0; base < count; base += MERKLE_HASH_CHUNK) {
+        uint32_t chunk = count - base < MERKLE_HASH_CHUNK ? count - base : MERKLE_HASH_CHUNK;
+        for (uint32_t i = 0; i < chunk; i++) {
+            messages[i][0] = prefix;
+            memcpy(messages[i] + 1, in + (size_t)(base + i) * arity * SGX_SHA256_HASH_SIZE,
+                   (size_t)arity * SGX_SHA256_HASH_SIZE);
+            jobs[i].data = messages[i];
+            jobs[i].size = message_size;
+            jobs[i].hash = out + (size_t)(base + i) * SGX_SHA256_HASH_SIZE;
+        }
+        
+        sgx_status_t ret = compute_sha256_multi(jobs, chunk);
+        if (ret != SGX_SUCCESS) {
+            return ret;
+        }
+    }
+    
+    return SGX_SUCCESS;
+}
+
+/**
+ * 计算执行哈希的Merkle根
+ */
+sgx_status_t merkle_compute_root(
+    const uint8_t* execution_hashes,
+    uint32_t leaf_count,
+    sgx_sha256_hash_t* root
+) {
+    if (!execution_hashes || !root || leaf_count == 0 || leaf_count > MERKLE_MAX_LEAVES) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    uint8_t* level = (uint8_t*)malloc((size_t)leaf_count * SGX_SHA256_HASH_SIZE);
+    if (!level) {
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    
+    sgx_status_t ret = hash_level(MERKLE_LEAF_PREFIX, execution_hashes, 1, leaf_count, level);
+    
+    // 逐层原地归并：第i个父节点只覆盖已读取过的位置
+    uint32_t count = leaf_count;
+    while (count > 1 && ret == SGX_SUCCESS) {
+        uint32_t pairs = count / 2;
+        ret = hash_level(MERKLE_NODE_PREFIX, level, 2, pairs, level);
+        if (count & 1) {
+            memmove(level + (size_t)pairs * SGX_SHA256_HASH_SIZE,
+                    level + (size_t)(count - 1) * SGX_SHA256_HASH_SIZE, SGX_SHA256_HASH_SIZE);
+        }
+        count = pairs + (count & 1);
+    }
+    
+    if (ret == SGX_SUCCESS) {
+        memcpy(root, level, SGX_SHA256_HASH_SIZE);
+    }
+    
+    free(level);
+    return ret;
+}
+
+/**
+ * 计算批量证明的签名对象
+ */
+sgx_status_t merkle_batch_digest(
+    const sgx_sha256_hash_t* root,
+    uint32_t leaf_count,
+    sgx_sha256_hash_t* digest
+) {
+    if (!root || !digest) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    
+    uint8_t buffer[1 + SGX_SHA256_HASH_SIZE + 4];
+    buffer[0] = MERKLE_ROOT_PREFIX;
+    memcpy(buffer + 1, root, SGX_SHA256_HASH_SIZE);
+    for (int i = 0; i < 4; i++) {
+        buffer[1 + SGX_SHA256_HASH_SIZE + i] = (uint8_t)(leaf_count >> (i * 8));
+    }
+    
+    return sgx_sha256_msg(buffer, sizeof(buffer), digest);
+}
@@ -0,0 +1,46 @@
+#ifndef MERKLE_TREE_H
+#define MERKLE_TREE_H
+
+#include "enclave_shared.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 树的构造规则见enclave_shared.h中的MERKLE_*定义
+
+/**
+ * 计算执行哈希的Merkle根
+ * @param execution_hashes 连续存放的执行哈希（每个32字节）
+ * @param leaf_count 执行哈希数量（1到MERKLE_MAX_LEAVES）
+ * @param root 输出Merkle根
+ * @return SGX状态码
+ */
+sgx_status_t merkle_compute_root(
+    const uint8_t* execution_hashes,
+    uint32_t leaf_count,
+    sgx_sha256_hash_t* root
+);
+
+/**
+ * 计算批量证明的签名对象（绑定Merkle根和叶子数量）
+ * @param root Merkle根
+ * @param leaf_count 叶子数量
+ * @param digest 输出摘要
+ * @return SGX状态码
+ */
+sgx_status_t merkle_batch_digest(
+    const sgx_sha256_hash_t* root,
+    uint32_t leaf_count,
+    sgx_sha256_hash_t* digest
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MERKLE_TREE_H
@@ -0,0 +1,305 @@
+#include "result_cache.h"
+#include "enclave.h"
+
+#include <sgx_tcrypto.h>
+#include <sgx_spinlock.h>
+#include <string.h>
+#include <stdlib.h>
+
+// 缓存项，结果数据紧跟在结构之后分配
+typedef struct result_cache_entry {
+    sgx_sha256_hash_t key;                  // 缓存键
+    uint8_t execution_hash[HASH_SIZE];      // 执行哈希
+    uint64_t gas_used;                      // Gas使用量
+    size_t result_size;                     // 结果大小
+    size_t footprint;                       // 占用内存
+    bool has_proof;                         // 是否已附上签名证明
+    execution_proof_t proof;                // 已签名的执行证明
+    struct result_cache_entry* lru_prev;    // LRU链表（头部为最近使用）
+    struct result_cache_entry* lru_next;
+    struct result_cache_entry* key_next;    // 按缓存键的哈希桶链表
+    struct result_cache_entry* hash_next;   // 按执行哈希的哈希桶链表
+} result_cache_entry_t;
+
+// 缓存全局状态（由g_result_lock保护，g_enabled另以原子方式读取）
+static sgx_spinlock_t g_result_lock = SGX_SPINLOCK_INITIALIZER;
+static uint32_t g_enabled = 0;
+static result_cache_entry_t* g_key_buckets[RESULT_CACHE_BUCKET_COUNT];
+static result_cache_entry_t* g_hash_buckets[RESULT_CACHE_BUCKET_COUNT];
+static result_cache_entry_t* g_lru_head = NULL;
+static result_cache_entry_t* g_lru_tail = NULL;
+static result_cache_stats_t g_stats;
+
+/**
+ * 计算哈希桶索引（SHA-256输出本身分布均匀，直接取前4字节）
+ */
+static size_t bucket_index(const uint8_t* hash) {
+    uint32_t prefix;
+    memcpy(&prefix, hash, sizeof(prefix));
+    return prefix % RESULT_CACHE_BUCKET_COUNT;
+}
+
+static uint8_t* entry_result(result_cache_entry_t* entry) {
+    return (uint8_t*)(entry + 1);
+}
+
+static void lru_unlink(result_cache_entry_t* entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        g_lru_head = entry->lru_next;
+    }
+
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        g_lru_tail = entry->lru_prev;
+    }
+
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void lru_push_front(result_cache_entry_t* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = g_lru_head;
+    if (g_lru_head) {
+        g_lru_head->lru_prev = entry;
+    }
+    g_lru_head = entry;
+    if (!g_lru_tail) {
+        g_lru_tail = entry;
+    }
+}
+
+static result_cache_entry_t* find_entry(const sgx_sha256_hash_t* key) {
+    result_cache_entry_t* entry = g_key_buckets[bucket_index(*key)];
+    while (entry) {
+        if (memcmp(entry->key, *key, sizeof(sgx_sha256_hash_t)) == 0) {
+            return entry;
+        }
+        entry = entry->key_next;
+    }
+    return NULL;
+}
+
+/**
+ * 从两个哈希桶和LRU链表中移除并释放缓存项
+ */
+static void remove_entry(result_cache_entry_t* entry) {
+    result_cache_entry_t** link = &g_key_buckets[bucket_index(entry->key)];
+    while (*link && *link != entry) {
+        link = &(*link)->key_next;
+    }
+    if (*link) {
+        *link = entry->key_next;
+    }
+
+    link = &g_hash_buckets[bucket_index(entry->execution_hash)];
+    while (*link && *link != entry) {
+        link = &(*link)->hash_next;
+    }
+    if (*link) {
+        *link = entry->hash_next;
+    }
+
+    lru_unlink(entry);
+
+    g_stats.bytes_used -= entry->footprint;
+    g_stats.entry_count--;
+    free(entry);
+}
+
+/**
+ * 从LRU尾部淘汰缓存项，直到腾出所需空间（缓存项只在锁内被读取，没有外部引用）
+ */
+static bool evict_for(size_t required) {
+    while (g_stats.bytes_used + required > g_stats.budget && g_lru_tail) {
+        remove_entry(g_lru_tail);
+        g_stats.evictions++;
+    }
+
+    return g_stats.bytes_used + required <= g_stats.budget;
+}
+
+/**
+ * 调整内存预算
+ */
+void result_cache_set_budget(size_t budget) {
+    sgx_spin_lock(&g_result_lock);
+    g_stats.budget = budget;
+    evict_for(0);
+    __atomic_store_n(&g_enabled, budget > 0 ? 1u : 0u, __ATOMIC_RELAXED);
+    sgx_spin_unlock(&g_result_lock);
+}
+
+/**
+ * 检查结果缓存是否开启
+ */
+bool result_cache_enabled(void) {
+    return __atomic_load_n(&g_enabled, __ATOMIC_RELAXED) != 0;
+}
+
+/**
+ * 计算缓存键
+ */
+sgx_status_t result_cache_key(
+    const sgx_sha256_hash_t* code_hash,
+    const sgx_sha256_hash_t* input_hash,
+    uint64_t gas_limit,
+    sgx_sha256_hash_t* key
+) {
+    if (!code_hash || !key) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 空输入以全零哈希占位，键的长度固定
+    uint8_t message[sizeof(sgx_sha256_hash_t) * 2 + sizeof(uint64_t)];
+    memcpy(message, *code_hash, sizeof(sgx_sha256_hash_t));
+    if (input_hash) {
+        memcpy(message + sizeof(sgx_sha256_hash_t), *input_hash, sizeof(sgx_sha256_hash_t));
+    } else {
+        memset(message + sizeof(sgx_sha256_hash_t), 0, sizeof(sgx_sha256_hash_t));
+    }
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        message[sizeof(sgx_sha256_hash_t) * 2 + i] = (uint8_t)(gas_limit >> (8 * i));
+    }
+
+    return sgx_sha256_msg(message, sizeof(message), key);
+}
+
+/**
+ * 查找缓存的执行
+ */
+bool result_cache_lookup(const sgx_sha256_hash_t* key, contract_execution_context_t* context) {
+    if (!key || !context || !context->result_data) {
+        return false;
+    }
+
+    sgx_spin_lock(&g_result_lock);
+
+    result_cache_entry_t* found = find_entry(key);
+    if (!found) {
+        g_stats.misses++;
+        sgx_spin_unlock(&g_result_lock);
+        return false;
+    }
+
+    lru_unlink(found);
+    lru_push_front(found);
+    g_stats.hits++;
+
+    memcpy(context->result_data, entry_result(found), found->result_size);
+    context->result_size = found->result_size;
+    context->gas_used = found->gas_used;
+    memcpy(context->execution_hash, found->execution_hash, HASH_SIZE);
+    context->state = CONTRACT_STATE_COMPLETED;
+
+    sgx_spin_unlock(&g_result_lock);
+    return true;
+}
+
+/**
+ * 插入成功完成的执行
+ */
+void result_cache_insert(const sgx_sha256_hash_t* key, const contract_execution_context_t* context) {
+    if (!key || !context || context->state != CONTRACT_STATE_COMPLETED || context->result_size > MAX_RESULT_SIZE) {
+        return;
+    }
+
+    size_t footprint = sizeof(result_cache_entry_t) + context->result_size;
+    result_cache_entry_t* created = (result_cache_entry_t*)malloc(footprint);
+    if (!created) {
+        return;
+    }
+
+    // 复制在锁外完成
+    memset(created, 0, sizeof(*created));
+    memcpy(created->key, *key, sizeof(sgx_sha256_hash_t));
+    memcpy(created->execution_hash, context->execution_hash, HASH_SIZE);
+    created->gas_used = context->gas_used;
+    created->result_size = context->result_size;
+    created->footprint = footprint;
+    memcpy(entry_result(created), context->result_data, context->result_size);
+
+    sgx_spin_lock(&g_result_lock);
+
+    // 并发的相同执行可能已插入
+    if (footprint > g_stats.budget || find_entry(key) || !evict_for(footprint)) {
+        sgx_spin_unlock(&g_result_lock);
+        free(created);
+        return;
+    }
+
+    size_t index = bucket_index(created->key);
+    created->key_next = g_key_buckets[index];
+    g_key_buckets[index] = created;
+    index = bucket_index(created->execution_hash);
+    created->hash_next = g_hash_buckets[index];
+    g_hash_buckets[index] = created;
+    lru_push_front(created);
+
+    g_stats.bytes_used += footprint;
+    g_stats.entry_count++;
+
+    sgx_spin_unlock(&g_result_lock);
+}
+
+/**
+ * 查找已签名的证明
+ */
+bool result_cache_find_proof(const uint8_t* execution_hash, execution_proof_t* proof) {
+    if (!execution_hash || !proof) {
+        return false;
+    }
+
+    sgx_spin_lock(&g_result_lock);
+
+    result_cache_entry_t* entry = g_hash_buckets[bucket_index(execution_hash)];
+    while (entry) {
+        if (entry->has_proof && memcmp(entry->execution_hash, execution_hash, HASH_SIZE) == 0) {
+            memcpy(proof, &entry->proof, sizeof(*proof));
+            g_stats.proof_hits++;
+            sgx_spin_unlock(&g_result_lock);
+            return true;
+        }
+        entry = entry->hash_next;
+    }
+
+    sgx_spin_unlock(&g_result_lock);
+    return false;
+}
+
+/**
+ * 附上已签名的证明
+ */
+void result_cache_attach_proof(const execution_proof_t* proof) {
+    if (!proof) {
+        return;
+    }
+
+    sgx_spin_lock(&g_result_lock);
+
+    // Gas上限不同而结果相同的执行共享执行哈希，同一证明对它们都有效
+    result_cache_entry_t* entry = g_hash_buckets[bucket_index(proof->execution_hash)];
+    while (entry) {
+        if (!entry->has_proof && memcmp(entry->execution_hash, proof->execution_hash, HASH_SIZE) == 0) {
+            memcpy(&entry->proof, proof, sizeof(*proof));
+            entry->has_proof = true;
+        }
+        entry = entry->hash_next;
+    }
+
+    sgx_spin_unlock(&g_result_lock);
+}
+
+/**
+ * 获取缓存统计
+ */
+void result_cache_get_stats(result_cache_stats_t* stats) {
+    if (stats) {
+        sgx_spin_lock(&g_result_lock);
+        memcpy(stats, &g_stats, sizeof(g_stats));
+        sgx_spin_unlock(&g_result_lock);
+    }
+}
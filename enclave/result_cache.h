@@ -0,0 +1,98 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "enclave.h"
+
+#include <sgx_tcrypto.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 确定性执行的结果缓存：未启用状态持久化时，合约的执行结果只由字节码、输入和Gas上限决定，
+// 相同的三元组直接返回缓存的结果、Gas和执行哈希，已签名的执行证明附在缓存项上一并复用。
+// 只缓存成功完成的执行，所有接口均为线程安全
+
+#define RESULT_CACHE_BUCKET_COUNT   1024
+
+// 缓存统计
+typedef struct {
+    uint64_t hits;                          // 命中次数
+    uint64_t misses;                        // 未命中次数
+    uint64_t evictions;                     // 淘汰次数
+    uint64_t proof_hits;                    // 复用已签名证明的次数
+    size_t entry_count;                     // 缓存项数量
+    size_t bytes_used;                      // 已用内存
+    size_t budget;                          // 内存预算（0表示关闭）
+} result_cache_stats_t;
+
+/**
+ * 调整内存预算，超出新预算的缓存项立即淘汰
+ * @param budget 内存预算（字节，0表示关闭并清空缓存）
+ */
+void result_cache_set_budget(size_t budget);
+
+/**
+ * 检查结果缓存是否开启（不加锁，供执行路径快速跳过）
+ * @return 是否开启
+ */
+bool result_cache_enabled(void);
+
+/**
+ * 计算缓存键 SHA256(字节码哈希 | 输入哈希 | Gas上限(小端64位))
+ * @param code_hash 字节码哈希
+ * @param input_hash 输入哈希（为NULL表示空输入）
+ * @param gas_limit Gas上限
+ * @param key 输出的缓存键
+ * @return SGX状态码
+ */
+sgx_status_t result_cache_key(
+    const sgx_sha256_hash_t* code_hash,
+    const sgx_sha256_hash_t* input_hash,
+    uint64_t gas_limit,
+    sgx_sha256_hash_t* key
+);
+
+/**
+ * 查找缓存的执行，命中时把结果、Gas和执行哈希写入上下文并置为CONTRACT_STATE_COMPLETED
+ * @param key 缓存键
+ * @param context 执行上下文（result_data须能容纳MAX_RESULT_SIZE）
+ * @return 是否命中
+ */
+bool result_cache_lookup(const sgx_sha256_hash_t* key, contract_execution_context_t* context);
+
+/**
+ * 插入成功完成的执行（空间不足或已存在时忽略）
+ * @param key 缓存键
+ * @param context 已完成的执行上下文
+ */
+void result_cache_insert(const sgx_sha256_hash_t* key, const contract_execution_context_t* context);
+
+/**
+ * 查找执行哈希对应的已签名证明
+ * @param execution_hash 执行哈希
+ * @param proof 输出的证明
+ * @return 是否找到
+ */
+bool result_cache_find_proof(const uint8_t* execution_hash, execution_proof_t* proof);
+
+/**
+ * 把已签名的证明附到执行哈希相同的缓存项上（没有对应缓存项时忽略）
+ * @param proof 证明
+ */
+void result_cache_attach_proof(const execution_proof_t* proof);
+
+/**
+ * 获取缓存统计
+ * @param stats 输出统计
+ */
+void result_cache_get_stats(result_cache_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RESULT_CACHE_H
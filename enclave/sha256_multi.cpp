@@ -0,0 +1,366 @@
+#include "crypto_utils.h"
+
+#include <sgx_cpuid.h>
+#include <string.h>
+
+// 多缓冲SHA-256：SIMD核心每次压缩各路的一个消息块，调度器在某一路的消息处理完后换入下一条消息。
+// Enclave以-nostdinc编译，没有intrinsics头文件，核心使用GCC向量扩展和内建函数，
+// 各核心以target属性单独启用指令集，运行时按CPU特性选择
+
+#define SHA256_BLOCK_SIZE       64
+#define SHA256_MAX_LANES        16
+#define SHA256_SMALL_BATCH      4       // 少于此数量的消息不使用多路核心
+
+typedef uint32_t u32x4 __attribute__((vector_size(16)));
+typedef int i32x4 __attribute__((vector_size(16)));
+typedef uint8_t u8x16 __attribute__((vector_size(16)));
+typedef uint32_t u32x8 __attribute__((vector_size(32)));
+typedef uint32_t u32x16 __attribute__((vector_size(64)));
+
+static const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t IV256[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// CPUID经OCALL由主机提供，结果不可信：虚报的特性只会导致非法指令异常（主机本来就能拒绝服务），
+// 不会影响哈希结果。XGETBV在Enclave内返回的是XFRM，即Enclave实际启用的寄存器状态
+static uint32_t g_supported_engines = 1u << SHA256_ENGINE_GENERIC;
+static uint32_t g_engine = SHA256_ENGINE_GENERIC;
+
+static uint32_t load_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void store_be32(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+
+static size_t padded_block_count(size_t size) {
+    return (size + 9 + SHA256_BLOCK_SIZE - 1) / SHA256_BLOCK_SIZE;
+}
+
+/**
+ * 消息填充后的第index块：完整的数据块直接指向消息，其余在pad中构造
+ */
+static const uint8_t* message_block(const sha256_job_t* job, size_t index, size_t block_count, uint8_t* pad) {
+    size_t offset = index * SHA256_BLOCK_SIZE;
+    if (offset + SHA256_BLOCK_SIZE <= job->size) {
+        return job->data + offset;
+    }
+
+    memset(pad, 0, SHA256_BLOCK_SIZE);
+    if (offset <= job->size) {
+        if (job->size > offset) {
+            memcpy(pad, job->data + offset, job->size - offset);
+        }
+        pad[job->size - offset] = 0x80;
+    }
+    if (index == block_count - 1) {
+        uint64_t bits = (uint64_t)job->size * 8;
+        store_be32(pad + 56, (uint32_t)(bits >> 32));
+        store_be32(pad + 60, (uint32_t)bits);
+    }
+    return pad;
+}
+
+/**
+ * SHA扩展指令：压缩连续的blocks个消息块
+ */
+__attribute__((target("sha,sse4.1")))
+static void sha256_shani_blocks(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    const u8x16 bswap = { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+    u32x4 abcd, efgh;
+    memcpy(&abcd, state, sizeof(abcd));
+    memcpy(&efgh, state + 4, sizeof(efgh));
+
+    // sha256rnds2的状态排列为ABEF和CDGH（从高到低）
+    u32x4 abef = __builtin_shuffle(abcd, efgh, (u32x4){ 5, 4, 1, 0 });
+    u32x4 cdgh = __builtin_shuffle(abcd, efgh, (u32x4){ 7, 6, 3, 2 });
+
+    for (; blocks > 0; blocks--, data += SHA256_BLOCK_SIZE) {
+        u32x4 abef_save = abef;
+        u32x4 cdgh_save = cdgh;
+        u32x4 w[4];
+
+#pragma GCC unroll 16
+        for (int g = 0; g < 16; g++) {
+            u32x4 m;
+            if (g < 4) {
+                u8x16 bytes;
+                memcpy(&bytes, data + g * 16, sizeof(bytes));
+                m = (u32x4)__builtin_shuffle(bytes, bswap);
+            } else {
+                // W[t] = σ1(W[t-2]) + W[t-7] + σ0(W[t-15]) + W[t-16]，4个一组
+                u32x4 x = (u32x4)__builtin_ia32_sha256msg1((i32x4)w[g & 3], (i32x4)w[(g + 1) & 3]);
+                x += __builtin_shuffle(w[(g + 2) & 3], w[(g + 3) & 3], (u32x4){ 1, 2, 3, 4 });
+                m = (u32x4)__builtin_ia32_sha256msg2((i32x4)x, (i32x4)w[(g + 3) & 3]);
+            }
+            w[g & 3] = m;
+
+            u32x4 k;
+            memcpy(&k, K256 + g * 4, sizeof(k));
+            u32x4 wk = m + k;
+            cdgh = (u32x4)__builtin_ia32_sha256rnds2((i32x4)cdgh, (i32x4)abef, (i32x4)wk);
+            wk = __builtin_shuffle(wk, (u32x4){ 2, 3, 0, 1 });
+            abef = (u32x4)__builtin_ia32_sha256rnds2((i32x4)abef, (i32x4)cdgh, (i32x4)wk);
+        }
+
+        abef += abef_save;
+        cdgh += cdgh_save;
+    }
+
+    abcd = __builtin_shuffle(abef, cdgh, (u32x4){ 3, 2, 7, 6 });
+    efgh = __builtin_shuffle(abef, cdgh, (u32x4){ 1, 0, 5, 4 });
+    memcpy(state, &abcd, sizeof(abcd));
+    memcpy(state + 4, &efgh, sizeof(efgh));
+}
+
+/**
+ * 读取各路消息块并按字转置：words[j * lanes + l]为第l路的第j个字
+ */
+static void transpose_blocks(const uint8_t* const* blocks, unsigned lanes, uint32_t* words) {
+    for (unsigned l = 0; l < lanes; l++) {
+        for (unsigned j = 0; j < 16; j++) {
+            words[j * lanes + l] = load_be32(blocks[l] + j * 4);
+        }
+    }
+}
+
+#define ROR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+
+// 一轮压缩和消息扩展，AVX2和AVX-512核心共用（V为向量类型）
+#define SHA256_LANE_ROUNDS(V, state, words)                                     \
+    do {                                                                        \
+        V s[8], w[16];                                                          \
+        memcpy(s, state, sizeof(s));                                            \
+        memcpy(w, words, sizeof(w));                                            \
+        V a = s[0], b = s[1], c = s[2], d = s[3];                               \
+        V e = s[4], f = s[5], g = s[6], h = s[7];                               \
+        for (int t = 0; t < 64; t++) {                                          \
+            if (t >= 16) {                                                      \
+                V w15 = w[(t + 1) & 15], w2 = w[(t + 14) & 15];                 \
+                w[t & 15] += (ROR(w15, 7) ^ ROR(w15, 18) ^ (w15 >> 3)) +        \
+                             (ROR(w2, 17) ^ ROR(w2, 19) ^ (w2 >> 10)) +         \
+                             w[(t + 9) & 15];                                   \
+            }                                                                   \
+            V t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) +                  \
+                   ((e & f) ^ (~e & g)) + K256[t] + w[t & 15];                  \
+            V t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) +                      \
+                   ((a & b) ^ (c & (a ^ b)));                                   \
+            h = g; g = f; f = e; e = d + t1;                                    \
+            d = c; c = b; b = a; a = t1 + t2;                                   \
+        }                                                                       \
+        s[0] += a; s[1] += b; s[2] += c; s[3] += d;                             \
+        s[4] += e; s[5] += f; s[6] += g; s[7] += h;                             \
+        memcpy(state, s, sizeof(s));                                            \
+    } while (0)
+
+/**
+ * AVX2：8路各压缩一个消息块，state[w * 8 + l]为第l路的第w个状态字
+ */
+__attribute__((target("avx2")))
+static void sha256_avx2_x8(uint32_t* state, const uint8_t* const* blocks) {
+    uint32_t words[16 * 8];
+    transpose_blocks(blocks, 8, words);
+    SHA256_LANE_ROUNDS(u32x8, state, words);
+}
+
+/**
+ * AVX-512：16路各压缩一个消息块，state[w * 16 + l]为第l路的第w个状态字
+ */
+__attribute__((target("avx512f")))
+static void sha256_avx512_x16(uint32_t* state, const uint8_t* const* blocks) {
+    uint32_t words[16 * 16];
+    transpose_blocks(blocks, 16, words);
+    SHA256_LANE_ROUNDS(u32x16, state, words);
+}
+
+typedef void (*sha256_lanes_fn)(uint32_t* state, const uint8_t* const* blocks);
+
+/**
+ * 多路调度：每路处理一条消息，处理完后换入下一条，空闲的路压缩一个占位块
+ */
+static void hash_lanes(sha256_lanes_fn kernel, unsigned lanes, const sha256_job_t* jobs, size_t count) {
+    static const uint8_t idle_block[SHA256_BLOCK_SIZE] = { 0 };
+    uint32_t state[8 * SHA256_MAX_LANES];
+    uint8_t pad[SHA256_MAX_LANES][SHA256_BLOCK_SIZE];
+    const uint8_t* blocks[SHA256_MAX_LANES];
+    const sha256_job_t* lane_job[SHA256_MAX_LANES] = { NULL };
+    size_t lane_block[SHA256_MAX_LANES];
+    size_t lane_blocks[SHA256_MAX_LANES];
+    size_t next = 0;
+
+    while (true) {
+        unsigned active = 0;
+        for (unsigned l = 0; l < lanes; l++) {
+            if (!lane_job[l] && next < count) {
+                lane_job[l] = &jobs[next++];
+                lane_block[l] = 0;
+                lane_blocks[l] = padded_block_count(lane_job[l]->size);
+                for (unsigned w = 0; w < 8; w++) {
+                    state[w * lanes + l] = IV256[w];
+                }
+            }
+            if (lane_job[l]) {
+                blocks[l] = message_block(lane_job[l], lane_block[l], lane_blocks[l], pad[l]);
+                active++;
+            } else {
+                blocks[l] = idle_block;
+            }
+        }
+        if (active == 0) {
+            return;
+        }
+
+        kernel(state, blocks);
+
+        for (unsigned l = 0; l < lanes; l++) {
+            if (lane_job[l] && ++lane_block[l] == lane_blocks[l]) {
+                for (unsigned w = 0; w < 8; w++) {
+                    store_be32(lane_job[l]->hash + w * 4, state[w * lanes + l]);
+                }
+                lane_job[l] = NULL;
+            }
+        }
+    }
+}
+
+/**
+ * SHA扩展指令逐条处理：完整的数据块直接压缩，只有最后一到两块需要构造
+ */
+static void hash_shani(const sha256_job_t* jobs, size_t count) {
+    uint8_t pad[SHA256_BLOCK_SIZE];
+    for (size_t i = 0; i < count; i++) {
+        const sha256_job_t* job = &jobs[i];
+        uint32_t state[8];
+        memcpy(state, IV256, sizeof(state));
+
+        size_t full = job->size / SHA256_BLOCK_SIZE;
+        if (full > 0) {
+            sha256_shani_blocks(state, job->data, full);
+        }
+        size_t block_count = padded_block_count(job->size);
+        for (size_t b = full; b < block_count; b++) {
+            sha256_shani_blocks(state, message_block(job, b, block_count, pad), 1);
+        }
+
+        for (unsigned w = 0; w < 8; w++) {
+            store_be32(job->hash + w * 4, state[w]);
+        }
+    }
+}
+
+static uint64_t read_xcr0(void) {
+    uint32_t low, high;
+    __asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * 检测可用的SHA-256引擎
+ */
+uint32_t sha256_detect_engines(void) {
+    uint32_t supported = 1u << SHA256_ENGINE_GENERIC;
+    int leaf0[4], leaf1[4], leaf7[4];
+
+    if (sgx_cpuid(leaf0, 0) == SGX_SUCCESS && leaf0[0] >= 7 &&
+        sgx_cpuid(leaf1, 1) == SGX_SUCCESS && sgx_cpuidex(leaf7, 7, 0) == SGX_SUCCESS) {
+        uint32_t ecx1 = (uint32_t)leaf1[2];
+        uint32_t ebx7 = (uint32_t)leaf7[1];
+        bool sse41 = (ecx1 & (1u << 19)) != 0;
+        bool osxsave = (ecx1 & (1u << 27)) != 0;
+        uint64_t xcr0 = osxsave ? read_xcr0() : 0;
+
+        if (sse41 && (ebx7 & (1u << 29))) {
+            supported |= 1u << SHA256_ENGINE_SHANI;
+        }
+        if ((ebx7 & (1u << 5)) && (xcr0 & 0x06) == 0x06) {
+            supported |= 1u << SHA256_ENGINE_AVX2;
+        }
+        if ((ebx7 & (1u << 16)) && (xcr0 & 0xE6) == 0xE6) {
+            supported |= 1u << SHA256_ENGINE_AVX512;
+        }
+    }
+
+    __atomic_store_n(&g_supported_engines, supported, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_engine, 31 - __builtin_clz(supported), __ATOMIC_RELAXED);
+    return supported;
+}
+
+/**
+ * 设置SHA-256引擎
+ */
+sgx_status_t sha256_set_engine(uint32_t engine) {
+    if (engine > SHA256_ENGINE_AVX512 ||
+        !(__atomic_load_n(&g_supported_engines, __ATOMIC_RELAXED) & (1u << engine))) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    __atomic_store_n(&g_engine, engine, __ATOMIC_RELAXED);
+    return SGX_SUCCESS;
+}
+
+/**
+ * 获取当前SHA-256引擎
+ */
+uint32_t sha256_get_engine(void) {
+    return __atomic_load_n(&g_engine, __ATOMIC_RELAXED);
+}
+
+/**
+ * 多缓冲计算SHA256哈希
+ */
+sgx_status_t compute_sha256_multi(const sha256_job_t* jobs, size_t count) {
+    if (!jobs && count > 0) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if ((!jobs[i].data && jobs[i].size > 0) || !jobs[i].hash || jobs[i].size > UINT32_MAX) {
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    uint32_t engine = sha256_get_engine();
+    uint32_t supported = __atomic_load_n(&g_supported_engines, __ATOMIC_RELAXED);
+
+    // 消息很少时多路核心的大部分路空闲，改用单路
+    if (count < SHA256_SMALL_BATCH && (engine == SHA256_ENGINE_AVX2 || engine == SHA256_ENGINE_AVX512)) {
+        engine = (supported & (1u << SHA256_ENGINE_SHANI)) ? SHA256_ENGINE_SHANI : SHA256_ENGINE_GENERIC;
+    }
+
+    switch (engine) {
+        case SHA256_ENGINE_AVX512:
+            hash_lanes(sha256_avx512_x16, 16, jobs, count);
+            return SGX_SUCCESS;
+        case SHA256_ENGINE_AVX2:
+            hash_lanes(sha256_avx2_x8, 8, jobs, count);
+            return SGX_SUCCESS;
+        case SHA256_ENGINE_SHANI:
+            hash_shani(jobs, count);
+            return SGX_SUCCESS;
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        sgx_status_t ret = sgx_sha256_msg(jobs[i].data, (uint32_t)jobs[i].size,
+                                          (sgx_sha256_hash_t*)jobs[i].hash);
+        if (ret != SGX_SUCCESS) {
+            return ret;
+        }
+    }
+    return SGX_SUCCESS;
+}
@@ -0,0 +1,124 @@
+#include "slab_alloc.h"
+
+#include <sgx_spinlock.h>
+#include <string.h>
+#include <stdlib.h>
+
+// 大小类（均为16的倍数，保证对象对齐）
+static const size_t SLAB_CLASS_SIZES[] = {
+    32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, SLAB_MAX_OBJECT_SIZE
+};
+
+#define SLAB_CLASS_COUNT    (sizeof(SLAB_CLASS_SIZES) / sizeof(SLAB_CLASS_SIZES[0]))
+
+static_assert(SLAB_CHUNK_SIZE % SLAB_MAX_OBJECT_SIZE == 0, "chunk must hold whole objects of the largest class");
+
+// 空闲对象（复用对象自身的内存）
+typedef struct slab_free_object {
+    struct slab_free_object* next;
+} slab_free_object_t;
+
+// 大小类状态（由lock保护）
+typedef struct {
+    sgx_spinlock_t lock;
+    slab_free_object_t* free_list;
+    size_t chunks;
+    size_t in_use;
+} slab_class_t;
+
+static slab_class_t g_classes[SLAB_CLASS_COUNT];
+
+/**
+ * 查找大小类索引，超出范围时返回SLAB_CLASS_COUNT
+ */
+static size_t class_index(size_t size) {
+    if (size == 0) {
+        return SLAB_CLASS_COUNT;
+    }
+    for (size_t i = 0; i < SLAB_CLASS_COUNT; i++) {
+        if (size <= SLAB_CLASS_SIZES[i]) {
+            return i;
+        }
+    }
+    return SLAB_CLASS_COUNT;
+}
+
+/**
+ * 申请新块并切分到空闲链表（调用方持有该类的锁）
+ */
+static bool refill(slab_class_t* slab, size_t object_size) {
+    uint8_t* chunk = (uint8_t*)malloc(SLAB_CHUNK_SIZE);
+    if (!chunk) {
+        return false;
+    }
+
+    size_t count = SLAB_CHUNK_SIZE / object_size;
+    for (size_t i = count; i > 0; i--) {
+        slab_free_object_t* object = (slab_free_object_t*)(chunk + (i - 1) * object_size);
+        object->next = slab->free_list;
+        slab->free_list = object;
+    }
+    slab->chunks++;
+
+    return true;
+}
+
+size_t slab_object_size(size_t size) {
+    size_t index = class_index(size);
+    return index < SLAB_CLASS_COUNT ? SLAB_CLASS_SIZES[index] : 0;
+}
+
+void* slab_alloc(size_t size) {
+    size_t index = class_index(size);
+    if (index == SLAB_CLASS_COUNT) {
+        return NULL;
+    }
+
+    slab_class_t* slab = &g_classes[index];
+    sgx_spin_lock(&slab->lock);
+
+    if (!slab->free_list && !refill(slab, SLAB_CLASS_SIZES[index])) {
+        sgx_spin_unlock(&slab->lock);
+        return NULL;
+    }
+
+    slab_free_object_t* object = slab->free_list;
+    slab->free_list = object->next;
+    slab->in_use++;
+
+    sgx_spin_unlock(&slab->lock);
+
+    return object;
+}
+
+void slab_free(void* ptr, size_t size) {
+    size_t index = class_index(size);
+    if (!ptr || index == SLAB_CLASS_COUNT) {
+        return;
+    }
+
+    slab_class_t* slab = &g_classes[index];
+    slab_free_object_t* object = (slab_free_object_t*)ptr;
+
+    sgx_spin_lock(&slab->lock);
+    object->next = slab->free_list;
+    slab->free_list = object;
+    slab->in_use--;
+    sgx_spin_unlock(&slab->lock);
+}
+
+void slab_get_stats(slab_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    for (size_t i = 0; i < SLAB_CLASS_COUNT; i++) {
+        slab_class_t* slab = &g_classes[i];
+        sgx_spin_lock(&slab->lock);
+        stats->bytes_reserved += slab->chunks * SLAB_CHUNK_SIZE;
+        stats->bytes_in_use += slab->in_use * SLAB_CLASS_SIZES[i];
+        stats->objects_in_use += slab->in_use;
+        sgx_spin_unlock(&slab->lock);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef SLAB_ALLOC_H
+#define SLAB_ALLOC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 按大小类分配的小对象内存（状态缓存项、状态值、VM内存页）。
+// 每个大小类从堆中整块申请SLAB_CHUNK_SIZE并切分为等长对象，释放的对象进入该类的空闲链表，
+// 块本身不归还堆：占用只随各类对象的峰值增长，同类对象集中在少数EPC页上。
+// 大小类按约1.5倍递增，对象的浪费不超过三分之一。所有接口均为线程安全
+
+#define SLAB_CHUNK_SIZE         (64 * 1024)
+#define SLAB_MAX_OBJECT_SIZE    4096        // 更大的请求返回NULL
+
+// 分配统计
+typedef struct {
+    size_t bytes_reserved;                  // 从堆中申请的块
+    size_t bytes_in_use;                    // 已分配对象（按大小类计）
+    size_t objects_in_use;                  // 已分配对象数量
+} slab_stats_t;
+
+/**
+ * 获取请求大小对应的大小类
+ * @param size 请求大小（1到SLAB_MAX_OBJECT_SIZE）
+ * @return 实际分配的字节数（超出范围时为0）
+ */
+size_t slab_object_size(size_t size);
+
+/**
+ * 分配对象（内容未初始化，按16字节对齐）
+ * @param size 请求大小
+ * @return 对象指针（内存不足或超出范围时为NULL）
+ */
+void* slab_alloc(size_t size);
+
+/**
+ * 释放对象
+ * @param ptr 对象指针（可为NULL）
+ * @param size 分配时的请求大小（与slab_alloc相同的大小类即可）
+ */
+void slab_free(void* ptr, size_t size);
+
+/**
+ * 获取分配统计
+ * @param stats 输出统计
+ */
+void slab_get_stats(slab_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SLAB_ALLOC_H
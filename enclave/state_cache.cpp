@@ -0,0 +1,474 @@
+#include "state_cache.h"
+#include "enclave_t.h"
+#include "enclave.h"
+#include "exec_arena.h"
+#include "slab_alloc.h"
+
+#include <sgx_spinlock.h>
+#include <string.h>
+#include <stdlib.h>
+
+static_assert(MAX_STATE_KEY_SIZE == STATE_RECORD_MAX_KEY_SIZE &&
+              MAX_STATE_VALUE_SIZE == STATE_RECORD_MAX_VALUE_SIZE,
+              "state record limits must match state_item_t");
+static_assert(sizeof(state_cache_entry_t) + MAX_STATE_KEY_SIZE <= SLAB_MAX_OBJECT_SIZE &&
+              MAX_STATE_VALUE_SIZE <= SLAB_MAX_OBJECT_SIZE,
+              "state cache entries and values must fit in a slab object");
+
+// 缓存全局状态（由g_cache_lock保护，临界区内不做OCALL）
+static sgx_spinlock_t g_cache_lock = SGX_SPINLOCK_INITIALIZER;
+static bool g_cache_initialized = false;
+static state_cache_entry_t* g_buckets[STATE_CACHE_BUCKET_COUNT];
+static state_cache_entry_t* g_lru_head = NULL;
+static state_cache_entry_t* g_lru_tail = NULL;
+static state_cache_stats_t g_stats;
+
+/**
+ * 计算哈希桶索引（键由主机提供，不一定分布均匀，使用FNV-1a）
+ */
+static size_t bucket_index(const uint8_t* key, size_t key_size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < key_size; i++) {
+        hash = (hash ^ key[i]) * 16777619u;
+    }
+    return hash % STATE_CACHE_BUCKET_COUNT;
+}
+
+static void lru_unlink(state_cache_entry_t* entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        g_lru_head = entry->lru_next;
+    }
+
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        g_lru_tail = entry->lru_prev;
+    }
+
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void lru_push_front(state_cache_entry_t* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = g_lru_head;
+    if (g_lru_head) {
+        g_lru_head->lru_prev = entry;
+    }
+    g_lru_head = entry;
+    if (!g_lru_tail) {
+        g_lru_tail = entry;
+    }
+}
+
+static state_cache_entry_t* find_entry(const uint8_t* key, size_t key_size) {
+    state_cache_entry_t* entry = g_buckets[bucket_index(key, key_size)];
+    while (entry) {
+        if (entry->item.key_size == key_size && memcmp(entry->item.key, key, key_size) == 0) {
+            return entry;
+        }
+        entry = entry->bucket_next;
+    }
+    return NULL;
+}
+
+/**
+ * 缓存项占用的内存（按slab大小类计）
+ */
+static size_t entry_bytes(const state_cache_entry_t* entry) {
+    return slab_object_size(sizeof(state_cache_entry_t) + entry->item.key_size) + entry->item.value_capacity;
+}
+
+/**
+ * 释放缓存项及其值
+ */
+static void free_entry(state_cache_entry_t* entry) {
+    sgx_thread_mutex_destroy(&entry->exec_mutex);
+    if (entry->item.value) {
+        slab_free(entry->item.value, entry->item.value_capacity);
+    }
+    slab_free(entry, sizeof(state_cache_entry_t) + entry->item.key_size);
+}
+
+/**
+ * 缓存项是否可以淘汰（未被引用且没有未写回的修改）
+ */
+static bool evictable(const state_cache_entry_t* entry) {
+    return entry->refcount == 0 && entry->flushed_version == entry->item.version;
+}
+
+/**
+ * 从哈希桶和LRU链表中移除并释放缓存项
+ */
+static void remove_entry(state_cache_entry_t* entry) {
+    state_cache_entry_t** link = &g_buckets[bucket_index(entry->item.key, entry->item.key_size)];
+    while (*link && *link != entry) {
+        link = &(*link)->bucket_next;
+    }
+    if (*link) {
+        *link = entry->bucket_next;
+    }
+
+    lru_unlink(entry);
+
+    g_stats.bytes_used -= entry_bytes(entry);
+    g_stats.entry_count--;
+
+    free_entry(entry);
+}
+
+/**
+ * 从LRU尾部淘汰可淘汰的缓存项，直到腾出所需空间
+ */
+static bool evict_for(size_t required) {
+    state_cache_entry_t* entry = g_lru_tail;
+
+    while (g_stats.bytes_used + required > g_stats.budget && entry) {
+        state_cache_entry_t* prev = entry->lru_prev;
+        if (evictable(entry)) {
+            remove_entry(entry);
+            g_stats.evictions++;
+        }
+        entry = prev;
+    }
+
+    return g_stats.bytes_used + required <= g_stats.budget;
+}
+
+/**
+ * 命中时将缓存项移到LRU头部并增加引用
+ */
+static void touch_entry(state_cache_entry_t* entry) {
+    lru_unlink(entry);
+    lru_push_front(entry);
+    entry->refcount++;
+}
+
+/**
+ * 初始化状态缓存
+ */
+sgx_status_t state_cache_init(size_t budget) {
+    if (budget < sizeof(state_cache_entry_t)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    sgx_spin_lock(&g_cache_lock);
+
+    if (g_cache_initialized) {
+        state_cache_entry_t* entry = g_lru_head;
+        while (entry) {
+            state_cache_entry_t* next = entry->lru_next;
+            if (evictable(entry)) {
+                remove_entry(entry);
+            }
+            entry = next;
+        }
+    } else {
+        memset(g_buckets, 0, sizeof(g_buckets));
+        memset(&g_stats, 0, sizeof(g_stats));
+        g_lru_head = NULL;
+        g_lru_tail = NULL;
+    }
+
+    g_stats.budget = budget;
+    g_cache_initialized = true;
+
+    sgx_spin_unlock(&g_cache_lock);
+
+    return SGX_SUCCESS;
+}
+
+/**
+ * 获取状态项
+ */
+sgx_status_t state_cache_acquire(const uint8_t* key, size_t key_size, state_cache_entry_t** entry) {
+    if (!key || key_size == 0 || key_size > MAX_STATE_KEY_SIZE || !entry) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    *entry = NULL;
+
+    sgx_spin_lock(&g_cache_lock);
+
+    if (!g_cache_initialized) {
+        sgx_spin_unlock(&g_cache_lock);
+        return SGX_ERROR_INVALID_STATE;
+    }
+
+    state_cache_entry_t* found = find_entry(key, key_size);
+    if (found) {
+        touch_entry(found);
+        g_stats.hits++;
+        sgx_spin_unlock(&g_cache_lock);
+        *entry = found;
+        return SGX_SUCCESS;
+    }
+
+    g_stats.misses++;
+    sgx_spin_unlock(&g_cache_lock);
+
+    // 未命中：在锁外从主机读入临时分配区，再按实际大小复制到新缓存项
+    // 缓存项和键一次分配，值单独分配（修改时可能改变大小类）
+    state_cache_entry_t* created = (state_cache_entry_t*)slab_alloc(sizeof(state_cache_entry_t) + key_size);
+    uint8_t* buffer = (uint8_t*)exec_scratch_alloc(MAX_STATE_VALUE_SIZE);
+    if (!created || !buffer) {
+        slab_free(created, sizeof(state_cache_entry_t) + key_size);
+        exec_scratch_free(buffer);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    memset(created, 0, sizeof(*created));
+    created->item.key = (uint8_t*)(created + 1);
+    memcpy(created->item.key, key, key_size);
+    created->item.key_size = key_size;
+    created->lock = SGX_SPINLOCK_INITIALIZER;
+    sgx_thread_mutex_init(&created->exec_mutex, NULL);
+    created->refcount = 1;
+
+    int found_on_host = -1;
+    size_t value_size = 0;
+    uint64_t version = 0;
+    sgx_status_t ret = ocall_state_read(&found_on_host, key, key_size, buffer, MAX_STATE_VALUE_SIZE,
+                                        &value_size, &version);
+    if (ret == SGX_SUCCESS && (found_on_host < 0 || value_size > MAX_STATE_VALUE_SIZE)) {
+        ret = SGX_ERROR_UNEXPECTED;
+    }
+    if (ret == SGX_SUCCESS && found_on_host == 0) {
+        created->flags = STATE_ENTRY_FLAG_EXISTS;
+        if (value_size > 0) {
+            created->item.value = (uint8_t*)slab_alloc(value_size);
+            if (created->item.value) {
+                memcpy(created->item.value, buffer, value_size);
+                created->item.value_size = value_size;
+                created->item.value_capacity = slab_object_size(value_size);
+            } else {
+                ret = SGX_ERROR_OUT_OF_MEMORY;
+            }
+        }
+    }
+    exec_scratch_free(buffer);
+
+    if (ret != SGX_SUCCESS) {
+        free_entry(created);
+        return ret;
+    }
+
+    created->item.version = version;
+    created->flushed_version = version;
+
+    sgx_spin_lock(&g_cache_lock);
+
+    // 读取期间其他线程可能已插入同一状态项
+    found = find_entry(key, key_size);
+    if (found) {
+        touch_entry(found);
+        sgx_spin_unlock(&g_cache_lock);
+        free_entry(created);
+        *entry = found;
+        return SGX_SUCCESS;
+    }
+
+    size_t bytes = entry_bytes(created);
+    if (!evict_for(bytes)) {
+        sgx_spin_unlock(&g_cache_lock);
+        free_entry(created);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t index = bucket_index(key, key_size);
+    created->bucket_next = g_buckets[index];
+    g_buckets[index] = created;
+    lru_push_front(created);
+
+    g_stats.bytes_used += bytes;
+    g_stats.entry_count++;
+
+    sgx_spin_unlock(&g_cache_lock);
+
+    *entry = created;
+    return SGX_SUCCESS;
+}
+
+/**
+ * 释放缓存项引用
+ */
+void state_cache_release(state_cache_entry_t* entry) {
+    if (!entry) {
+        return;
+    }
+
+    sgx_spin_lock(&g_cache_lock);
+    if (entry->refcount > 0) {
+        entry->refcount--;
+    }
+    sgx_spin_unlock(&g_cache_lock);
+}
+
+/**
+ * 修改状态项的值
+ */
+sgx_status_t state_cache_update(state_cache_entry_t* entry, const uint8_t* value, size_t value_size) {
+    if (!entry || value_size > MAX_STATE_VALUE_SIZE || (!value && value_size != 0)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 大小类改变时换用新的值缓冲区，缩小时同样换用以归还空间
+    size_t capacity = value_size > 0 ? slab_object_size(value_size) : 0;
+    if (capacity != entry->item.value_capacity) {
+        uint8_t* buffer = NULL;
+        if (capacity > 0) {
+            buffer = (uint8_t*)slab_alloc(value_size);
+            if (!buffer) {
+                return SGX_ERROR_OUT_OF_MEMORY;
+            }
+        }
+        if (entry->item.value) {
+            slab_free(entry->item.value, entry->item.value_capacity);
+        }
+
+        // 被引用的缓存项不会被淘汰，增长时尽量淘汰其他缓存项，预算暂时超出时由后续未命中补偿
+        sgx_spin_lock(&g_cache_lock);
+        g_stats.bytes_used = g_stats.bytes_used - entry->item.value_capacity + capacity;
+        evict_for(0);
+        sgx_spin_unlock(&g_cache_lock);
+
+        entry->item.value = buffer;
+        entry->item.value_capacity = capacity;
+    }
+
+    if (value_size > 0) {
+        memcpy(entry->item.value, value, value_size);
+    }
+    entry->item.value_size = value_size;
+    if (value) {
+        entry->flags |= STATE_ENTRY_FLAG_EXISTS;
+    } else {
+        entry->flags &= ~STATE_ENTRY_FLAG_EXISTS;
+    }
+    entry->item.version++;
+
+    return SGX_SUCCESS;
+}
+
+/**
+ * 将修改过的状态项加入写回事务
+ */
+sgx_status_t state_txn_add(state_txn_t* txn, state_cache_entry_t* entry) {
+    if (!txn || !entry) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    // 同一批次通常只涉及少量状态项，线性查重即可
+    for (uint32_t i = 0; i < txn->count; i++) {
+        if (txn->entries[i] == entry) {
+            return SGX_SUCCESS;
+        }
+    }
+
+    sgx_status_t ret = SGX_SUCCESS;
+    if (txn->count == STATE_TXN_MAX_ENTRIES) {
+        ret = state_txn_commit(txn);
+    }
+
+    sgx_spin_lock(&g_cache_lock);
+    entry->refcount++;
+    sgx_spin_unlock(&g_cache_lock);
+
+    txn->entries[txn->count++] = entry;
+
+    return ret;
+}
+
+/**
+ * 提交写回事务
+ */
+sgx_status_t state_txn_commit(state_txn_t* txn) {
+    if (!txn) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    if (txn->count == 0) {
+        return SGX_SUCCESS;
+    }
+
+    // 按当前大小从执行槽的临时分配区分配，键和值在序列化时于各项的锁内读取
+    size_t records_size = 0;
+    for (uint32_t i = 0; i < txn->count; i++) {
+        records_size += state_record_size(txn->entries[i]->item.key_size, MAX_STATE_VALUE_SIZE);
+    }
+
+    uint64_t versions[STATE_TXN_MAX_ENTRIES];
+    uint8_t* records = (uint8_t*)exec_scratch_alloc(records_size);
+    sgx_status_t ret = records ? SGX_SUCCESS : SGX_ERROR_OUT_OF_MEMORY;
+    size_t offset = 0;
+
+    for (uint32_t i = 0; i < txn->count && ret == SGX_SUCCESS; i++) {
+        state_cache_entry_t* entry = txn->entries[i];
+        sgx_spin_lock(&entry->lock);
+
+        state_record_header_t header;
+        memset(&header, 0, sizeof(header));
+        header.key_size = (uint32_t)entry->item.key_size;
+        header.value_size = (uint32_t)entry->item.value_size;
+        header.flags = (entry->flags & STATE_ENTRY_FLAG_EXISTS) ? 0 : STATE_RECORD_FLAG_DELETED;
+        header.version = entry->item.version;
+        versions[i] = entry->item.version;
+
+        size_t record_size = state_record_size(header.key_size, header.value_size);
+        memset(records + offset, 0, record_size);
+        memcpy(records + offset, &header, sizeof(header));
+        memcpy(records + offset + sizeof(header), entry->item.key, header.key_size);
+        if (header.value_size > 0) {
+            memcpy(records + offset + sizeof(header) + header.key_size, entry->item.value, header.value_size);
+        }
+        offset += record_size;
+
+        sgx_spin_unlock(&entry->lock);
+    }
+
+    if (ret == SGX_SUCCESS) {
+        int write_result = -1;
+        ret = ocall_state_write_batch(&write_result, records, offset, txn->count);
+        if (ret == SGX_SUCCESS && write_result != 0) {
+            ret = SGX_ERROR_UNEXPECTED;
+        }
+    }
+    exec_scratch_free(records);
+
+    // 主机按版本保留最新记录，并发提交的先后顺序不影响结果
+    for (uint32_t i = 0; i < txn->count; i++) {
+        state_cache_entry_t* entry = txn->entries[i];
+        if (ret == SGX_SUCCESS) {
+            sgx_spin_lock(&entry->lock);
+            if (versions[i] > entry->flushed_version) {
+                entry->flushed_version = versions[i];
+            }
+            sgx_spin_unlock(&entry->lock);
+        }
+        state_cache_release(entry);
+    }
+
+    sgx_spin_lock(&g_cache_lock);
+    if (ret == SGX_SUCCESS) {
+        g_stats.flushes++;
+        g_stats.records_flushed += txn->count;
+    }
+    sgx_spin_unlock(&g_cache_lock);
+
+    txn->count = 0;
+
+    return ret;
+}
+
+/**
+ * 获取缓存统计
+ */
+void state_cache_get_stats(state_cache_stats_t* stats) {
+    if (stats) {
+        sgx_spin_lock(&g_cache_lock);
+        memcpy(stats, &g_stats, sizeof(g_stats));
+        sgx_spin_unlock(&g_cache_lock);
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef STATE_CACHE_H
+#define STATE_CACHE_H
+
+#include "enclave.h"
+#include "enclave_shared.h"
+
+#include <sgx_spinlock.h>
+#include <sgx_thread.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 所有接口均为线程安全，缓存项在引用期间或有未写回的修改时不会被淘汰
+// 主机侧的状态存储不受信任，值以明文写回，且不防回滚
+
+// 默认EPC内存预算
+#define STATE_CACHE_DEFAULT_BUDGET  (4 * 1024 * 1024)  // 4MB
+#define STATE_CACHE_BUCKET_COUNT    1024
+
+// 单个写回事务最多记录的脏状态项（超过时提前提交）
+#define STATE_TXN_MAX_ENTRIES       128
+
+// 状态键的命名空间前缀（第一个字节），合约内存与主机直接读写的状态互不覆盖
+#define STATE_KEY_PREFIX_CONTRACT   0x43    // 'C'：合约内存映像，后接字节码哈希
+#define STATE_KEY_PREFIX_USER       0x55    // 'U'：ecall_handle_state_update的键
+
+// 缓存项标志
+#define STATE_ENTRY_FLAG_EXISTS     0x01    // 状态存在（未写入或已删除时清除）
+
+// 缓存项（键紧随其后存放，值按大小单独从slab分配）
+typedef struct state_cache_entry {
+    state_item_t item;                      // 状态项（version为最新修改的版本）
+    uint64_t flushed_version;               // 已写回主机的版本
+    uint32_t flags;                         // 缓存项标志
+    uint32_t refcount;                      // 引用计数（非零时不会被淘汰）
+    sgx_spinlock_t lock;                    // 保护item的短临界区
+    sgx_thread_mutex_t exec_mutex;          // 串行化合约内存的整个读-执行-写（先于lock获取）
+    struct state_cache_entry* lru_prev;     // LRU链表（头部为最近使用）
+    struct state_cache_entry* lru_next;
+    struct state_cache_entry* bucket_next;  // 哈希桶链表
+} state_cache_entry_t;
+
+// 写回事务：记录一次执行（或一个批次）修改过的状态项，提交时一次OCALL写回
+typedef struct {
+    state_cache_entry_t* entries[STATE_TXN_MAX_ENTRIES];  // 持有引用的脏状态项
+    uint32_t count;                         // 状态项数量
+} state_txn_t;
+
+// 缓存统计
+typedef struct {
+    uint64_t hits;                          // 命中次数
+    uint64_t misses;                        // 未命中次数（从主机读取）
+    uint64_t evictions;                     // 淘汰次数
+    uint64_t flushes;                       // 写回OCALL次数
+    uint64_t records_flushed;               // 写回的记录数
+    size_t entry_count;                     // 缓存项数量
+    size_t bytes_used;                      // 已用内存（缓存项、键和值按slab大小类计）
+    size_t budget;                          // 内存预算
+} state_cache_stats_t;
+
+/**
+ * 初始化状态缓存（重复调用时调整预算并移除未引用的干净缓存项）
+ * @param budget 内存预算（字节）
+ * @return SGX状态码
+ */
+sgx_status_t state_cache_init(size_t budget);
+
+/**
+ * 获取状态项，未命中时通过ocall_state_read从主机读取
+ * 返回的缓存项持有一个引用，使用完毕后必须调用state_cache_release；
+ * 读写item前须持有entry->lock。合约内存映像只在同时持有exec_mutex和lock时修改，
+ * 因此持有exec_mutex的执行可以不持lock读取item
+ * @param key 状态键
+ * @param key_size 键大小（1到MAX_STATE_KEY_SIZE）
+ * @param entry 输出的缓存项
+ * @return SGX状态码（预算被引用中或未写回的缓存项占满时返回SGX_ERROR_OUT_OF_MEMORY）
+ */
+sgx_status_t state_cache_acquire(const uint8_t* key, size_t key_size, state_cache_entry_t** entry);
+
+/**
+ * 释放缓存项引用
+ * @param entry 缓存项
+ */
+void state_cache_release(state_cache_entry_t* entry);
+
+/**
+ * 修改状态项的值并递增版本（调用方持有entry->lock）
+ * @param entry 缓存项
+ * @param value 新值（为NULL时表示删除）
+ * @param value_size 值大小
+ * @return SGX状态码
+ */
+sgx_status_t state_cache_update(state_cache_entry_t* entry, const uint8_t* value, size_t value_size);
+
+/**
+ * 将修改过的状态项加入写回事务，事务已满时先提交
+ * 事务为该项额外持有一个引用，提交后释放
+ * @param txn 写回事务
+ * @param entry 缓存项（调用方不持有entry->lock）
+ * @return SGX状态码（提前提交失败时返回写回的错误）
+ */
+sgx_status_t state_txn_add(state_txn_t* txn, state_cache_entry_t* entry);
+
+/**
+ * 提交写回事务：所有脏状态项合并为一条ocall_state_write_batch
+ * 写回失败的状态项保持为脏，后续提交中包含它们时重试
+ * @param txn 写回事务（提交后清空）
+ * @return SGX状态码
+ */
+sgx_status_t state_txn_commit(state_txn_t* txn);
+
+/**
+ * 获取缓存统计
+ * @param stats 输出统计
+ */
+void state_cache_get_stats(state_cache_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATE_CACHE_H
@@ -0,0 +1,163 @@
+#include "vm_vector.h"
+
+#include <sgx_cpuid.h>
+#include <string.h>
+
+// 与sha256_multi.cpp相同：Enclave以-nostdinc编译，没有intrinsics头文件，
+// 核心使用GCC向量扩展，以target属性单独启用AVX2。未对齐的向量读写通过memcpy完成
+
+typedef uint64_t u64x2 __attribute__((vector_size(16)));
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+
+typedef void (*vector_add_fn)(uint8_t* dst, const uint8_t* src, size_t words);
+typedef void (*vector_xor_fn)(uint8_t* dst, const uint8_t* src, size_t size);
+typedef size_t (*vector_mismatch_fn)(const uint8_t* a, const uint8_t* b, size_t size);
+typedef uint64_t (*vector_sum_fn)(const uint8_t* data, size_t words);
+
+/**
+ * 按向量类型V生成一组核心，向量部分之后的余数逐字或逐字节处理
+ */
+#define VM_VECTOR_KERNELS(name, V, attr)                                        \
+    attr static void name##_add(uint8_t* dst, const uint8_t* src, size_t words) { \
+        const size_t lanes = sizeof(V) / 8;                                     \
+        size_t i = 0;                                                           \
+        for (; i + lanes <= words; i += lanes) {                                \
+            V a, b;                                                             \
+            memcpy(&a, dst + i * 8, sizeof(V));                                 \
+            memcpy(&b, src + i * 8, sizeof(V));                                 \
+            a += b;                                                             \
+            memcpy(dst + i * 8, &a, sizeof(V));                                 \
+        }                                                                       \
+        for (; i < words; i++) {                                                \
+            uint64_t a, b;                                                      \
+            memcpy(&a, dst + i * 8, 8);                                         \
+            memcpy(&b, src + i * 8, 8);                                         \
+            a += b;                                                             \
+            memcpy(dst + i * 8, &a, 8);                                         \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    attr static void name##_xor(uint8_t* dst, const uint8_t* src, size_t size) { \
+        size_t i = 0;                                                           \
+        for (; i + sizeof(V) <= size; i += sizeof(V)) {                         \
+            V a, b;                                                             \
+            memcpy(&a, dst + i, sizeof(V));                                     \
+            memcpy(&b, src + i, sizeof(V));                                     \
+            a ^= b;                                                             \
+            memcpy(dst + i, &a, sizeof(V));                                     \
+        }                                                                       \
+        for (; i < size; i++) {                                                 \
+            dst[i] ^= src[i];                                                   \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    attr static size_t name##_mismatch(const uint8_t* a, const uint8_t* b, size_t size) { \
+        size_t i = 0;                                                           \
+        for (; i + sizeof(V) <= size; i += sizeof(V)) {                         \
+            V x, y;                                                             \
+            memcpy(&x, a + i, sizeof(V));                                       \
+            memcpy(&y, b + i, sizeof(V));                                       \
+            x ^= y;                                                             \
+            uint64_t diff = 0;                                                  \
+            for (size_t l = 0; l < sizeof(V) / 8; l++) {                        \
+                diff |= x[l];                                                   \
+            }                                                                   \
+            if (diff) {                                                         \
+                break;                                                          \
+            }                                                                   \
+        }                                                                       \
+        for (; i < size; i++) {                                                 \
+            if (a[i] != b[i]) {                                                 \
+                return i;                                                       \
+            }                                                                   \
+        }                                                                       \
+        return size;                                                            \
+    }                                                                           \
+                                                                                \
+    attr static uint64_t name##_sum(const uint8_t* data, size_t words) {        \
+        const size_t lanes = sizeof(V) / 8;                                     \
+        V acc = { 0 };                                                          \
+        size_t i = 0;                                                           \
+        for (; i + lanes <= words; i += lanes) {                                \
+            V x;                                                                \
+            memcpy(&x, data + i * 8, sizeof(V));                                \
+            acc += x;                                                           \
+        }                                                                       \
+        uint64_t sum = 0;                                                       \
+        for (size_t l = 0; l < lanes; l++) {                                    \
+            sum += acc[l];                                                      \
+        }                                                                       \
+        for (; i < words; i++) {                                                \
+            uint64_t x;                                                         \
+            memcpy(&x, data + i * 8, 8);                                        \
+            sum += x;                                                           \
+        }                                                                       \
+        return sum;                                                             \
+    }
+
+// SSE2是x86-64的基线指令集，始终可用
+VM_VECTOR_KERNELS(sse2, u64x2, )
+VM_VECTOR_KERNELS(avx2, u64x4, __attribute__((target("avx2"))))
+
+#undef VM_VECTOR_KERNELS
+
+// CPUID由主机提供，虚报AVX2只会导致非法指令异常，不会影响计算结果
+static vector_add_fn g_add = sse2_add;
+static vector_xor_fn g_xor = sse2_xor;
+static vector_mismatch_fn g_mismatch = sse2_mismatch;
+static vector_sum_fn g_sum = sse2_sum;
+
+static uint64_t read_xcr0(void) {
+    uint32_t low, high;
+    __asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * 检测CPU特性并选择向量核心
+ */
+bool vm_vector_init(void) {
+    bool avx2 = false;
+    int leaf0[4], leaf1[4], leaf7[4];
+
+    if (sgx_cpuid(leaf0, 0) == SGX_SUCCESS && leaf0[0] >= 7 &&
+        sgx_cpuid(leaf1, 1) == SGX_SUCCESS && sgx_cpuidex(leaf7, 7, 0) == SGX_SUCCESS) {
+        bool osxsave = ((uint32_t)leaf1[2] & (1u << 27)) != 0;
+        avx2 = ((uint32_t)leaf7[1] & (1u << 5)) && osxsave && (read_xcr0() & 0x06) == 0x06;
+    }
+
+    // 初始化在任何合约执行之前完成，此后函数指针只读
+    g_add = avx2 ? avx2_add : sse2_add;
+    g_xor = avx2 ? avx2_xor : sse2_xor;
+    g_mismatch = avx2 ? avx2_mismatch : sse2_mismatch;
+    g_sum = avx2 ? avx2_sum : sse2_sum;
+    return avx2;
+}
+
+/**
+ * 按64位字相加
+ */
+void vm_vector_add(uint8_t* dst, const uint8_t* src, size_t words) {
+    g_add(dst, src, words);
+}
+
+/**
+ * 按字节异或
+ */
+void vm_vector_xor(uint8_t* dst, const uint8_t* src, size_t size) {
+    g_xor(dst, src, size);
+}
+
+/**
+ * 查找第一个不同字节
+ */
+size_t vm_vector_mismatch(const uint8_t* a, const uint8_t* b, size_t size) {
+    return g_mismatch(a, b, size);
+}
+
+/**
+ * 64位字求和
+ */
+uint64_t vm_vector_sum(const uint8_t* data, size_t words) {
+    return g_sum(data, words);
+}
@@ -0,0 +1,59 @@
+#ifndef VM_VECTOR_H
+#define VM_VECTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 合约向量指令（OP_COPY至OP_VSUM）的批量内存核心。
+// 执行时先把合约内存的范围读入Enclave内的连续缓冲区，核心只处理连续内存；
+// 运行时按CPU特性选择AVX2或SSE2实现，结果与逐字节、逐字的标量计算完全一致
+
+/**
+ * 检测CPU特性并选择向量核心
+ * @return 是否使用AVX2核心
+ */
+bool vm_vector_init(void);
+
+/**
+ * dst[i] += src[i]，按小端64位字回绕相加
+ * @param dst 目标
+ * @param src 源（不能与dst部分重叠）
+ * @param words 字数
+ */
+void vm_vector_add(uint8_t* dst, const uint8_t* src, size_t words);
+
+/**
+ * dst[i] ^= src[i]，按字节异或
+ * @param dst 目标
+ * @param src 源（不能与dst部分重叠）
+ * @param size 字节数
+ */
+void vm_vector_xor(uint8_t* dst, const uint8_t* src, size_t size);
+
+/**
+ * 查找两段内存第一个不同字节的偏移
+ * @param a 第一段
+ * @param b 第二段
+ * @param size 字节数
+ * @return 偏移（完全相同时为size）
+ */
+size_t vm_vector_mismatch(const uint8_t* a, const uint8_t* b, size_t size);
+
+/**
+ * 小端64位字的回绕求和
+ * @param data 数据
+ * @param words 字数
+ * @return 和
+ */
+uint64_t vm_vector_sum(const uint8_t* data, size_t words);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VM_VECTOR_H
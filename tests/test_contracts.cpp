@@ -0,0 +1,224 @@
+#include "test_contracts.h"
+
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+// 操作码，与enclave/enclave.h中的contract_opcode_t一致
+enum : uint8_t {
+    OP_NOP = 0x00,
+    OP_PUSH = 0x01,
+    OP_POP = 0x02,
+    OP_ADD = 0x03,
+    OP_SUB = 0x04,
+    OP_MUL = 0x05,
+    OP_DIV = 0x06,
+    OP_MOD = 0x07,
+    OP_AND = 0x08,
+    OP_OR = 0x09,
+    OP_XOR = 0x0A,
+    OP_NOT = 0x0B,
+    OP_EQ = 0x0C,
+    OP_LT = 0x0D,
+    OP_GT = 0x0E,
+    OP_JMP = 0x0F,
+    OP_JMPIF = 0x10,
+    OP_LOAD = 0x13,
+    OP_STORE = 0x14,
+    OP_HASH = 0x15,
+    OP_VERIFY = 0x16,
+    OP_COPY = 0x17,
+    OP_VADD = 0x18,
+    OP_VXOR = 0x19,
+    OP_VCMP = 0x1A,
+    OP_VSUM = 0x1B,
+    OP_INPUT = 0x1C,
+    OP_HALT = 0xFF
+};
+
+/**
+ * 字节码构造器：跳转目标按标签在build时回填
+ */
+class ContractBuilder {
+public:
+    ContractBuilder& op(uint8_t opcode) {
+        code.push_back(opcode);
+        return *this;
+    }
+
+    ContractBuilder& push(uint64_t value) {
+        code.push_back(OP_PUSH);
+        for (int i = 0; i < 8; i++) {
+            code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+        return *this;
+    }
+
+    ContractBuilder& label(const std::string& name) {
+        labels[name] = static_cast<uint32_t>(code.size());
+        return *this;
+    }
+
+    ContractBuilder& jump(uint8_t opcode, const std::string& name) {
+        fixups.emplace_back(code.size() + 1, name);
+        return jump_to(opcode, 0);
+    }
+
+    // 直接写入跳转地址，用于构造非法跳转
+    ContractBuilder& jump_to(uint8_t opcode, uint32_t target) {
+        code.push_back(opcode);
+        for (int i = 0; i < 4; i++) {
+            code.push_back(static_cast<uint8_t>(target >> (i * 8)));
+        }
+        return *this;
+    }
+
+    // 写入mem[address] = value
+    ContractBuilder& store(uint64_t address, uint64_t value) {
+        return push(address).push(value).op(OP_STORE);
+    }
+
+    std::vector<uint8_t> build() const {
+        std::vector<uint8_t> result = code;
+        for (const auto& fixup : fixups) {
+            auto it = labels.find(fixup.second);
+            if (it == labels.end()) {
+                throw std::logic_error("未定义的标签: " + fixup.second);
+            }
+            for (int i = 0; i < 4; i++) {
+                result[fixup.first + i] = static_cast<uint8_t>(it->second >> (i * 8));
+            }
+        }
+        return result;
+    }
+
+private:
+    std::vector<uint8_t> code;
+    std::map<std::string, uint32_t> labels;
+    std::vector<std::pair<size_t, std::string>> fixups;
+};
+
+// 计数循环：mem[0]从count递减到0
+ContractBuilder counting_loop(uint64_t count) {
+    ContractBuilder builder;
+    builder.store(0, count)
+           .label("loop")
+           .push(0).push(0).op(OP_LOAD).push(1).op(OP_SUB).op(OP_STORE)
+           .push(0).op(OP_LOAD)
+           .jump(OP_JMPIF, "loop");
+    return builder;
+}
+
+TestContract make_contract(const std::string& name, const ContractBuilder& builder,
+                           uint64_t gas_limit, bool expect_success, bool stateful = false,
+                           const std::vector<uint8_t>& input = std::vector<uint8_t>()) {
+    TestContract contract;
+    contract.name = name;
+    contract.bytecode = builder.build();
+    contract.input = input;
+    contract.gas_limit = gas_limit;
+    contract.expect_success = expect_success;
+    contract.stateful = stateful;
+    return contract;
+}
+
+} // namespace
+
+std::vector<TestContract> build_test_contracts() {
+    std::vector<TestContract> contracts;
+    const uint64_t gas = 1000000;
+
+    // 正常执行
+    contracts.push_back(make_contract("arithmetic", ContractBuilder()
+        .push(7).push(5).op(OP_ADD).push(3).op(OP_MUL).push(4).op(OP_SUB)
+        .push(2).op(OP_DIV).push(5).op(OP_MOD).op(OP_POP).op(OP_HALT), gas, true));
+
+    contracts.push_back(make_contract("bitwise_compare", ContractBuilder()
+        .push(0xF0F0).push(0x0FF0).op(OP_AND).push(1).op(OP_OR).push(0xFF).op(OP_XOR).op(OP_NOT)
+        .push(3).push(3).op(OP_EQ).op(OP_ADD).push(1).push(2).op(OP_LT).op(OP_ADD)
+        .push(2).push(1).op(OP_GT).op(OP_ADD).push(9).op(OP_VERIFY).op(OP_ADD).op(OP_POP)
+        .op(OP_NOP).op(OP_HALT), gas, true));
+
+    contracts.push_back(make_contract("counting_loop",
+        counting_loop(200).op(OP_HALT), gas, true, true));
+
+    contracts.push_back(make_contract("branch_over", ContractBuilder()
+        .push(1).jump(OP_JMPIF, "skip").push(0).push(0).op(OP_DIV).label("skip")
+        .push(0).jump(OP_JMPIF, "fail").jump(OP_JMP, "done")
+        .label("fail").push(1).push(0).op(OP_DIV)
+        .label("done").store(8, 42).op(OP_HALT), gas, true, true));
+
+    ContractBuilder vectors;
+    for (uint64_t i = 0; i < 8; i++) {
+        vectors.store(i * 8, i * 0x0101010101010101ULL + 1);
+    }
+    vectors.push(256).push(0).push(64).op(OP_COPY)          // mem[256..320) = mem[0..64)
+           .push(256).push(0).push(64).op(OP_VADD)          // mem[256..320) += mem[0..64)
+           .push(1024).push(3).push(61).op(OP_VXOR)         // 非对齐范围
+           .push(2048)                                      // 结果写入mem[2048]
+           .push(256).push(0).push(64).op(OP_VCMP)
+           .push(256).push(64).op(OP_VSUM).op(OP_ADD)
+           .push(0).push(512).op(OP_HASH).op(OP_ADD).op(OP_STORE)
+           .op(OP_HALT);
+    contracts.push_back(make_contract("memory_vector", vectors, gas, true, true));
+
+    std::vector<uint8_t> input;
+    for (int i = 0; i < 200; i++) {
+        input.push_back(static_cast<uint8_t>(i * 7 + 3));
+    }
+    contracts.push_back(make_contract("input_hash", ContractBuilder()
+        .push(128).push(100).op(OP_INPUT)                  // 复制前100字节
+        .push(512).push(4096 - 512).op(OP_INPUT).op(OP_ADD)  // 只剩100字节可读
+        .push(128).push(100).op(OP_HASH).op(OP_ADD)
+        .push(16).op(OP_ADD).push(0).op(OP_LOAD).op(OP_ADD).op(OP_POP)
+        .op(OP_HALT), gas, true, true, input));
+
+    // Gas耗尽：循环中途、长度计价的指令处和无限循环
+    contracts.push_back(make_contract("gas_exhaustion_loop",
+        counting_loop(1000).op(OP_HALT), 500, false, true));
+
+    contracts.push_back(make_contract("gas_exhaustion_vector", ContractBuilder()
+        .push(0).push(0).push(4096).op(OP_COPY).op(OP_HALT), 20, false));
+
+    contracts.push_back(make_contract("gas_exhaustion_infinite", ContractBuilder()
+        .label("spin").op(OP_NOP).jump(OP_JMP, "spin").op(OP_HALT), 10000, false));
+
+    // 运行时错误
+    contracts.push_back(make_contract("division_by_zero", ContractBuilder()
+        .push(1).push(0).op(OP_DIV).op(OP_HALT), gas, false));
+
+    contracts.push_back(make_contract("modulo_by_zero", ContractBuilder()
+        .push(1).push(0).op(OP_MOD).op(OP_HALT), gas, false));
+
+    contracts.push_back(make_contract("stack_underflow", ContractBuilder()
+        .push(1).op(OP_ADD).op(OP_HALT), gas, false));
+
+    contracts.push_back(make_contract("memory_out_of_range", ContractBuilder()
+        .store(8, 1).push(4095).op(OP_LOAD).op(OP_HALT), gas, false, true));
+
+    contracts.push_back(make_contract("vector_out_of_range", ContractBuilder()
+        .push(4000).push(0).push(200).op(OP_COPY).op(OP_HALT), gas, false));
+
+    // 非法字节码，所有后端都必须在验证时拒绝
+    contracts.push_back(make_contract("invalid_jump_out_of_range", ContractBuilder()
+        .push(1).jump_to(OP_JMPIF, 1000).op(OP_HALT), gas, false));
+
+    contracts.push_back(make_contract("invalid_jump_into_immediate", ContractBuilder()
+        .push(0x1234).jump_to(OP_JMP, 3).op(OP_HALT), gas, false));
+
+    contracts.push_back(make_contract("missing_halt", ContractBuilder()
+        .push(1).push(2).op(OP_ADD), gas, false));
+
+    contracts.push_back(make_contract("unknown_opcode", ContractBuilder()
+        .op(0x40).op(OP_HALT), gas, false));
+
+    return contracts;
+}
+
+std::vector<uint8_t> make_state_variant(const std::vector<uint8_t>& bytecode, uint32_t variant) {
+    std::vector<uint8_t> code = bytecode;
+    code.insert(code.end(), variant + 1, OP_NOP);
+    code.push_back(OP_HALT);
+    return code;
+}
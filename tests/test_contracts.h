@@ -0,0 +1,34 @@
+#ifndef TEST_CONTRACTS_H
+#define TEST_CONTRACTS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 后端一致性测试合约：同一份字节码和输入在所有执行后端上运行，输出必须逐项一致
+struct TestContract {
+    std::string name;
+    std::vector<uint8_t> bytecode;
+    std::vector<uint8_t> input;
+    uint64_t gas_limit;
+    bool expect_success;    // 解释器上的预期结果，防止所有后端一致地出错
+    bool stateful;          // 写入合约内存，启用状态持久化时比较提交后的状态
+};
+
+/**
+ * 构造测试合约集合：算术、位运算、循环、内存和向量指令、哈希、输入，
+ * 以及Gas耗尽、运行时错误和非法跳转（验证时拒绝）的合约
+ * @return 测试合约列表
+ */
+std::vector<TestContract> build_test_contracts();
+
+/**
+ * 为状态持久化测试生成字节码变体：在最后的OP_HALT之后追加不可达的填充指令
+ * 执行路径、Gas和内存写入不变，字节码哈希（即状态键）不同，各后端的状态互不影响
+ * @param bytecode 原字节码（以OP_HALT结束）
+ * @param variant 变体编号
+ * @return 变体字节码
+ */
+std::vector<uint8_t> make_state_variant(const std::vector<uint8_t>& bytecode, uint32_t variant);
+
+#endif // TEST_CONTRACTS_H
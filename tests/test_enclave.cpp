@@ -0,0 +1,181 @@
+#include "app.h"
+#include "app_utils.h"
+#include "state_store.h"
+#include "test_contracts.h"
+
+#include <openssl/sha.h>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t BACKEND_COUNT = 4;
+const char* const BACKEND_NAMES[BACKEND_COUNT] = { "interpreter", "decoded", "threaded", "jit" };
+
+// 每个合约在每个后端上连续执行的次数：JIT阈值为1，第二次起执行编译后的本地代码
+const int RUNS_PER_BACKEND = 3;
+
+// 一次执行的全部可观察输出
+struct Observation {
+    app_status_t status;
+    ExecutionResult result;
+    std::vector<uint8_t> state_hash;    // 持久化的合约内存镜像的SHA256（未提交时为空）
+};
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& message) {
+    if (!condition) {
+        print_error(message);
+        g_failures++;
+    }
+}
+
+/**
+ * 读取合约持久化状态并计算哈希，状态键为'C' | 字节码哈希
+ * @param bytecode 合约字节码
+ * @return 状态镜像哈希，状态不存在时为空
+ */
+std::vector<uint8_t> read_state_hash(const std::vector<uint8_t>& bytecode) {
+    uint8_t key[1 + SHA256_DIGEST_LENGTH];
+    key[0] = 'C';
+    SHA256(bytecode.data(), bytecode.size(), key + 1);
+
+    std::vector<uint8_t> value(STATE_RECORD_MAX_VALUE_SIZE);
+    size_t value_size = 0;
+    uint64_t version = 0;
+    if (StateStore::instance().get(key, sizeof(key), value.data(), value.size(), &value_size, &version) != 0) {
+        return std::vector<uint8_t>();
+    }
+
+    std::vector<uint8_t> hash(SHA256_DIGEST_LENGTH);
+    SHA256(value.data(), value_size, hash.data());
+    return hash;
+}
+
+Observation run_once(SGXSmartContractApp& app, const SmartContract& contract,
+                     const std::vector<uint8_t>& input, bool with_state) {
+    Observation observation;
+    observation.status = app.execute_contract(contract, input, observation.result);
+    if (with_state) {
+        observation.state_hash = read_state_hash(contract.bytecode);
+    }
+    return observation;
+}
+
+/**
+ * 比较两次执行的输出：状态码、成功标志、Gas、输出、执行哈希、错误信息和状态哈希
+ * @param compare_hash 是否比较执行哈希（字节码不同的状态变体之间不比较）
+ */
+void compare(const Observation& expected, const Observation& actual, bool compare_hash,
+             const std::string& label) {
+    check(expected.status == actual.status, label + ": 状态码不一致 " +
+          std::to_string(expected.status) + " / " + std::to_string(actual.status));
+    check(expected.result.success == actual.result.success, label + ": 成功标志不一致");
+    check(expected.result.gas_used == actual.result.gas_used, label + ": Gas不一致 " +
+          std::to_string(expected.result.gas_used) + " / " + std::to_string(actual.result.gas_used));
+    check(expected.result.output == actual.result.output, label + ": 输出不一致");
+    check(expected.result.error_message == actual.result.error_message, label + ": 错误信息不一致 \"" +
+          expected.result.error_message + "\" / \"" + actual.result.error_message + "\"");
+    if (compare_hash) {
+        check(expected.result.execution_hash == actual.result.execution_hash, label + ": 执行哈希不一致");
+    }
+    check(expected.state_hash == actual.state_hash, label + ": 状态哈希不一致");
+}
+
+/**
+ * 无状态执行：同一份字节码在各后端上执行，逐项与解释器比较
+ */
+void test_backend_equivalence(SGXSmartContractApp& app, const std::vector<TestContract>& contracts) {
+    for (const auto& test : contracts) {
+        SmartContract contract(test.bytecode, test.name);
+        contract.gas_limit = test.gas_limit;
+
+        app.set_execution_backend(EXECUTION_BACKEND_INTERPRETER);
+        Observation expected = run_once(app, contract, test.input, false);
+        check(expected.result.success == test.expect_success, test.name + ": 解释器执行结果与预期不符 " +
+              expected.result.error_message);
+
+        for (uint32_t backend = 0; backend < BACKEND_COUNT; backend++) {
+            check(app.set_execution_backend(backend) == APP_SUCCESS,
+                  std::string("无法切换到后端 ") + BACKEND_NAMES[backend]);
+            for (int run = 0; run < RUNS_PER_BACKEND; run++) {
+                Observation actual = run_once(app, contract, test.input, false);
+                compare(expected, actual, true, test.name + "/" + BACKEND_NAMES[backend] +
+                        "#" + std::to_string(run));
+            }
+        }
+    }
+}
+
+/**
+ * 有状态执行：每个后端使用自己的字节码变体，状态从空开始累积，
+ * 每次执行后提交的状态镜像都必须与解释器相同
+ */
+void test_state_equivalence(SGXSmartContractApp& app, const std::vector<TestContract>& contracts) {
+    for (const auto& test : contracts) {
+        if (!test.stateful) {
+            continue;
+        }
+
+        std::vector<Observation> expected;
+        for (uint32_t backend = 0; backend < BACKEND_COUNT; backend++) {
+            SmartContract contract(make_state_variant(test.bytecode, backend), test.name);
+            contract.gas_limit = test.gas_limit;
+            check(app.set_execution_backend(backend) == APP_SUCCESS,
+                  std::string("无法切换到后端 ") + BACKEND_NAMES[backend]);
+
+            for (int run = 0; run < RUNS_PER_BACKEND; run++) {
+                Observation actual = run_once(app, contract, test.input, true);
+                std::string label = test.name + "/state/" + BACKEND_NAMES[backend] + "#" + std::to_string(run);
+                if (backend == EXECUTION_BACKEND_INTERPRETER) {
+                    check(actual.result.success == test.expect_success, label + ": 执行结果与预期不符");
+                    expected.push_back(actual);
+                } else {
+                    compare(expected[run], actual, false, label);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    // 测试使用独立的数据目录，不影响应用的状态日志
+    Config::data_directory = "tests/data";
+    std::error_code ec;
+    std::filesystem::remove_all(Config::data_directory, ec);
+
+    SGXSmartContractApp app;
+    if (app.initialize_enclave() != APP_SUCCESS) {
+        print_error("Enclave初始化失败");
+        return 1;
+    }
+    if (app.set_jit_threshold(1) != APP_SUCCESS) {
+        print_error("无法设置JIT编译阈值");
+        return 1;
+    }
+
+    std::vector<TestContract> contracts = build_test_contracts();
+    std::cout << "后端一致性测试: " << contracts.size() << " 个合约, " << BACKEND_COUNT << " 个后端" << std::endl;
+
+    test_backend_equivalence(app, contracts);
+
+    if (app.configure_state(true) != APP_SUCCESS) {
+        print_error("无法启用合约状态持久化");
+        return 1;
+    }
+    test_state_equivalence(app, contracts);
+
+    app.destroy_enclave();
+
+    if (g_failures > 0) {
+        print_error("测试失败: " + std::to_string(g_failures) + " 项检查不一致");
+        return 1;
+    }
+    print_success("所有后端的执行结果一致");
+    return 0;
+}